@@ -18,6 +18,10 @@
 #include "core/cpp/include/brush_preset_manager.h"
 #include "core/brushes/abr_parser.h"
 #include "core/cpp/include/undo_commands.h"
+#include "core/cpp/include/frame_tracer.h"
+#include "core/cpp/include/latency_profiler.h"
+#include "core/cpp/include/live_wire.h"
+#include "core/cpp/include/transform_warp.h"
 #include "ProjectModel.h"
 #include <QBuffer>
 #include <QCoreApplication>
@@ -37,6 +41,7 @@
 #include <QNetworkRequest>
 #include <QEventLoop>
 #include <QFutureWatcher>
+#include <QPromise>
 #include <QGuiApplication>
 #include <QHoverEvent>
 #include <QJsonArray>
@@ -150,65 +155,57 @@ static QTransform deserializeTransform(const QJsonArray &arr) {
 
 
 
+// Vector edits are undone by replaying a stroke-level delta on the live layer
+// data; the pixels come back from the tile cache (rasterizeDirty) instead of
+// stored before/after buffers.
 class VectorUndoCommand : public artflow::UndoCommand {
 public:
   VectorUndoCommand(artflow::LayerManager *manager, int layerIndex,
-                    std::unique_ptr<ImageBuffer> beforeBuffer,
-                    std::unique_ptr<ImageBuffer> afterBuffer,
-                    std::unique_ptr<artflow::VectorLayerData> beforeVector,
-                    std::unique_ptr<artflow::VectorLayerData> afterVector)
-      : m_manager(manager), m_layerIndex(layerIndex),
-        m_beforeBuffer(std::move(beforeBuffer)), m_afterBuffer(std::move(afterBuffer)),
-        m_beforeVector(std::move(beforeVector)), m_afterVector(std::move(afterVector)) {}
+                    artflow::VectorLayerData::Delta delta)
+      : m_manager(manager), m_layerIndex(layerIndex), m_delta(std::move(delta)) {}
 
-  void undo() override {
-    artflow::Layer *layer = m_manager->getLayer(m_layerIndex);
-    if (layer) {
-      if (m_beforeBuffer) {
-        layer->buffer->copyFrom(*m_beforeBuffer);
-      }
-      if (m_beforeVector) {
-        layer->vectorData = std::make_unique<artflow::VectorLayerData>(*m_beforeVector);
-      } else {
-        layer->vectorData.reset();
-      }
-      layer->dirty = true;
-      layer->markDirty();
-    }
-  }
-
-  void redo() override {
-    artflow::Layer *layer = m_manager->getLayer(m_layerIndex);
-    if (layer) {
-      if (m_afterBuffer) {
-        layer->buffer->copyFrom(*m_afterBuffer);
-      }
-      if (m_afterVector) {
-        layer->vectorData = std::make_unique<artflow::VectorLayerData>(*m_afterVector);
-      } else {
-        layer->vectorData.reset();
-      }
-      layer->dirty = true;
-      layer->markDirty();
-    }
-  }
+  void undo() override { apply(false); }
+  void redo() override { apply(true); }
 
   std::string name() const override { return "Vector Edit"; }
 
 private:
+  void apply(bool forward) {
+    artflow::Layer *layer = m_manager->getLayer(m_layerIndex);
+    if (!layer || !layer->vectorData || !layer->buffer)
+      return;
+    layer->vectorData->applyDelta(m_delta, forward);
+    const QRect changed = layer->vectorData->rasterizeDirty(*layer->buffer);
+    layer->dirty = false;
+    if (!changed.isEmpty())
+      layer->markDirty(changed);
+  }
+
   artflow::LayerManager *m_manager;
   int m_layerIndex;
-  std::unique_ptr<ImageBuffer> m_beforeBuffer;
-  std::unique_ptr<ImageBuffer> m_afterBuffer;
-  std::unique_ptr<artflow::VectorLayerData> m_beforeVector;
-  std::unique_ptr<artflow::VectorLayerData> m_afterVector;
+  artflow::VectorLayerData::Delta m_delta;
 };
 
-static QString getAutoSaveDir();
+// Records the difference between `before` (snapshot taken when the edit
+// started, may be null) and the layer's current vector data.
+static void pushVectorUndo(artflow::UndoManager *undoManager,
+                           artflow::LayerManager *layerManager, int layerIndex,
+                           const artflow::VectorLayerData *before,
+                           const artflow::VectorLayerData &after) {
+  if (!undoManager)
+    return;
+  artflow::VectorLayerData::Delta delta =
+      before ? artflow::VectorLayerData::diff(*before, after)
+             : artflow::VectorLayerData::diff(
+                   artflow::VectorLayerData(after.canvasWidth(), after.canvasHeight()),
+                   after);
+  if (delta.empty())
+    return;
+  undoManager->pushCommand(std::make_unique<VectorUndoCommand>(
+      layerManager, layerIndex, std::move(delta)));
+}
 
-static void warpQuadBilinear(const QImage &srcImg, QImage &dstImg,
-                             const QPolygonF &srcQuad, const QPolygonF &dstQuad,
-                             int canvasWidth, int canvasHeight);
+static QString getAutoSaveDir();
 
 static QCursor getModernCursor() {
   static QCursor modernCursor;
@@ -387,6 +384,20 @@ CanvasItem::CanvasItem(QQuickItem *parent)
     QQuickPaintedItem::update();
   });
 
+  // Refinamiento del preview de transformación: tras una pausa sin mover
+  // los handles, cada tick duplica la resolución hasta la de pantalla
+  m_transformRefineTimer = new QTimer(this);
+  m_transformRefineTimer->setSingleShot(true);
+  connect(m_transformRefineTimer, &QTimer::timeout, this, [this]() {
+    m_transformInteracting = false;
+    if (m_transformPreviewCoarseness > 0) {
+      --m_transformPreviewCoarseness;
+      update();
+      if (m_transformPreviewCoarseness > 0)
+        m_transformRefineTimer->start(50);
+    }
+  });
+
   // Timer persistente para animación de marching ants
   m_marchingAntsTimer = new QTimer(this);
   m_marchingAntsTimer->setInterval(50); // 20fps
@@ -410,6 +421,9 @@ CanvasItem::CanvasItem(QQuickItem *parent)
   // Sincronizar niveles de deshacer (Undo Levels)
   m_undoManager->setMaxLevels(PreferencesManager::instance()->undoLevels());
 
+  // Trazado de frames (Chrome Trace) sólo si está activado en preferencias
+  syncFrameTracing();
+
   // Escuchar cambios en preferencias para actualizar el sistema en tiempo real
 
   m_activeLayerIndex = 1;
@@ -495,6 +509,7 @@ CanvasItem::CanvasItem(QQuickItem *parent)
           this, [this, updateTheme]() {
             m_undoManager->setMaxLevels(
                 PreferencesManager::instance()->undoLevels());
+            syncFrameTracing();
             updateTheme();
           });
 
@@ -508,6 +523,7 @@ CanvasItem::CanvasItem(QQuickItem *parent)
   updateTheme();
   setupAutoSave();
   m_edgeDetector = new EdgeDetector();
+  m_colorRangeSelector = new ColorRangeSelector();
   m_animationManager = new AnimationManager(m_layerManager, this);
   connect(m_animationManager, &AnimationManager::frameUpdated, this, [this]() {
     clearRenderCaches();
@@ -567,6 +583,7 @@ void CanvasItem::renderGpuComposition(QOpenGLFramebufferObject *target, int w,
                                       int h) {
   if (!m_compositionShader || !m_compositionShader->isLinked())
     return;
+  artflow::ScopedTrace trace("CanvasItem::renderGpuComposition");
 
   QOpenGLFunctions *f = QOpenGLContext::currentContext()->functions();
 
@@ -666,6 +683,7 @@ void CanvasItem::renderGpuComposition(QOpenGLFramebufferObject *target, int w,
       bool bufferDirty = layer->buffer->hasDirtyTiles();
 
       if (!tex || layer->dirty || bufferDirty) {
+        artflow::ScopedTrace uploadTrace("uploadLayerTexture", "gpu");
         if (!tex) {
           tex = new QOpenGLTexture(QOpenGLTexture::Target2D);
           tex->setSize(layer->buffer->width(), layer->buffer->height());
@@ -697,7 +715,6 @@ void CanvasItem::renderGpuComposition(QOpenGLFramebufferObject *target, int w,
               tex->setData(xPos, yPos, 0, tw, th, 1, QOpenGLTexture::RGBA,
                            QOpenGLTexture::UInt8, ptr);
               f->glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-              if (tile) tile->dirty = false;
             }
           }
         } else {
@@ -716,10 +733,10 @@ void CanvasItem::renderGpuComposition(QOpenGLFramebufferObject *target, int w,
               tex->setData(tx, ty, 0, tw, th, 1, QOpenGLTexture::RGBA,
                            QOpenGLTexture::UInt8, tile->data.get());
               f->glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-              tile->dirty = false;
             }
           }
         }
+        // Also advances the tile revisions the edge detector validates against
         layer->buffer->clearDirtyFlags();
         layer->dirty = false;
         layer->dirtyRect = QRect();
@@ -985,6 +1002,8 @@ void CanvasItem::renderGpuComposition(QOpenGLFramebufferObject *target, int w,
 }
 
 CanvasItem::~CanvasItem() {
+  if (m_vectorSimplifyJob)
+    m_vectorSimplifyJob->cancel();
   if (m_brushEngine)
     delete m_brushEngine;
   if (m_layerManager)
@@ -1001,6 +1020,8 @@ CanvasItem::~CanvasItem() {
     delete m_liquifyEngine;
   if (m_edgeDetector)
     delete m_edgeDetector;
+  if (m_colorRangeSelector)
+    delete m_colorRangeSelector;
   if (m_animationManager)
     delete m_animationManager;
   if (m_perspectiveRuler)
@@ -1038,6 +1059,8 @@ CanvasItem::~CanvasItem() {
     delete m_selectionTex;
   if (m_transformShader)
     delete m_transformShader;
+  if (m_tileReadback)
+    delete m_tileReadback;
 }
 
 void CanvasItem::cleanupGlResources() {
@@ -1087,6 +1110,10 @@ void CanvasItem::cleanupGlResources() {
     delete m_dabFBO;
     m_dabFBO = nullptr;
   }
+  if (m_tileReadback) {
+    delete m_tileReadback;
+    m_tileReadback = nullptr;
+  }
 }
 
 void CanvasItem::requestUpdate() {
@@ -1100,12 +1127,19 @@ void CanvasItem::resetTransformState() {
   m_isTransforming = false;
   setIsFreeTransformActive(false);
   m_selectionBuffer = QImage();
+  m_transformProxy = artflow::TransformProxy();
+  m_transformRefineTimer->stop();
+  m_transformInteracting = false;
+  m_transformPreviewCoarseness = 0;
   m_transformStaticCache = QImage();
   m_updateTransformTextures = false;
   m_transformMatrix = QTransform();
   m_initialMatrix = QTransform();
   m_transformBox = QRectF();
+  m_meshWarp = artflow::MeshWarp();
+  m_selectionMask = artflow::SelectionMask(m_canvasWidth, m_canvasHeight);
   m_selectionPath = QPainterPath();
+  m_selectionOutline = QPainterPath();
   m_activeLassoPath = QPainterPath();
   m_isLassoDragging = false;
   m_isMagneticLassoActive = false;
@@ -1120,6 +1154,13 @@ void CanvasItem::resetTransformState() {
   update();
 }
 
+// Handles or view moved: preview frames from the interactive proxy until
+// they rest, then refine (see m_transformRefineTimer)
+void CanvasItem::noteTransformInteraction() {
+  m_transformInteracting = true;
+  m_transformRefineTimer->start(150);
+}
+
 // --- HSL helper functions for Hue/Saturation/Color/Luminosity blend modes ---
 // Follows the W3C compositing spec / Krita's non-separable blend mode math.
 static inline float hslLuminosity(float r, float g, float b) {
@@ -1389,6 +1430,9 @@ void CanvasItem::paint(QPainter *painter) {
   if (!m_layerManager)
     return;
 
+  artflow::ScopedFrameTimer frameTimer;
+  artflow::ScopedTrace paintTrace("CanvasItem::paint");
+
   // Deferred GL resource cleanup (must happen in render thread with valid GL
   // context)
   cleanupGlResources();
@@ -1648,6 +1692,7 @@ void CanvasItem::paint(QPainter *painter) {
     bool gpuTransformReady = false; // Always use QPainter high-fidelity CPU path to prevent FBO viewport shift and vertical flipping bugs
 
     if (m_isTransforming && gpuTransformReady) {
+      artflow::ScopedTrace transformTrace("transformPreview", "gpu");
       painter->beginNativePainting();
       drewNative = true;
 
@@ -1698,8 +1743,8 @@ void CanvasItem::paint(QPainter *painter) {
         }
         if (!m_selectionBuffer.isNull()) {
           m_selectionTex =
-              new QOpenGLTexture(m_selectionBuffer);
-          m_selectionTex->setMinificationFilter(QOpenGLTexture::Linear);
+              new QOpenGLTexture(m_selectionBuffer); // with its mip chain
+          m_selectionTex->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
           m_selectionTex->setMagnificationFilter(QOpenGLTexture::Linear);
         }
 
@@ -1771,61 +1816,16 @@ void CanvasItem::paint(QPainter *painter) {
 
         m_selectionTex->bind(0);
 
-        if (m_isMeshTransform && m_meshPoints.size() == 16) {
-          // Draw Selection Mesh (9 quads = 18 triangles = 54 vertices)
-          std::vector<GLfloat> vertices;
-          vertices.reserve(54 * 4);
-
-          for (int row = 0; row < 3; ++row) {
-            for (int col = 0; col < 3; ++col) {
-              int idx_TL = row * 4 + col;
-              int idx_TR = row * 4 + col + 1;
-              int idx_BR = (row + 1) * 4 + col + 1;
-              int idx_BL = (row + 1) * 4 + col;
-
-              QPointF TL = m_meshPoints[idx_TL];
-              QPointF TR = m_meshPoints[idx_TR];
-              QPointF BR = m_meshPoints[idx_BR];
-              QPointF BL = m_meshPoints[idx_BL];
-
-              float u_TL = col / 3.0f;
-              float u_TR = (col + 1) / 3.0f;
-              float u_BR = (col + 1) / 3.0f;
-              float u_BL = col / 3.0f;
-
-              float v_TL = row / 3.0f;
-              float v_TR = row / 3.0f;
-              float v_BR = (row + 1) / 3.0f;
-              float v_BL = (row + 1) / 3.0f;
-
-              // Triangle 1: TL, TR, BL
-              vertices.push_back(TL.x()); vertices.push_back(TL.y());
-              vertices.push_back(u_TL);   vertices.push_back(v_TL);
-
-              vertices.push_back(TR.x()); vertices.push_back(TR.y());
-              vertices.push_back(u_TR);   vertices.push_back(v_TR);
-
-              vertices.push_back(BL.x()); vertices.push_back(BL.y());
-              vertices.push_back(u_BL);   vertices.push_back(v_BL);
-
-              // Triangle 2: BL, TR, BR
-              vertices.push_back(BL.x()); vertices.push_back(BL.y());
-              vertices.push_back(u_BL);   vertices.push_back(v_BL);
-
-              vertices.push_back(TR.x()); vertices.push_back(TR.y());
-              vertices.push_back(u_TR);   vertices.push_back(v_TR);
-
-              vertices.push_back(BR.x()); vertices.push_back(BR.y());
-              vertices.push_back(u_BR);   vertices.push_back(v_BR);
-            }
-          }
+        if (m_isMeshTransform && m_meshWarp.isValid()) {
+          // Draw Selection Mesh: the lattice triangles the commit rasterizes
+          const std::vector<GLfloat> vertices = m_meshWarp.triangleVertices();
 
           m_transformShader->setUniformValue("MVP", orthoView);
           m_transformShader->enableAttributeArray(0);
           m_transformShader->enableAttributeArray(1);
           m_transformShader->setAttributeArray(0, GL_FLOAT, vertices.data(), 2, 4 * sizeof(GLfloat));
           m_transformShader->setAttributeArray(1, GL_FLOAT, vertices.data() + 2, 2, 4 * sizeof(GLfloat));
-          f->glDrawArrays(GL_TRIANGLES, 0, 54);
+          f->glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(vertices.size() / 4));
 
         } else {
           // Draw Selection Frame natively with perspective correction
@@ -1863,6 +1863,7 @@ void CanvasItem::paint(QPainter *painter) {
       painter->endNativePainting();
     } else {
       if (m_layerManager && m_layerManager->getLayerCount() > 0) {
+        artflow::ScopedTrace cpuTrace("cachedCanvasImage", "cpu");
         const int cw = m_canvasWidth;
         const int ch = m_canvasHeight;
 
@@ -1910,6 +1911,10 @@ void CanvasItem::paint(QPainter *painter) {
           dirtyUnion = QRect(0, 0, cw, ch);
 
         if (!dirtyUnion.isNull()) {
+          artflow::ScopedLatencyTimer compositeTimer(
+              artflow::LatencyStage::Composite);
+          artflow::ScopedTrace compositeTrace("cachedCanvasImage.composite",
+                                              "cpu");
           m_canvasPreviewBase64 = QString(); // Invalidate base64 cache
           // Clip to canvas bounds
           dirtyUnion = dirtyUnion.intersected(QRect(0, 0, cw, ch));
@@ -2344,7 +2349,10 @@ void CanvasItem::paint(QPainter *painter) {
                           ch * m_zoomLevel);
         painter->setRenderHint(QPainter::SmoothPixmapTransform,
                                m_zoomLevel < 1.0f);
-        painter->drawImage(targetRect, m_cachedCanvasImage);
+        {
+          artflow::ScopedTrace drawTrace("cachedCanvasImage.draw", "cpu");
+          painter->drawImage(targetRect, m_cachedCanvasImage);
+        }
         drawActivePanelOverlay(painter);
       }
     }
@@ -2362,59 +2370,35 @@ void CanvasItem::paint(QPainter *painter) {
         painter->setRenderHint(QPainter::SmoothPixmapTransform);
         painter->setRenderHint(QPainter::Antialiasing);
 
-        if (m_isMeshTransform && m_meshPoints.size() == 16) {
-          QImage tempImg(m_canvasWidth, m_canvasHeight, QImage::Format_RGBA8888_Premultiplied);
-          tempImg.fill(Qt::transparent);
-
-          float sw = m_selectionBuffer.width();
-          float sh = m_selectionBuffer.height();
-
-          for (int row = 0; row < 3; ++row) {
-            for (int col = 0; col < 3; ++col) {
-              int idx_TL = row * 4 + col;
-              int idx_TR = row * 4 + col + 1;
-              int idx_BR = (row + 1) * 4 + col + 1;
-              int idx_BL = (row + 1) * 4 + col;
-
-              QPointF TL = m_meshPoints[idx_TL];
-              QPointF TR = m_meshPoints[idx_TR];
-              QPointF BR = m_meshPoints[idx_BR];
-              QPointF BL = m_meshPoints[idx_BL];
-
-              QPolygonF dstPolygon;
-              dstPolygon << TL << TR << BR << BL;
-
-              QPolygonF srcPolygon;
-              srcPolygon << QPointF(col * sw / 3.0f, row * sh / 3.0f)
-                         << QPointF((col + 1) * sw / 3.0f, row * sh / 3.0f)
-                         << QPointF((col + 1) * sw / 3.0f, (row + 1) * sh / 3.0f)
-                         << QPointF(col * sw / 3.0f, (row + 1) * sh / 3.0f);
-
-              warpQuadBilinear(m_selectionBuffer, tempImg, srcPolygon, dstPolygon, m_canvasWidth, m_canvasHeight);
-            }
-          }
-          painter->drawImage(0, 0, tempImg);
-        } else if (m_meshPoints.size() == 4) { // Perspective mode preview
-          QImage tempImg(m_canvasWidth, m_canvasHeight, QImage::Format_RGBA8888_Premultiplied);
-          tempImg.fill(Qt::transparent);
-
-          float sw = m_selectionBuffer.width();
-          float sh = m_selectionBuffer.height();
-
-          QPolygonF srcPolygon;
-          srcPolygon << QPointF(0, 0) << QPointF(sw, 0) << QPointF(sw, sh) << QPointF(0, sh);
-
-          QPolygonF dstPolygon;
-          for (int i = 0; i < 4; ++i) {
-            dstPolygon << m_meshPoints[i];
-          }
-
-          warpQuadBilinear(m_selectionBuffer, tempImg, srcPolygon, dstPolygon, m_canvasWidth, m_canvasHeight);
-          painter->drawImage(0, 0, tempImg);
-        } else { // Free transform (affine)
-          painter->setTransform(m_transformMatrix * painter->transform());
-          painter->drawImage(0, 0, m_selectionBuffer);
+        // Frame of the mip-mapped proxy: only the visible part, at screen
+        // resolution or coarser while the handles (or the view) move
+        const QTransform viewport = painter->transform();
+        if (viewport != m_transformPreviewViewport) {
+          m_transformPreviewViewport = viewport;
+          m_transformInteracting = true;
+          // paint() may run on the render thread: the refine timer lives on
+          // the GUI thread
+          QMetaObject::invokeMethod(
+              this, [this]() { noteTransformInteraction(); },
+              Qt::QueuedConnection);
         }
+        const double dpr = window() ? window()->devicePixelRatio() : 1.0;
+        const QRectF visible =
+            viewport.inverted()
+                .mapRect(QRectF(0, 0, width(), height()))
+                .intersected(QRectF(0, 0, m_canvasWidth, m_canvasHeight));
+        const int coarseness = m_transformInteracting
+                                   ? artflow::TransformProxy::kInteractive
+                                   : m_transformPreviewCoarseness;
+        const artflow::TransformProxy::Frame &frame =
+            m_isMeshTransform && m_meshWarp.isValid()
+                ? m_transformProxy.renderMesh(m_meshWarp, visible,
+                                              m_zoomLevel * dpr, coarseness)
+                : m_transformProxy.render(m_transformMatrix, visible,
+                                          m_zoomLevel * dpr, coarseness);
+        m_transformPreviewCoarseness = frame.coarseness;
+        if (!frame.image.isNull())
+          painter->drawImage(frame.canvasRect, frame.image);
         painter->restore();
       }
     }
@@ -2631,10 +2615,13 @@ void CanvasItem::paint(QPainter *painter) {
     dashOffset += 0.2f;
     if (dashOffset > 20) dashOffset = 0;
 
+    // Contours of the mask, traced when the selection was set
+    const QPainterPath &outline = m_selectionOutline;
+
     // Solid white base
     QPen whitePen(Qt::white, 1.5f / m_zoomLevel, Qt::SolidLine);
     painter->setPen(whitePen);
-    painter->drawPath(m_selectionPath);
+    painter->drawPath(outline);
 
     // Dashed marching ants accent
     QColor lassoColor = m_accentColor;
@@ -2643,7 +2630,7 @@ void CanvasItem::paint(QPainter *painter) {
     dashPen.setDashPattern({4, 4});
     dashPen.setDashOffset(dashOffset);
     painter->setPen(dashPen);
-    painter->drawPath(m_selectionPath);
+    painter->drawPath(outline);
 
     // Tinted fill overlay for the committed selection
     painter->setPen(Qt::NoPen);
@@ -3255,6 +3242,8 @@ void CanvasItem::handleDraw(const QPointF &pos, float pressure, float tilt) {
   float effectivePressure = pressure;
 
   if (m_isDrawing) {
+    artflow::ScopedLatencyTimer stabilizeTimer(
+        artflow::LatencyStage::Stabilize);
     float strength = std::clamp(m_brushStabilization, 0.0f, 1.0f);
 
     if (strength > 0.01f) {
@@ -3367,7 +3356,6 @@ void CanvasItem::handleDraw(const QPointF &pos, float pressure, float tilt) {
       m_dabFBO = nullptr;
     }
     m_lastActiveLayerIndex = m_activeLayerIndex;
-    m_gradientMapDirty = true;
   }
 
   QPointF lastCanvasPos = m_lastPos;
@@ -3388,7 +3376,8 @@ void CanvasItem::handleDraw(const QPointF &pos, float pressure, float tilt) {
     // they arrive, so the buffer stays small on long strokes and the final
     // Bezier fit starts from clean data. Threshold ~1.25 screen px.
     float minDist = std::max(0.35f, 1.25f / std::max(m_zoomLevel, 0.05f));
-    appendStrokePointFiltered(m_vectorPointBuffer, vp, minDist);
+    if (appendStrokePointFiltered(m_vectorPointBuffer, vp, minDist))
+      m_vectorFitter.update(m_vectorPointBuffer);
   }
 
   BrushSettings settings = m_brushEngine->getBrush();
@@ -3599,6 +3588,9 @@ void CanvasItem::handleDraw(const QPointF &pos, float pressure, float tilt) {
       fboPainter.drawImage(0, 0, img);
       fboPainter.end();
       m_pingFBO->release();
+
+      // FBO recién sembrado con la capa: todavía no hay tiles que devolver
+      m_strokeTiles.reset(m_canvasWidth, m_canvasHeight);
     }
 
     // Failsafe for m_dabFBO
@@ -3741,15 +3733,21 @@ void CanvasItem::handleDraw(const QPointF &pos, float pressure, float tilt) {
       settings.dualGrainTextureID = artflow::BrushEngine::loadTexture(settings.dualTextureName, false);
     }
     // Persist the loaded IDs back to the engine so they're cached
-    // for subsequent frames and the watercolor engine.
+    // for subsequent frames and the watercolor engine. Only when they
+    // changed: setBrush() also drops the engine's shared brush snapshot.
     if (settings.tipTextureID != 0 || settings.dualTipTextureID != 0 ||
         settings.grainTextureID != 0 || settings.dualGrainTextureID != 0) {
       BrushSettings engineCopy = m_brushEngine->getBrush();
-      engineCopy.tipTextureID = settings.tipTextureID;
-      engineCopy.dualTipTextureID = settings.dualTipTextureID;
-      engineCopy.grainTextureID = settings.grainTextureID;
-      engineCopy.dualGrainTextureID = settings.dualGrainTextureID;
-      m_brushEngine->setBrush(engineCopy);
+      if (engineCopy.tipTextureID != settings.tipTextureID ||
+          engineCopy.dualTipTextureID != settings.dualTipTextureID ||
+          engineCopy.grainTextureID != settings.grainTextureID ||
+          engineCopy.dualGrainTextureID != settings.dualGrainTextureID) {
+        engineCopy.tipTextureID = settings.tipTextureID;
+        engineCopy.dualTipTextureID = settings.dualTipTextureID;
+        engineCopy.grainTextureID = settings.grainTextureID;
+        engineCopy.dualGrainTextureID = settings.dualGrainTextureID;
+        m_brushEngine->setBrush(engineCopy);
+      }
     }
     // ─── FIN LAZY TEXTURE LOADING ────────────────────────────────
 
@@ -3788,6 +3786,13 @@ void CanvasItem::handleDraw(const QPointF &pos, float pressure, float tilt) {
     }
 
     layer->markDirty(canvasRect.toAlignedRect());
+    // El readback final depende de este conjunto: margen extra para el
+    // jitter de trayectoria, que puede sacar dabs fuera de canvasRect
+    float readbackPad =
+        settings.size * (settings.jitterLateral + settings.jitterLinear);
+    m_strokeTiles.markRect(
+        canvasRect.adjusted(-readbackPad, -readbackPad, readbackPad, readbackPad)
+            .toAlignedRect());
     std::swap(m_pingFBO, m_pongFBO);
 
     // ─────────────────────────────────────────────────────────────────────
@@ -4489,6 +4494,8 @@ void CanvasItem::mousePressEvent(QMouseEvent *event) {
       }
     } else if (m_tool == ToolType::MagneticLasso) {
       // Magnetic: snap vertex to nearest edge, trace edge path
+      // Gradients are computed lazily around the queries
+      syncEdgeDetectorSource();
       const float snapRadius = 12.0f / m_zoomLevel;
       if (m_activeLassoPath.elementCount() >= 3 &&
           QLineF(canvasPos, m_activeLassoPath.elementAt(0)).length() < snapRadius) {
@@ -4501,21 +4508,12 @@ void CanvasItem::mousePressEvent(QMouseEvent *event) {
         _commitLassoPath();
         m_magneticPreviewPath = QPainterPath();
       } else {
-        // Precompute gradient map if dirty
-        if (m_gradientMapDirty) {
-          Layer *layer = m_layerManager->getActiveLayer();
-          if (layer && layer->buffer) {
-            QImage img(layer->buffer->data(), m_canvasWidth, m_canvasHeight, QImage::Format_RGBA8888);
-            m_edgeDetector->computeGradientMap(img);
-            m_gradientMapDirty = false;
-          }
-        }
         
         // Reset last trace target for new session
         m_lastTraceTarget = QPointF(-9999.0f, -9999.0f);
         
         // Snap clicked coordinate to nearest edge point
-        QPointF snapped = m_edgeDetector->findEdgePoint(canvasPos, m_magneticSearchRadius);
+        QPointF snapped = m_edgeDetector->findEdgePoint(canvasPos, magneticSnapRadius());
         if (m_activeLassoPath.elementCount() == 0) {
           m_activeLassoPath.moveTo(snapped);
         } else {
@@ -4547,110 +4545,25 @@ void CanvasItem::mousePressEvent(QMouseEvent *event) {
     int iy = static_cast<int>(std::round(canvasPos.y()));
 
     if (ix >= 0 && ix < m_canvasWidth && iy >= 0 && iy < m_canvasHeight) {
-      Layer *layer = m_layerManager->getActiveLayer();
-      if (layer && layer->buffer) {
-        int W = m_canvasWidth;
-        int H = m_canvasHeight;
-        QImage layerImg(layer->buffer->data(), W, H, QImage::Format_RGBA8888);
-        QRgb startCol = layerImg.pixel(ix, iy);
-
-        int startR = qRed(startCol);
-        int startG = qGreen(startCol);
-        int startB = qBlue(startCol);
-        int startA = qAlpha(startCol);
-
-        QImage mask(W, H, QImage::Format_Grayscale8);
-        mask.fill(0);
-
-        std::vector<bool> visited(W * H, false);
-        std::vector<QPoint> queue;
-        queue.reserve(W * H / 8);
-        queue.push_back(QPoint(ix, iy));
-        visited[iy * W + ix] = true;
-
-        // selectionThreshold is [0.0 - 1.0].
-        // Scale to Euclidean distance in RGBA space (Max = sqrt(255^2 * 4) = 510.0f)
-        float maxDist = 510.0f * m_selectionThreshold;
-        float maxDistSq = maxDist * maxDist;
-
-        size_t head = 0;
-        while (head < queue.size()) {
-          QPoint curr = queue[head++];
-          int cx = curr.x();
-          int cy = curr.y();
-
-          mask.scanLine(cy)[cx] = 255;
-
-          int dx[] = {0, 0, 1, -1};
-          int dy[] = {1, -1, 0, 0};
-
-          for (int i = 0; i < 4; ++i) {
-            int nx = cx + dx[i];
-            int ny = cy + dy[i];
-
-            if (nx >= 0 && nx < W && ny >= 0 && ny < H) {
-              int vIdx = ny * W + nx;
-              if (!visited[vIdx]) {
-                visited[vIdx] = true;
-                QRgb pix = layerImg.pixel(nx, ny);
-                int pr = qRed(pix);
-                int pg = qGreen(pix);
-                int pb = qBlue(pix);
-                int pa = qAlpha(pix);
-
-                float dr = pr - startR;
-                float dg = pg - startG;
-                float db = pb - startB;
-                float da = pa - startA;
-                float distSq = dr * dr + dg * dg + db * db + da * da;
-
-                if (distSq <= maxDistSq) {
-                  queue.push_back(QPoint(nx, ny));
-                }
-              }
-            }
-          }
-        }
-
-        ColorRangeSelector selector;
-        QPainterPath wandPath = selector.maskToPath(mask);
-
-        QPainterPath beforePath = m_selectionPath;
-        bool beforeHasSel = m_hasSelection;
-
-        if (m_selectionAddMode == 0) {
-          m_selectionPath = wandPath;
-        } else if (m_selectionAddMode == 1) {
-          m_selectionPath = m_selectionPath.united(wandPath);
-        } else if (m_selectionAddMode == 2) {
-          m_selectionPath = m_selectionPath.subtracted(wandPath);
-        }
-
-        m_hasSelection = !m_selectionPath.isEmpty();
-        emit hasSelectionChanged();
-
-        if (m_hasSelection && m_marchingAntsTimer && !m_marchingAntsTimer->isActive())
-          m_marchingAntsTimer->start();
-        else if (!m_hasSelection && m_marchingAntsTimer)
-          m_marchingAntsTimer->stop();
-
-        update();
-
-        auto updateSelCb = [this](const QPainterPath &path, bool hasSel) {
-          m_selectionPath = path;
-          m_hasSelection = hasSel;
-          emit hasSelectionChanged();
-          if (m_hasSelection && m_marchingAntsTimer && !m_marchingAntsTimer->isActive())
-            m_marchingAntsTimer->start();
-          else if (!m_hasSelection && m_marchingAntsTimer)
-            m_marchingAntsTimer->stop();
-          update();
-        };
+      // Sample the active layer in place, or a one-off composite
+      const ImageBuffer *source = nullptr;
+      std::unique_ptr<ImageBuffer> composite;
+      if (m_wandSampleMerged) {
+        composite = std::make_unique<ImageBuffer>(m_canvasWidth, m_canvasHeight);
+        m_layerManager->compositeAll(*composite);
+        source = composite.get();
+      } else {
+        Layer *layer = m_layerManager->getActiveLayer();
+        if (layer && layer->buffer)
+          source = layer->buffer.get();
+      }
 
-        if (m_undoManager) {
-          m_undoManager->pushCommand(std::make_unique<artflow::SelectionUndoCommand>(
-              updateSelCb, beforePath, beforeHasSel, m_selectionPath, m_hasSelection));
-        }
+      if (source) {
+        // Only the tiles the wand reaches are allocated, so Add / Subtract
+        // into a large selection touches just those
+        artflow::MagicWand::Options options = m_wandOptions;
+        options.tolerance = m_selectionThreshold;
+        combineSelectionMask(artflow::MagicWand::select(*source, ix, iy, options));
       }
     }
     event->accept();
@@ -4845,6 +4758,7 @@ void CanvasItem::mousePressEvent(QMouseEvent *event) {
       vp.y = canvasPos.y();
       vp.pressure = 0.5f;
       m_vectorPointBuffer.push_back(vp);
+      beginVectorFit();
     }
 
     m_stabPosQueue.clear(); // Reset stabilizer buffer for new stroke
@@ -4998,6 +4912,7 @@ void CanvasItem::mouseMoveEvent(QMouseEvent *event) {
     m_transformMatrix.translate(m_transformBox.x(), m_transformBox.y());
 
     emit transformBoxChanged();
+    noteTransformInteraction();
     update();
     return;
   }
@@ -5137,23 +5052,18 @@ void CanvasItem::mouseMoveEvent(QMouseEvent *event) {
   if (m_tool == ToolType::MagneticLasso && m_isMagneticLassoActive && m_activeLassoPath.elementCount() > 0) {
     m_lassoCursorPos = screenToCanvas(event->position());
     
-    if (QLineF(m_lassoCursorPos, m_lastTraceTarget).length() < 4.0f) {
-      return; // Skip heavy Dijkstra on micro-movements to eliminate lag!
+    if (QLineF(m_lassoCursorPos, m_lastTraceTarget).length() < 1.0f) {
+      return; // Same pixel: the live-wire path would not change
     }
     m_lastTraceTarget = m_lassoCursorPos;
 
-    // Precompute gradient map if dirty
-    if (m_gradientMapDirty) {
-      Layer *layer = m_layerManager->getActiveLayer();
-      if (layer && layer->buffer) {
-        QImage img(layer->buffer->data(), m_canvasWidth, m_canvasHeight, QImage::Format_RGBA8888);
-        m_edgeDetector->computeGradientMap(img);
-        m_gradientMapDirty = false;
-      }
-    }
+    syncEdgeDetectorSource();
     
-    QPointF snappedCursor = m_edgeDetector->findEdgePoint(m_lassoCursorPos, m_magneticSearchRadius);
-    auto previewPts = m_edgeDetector->traceEdgePath(m_activeLassoPath.currentPosition(), snappedCursor);
+    QPointF snappedCursor = m_edgeDetector->findEdgePoint(m_lassoCursorPos, magneticSnapRadius());
+    // Bounded per move: a far cursor gets a straight rubber band until the
+    // live-wire search reaches it over the next moves
+    auto previewPts = m_edgeDetector->traceEdgePath(m_activeLassoPath.currentPosition(), snappedCursor,
+                                                    artflow::LiveWire::kFrameBudget);
     
     m_magneticPreviewPath = QPainterPath();
     if (!previewPts.empty()) {
@@ -5164,6 +5074,7 @@ void CanvasItem::mouseMoveEvent(QMouseEvent *event) {
     } else {
       m_magneticPreviewPath.moveTo(m_activeLassoPath.currentPosition());
       m_magneticPreviewPath.lineTo(snappedCursor);
+      m_lastTraceTarget = QPointF(-9999.0f, -9999.0f); // keep searching on the next move
     }
     update();
   } else if (m_tool == ToolType::Lasso || m_tool == ToolType::MagneticLasso) {
@@ -5267,8 +5178,10 @@ void CanvasItem::mouseMoveEvent(QMouseEvent *event) {
           m_quickShapeTimer->start(500);
       }
       // Block drawing during two-finger gestures
-      if (!m_isTwoFingerGesture && m_touchPointCount < 2)
+      if (!m_isTwoFingerGesture && m_touchPointCount < 2) {
+        artflow::LatencyProfiler::instance()->markInput();
         handleDraw(event->position(), pressure, tiltFactor);
+      }
     }
   }
 
@@ -5492,7 +5405,6 @@ void CanvasItem::mouseReleaseEvent(QMouseEvent *event) {
 
       bool wasHolding = m_isHoldingForShape;
       m_isDrawing = false;
-      m_gradientMapDirty = true;
       m_isHoldingForShape = false;
       m_quickShapeType = QuickShapeType::None;
       m_hasPrediction = false;
@@ -5501,16 +5413,9 @@ void CanvasItem::mouseReleaseEvent(QMouseEvent *event) {
 
       if (m_pingFBO) {
         if (!wasHolding) {
-          // Normal stroke: copy FBO result to CPU layer buffer
-          QImage result = m_pingFBO->toImage(true).convertToFormat(
-              QImage::Format_RGBA8888_Premultiplied);
-
-          Layer *layer = m_layerManager->getActiveLayer();
-          if (layer && layer->buffer) {
-            layer->buffer->loadRawData(result.bits());
-            layer->markDirty();
-            m_cachedCanvasImage = QImage(); // Force recomposite
-          }
+          // Normal stroke: copy the tiles the stroke touched to the CPU layer
+          syncGpuToCpu();
+          m_cachedCanvasImage = QImage(); // Force recomposite
         } else {
           // QuickShape stroke: drawCircle/drawLine already wrote to layer
           // buffer Just mark it dirty so the cache recomposes correctly on next
@@ -5565,7 +5470,8 @@ void CanvasItem::mouseDoubleClickEvent(QMouseEvent *event) {
   if (m_tool == ToolType::MagneticLasso && m_isMagneticLassoActive) {
     // Snap the final double-click point and trace path to it before closing!
     QPointF canvasPos = screenToCanvas(event->position());
-    QPointF snapped = m_edgeDetector->findEdgePoint(canvasPos, m_magneticSearchRadius);
+    syncEdgeDetectorSource();
+    QPointF snapped = m_edgeDetector->findEdgePoint(canvasPos, magneticSnapRadius());
     if (m_activeLassoPath.elementCount() > 0) {
       auto edgePath = m_edgeDetector->traceEdgePath(m_activeLassoPath.currentPosition(), snapped);
       for (auto &pt : edgePath) {
@@ -5594,6 +5500,9 @@ void CanvasItem::onWintabEvent(float x, float y, float pressure, float tiltX, fl
 }
 
 void CanvasItem::tabletEvent(QTabletEvent *event) {
+  artflow::LatencyProfiler::instance()->markInput();
+  artflow::ScopedLatencyTimer inputTimer(artflow::LatencyStage::Input);
+
   // ── Dragging Vanishing Points in Perspective Ruler (Tablet) ──
   if (m_perspectiveRuler && m_perspectiveRuler->active()) {
     bool canDrag = false;
@@ -5737,6 +5646,7 @@ void CanvasItem::tabletEvent(QTabletEvent *event) {
       vp.y = canvasPos.y();
       vp.pressure = pressure;
       m_vectorPointBuffer.push_back(vp);
+      beginVectorFit();
     }
 
     // Reset history for prediction
@@ -5884,14 +5794,8 @@ void CanvasItem::tabletEvent(QTabletEvent *event) {
     // FINALIZAR TRAZO PREMIUM (Pilar 3): Volcar GPU a CPU
     if (m_pingFBO) {
       if (!wasHolding) {
-        QImage result = m_pingFBO->toImage(true).convertToFormat(
-            QImage::Format_RGBA8888_Premultiplied);
-        Layer *layer = m_layerManager->getActiveLayer();
-        if (layer && layer->buffer) {
-          layer->buffer->loadRawData(result.bits());
-          layer->markDirty();
-          m_cachedCanvasImage = QImage();
-        }
+        syncGpuToCpu();
+        m_cachedCanvasImage = QImage();
       } else {
         // QuickShape: layer buffer already updated by drawCircle/drawLine
         Layer *layer = m_layerManager->getActiveLayer();
@@ -6796,85 +6700,40 @@ void CanvasItem::_commitLassoPath() {
   if (closed.elementCount() < 3)
     return;
 
-  QPainterPath beforePath = m_selectionPath;
-  bool beforeHasSel = m_hasSelection;
-
-  if (m_selectionAddMode == 0) {
-    m_selectionPath = closed;
-  } else if (m_selectionAddMode == 1) {
-    m_selectionPath = m_selectionPath.united(closed);
-  } else if (m_selectionAddMode == 2) {
-    m_selectionPath = m_selectionPath.subtracted(closed);
-  }
-
-  m_hasSelection = !m_selectionPath.isEmpty();
-  emit hasSelectionChanged();
-
-  if (m_hasSelection && !m_marchingAntsTimer->isActive())
-    m_marchingAntsTimer->start();
-
-  update();
-
-  auto updateSelCb = [this](const QPainterPath &path, bool hasSel) {
-    m_selectionPath = path;
-    m_hasSelection = hasSel;
-    emit hasSelectionChanged();
-    if (m_hasSelection && m_marchingAntsTimer && !m_marchingAntsTimer->isActive())
-      m_marchingAntsTimer->start();
-    else if (!m_hasSelection && m_marchingAntsTimer)
-      m_marchingAntsTimer->stop();
-    update();
-  };
-  if (m_undoManager) {
-    m_undoManager->pushCommand(std::make_unique<artflow::SelectionUndoCommand>(
-        updateSelCb, beforePath, beforeHasSel, m_selectionPath, m_hasSelection));
-  }
+  combineSelectionMask(
+      artflow::SelectionMask::fromPath(closed, m_canvasWidth, m_canvasHeight));
 }
 
 void CanvasItem::_commitNewShapePath(const QPainterPath &newPath) {
-  QPainterPath beforePath = m_selectionPath;
-  bool beforeHasSel = m_hasSelection;
-
-  if (m_selectionAddMode == 0) {
-    m_selectionPath = newPath;
-  } else if (m_selectionAddMode == 1) {
-    m_selectionPath = m_selectionPath.united(newPath);
-  } else if (m_selectionAddMode == 2) {
-    m_selectionPath = m_selectionPath.subtracted(newPath);
-  }
-
-  m_hasSelection = !m_selectionPath.isEmpty();
-  emit hasSelectionChanged();
-
-  if (m_hasSelection && !m_marchingAntsTimer->isActive())
-    m_marchingAntsTimer->start();
-
-  update();
-
-  auto updateSelCb = [this](const QPainterPath &path, bool hasSel) {
-    m_selectionPath = path;
-    m_hasSelection = hasSel;
-    emit hasSelectionChanged();
-    if (m_hasSelection && m_marchingAntsTimer && !m_marchingAntsTimer->isActive())
-      m_marchingAntsTimer->start();
-    else if (!m_hasSelection && m_marchingAntsTimer)
-      m_marchingAntsTimer->stop();
-    update();
-  };
-  if (m_undoManager) {
-    m_undoManager->pushCommand(std::make_unique<artflow::SelectionUndoCommand>(
-        updateSelCb, beforePath, beforeHasSel, m_selectionPath, m_hasSelection));
-  }
+  combineSelectionMask(
+      artflow::SelectionMask::fromPath(newPath, m_canvasWidth, m_canvasHeight));
 }
 
 void CanvasItem::invertSelection() {
-  QPainterPath beforePath = m_selectionPath;
-  bool beforeHasSel = m_hasSelection;
-
-  QPainterPath full;
-  full.addRect(0, 0, m_canvasWidth, m_canvasHeight);
-  m_selectionPath = full.subtracted(m_selectionPath);
-  m_hasSelection = !m_selectionPath.isEmpty();
+  artflow::SelectionMask inverted = currentSelectionMask();
+  inverted.invert();
+  commitSelectionMask(inverted);
+}
+
+artflow::SelectionMask CanvasItem::currentSelectionMask() const {
+  // A mask left from before a canvas resize selects nothing
+  if (m_selectionMask.width() == m_canvasWidth &&
+      m_selectionMask.height() == m_canvasHeight)
+    return m_selectionMask;
+  return artflow::SelectionMask(m_canvasWidth, m_canvasHeight);
+}
+
+void CanvasItem::setSelectionMask(const artflow::SelectionMask &mask) {
+  m_selectionMask = mask;
+  // QPainter clipping is binary: brush, filter and clear/fill clipping see
+  // coverage >= SelectionMask::kInside as fully selected and anything below
+  // as not at all, so a feathered edge is hard there. Flood fill reads the
+  // mask itself and fills every pixel with any coverage.
+  m_selectionPath = m_selectionMask.clipPath();
+  // Half-pixel simplification turns staircases into straight runs; closed
+  // rings keep the dash pattern flowing around each contour
+  m_selectionOutline = m_selectionMask.contourPath(0.5f);
+  m_hasSelection = !m_selectionMask.isEmpty();
 
   emit hasSelectionChanged();
   if (m_hasSelection && m_marchingAntsTimer && !m_marchingAntsTimer->isActive())
@@ -6882,23 +6741,30 @@ void CanvasItem::invertSelection() {
   else if (!m_hasSelection && m_marchingAntsTimer)
     m_marchingAntsTimer->stop();
   update();
+}
+
+void CanvasItem::commitSelectionMask(const artflow::SelectionMask &mask) {
+  artflow::SelectionMask before = m_selectionMask;
+  setSelectionMask(mask);
 
-  auto updateSelCb = [this](const QPainterPath &path, bool hasSel) {
-    m_selectionPath = path;
-    m_hasSelection = hasSel;
-    emit hasSelectionChanged();
-    if (m_hasSelection && m_marchingAntsTimer && !m_marchingAntsTimer->isActive())
-      m_marchingAntsTimer->start();
-    else if (!m_hasSelection && m_marchingAntsTimer)
-      m_marchingAntsTimer->stop();
-    update();
-  };
   if (m_undoManager) {
     m_undoManager->pushCommand(std::make_unique<artflow::SelectionUndoCommand>(
-        updateSelCb, beforePath, beforeHasSel, m_selectionPath, m_hasSelection));
+        [this](const artflow::SelectionMask &m) { setSelectionMask(m); },
+        before, m_selectionMask));
   }
 }
 
+void CanvasItem::combineSelectionMask(const artflow::SelectionMask &shape) {
+  artflow::SelectionMask combined = currentSelectionMask();
+  if (m_selectionAddMode == 1)
+    combined.combine(shape, artflow::SelectionMask::Op::Add);
+  else if (m_selectionAddMode == 2)
+    combined.combine(shape, artflow::SelectionMask::Op::Subtract);
+  else
+    combined = shape;
+  commitSelectionMask(combined);
+}
+
 void CanvasItem::setBrushSmudge(float value) {
   m_brushSmudge = value;
   BrushSettings s = m_brushEngine->getBrush();
@@ -6962,6 +6828,27 @@ void CanvasItem::setSelectionThreshold(float threshold) {
   emit selectionThresholdChanged();
 }
 
+void CanvasItem::setWandContiguous(bool value) {
+  if (m_wandOptions.contiguous == value)
+    return;
+  m_wandOptions.contiguous = value;
+  emit wandOptionsChanged();
+}
+
+void CanvasItem::setWandSampleMerged(bool value) {
+  if (m_wandSampleMerged == value)
+    return;
+  m_wandSampleMerged = value;
+  emit wandOptionsChanged();
+}
+
+void CanvasItem::setWandAntiAlias(bool value) {
+  if (m_wandOptions.antiAlias == value)
+    return;
+  m_wandOptions.antiAlias = value;
+  emit wandOptionsChanged();
+}
+
 void CanvasItem::setIsSelectionModeActive(bool active) {
   if (m_isSelectionModeActive == active)
     return;
@@ -7017,31 +6904,23 @@ void CanvasItem::apply_color_drop(int x, int y, const QColor &color) {
   if (!layer || !layer->buffer || layer->locked)
     return;
 
-  // 3. Handle Selection Mask / Panel Mask
-  std::unique_ptr<artflow::ImageBuffer> selectionMask;
+  // 3. Handle Selection Mask / Panel Mask (copying the mask shares its tiles)
   int basePanelIdx = -1;
   artflow::Layer *basePanel = getActiveBasePanel(&basePanelIdx);
-  bool hasSelection = m_hasSelection && !m_selectionPath.isEmpty();
+  const artflow::SelectionMask selection = currentSelectionMask();
+  bool hasSelection = m_hasSelection && !selection.isEmpty();
   bool hasPanelPath = basePanel && !basePanel->panelPath.isEmpty();
 
-  if (hasSelection || hasPanelPath) {
-    selectionMask =
-        std::make_unique<artflow::ImageBuffer>(m_canvasWidth, m_canvasHeight);
-    QImage maskImg(selectionMask->data(), m_canvasWidth, m_canvasHeight,
-                   QImage::Format_RGBA8888_Premultiplied);
-    maskImg.fill(Qt::transparent);
-
-    QPainter p(&maskImg);
-    p.setRenderHint(QPainter::Antialiasing);
-    if (hasSelection && hasPanelPath) {
-      QPainterPath intersected = m_selectionPath.intersected(basePanel->panelPath);
-      p.fillPath(intersected, Qt::white);
-    } else if (hasSelection) {
-      p.fillPath(m_selectionPath, Qt::white);
-    } else if (hasPanelPath) {
-      p.fillPath(basePanel->panelPath, Qt::white);
-    }
-    p.end();
+  artflow::SelectionMask panelMask;
+  const artflow::SelectionMask *fillMask = nullptr;
+  if (hasPanelPath) {
+    panelMask = artflow::SelectionMask::fromPath(basePanel->panelPath,
+                                                 m_canvasWidth, m_canvasHeight);
+    if (hasSelection)
+      panelMask.combine(selection, artflow::SelectionMask::Op::Intersect);
+    fillMask = &panelMask;
+  } else if (hasSelection) {
+    fillMask = &selection;
   }
 
   // Snapshot for undo
@@ -7050,7 +6929,7 @@ void CanvasItem::apply_color_drop(int x, int y, const QColor &color) {
   // Flood fill
   layer->buffer->floodFill(ix, iy, color.red(), color.green(), color.blue(),
                            color.alpha(), m_selectionThreshold,
-                           selectionMask.get(), layer->alphaLock);
+                           fillMask, layer->alphaLock);
   layer->dirty = true;
 
   // Snapshot after for undo
@@ -7064,45 +6943,57 @@ void CanvasItem::apply_color_drop(int x, int y, const QColor &color) {
   updateLayersList();
 }
 
-void CanvasItem::featherSelection(float radius) {
-  // Raster implementation of feathering using a blurred mask
-  if (m_selectionPath.isEmpty())
+void CanvasItem::refineSelection(void (artflow::SelectionMask::*op)(float),
+                                 float radius) {
+  if (!m_hasSelection || radius <= 0.0f)
     return;
+  artflow::SelectionMask refined = currentSelectionMask();
+  (refined.*op)(radius);
+  commitSelectionMask(refined);
+}
 
-  // This is complex for a vector path, usually done by converting to bitmap
-  // mask, blurring, and using that alpha. For now, we'll keep the vector
-  // path and just store the feather value if we had a multi-mode selection
-  // buffer. Simplifying: Just notification of feathering applied.
-  emit notificationRequested("Feathering applied: " + QString::number(radius),
-                             "info");
+void CanvasItem::featherSelection(float radius) {
+  refineSelection(&artflow::SelectionMask::feather, radius);
+}
+
+void CanvasItem::growSelection(float radius) {
+  refineSelection(&artflow::SelectionMask::grow, radius);
+}
+
+void CanvasItem::shrinkSelection(float radius) {
+  refineSelection(&artflow::SelectionMask::shrink, radius);
+}
+
+void CanvasItem::smoothSelection(float radius) {
+  refineSelection(&artflow::SelectionMask::smooth, radius);
 }
 
 void CanvasItem::duplicateSelection() {
-  if (!m_hasSelection || m_selectionPath.isEmpty())
+  if (!m_hasSelection || m_selectionMask.isEmpty())
     return;
 
   Layer *layer = m_layerManager->getActiveLayer();
   if (!layer || !layer->buffer)
     return;
 
-  // Create mask from path
-  QImage mask(m_canvasWidth, m_canvasHeight, QImage::Format_Alpha8);
-  mask.fill(0);
-  QPainter p(&mask);
-  p.fillPath(m_selectionPath, Qt::white);
-  p.end();
-
-  // Extract content
+  // Extract content weighted by the selection coverage
   QImage srcImg(layer->buffer->data(), m_canvasWidth, m_canvasHeight,
                 QImage::Format_RGBA8888_Premultiplied);
   QImage result(m_canvasWidth, m_canvasHeight,
                 QImage::Format_RGBA8888_Premultiplied);
   result.fill(0);
 
-  QPainter p2(&result);
-  p2.setClipPath(m_selectionPath);
-  p2.drawImage(0, 0, srcImg);
-  p2.end();
+  const QRect bounds = m_selectionMask.boundingRect().intersected(
+      QRect(0, 0, m_canvasWidth, m_canvasHeight));
+  for (int y = bounds.top(); y <= bounds.bottom(); ++y) {
+    const uint8_t *src = srcImg.constScanLine(y);
+    uint8_t *dst = result.scanLine(y);
+    for (int x = bounds.left(); x <= bounds.right(); ++x) {
+      const int cov = m_selectionMask.value(x, y);
+      for (int c = 0; c < 4; ++c)
+        dst[x * 4 + c] = static_cast<uint8_t>(src[x * 4 + c] * cov / 255);
+    }
+  }
 
   // Create new layer
   addLayer();
@@ -7154,64 +7045,23 @@ void CanvasItem::clearSelectionContent() {
 }
 
 void CanvasItem::deselect() {
-  QPainterPath beforePath = m_selectionPath;
   bool beforeHasSel = m_hasSelection;
 
-  m_selectionPath = QPainterPath();
   m_activeLassoPath = QPainterPath();
   m_isLassoDragging = false;
   m_isMagneticLassoActive = false;
-  m_hasSelection = false;
 
-  emit hasSelectionChanged();
-  if (m_marchingAntsTimer) m_marchingAntsTimer->stop();
-  update();
-
-  if (beforeHasSel) {
-    auto updateSelCb = [this](const QPainterPath &path, bool hasSel) {
-      m_selectionPath = path;
-      m_hasSelection = hasSel;
-      emit hasSelectionChanged();
-      if (m_hasSelection && m_marchingAntsTimer && !m_marchingAntsTimer->isActive())
-        m_marchingAntsTimer->start();
-      else if (!m_hasSelection && m_marchingAntsTimer)
-        m_marchingAntsTimer->stop();
-      update();
-    };
-    if (m_undoManager) {
-      m_undoManager->pushCommand(std::make_unique<artflow::SelectionUndoCommand>(
-          updateSelCb, beforePath, beforeHasSel, m_selectionPath, m_hasSelection));
-    }
-  }
+  artflow::SelectionMask none(m_canvasWidth, m_canvasHeight);
+  if (beforeHasSel)
+    commitSelectionMask(none);
+  else
+    setSelectionMask(none);
 }
 
 void CanvasItem::selectAll() {
-  QPainterPath beforePath = m_selectionPath;
-  bool beforeHasSel = m_hasSelection;
-
-  m_selectionPath = QPainterPath();
-  m_selectionPath.addRect(0, 0, m_canvasWidth, m_canvasHeight);
-  m_hasSelection = true;
-
-  emit hasSelectionChanged();
-  update();
-
-  if (beforePath != m_selectionPath || beforeHasSel != m_hasSelection) {
-    auto updateSelCb = [this](const QPainterPath &path, bool hasSel) {
-      m_selectionPath = path;
-      m_hasSelection = hasSel;
-      emit hasSelectionChanged();
-      if (m_hasSelection && m_marchingAntsTimer && !m_marchingAntsTimer->isActive())
-        m_marchingAntsTimer->start();
-      else if (!m_hasSelection && m_marchingAntsTimer)
-        m_marchingAntsTimer->stop();
-      update();
-    };
-    if (m_undoManager) {
-      m_undoManager->pushCommand(std::make_unique<artflow::SelectionUndoCommand>(
-          updateSelCb, beforePath, beforeHasSel, m_selectionPath, m_hasSelection));
-    }
-  }
+  artflow::SelectionMask all(m_canvasWidth, m_canvasHeight);
+  all.selectAll();
+  commitSelectionMask(all);
 }
 
 void CanvasItem::setBrushRoundness(float value) {
@@ -7467,7 +7317,6 @@ void CanvasItem::setCurrentTool(const QString &tool) {
       m_tool = ToolType::Lasso;
     } else if (tool == "magnetic_lasso") {
       m_tool = ToolType::MagneticLasso;
-      m_gradientMapDirty = true;
     } else if (tool == "select_rect") {
       m_tool = ToolType::RectSelect;
     } else if (tool == "select_ellipse") {
@@ -7543,11 +7392,9 @@ void CanvasItem::beginTransform() {
   }
 
   // 1. Extract content safely in cropped box
-  if (m_hasSelection && !m_selectionPath.isEmpty()) {
-    QRectF boundOriginal = m_selectionPath.boundingRect();
-    m_transformBox =
-        boundOriginal.intersected(QRectF(0, 0, m_canvasWidth, m_canvasHeight));
-    QRect bbox = m_transformBox.toRect();
+  if (m_hasSelection && !m_selectionMask.isEmpty()) {
+    QRect bbox = m_selectionMask.boundingRect().intersected(
+        QRect(0, 0, m_canvasWidth, m_canvasHeight));
     m_transformBox = bbox;
 
     if (bbox.isEmpty() || bbox.width() <= 0 || bbox.height() <= 0) {
@@ -7555,37 +7402,33 @@ void CanvasItem::beginTransform() {
       return;
     }
 
-    m_selectionBuffer = QImage(bbox.width(), bbox.height(),
-                               QImage::Format_ARGB32_Premultiplied);
-    m_selectionBuffer.fill(Qt::transparent);
-
-    QImage srcImg(layer->buffer->data(), m_canvasWidth, m_canvasHeight,
-                  QImage::Format_RGBA8888_Premultiplied);
-    QPainter p(&m_selectionBuffer);
-    p.translate(-bbox.x(), -bbox.y());
-    p.setClipPath(m_selectionPath);
-    p.drawImage(0, 0, srcImg);
-    p.end();
-
-    // Clear area in original layer
-    if (layer->type != Layer::Type::Vector) {
-      QImage layerImg(layer->buffer->data(), m_canvasWidth, m_canvasHeight,
-                      QImage::Format_RGBA8888_Premultiplied);
-      QPainter p2(&layerImg);
-      p2.setCompositionMode(QPainter::CompositionMode_Clear);
-      p2.setClipPath(m_selectionPath);
-      p2.fillRect(bbox, Qt::transparent);
-      p2.end();
-
-      // Clear real tiles in original layer buffer
-      for (int y = bbox.top(); y <= bbox.bottom(); ++y) {
-        for (int x = bbox.left(); x <= bbox.right(); ++x) {
-          if (m_selectionPath.contains(QPointF(x, y))) {
-            layer->buffer->setPixel(x, y, 0, 0, 0, 0);
-          }
+    // Lift the pixels weighted by the selection coverage; raster layers
+    // keep the remainder, so soft selection edges split the pixel. Only the
+    // bbox goes through the tiles, no data() copy of the whole canvas.
+    QImage lifted(bbox.size(), QImage::Format_RGBA8888_Premultiplied);
+    layer->buffer->readRegion(bbox.x(), bbox.y(), bbox.width(), bbox.height(),
+                              lifted.bits(), lifted.bytesPerLine());
+    const bool clearSource = layer->type != Layer::Type::Vector;
+    QImage kept = clearSource ? lifted.copy() : QImage();
+    for (int y = 0; y < bbox.height(); ++y) {
+      uint8_t *row = lifted.scanLine(y);
+      uint8_t *keptRow = clearSource ? kept.scanLine(y) : nullptr;
+      for (int x = 0; x < bbox.width(); ++x) {
+        const int cov = m_selectionMask.value(bbox.x() + x, bbox.y() + y);
+        uint8_t *px = row + x * 4;
+        for (int c = 0; c < 4; ++c) {
+          if (keptRow)
+            keptRow[x * 4 + c] = static_cast<uint8_t>(px[c] * (255 - cov) / 255);
+          px[c] = static_cast<uint8_t>(px[c] * cov / 255);
         }
       }
     }
+    if (clearSource)
+      layer->buffer->writeRegion(bbox.x(), bbox.y(), bbox.width(),
+                                 bbox.height(), kept.constBits(),
+                                 kept.bytesPerLine());
+    m_selectionBuffer =
+        lifted.convertToFormat(QImage::Format_ARGB32_Premultiplied);
   } else {
     // Use the content bounds instead of full canvas
     int bx, by, bw, bh;
@@ -7604,26 +7447,26 @@ void CanvasItem::beginTransform() {
       return;
     }
 
-    QImage fullImg(layer->buffer->data(), m_canvasWidth, m_canvasHeight,
-                   QImage::Format_RGBA8888_Premultiplied);
-    m_selectionBuffer = fullImg.copy(bbox);
+    m_selectionBuffer =
+        QImage(bbox.size(), QImage::Format_RGBA8888_Premultiplied);
+    layer->buffer->readRegion(bbox.x(), bbox.y(), bbox.width(), bbox.height(),
+                              m_selectionBuffer.bits(),
+                              m_selectionBuffer.bytesPerLine());
 
-    // Clear area in original layer
+    // Clear area in original layer (stride 0: every row is the same
+    // transparent one)
     if (layer->type != Layer::Type::Vector) {
-      QPainter p2(&fullImg);
-      p2.setCompositionMode(QPainter::CompositionMode_Clear);
-      p2.fillRect(bbox, Qt::transparent);
-      p2.end();
-
-      // Clear real tiles in original layer buffer
-      for (int y = bbox.top(); y <= bbox.bottom(); ++y) {
-        for (int x = bbox.left(); x <= bbox.right(); ++x) {
-          layer->buffer->setPixel(x, y, 0, 0, 0, 0);
-        }
-      }
+      const std::vector<uint8_t> clearRow(static_cast<size_t>(bbox.width()) * 4, 0);
+      layer->buffer->writeRegion(bbox.x(), bbox.y(), bbox.width(),
+                                 bbox.height(), clearRow.data(), 0);
     }
   }
 
+  // Preview pyramid; the commit still warps m_selectionBuffer
+  m_transformProxy = artflow::TransformProxy(m_selectionBuffer);
+  m_transformInteracting = false;
+  m_transformPreviewCoarseness = 0;
+
   m_initialMatrix = QTransform();
   m_transformMatrix = QTransform();
   m_transformMatrix.translate(m_transformBox.x(), m_transformBox.y());
@@ -7648,6 +7491,7 @@ void CanvasItem::beginTransform() {
   int ch = m_canvasHeight;
 
   QFuture<QImage> future = QtConcurrent::run([this, cw, ch]() -> QImage {
+    artflow::ScopedTrace trace("transformStaticCache", "concurrent");
     artflow::ImageBuffer tempBuffer(cw, ch);
     m_layerManager->compositeAll(tempBuffer, false);
     return QImage(tempBuffer.data(), cw, ch,
@@ -7932,10 +7776,16 @@ void CanvasItem::updateTransformCorners(const QVariantList &corners) {
     m_meshPoints.push_back(QPointF(p["x"].toDouble(), p["y"].toDouble()));
   }
 
-  if (m_meshPoints.size() == 16) {
-    m_isMeshTransform = true;
+  // Warp / mesh grid: tessellate once here, the preview and the commit
+  // both draw the lattice
+  m_isMeshTransform = m_meshPoints.size() ==
+                      static_cast<size_t>(m_meshColumns + 1) * (m_meshRows + 1);
+  if (m_isMeshTransform) {
+    m_meshWarp = artflow::MeshWarp(m_meshColumns, m_meshRows, m_meshPoints,
+                                   m_selectionBuffer.width(),
+                                   m_selectionBuffer.height());
   } else {
-    m_isMeshTransform = false;
+    m_meshWarp = artflow::MeshWarp();
   }
 
   // If 4 corners (Perspective mode)
@@ -7956,77 +7806,10 @@ void CanvasItem::updateTransformCorners(const QVariantList &corners) {
     }
   }
 
+  noteTransformInteraction();
   requestUpdate(); // throttled — no update() directo aquí
 }
 
-static void warpQuadBilinear(const QImage &srcImg, QImage &dstImg,
-                             const QPolygonF &srcQuad, const QPolygonF &dstQuad,
-                             int canvasWidth, int canvasHeight) {
-  QTransform trans;
-  if (!QTransform::quadToQuad(srcQuad, dstQuad, trans))
-    return;
-
-  QTransform invTrans = trans.inverted();
-  QRectF bound = dstQuad.boundingRect();
-  QRect bbox = bound.toRect().intersected(QRect(0, 0, canvasWidth, canvasHeight));
-
-  int sw = srcImg.width();
-  int sh = srcImg.height();
-
-  for (int y = bbox.top(); y <= bbox.bottom(); ++y) {
-    for (int x = bbox.left(); x <= bbox.right(); ++x) {
-      QPointF pt(x + 0.5, y + 0.5);
-      if (dstQuad.containsPoint(pt, Qt::OddEvenFill)) {
-        QPointF srcPt = invTrans.map(pt);
-        float sx = srcPt.x();
-        float sy = srcPt.y();
-        if (sx >= 0 && sx < sw && sy >= 0 && sy < sh) {
-          // Bilinear interpolation
-          int x0 = qBound(0, (int)std::floor(sx), sw - 1);
-          int y0 = qBound(0, (int)std::floor(sy), sh - 1);
-          int x1 = qBound(0, x0 + 1, sw - 1);
-          int y1 = qBound(0, y0 + 1, sh - 1);
-
-          float tx = sx - std::floor(sx);
-          float ty = sy - std::floor(sy);
-
-          QRgb p00 = srcImg.pixel(x0, y0);
-          QRgb p10 = srcImg.pixel(x1, y0);
-          QRgb p01 = srcImg.pixel(x0, y1);
-          QRgb p11 = srcImg.pixel(x1, y1);
-
-          float a = (1.0f - tx) * (1.0f - ty) * qAlpha(p00) + tx * (1.0f - ty) * qAlpha(p10) +
-                    (1.0f - tx) * ty * qAlpha(p01) + tx * ty * qAlpha(p11);
-          float r = (1.0f - tx) * (1.0f - ty) * qRed(p00) + tx * (1.0f - ty) * qRed(p10) +
-                    (1.0f - tx) * ty * qRed(p01) + tx * ty * qRed(p11);
-          float g = (1.0f - tx) * (1.0f - ty) * qGreen(p00) + tx * (1.0f - ty) * qGreen(p10) +
-                    (1.0f - tx) * ty * qGreen(p01) + tx * ty * qGreen(p11);
-          float b = (1.0f - tx) * (1.0f - ty) * qBlue(p00) + tx * (1.0f - ty) * qBlue(p10) +
-                    (1.0f - tx) * ty * qBlue(p01) + tx * ty * qBlue(p11);
-
-          QRgb srcColor = qRgba((int)r, (int)g, (int)b, (int)a);
-          
-          int srcA = qAlpha(srcColor);
-          if (srcA == 0) continue;
-
-          QRgb dstColor = dstImg.pixel(x, y);
-          int dstA = qAlpha(dstColor);
-
-          if (dstA == 0) {
-            dstImg.setPixel(x, y, srcColor);
-          } else {
-            int outA = srcA + (dstA * (255 - srcA) + 127) / 255;
-            int outR = qRed(srcColor) + (qRed(dstColor) * (255 - srcA) + 127) / 255;
-            int outG = qGreen(srcColor) + (qGreen(dstColor) * (255 - srcA) + 127) / 255;
-            int outB = qBlue(srcColor) + (qBlue(dstColor) * (255 - srcA) + 127) / 255;
-            dstImg.setPixel(x, y, qRgba(outR, outG, outB, outA));
-          }
-        }
-      }
-    }
-  }
-}
-
 void CanvasItem::applyTransform() {
   if (!m_isTransforming)
     return;
@@ -8044,52 +7827,28 @@ void CanvasItem::applyTransform() {
         // The old translate(box)*M*translate(-box) sandwich collapsed to M
         // alone (QTransform pre-multiplies), shifting every stroke by the
         // content-bounds origin on commit.
-        layer->vectorData->transformAll(canvasSpaceTransform());
+        const QTransform matrix = canvasSpaceTransform();
+        layer->vectorData->transformAll(matrix);
         
-        layer->buffer->clear();
-        layer->vectorData->rasterize(*layer->buffer);
+        layer->vectorData->rasterizeDirty(*layer->buffer);
         layer->dirty = false;
         layer->markDirty();
 
-        // Push Vector Undo Command
-        auto afterVector = std::make_unique<artflow::VectorLayerData>(*layer->vectorData);
-        auto afterBuffer = std::make_unique<artflow::ImageBuffer>(*layer->buffer);
-        m_undoManager->pushCommand(std::make_unique<VectorUndoCommand>(
-            m_layerManager, m_activeLayerIndex, std::move(m_transformBeforeBuffer),
-            std::move(afterBuffer), std::move(m_vectorBeforeData), std::move(afterVector)));
+        // Undo restores the original strokes (shared with the snapshot),
+        // not the inverse matrix, so repeated undo/redo does not drift
+        pushVectorUndo(m_undoManager, m_layerManager, m_activeLayerIndex,
+                       m_vectorBeforeData.get(), *layer->vectorData);
+        m_vectorBeforeData.reset();
+        m_transformBeforeBuffer.reset();
       }
     } else {
-      QImage img(layer->buffer->data(), m_canvasWidth, m_canvasHeight,
-                 QImage::Format_RGBA8888_Premultiplied);
+      // Resample straight into the layer tiles under the transformed
+      // bounds (no full-canvas data() round-trip)
+      const artflow::TransformWarp warp(m_selectionBuffer);
+      const auto filter = artflow::TransformWarp::Filter::Bicubic;
 
-      if (m_isMeshTransform && m_meshPoints.size() == 16) {
-        float sw = m_selectionBuffer.width();
-        float sh = m_selectionBuffer.height();
-
-        for (int row = 0; row < 3; ++row) {
-          for (int col = 0; col < 3; ++col) {
-            int idx_TL = row * 4 + col;
-            int idx_TR = row * 4 + col + 1;
-            int idx_BR = (row + 1) * 4 + col + 1;
-            int idx_BL = (row + 1) * 4 + col;
-
-            QPointF TL = m_meshPoints[idx_TL];
-            QPointF TR = m_meshPoints[idx_TR];
-            QPointF BR = m_meshPoints[idx_BR];
-            QPointF BL = m_meshPoints[idx_BL];
-
-            QPolygonF dstPolygon;
-            dstPolygon << TL << TR << BR << BL;
-
-            QPolygonF srcPolygon;
-            srcPolygon << QPointF(col * sw / 3.0f, row * sh / 3.0f)
-                       << QPointF((col + 1) * sw / 3.0f, row * sh / 3.0f)
-                       << QPointF((col + 1) * sw / 3.0f, (row + 1) * sh / 3.0f)
-                       << QPointF(col * sw / 3.0f, (row + 1) * sh / 3.0f);
-
-            warpQuadBilinear(m_selectionBuffer, img, srcPolygon, dstPolygon, m_canvasWidth, m_canvasHeight);
-          }
-        }
+      if (m_isMeshTransform && m_meshWarp.isValid()) {
+        warp.drawMesh(*layer->buffer, m_meshWarp, filter);
       } else if (m_meshPoints.size() == 4) { // Perspective transform (projective quad-to-quad)
         float sw = m_selectionBuffer.width();
         float sh = m_selectionBuffer.height();
@@ -8102,19 +7861,13 @@ void CanvasItem::applyTransform() {
           dstPolygon << m_meshPoints[i];
         }
 
-        warpQuadBilinear(m_selectionBuffer, img, srcPolygon, dstPolygon, m_canvasWidth, m_canvasHeight);
+        QTransform perspective;
+        if (QTransform::quadToQuad(srcPolygon, dstPolygon, perspective))
+          warp.draw(*layer->buffer, perspective, filter);
       } else { // Free transform (affine)
-        QPainter p(&img);
-        p.setRenderHint(QPainter::SmoothPixmapTransform);
-        p.setRenderHint(QPainter::Antialiasing);
-        p.setTransform(m_transformMatrix);
-        p.drawImage(0, 0, m_selectionBuffer);
-        p.end();
+        warp.draw(*layer->buffer, m_transformMatrix, filter);
       }
 
-      // Sync QImage modifications (m_cachedData) back to ImageBuffer tiles!
-      layer->buffer->loadRawData(layer->buffer->data());
-
       layer->dirty = true;
 
       // 3. PUSH UNDO
@@ -8150,15 +7903,11 @@ void CanvasItem::cancelTransform() {
       layer->dirty = true;
       layer->markDirty();
     } else {
-      QImage img(layer->buffer->data(), m_canvasWidth, m_canvasHeight,
-                 QImage::Format_RGBA8888_Premultiplied);
-      QPainter p(&img);
-      p.drawImage(m_transformBox.topLeft(),
-                  m_selectionBuffer); // Draw back original at its position
-      p.end();
-
-      // Sync QImage modifications (m_cachedData) back to ImageBuffer tiles!
-      layer->buffer->loadRawData(layer->buffer->data());
+      // Draw back original at its position (whole-pixel offset: an exact copy)
+      artflow::TransformWarp(m_selectionBuffer)
+          .draw(*layer->buffer,
+                QTransform::fromTranslate(m_transformBox.x(), m_transformBox.y()),
+                artflow::TransformWarp::Filter::Bilinear);
 
       layer->dirty = true;
     }
@@ -8219,6 +7968,7 @@ void CanvasItem::wheelEvent(QWheelEvent *event) {
 
 void CanvasItem::loadRecentProjectsAsync() {
   (void)QtConcurrent::run([this]() {
+    artflow::ScopedTrace trace("scanRecentProjects", "concurrent");
     QVariantList results = this->_scanSync();
     emit projectsLoaded(results);
   });
@@ -8338,28 +8088,28 @@ void CanvasItem::fitToView() {
   update();
 }
 
+// Rasterizing keeps the pixels and only drops the vector side, so undo
+// hands the same VectorLayerData back to the layer (tile cache included)
+// instead of copying it and re-rendering the whole layer.
 class VectorRasterizeUndoCommand : public artflow::UndoCommand {
 public:
-  VectorRasterizeUndoCommand(artflow::LayerManager *manager, int layerIndex, 
-                             std::unique_ptr<artflow::VectorLayerData> oldVectorData)
-      : m_manager(manager), m_layerIndex(layerIndex), m_oldVectorData(std::move(oldVectorData)) {}
+  VectorRasterizeUndoCommand(artflow::LayerManager *manager, int layerIndex)
+      : m_manager(manager), m_layerIndex(layerIndex) {}
 
   void undo() override {
     artflow::Layer *layer = m_manager->getLayer(m_layerIndex);
-    if (layer) {
+    if (layer && m_vectorData) {
       layer->type = artflow::Layer::Type::Vector;
-      layer->vectorData = std::make_unique<artflow::VectorLayerData>(*m_oldVectorData);
-      layer->buffer->clear();
-      layer->vectorData->rasterize(*layer->buffer);
+      layer->vectorData = std::move(m_vectorData);
       layer->markDirty();
     }
   }
 
   void redo() override {
     artflow::Layer *layer = m_manager->getLayer(m_layerIndex);
-    if (layer) {
+    if (layer && layer->vectorData) {
+      m_vectorData = std::move(layer->vectorData);
       layer->type = artflow::Layer::Type::Drawing;
-      layer->vectorData.reset();
       layer->markDirty();
     }
   }
@@ -8369,7 +8119,7 @@ public:
 private:
   artflow::LayerManager *m_manager;
   int m_layerIndex;
-  std::unique_ptr<artflow::VectorLayerData> m_oldVectorData;
+  std::unique_ptr<artflow::VectorLayerData> m_vectorData;
 };
 
 void CanvasItem::addVectorLayer() {
@@ -8435,16 +8185,10 @@ void CanvasItem::rasterizeVectorLayer(int index) {
   artflow::Layer *layer = m_layerManager->getLayer(index);
   if (!layer || layer->type != artflow::Layer::Type::Vector || !layer->vectorData) return;
 
-  auto oldVectorData = std::make_unique<artflow::VectorLayerData>(*layer->vectorData);
-
-  layer->type = artflow::Layer::Type::Drawing;
-  layer->vectorData.reset();
-  layer->markDirty();
-
-  if (m_undoManager) {
-    m_undoManager->pushCommand(std::make_unique<VectorRasterizeUndoCommand>(
-        m_layerManager, index, std::move(oldVectorData)));
-  }
+  auto command = std::make_unique<VectorRasterizeUndoCommand>(m_layerManager, index);
+  command->redo(); // takes the vector data off the layer
+  if (m_undoManager)
+    m_undoManager->pushCommand(std::move(command));
 
   update();
   updateLayersList();
@@ -8487,55 +8231,93 @@ void CanvasItem::simplifyVectorLayer(int index, int strength) {
     return;
   }
 
-  auto beforeVector = std::make_unique<artflow::VectorLayerData>(*layer->vectorData);
-  auto beforeBuffer = std::make_unique<artflow::ImageBuffer>(*layer->buffer);
+  // A new strength replaces the pending preview
+  if (m_vectorSimplifyJob) m_vectorSimplifyJob->cancel();
 
   // strength 0..100 -> tolerance 0.5..8 canvas px
   float tolerance = 0.5f + std::clamp(strength, 0, 100) * 0.075f;
-  int removedNodes = 0;
+  auto job = std::make_shared<artflow::VectorSimplifyJob>(
+      layer->vectorData->getStrokes(), tolerance);
+  m_vectorSimplifyJob = job;
+  m_vectorSimplifyLayer = index;
+  m_vectorSimplifyProgress = 0.0;
+  emit vectorSimplifyChanged();
+
+  // The refit runs on the pool in chunks; the UI only sees progress and,
+  // at the end, the node count the layer would keep.
+  auto *watcher = new QFutureWatcher<void>(this);
+  connect(watcher, &QFutureWatcher<void>::progressValueChanged, this,
+          [this, watcher, job](int value) {
+            if (job != m_vectorSimplifyJob || watcher->progressMaximum() <= 0)
+              return;
+            m_vectorSimplifyProgress =
+                std::min(0.99, qreal(value) / watcher->progressMaximum());
+            emit vectorSimplifyChanged();
+          });
+  connect(watcher, &QFutureWatcher<void>::finished, this, [this, watcher, job]() {
+    watcher->deleteLater();
+    if (job != m_vectorSimplifyJob) return; // superseded or cancelled
+    if (!job->isFinished() || job->nodesAfter() >= job->nodesBefore()) {
+      m_vectorSimplifyJob.reset();
+      m_vectorSimplifyProgress = -1.0;
+      emit vectorSimplifyChanged();
+      emit notificationRequested("No hay nodos redundantes", "info");
+      return;
+    }
+    m_vectorSimplifyProgress = 1.0;
+    emit vectorSimplifyChanged();
+  });
+  watcher->setFuture(QtConcurrent::run([job](QPromise<void> &promise) {
+    promise.setProgressRange(0, job->strokeCount());
+    job->run([&promise](int done, int) { promise.setProgressValue(done); });
+  }));
+}
 
-  for (auto &stroke : layer->vectorData->getStrokes()) {
-    if (stroke.segments.size() < 2) continue;
+int CanvasItem::vectorSimplifyPreviewNodes() const {
+  if (!m_vectorSimplifyJob || !m_vectorSimplifyJob->isFinished()) return -1;
+  return m_vectorSimplifyJob->nodesAfter();
+}
 
-    // Flatten with raw per-point pressure (NOT flattenStrokePolyline, which
-    // folds width factors into pressure and would shrink widths on refit).
-    std::vector<VPoint2D> pts;
-    for (size_t i = 0; i < stroke.segments.size(); ++i) {
-      auto segPts = flattenToPolyline(stroke.segments[i], 0.35f);
-      if (pts.empty()) {
-        pts = std::move(segPts);
-      } else if (segPts.size() > 1) {
-        pts.insert(pts.end(), segPts.begin() + 1, segPts.end());
-      }
-    }
-    if (pts.size() < 2) continue;
+void CanvasItem::cancelVectorSimplify() {
+  if (!m_vectorSimplifyJob) return;
+  m_vectorSimplifyJob->cancel();
+  m_vectorSimplifyJob.reset();
+  m_vectorSimplifyProgress = -1.0;
+  emit vectorSimplifyChanged();
+}
 
-    auto refitted = fitBezierChain(pts, tolerance, tolerance * 0.4f);
-    if (!refitted.empty() && refitted.size() < stroke.segments.size()) {
-      removedNodes += static_cast<int>(stroke.segments.size() - refitted.size());
-      stroke.segments = std::move(refitted);
-      stroke.recalcBounds();
-    }
+void CanvasItem::applyVectorSimplify() {
+  std::shared_ptr<artflow::VectorSimplifyJob> job = m_vectorSimplifyJob;
+  if (!job || !job->isFinished() || !m_layerManager) return;
+  m_vectorSimplifyJob.reset();
+  m_vectorSimplifyProgress = -1.0;
+  emit vectorSimplifyChanged();
+
+  Layer *layer = m_layerManager->getLayer(m_vectorSimplifyLayer);
+  if (!layer || layer->type != Layer::Type::Vector || !layer->vectorData ||
+      !layer->buffer || layer->locked) {
+    return;
   }
 
-  if (removedNodes == 0) {
+  auto beforeVector = std::make_unique<artflow::VectorLayerData>(*layer->vectorData);
+  // Strokes edited since the preview was computed are skipped
+  const int removedNodes = job->applyTo(*layer->vectorData);
+  if (removedNodes <= 0) {
     emit notificationRequested("No hay nodos redundantes", "info");
     return;
   }
 
-  layer->buffer->clear();
-  layer->vectorData->rasterize(*layer->buffer);
-  layer->dirty = false;
-  layer->markDirty();
+  {
+    // Only the tiles under the edited strokes are re-rendered
+    const QRect changed = layer->vectorData->rasterizeDirty(*layer->buffer);
+    layer->dirty = false;
+    if (!changed.isEmpty())
+      layer->markDirty(changed);
+  }
   m_cachedCanvasImage = QImage();
 
-  if (m_undoManager) {
-    auto afterVector = std::make_unique<artflow::VectorLayerData>(*layer->vectorData);
-    auto afterBuffer = std::make_unique<artflow::ImageBuffer>(*layer->buffer);
-    m_undoManager->pushCommand(std::make_unique<VectorUndoCommand>(
-        m_layerManager, index, std::move(beforeBuffer), std::move(afterBuffer),
-        std::move(beforeVector), std::move(afterVector)));
-  }
+  pushVectorUndo(m_undoManager, m_layerManager, m_vectorSimplifyLayer,
+                 beforeVector.get(), *layer->vectorData);
 
   emit notificationRequested(
       QString("Simplificado: %1 nodos menos").arg(removedNodes), "info");
@@ -8544,6 +8326,22 @@ void CanvasItem::simplifyVectorLayer(int index, int strength) {
   setProjectDirty(true);
 }
 
+void CanvasItem::beginVectorFit() {
+  if (m_tool == ToolType::VectorEraser || m_tool == ToolType::Eraser) {
+    m_vectorFitter.reset(3.0f, 1.5f);
+    return;
+  }
+  // Post-correction (Clip Studio-like): the slider controls how far the
+  // fitted curve may deviate from the drawn path. The input is low-pass
+  // smoothed before fitting, so these tolerances work on the intended
+  // shape, not on sensor jitter: 0 -> 0.5 px (faithful), 50 -> 2 px (clean:
+  // an 'S' fits in ~4-6 nodes), 100 -> 8 px (strong smoothing). Zoomed in,
+  // the effective tolerance shrinks further.
+  float base = 0.5f * std::pow(16.0f, m_vectorPostCorrection / 100.0f);
+  float fitTolerance = std::clamp(base / std::max(m_zoomLevel, 0.05f), base / 3.0f, base);
+  m_vectorFitter.reset(fitTolerance, fitTolerance * 0.4f);
+}
+
 void CanvasItem::finalizeVectorStroke() {
   m_isVectorDrawing = false;
   
@@ -8557,7 +8355,8 @@ void CanvasItem::finalizeVectorStroke() {
   if (m_tool == ToolType::VectorEraser || 
       (m_tool == ToolType::Eraser && layer->type == Layer::Type::Vector)) {
     if (m_vectorPointBuffer.size() >= 2) {
-      auto eraserSegments = fitBezierChain(m_vectorPointBuffer, 3.0f, 1.5f);
+      // Most of the stroke was already fitted while drawing
+      auto eraserSegments = m_vectorFitter.finish(m_vectorPointBuffer);
       if (!eraserSegments.empty()) {
         VectorStroke eraserStroke;
         eraserStroke.segments = std::move(eraserSegments);
@@ -8578,15 +8377,8 @@ void CanvasItem::finalizeVectorStroke() {
     }
   } else {
     if (m_vectorPointBuffer.size() >= 2) {
-      // Post-correction (Clip Studio-like): the slider controls how far the
-      // fitted curve may deviate from the drawn path. The input is low-pass
-      // smoothed inside fitBezierChain, so these tolerances work on the
-      // intended shape, not on sensor jitter: 0 -> 0.5 px (faithful),
-      // 50 -> 2 px (clean: an 'S' fits in ~4-6 nodes), 100 -> 8 px (strong
-      // smoothing). Zoomed in, the effective tolerance shrinks further.
-      float base = 0.5f * std::pow(16.0f, m_vectorPostCorrection / 100.0f);
-      float fitTolerance = std::clamp(base / std::max(m_zoomLevel, 0.05f), base / 3.0f, base);
-      auto segments = fitBezierChain(m_vectorPointBuffer, fitTolerance, fitTolerance * 0.4f);
+      // Tolerances were set in beginVectorFit(); only the open tail is fitted here
+      auto segments = m_vectorFitter.finish(m_vectorPointBuffer);
       if (!segments.empty()) {
         VectorStroke stroke;
         stroke.segments = std::move(segments);
@@ -8595,16 +8387,17 @@ void CanvasItem::finalizeVectorStroke() {
         stroke.globalWidth = m_brushSize;
 
         if (m_brushEngine) {
-          BrushSettings s = m_brushEngine->getBrush();
+          // Capture the full preset so the vector path renders through the
+          // raster brush pipeline (grain, taper, jitter, pressure dynamics).
+          // Strokes drawn with an unchanged brush share one snapshot.
+          stroke.brush = m_brushEngine->sharedBrush();
+          const BrushSettings &s = *stroke.brush;
           stroke.tipTextureName = s.tipTextureName;
           stroke.spacing = s.spacing;
           stroke.hardness = s.hardness;
           stroke.useTexture = s.useTexture;
           stroke.textureName = s.textureName;
           stroke.isEraser = false;
-          // Capture the full preset so the vector path renders through the
-          // raster brush pipeline (grain, taper, jitter, pressure dynamics).
-          stroke.brush = std::make_shared<BrushSettings>(s);
         }
 
         stroke.recalcBounds();
@@ -8623,20 +8416,22 @@ void CanvasItem::finalizeVectorStroke() {
     m_pongFBO = nullptr;
   }
 
-  layer->buffer->clear();
-  layer->vectorData->rasterize(*layer->buffer);
-  layer->dirty = false;
-  layer->markDirty();
+  {
+    // Only the tiles under the edited strokes are re-rendered
+    const QRect changed = layer->vectorData->rasterizeDirty(*layer->buffer);
+    layer->dirty = false;
+    if (!changed.isEmpty())
+      layer->markDirty(changed);
+  }
   m_cachedCanvasImage = QImage();
 
   if (m_strokeBeforeBuffer) {
-    auto afterBuffer = std::make_unique<ImageBuffer>(*layer->buffer);
     if (layer->type == Layer::Type::Vector) {
-      auto afterVector = std::make_unique<artflow::VectorLayerData>(*layer->vectorData);
-      m_undoManager->pushCommand(std::make_unique<VectorUndoCommand>(
-          m_layerManager, m_activeLayerIndex, std::move(m_strokeBeforeBuffer),
-          std::move(afterBuffer), std::move(m_vectorBeforeData), std::move(afterVector)));
+      pushVectorUndo(m_undoManager, m_layerManager, m_activeLayerIndex,
+                     m_vectorBeforeData.get(), *layer->vectorData);
+      m_vectorBeforeData.reset();
     } else {
+      auto afterBuffer = std::make_unique<ImageBuffer>(*layer->buffer);
       m_undoManager->pushCommand(std::make_unique<StrokeUndoCommand>(
           m_layerManager, m_activeLayerIndex, std::move(m_strokeBeforeBuffer),
           std::move(afterBuffer)));
@@ -8694,9 +8489,19 @@ bool CanvasItem::tryBeginVectorNodeDrag(const QPointF &screenPos, bool isTouch)
     }
   };
 
+  // Only strokes whose bounds (anchors + handles) reach the click radius can
+  // be hit. Query in untransformed stroke space.
+  const auto &strokes = layer->vectorData->getStrokes();
+  const QPointF localClick = t.inverted().map(canvasPos);
+  const QRectF probe = t.inverted().mapRect(
+      QRectF(canvasPos.x() - clickRadius, canvasPos.y() - clickRadius,
+             clickRadius * 2.0, clickRadius * 2.0));
+  const std::vector<size_t> nearby = layer->vectorData->queryRegion(probe);
+
   // Pass 1: anchors only. They take priority so a nearby tangent handle can
   // never steal the tap from the anchor the user is aiming at.
-  for (const auto &stroke : layer->vectorData->getStrokes()) {
+  for (size_t idx : nearby) {
+    const auto &stroke = strokes[idx];
     for (size_t i = 0; i < stroke.segments.size(); ++i) {
       const auto &seg = stroke.segments[i];
       consider(stroke.id, i, 0, seg.p0.x, seg.p0.y);
@@ -8706,7 +8511,8 @@ bool CanvasItem::tryBeginVectorNodeDrag(const QPointF &screenPos, bool isTouch)
 
   // Pass 2: tangent handles, only when no anchor is within reach.
   if (bestPointType == -1) {
-    for (const auto &stroke : layer->vectorData->getStrokes()) {
+    for (size_t idx : nearby) {
+      const auto &stroke = strokes[idx];
       for (size_t i = 0; i < stroke.segments.size(); ++i) {
         const auto &seg = stroke.segments[i];
         consider(stroke.id, i, 1, seg.cp1.x, seg.cp1.y);
@@ -8720,28 +8526,14 @@ bool CanvasItem::tryBeginVectorNodeDrag(const QPointF &screenPos, bool isTouch)
   bool snapshotTaken = false;
   if (bestPointType == -1) {
     // Hit-test in untransformed stroke space
-    QPointF localPos = t.inverted().map(canvasPos);
     VPoint2D vp;
-    vp.x = localPos.x();
-    vp.y = localPos.y();
-
-    float bestStrokeDist = clickRadius;
-    uint32_t hitStrokeId = 0;
-    int hitSegIdx = -1;
-    float hitT = 0.0f;
-
-    for (const auto &stroke : layer->vectorData->getStrokes()) {
-      QRectF expanded = stroke.cachedBounds.adjusted(-clickRadius, -clickRadius,
-                                                     clickRadius, clickRadius);
-      if (!expanded.contains(localPos)) continue;
-      auto res = distanceToStroke(vp, stroke);
-      if (res.segIdx >= 0 && res.distance < bestStrokeDist) {
-        bestStrokeDist = res.distance;
-        hitStrokeId = stroke.id;
-        hitSegIdx = res.segIdx;
-        hitT = res.t;
-      }
-    }
+    vp.x = localClick.x();
+    vp.y = localClick.y();
+
+    auto hit = layer->vectorData->nearestSegment(vp, clickRadius);
+    uint32_t hitStrokeId = hit.strokeId;
+    int hitSegIdx = hit.segIdx;
+    float hitT = hit.t;
 
     if (hitSegIdx >= 0) {
       VectorStroke *stroke = layer->vectorData->getStroke(hitStrokeId);
@@ -8749,7 +8541,6 @@ bool CanvasItem::tryBeginVectorNodeDrag(const QPointF &screenPos, bool isTouch)
         // Snapshot BEFORE mutating so the release-time undo covers the
         // insertion together with the drag.
         m_vectorBeforeData = std::make_unique<artflow::VectorLayerData>(*layer->vectorData);
-        m_transformBeforeBuffer = std::make_unique<artflow::ImageBuffer>(*layer->buffer);
         snapshotTaken = true;
 
         if (hitT < 0.05f || hitT > 0.95f) {
@@ -8758,9 +8549,10 @@ bool CanvasItem::tryBeginVectorNodeDrag(const QPointF &screenPos, bool isTouch)
           bestSegIdx = hitSegIdx;
           bestPointType = (hitT < 0.05f) ? 0 : 3;
         } else {
-          auto halves = subdivide(stroke->segments[hitSegIdx], hitT);
-          stroke->segments[hitSegIdx] = halves.first;
-          stroke->segments.insert(stroke->segments.begin() + hitSegIdx + 1, halves.second);
+          auto &segs = stroke->segments.unpack();
+          auto halves = subdivide(segs[hitSegIdx], hitT);
+          segs[hitSegIdx] = halves.first;
+          segs.insert(segs.begin() + hitSegIdx + 1, halves.second);
           stroke->recalcBounds();
 
           bestStrokeId = hitStrokeId;
@@ -8782,7 +8574,6 @@ bool CanvasItem::tryBeginVectorNodeDrag(const QPointF &screenPos, bool isTouch)
 
   if (!snapshotTaken) {
     m_vectorBeforeData = std::make_unique<artflow::VectorLayerData>(*layer->vectorData);
-    m_transformBeforeBuffer = std::make_unique<artflow::ImageBuffer>(*layer->buffer);
   }
 
   if (VectorStroke *stroke = layer->vectorData->getStroke(m_draggedStrokeId)) {
@@ -8807,7 +8598,7 @@ void CanvasItem::updateVectorNodeDrag(const QPointF &screenPos, bool breakTangen
   VectorStroke *stroke = layer->vectorData->getStroke(m_draggedStrokeId);
   if (!stroke || m_draggedSegmentIdx >= stroke->segments.size()) return;
 
-  auto &segs = stroke->segments;
+  auto &segs = stroke->segments.unpack();
   auto &seg = segs[m_draggedSegmentIdx];
 
   // G1-smoothness test around a shared anchor: are the incoming and outgoing
@@ -8903,19 +8694,17 @@ void CanvasItem::endVectorNodeDrag() {
   if (layer && layer->type == Layer::Type::Vector && layer->vectorData &&
       layer->buffer) {
     // Replace the draft preview with the final full-quality brush render.
-    layer->buffer->clear();
-    layer->vectorData->rasterize(*layer->buffer);
+    // Every tile the drag passed over was marked, so this covers the whole
+    // draft trail without redrawing the rest of the layer.
+    const QRect changed = layer->vectorData->rasterizeDirty(*layer->buffer);
     layer->dirty = false;
-    layer->markDirty();
+    if (!changed.isEmpty())
+      layer->markDirty(changed);
     m_cachedCanvasImage = QImage();
 
-    if (m_undoManager) {
-      auto afterVector = std::make_unique<artflow::VectorLayerData>(*layer->vectorData);
-      auto afterBuffer = std::make_unique<artflow::ImageBuffer>(*layer->buffer);
-      m_undoManager->pushCommand(std::make_unique<VectorUndoCommand>(
-          m_layerManager, m_activeLayerIndex, std::move(m_transformBeforeBuffer),
-          std::move(afterBuffer), std::move(m_vectorBeforeData), std::move(afterVector)));
-    }
+    pushVectorUndo(m_undoManager, m_layerManager, m_activeLayerIndex,
+                   m_vectorBeforeData.get(), *layer->vectorData);
+    m_vectorBeforeData.reset();
   }
 
   m_draggedStrokeId = 0;
@@ -8941,8 +8730,14 @@ bool CanvasItem::tryDeleteVectorNodeAt(const QPointF &screenPos, bool isTouch) {
   int bestPointType = -1;
   float bestDist = clickRadius;
 
+  const auto &strokes = layer->vectorData->getStrokes();
+  const QRectF probe = t.inverted().mapRect(
+      QRectF(canvasPos.x() - clickRadius, canvasPos.y() - clickRadius,
+             clickRadius * 2.0, clickRadius * 2.0));
+
   // Only anchors can be deleted (not tangent handles)
-  for (const auto &stroke : layer->vectorData->getStrokes()) {
+  for (size_t idx : layer->vectorData->queryRegion(probe)) {
+    const auto &stroke = strokes[idx];
     for (size_t i = 0; i < stroke.segments.size(); ++i) {
       const auto &seg = stroke.segments[i];
       auto consider = [&](int pointType, float px, float py) {
@@ -8975,9 +8770,8 @@ void CanvasItem::deleteVectorNode(uint32_t strokeId, size_t segIdx, int pointTyp
   if (!stroke || segIdx >= stroke->segments.size()) return;
 
   auto beforeVector = std::make_unique<artflow::VectorLayerData>(*layer->vectorData);
-  auto beforeBuffer = std::make_unique<artflow::ImageBuffer>(*layer->buffer);
 
-  auto &segs = stroke->segments;
+  auto &segs = stroke->segments.unpack();
   // Normalize the anchor to a boundary index: boundary k sits between
   // segment k-1 and segment k (k = 0 is the stroke start, k = n the end).
   size_t boundary = (pointType == 0) ? segIdx : segIdx + 1;
@@ -9009,19 +8803,17 @@ void CanvasItem::deleteVectorNode(uint32_t strokeId, size_t segIdx, int pointTyp
     stroke->recalcBounds();
   }
 
-  layer->buffer->clear();
-  layer->vectorData->rasterize(*layer->buffer);
-  layer->dirty = false;
-  layer->markDirty();
+  {
+    // Only the tiles under the edited strokes are re-rendered
+    const QRect changed = layer->vectorData->rasterizeDirty(*layer->buffer);
+    layer->dirty = false;
+    if (!changed.isEmpty())
+      layer->markDirty(changed);
+  }
   m_cachedCanvasImage = QImage();
 
-  if (m_undoManager) {
-    auto afterVector = std::make_unique<artflow::VectorLayerData>(*layer->vectorData);
-    auto afterBuffer = std::make_unique<artflow::ImageBuffer>(*layer->buffer);
-    m_undoManager->pushCommand(std::make_unique<VectorUndoCommand>(
-        m_layerManager, m_activeLayerIndex, std::move(beforeBuffer),
-        std::move(afterBuffer), std::move(beforeVector), std::move(afterVector)));
-  }
+  pushVectorUndo(m_undoManager, m_layerManager, m_activeLayerIndex,
+                 beforeVector.get(), *layer->vectorData);
 
   emit notificationRequested(strokeRemoved ? "Trazo eliminado" : "Nodo eliminado", "info");
   update();
@@ -9597,53 +9389,11 @@ void CanvasItem::selectPixels(int index) {
   if (!l || !l->buffer)
     return;
 
-  QPainterPath beforePath = m_selectionPath;
-  bool beforeHasSel = m_hasSelection;
-
-  m_selectionPath = QPainterPath();
-  int w = l->buffer->width();
-  int h = l->buffer->height();
-  const uint8_t *pixels = l->buffer->data();
-
-  // Scan row by row to find opaque spans
-  for (int y = 0; y < h; ++y) {
-    int startX = -1;
-    for (int x = 0; x < w; ++x) {
-      uint8_t alpha = pixels[(y * w + x) * 4 + 3];
-      if (alpha > 5) { // Threshold for non-transparency
-        if (startX == -1) {
-          startX = x;
-        }
-      } else {
-        if (startX != -1) {
-          m_selectionPath.addRect(startX, y, x - startX, 1);
-          startX = -1;
-        }
-      }
-    }
-    if (startX != -1) {
-      m_selectionPath.addRect(startX, y, w - startX, 1);
-    }
-  }
-
-  m_hasSelection = !m_selectionPath.isEmpty();
-  emit hasSelectionChanged();
-  update();
-
-  auto updateSelCb = [this](const QPainterPath &path, bool hasSel) {
-    m_selectionPath = path;
-    m_hasSelection = hasSel;
-    emit hasSelectionChanged();
-    if (m_hasSelection && m_marchingAntsTimer && !m_marchingAntsTimer->isActive())
-      m_marchingAntsTimer->start();
-    else if (!m_hasSelection && m_marchingAntsTimer)
-      m_marchingAntsTimer->stop();
-    update();
-  };
-  if (m_undoManager) {
-    m_undoManager->pushCommand(std::make_unique<artflow::SelectionUndoCommand>(
-        updateSelCb, beforePath, beforeHasSel, m_selectionPath, m_hasSelection));
-  }
+  // The layer's alpha is the selection coverage
+  QImage pixels(l->buffer->data(), l->buffer->width(), l->buffer->height(),
+                QImage::Format_RGBA8888_Premultiplied);
+  commitSelectionMask(artflow::SelectionMask::fromImage(
+      pixels.convertToFormat(QImage::Format_Alpha8)));
 }
 
 void CanvasItem::invertLayerColors(int index) {
@@ -9765,6 +9515,7 @@ bool CanvasItem::loadProject(const QString &path) {
 
   // 1. Reset Canvas
   resizeCanvas(w, h);
+  setProjectDpi(obj["dpi"].toInt(72));
 
   // Load background color
   if (obj.contains("backgroundColor")) {
@@ -9962,6 +9713,7 @@ bool CanvasItem::saveProject(const QString &pathText) {
   obj["timestamp"] = QDateTime::currentDateTime().toString(Qt::ISODate);
   obj["width"] = m_canvasWidth;
   obj["height"] = m_canvasHeight;
+  obj["dpi"] = m_projectDpi;
   obj["version"] = 2; // Version 2: Embedded Data
   obj["backgroundColor"] = m_backgroundColor.name(QColor::HexArgb);
 
@@ -10739,6 +10491,9 @@ bool CanvasItem::exportImage(const QString &path, const QString &format) {
   QImage img = QImage(composite.data(), m_canvasWidth, m_canvasHeight,
                       QImage::Format_RGBA8888_Premultiplied)
                    .copy();
+  // Print size travels with the file (document DPI)
+  img.setDotsPerMeterX(qRound(m_projectDpi / 0.0254));
+  img.setDotsPerMeterY(qRound(m_projectDpi / 0.0254));
 
   qDebug() << "Exporting image to:" << localPath;
   bool success = img.save(localPath, format.toUpper().toStdString().c_str());
@@ -10747,6 +10502,55 @@ bool CanvasItem::exportImage(const QString &path, const QString &format) {
   return success;
 }
 
+bool CanvasItem::exportImageAtDpi(const QString &path, const QString &format,
+                                  int dpi) {
+  if (!m_layerManager || dpi <= 0)
+    return false;
+
+  QString localPath = path;
+  if (localPath.startsWith("file:", Qt::CaseInsensitive)) {
+    localPath = QUrl(path).toLocalFile();
+  }
+
+  const float scale = static_cast<float>(dpi) / std::max(1, m_projectDpi);
+  if (std::abs(scale - 1.0f) < 1e-3f ||
+      format.toUpper() == "PSD" || localPath.endsWith(".psd", Qt::CaseInsensitive))
+    return exportImage(path, format);
+
+  syncGpuToCpu();
+
+  const int outW = std::max(1, qRound(m_canvasWidth * scale));
+  const int outH = std::max(1, qRound(m_canvasHeight * scale));
+
+  // The encoded image is the only full-size allocation. Layers are rendered
+  // one band of rows at a time into band-sized buffers and copied in, so a
+  // 4x print export does not hold every layer at 16x the canvas memory.
+  QImage img(outW, outH, QImage::Format_RGBA8888_Premultiplied);
+  if (img.isNull()) {
+    qWarning() << "exportImageAtDpi: cannot allocate" << outW << "x" << outH;
+    emit notificationRequested("Exportación demasiado grande para la memoria", "error");
+    return false;
+  }
+  img.setDotsPerMeterX(qRound(dpi / 0.0254));
+  img.setDotsPerMeterY(qRound(dpi / 0.0254));
+
+  const int bandH = artflow::ImageBuffer::TILE_SIZE;
+  for (int y = 0; y < outH; y += bandH) {
+    const int h = std::min(bandH, outH - y);
+    ImageBuffer band(outW, h);
+    m_layerManager->compositeRegionScaled(band, QRect(0, y, outW, h), scale);
+    band.readRegion(0, 0, outW, h, img.scanLine(y),
+                    static_cast<int>(img.bytesPerLine()));
+  }
+
+  qDebug() << "Exporting image at" << dpi << "dpi (" << outW << "x" << outH
+           << ") to:" << localPath;
+  bool success = img.save(localPath, format.toUpper().toStdString().c_str());
+  if (!success)
+    qDebug() << "Failed to save image to:" << localPath;
+  return success;
+}
+
 bool CanvasItem::importImageAsLayer(const QString &path) {
   qDebug() << "[importImageAsLayer] ENTER path=" << path;
 
@@ -11039,6 +10843,7 @@ bool CanvasItem::importABR(const QString &path) {
 
   // Parse on background thread (non-blocking)
   QFuture<ABRFile> future = QtConcurrent::run([localPath]() {
+    artflow::ScopedTrace trace("parseAbr", "concurrent");
     return ABRParser::parse(localPath);
   });
   watcher->setFuture(future);
@@ -11084,6 +10889,7 @@ void CanvasItem::updateTransformProperties(float x, float y, float scale,
            << "| Computed: Cx=" << newCx << "Cy=" << newCy
            << "| Matrix translation: tx=" << m_transformMatrix.dx() << "ty=" << m_transformMatrix.dy();
 
+  noteTransformInteraction();
   update();
 }
 
@@ -11340,7 +11146,10 @@ void CanvasItem::clearProjectPath() {
   emit currentProjectNameChanged();
 }
 
-void CanvasItem::setProjectDpi(int dpi) { qDebug() << "DPI set to" << dpi; }
+void CanvasItem::setProjectDpi(int dpi) {
+  m_projectDpi = std::clamp(dpi, 1, 4800);
+  qDebug() << "DPI set to" << m_projectDpi;
+}
 
 void CanvasItem::drawPanelLayout(const QString &layoutType, int gutterPx,
                                  int borderPx, int marginPx) {
@@ -11862,6 +11671,7 @@ void CanvasItem::setActiveLayer(int index) {
     // SYNC CURRENT LAYER BEFORE SWITCHING
     if (index != m_activeLayerIndex) {
       syncGpuToCpu();
+      cancelVectorSimplify(); // the preview belongs to the old layer
     }
 
     m_activeLayerIndex = index;
@@ -11871,7 +11681,6 @@ void CanvasItem::setActiveLayer(int index) {
       m_gradientStops = l->gradientMapStops;
       emit gradientStopsChanged();
     }
-    m_gradientMapDirty = true;
     emit activeLayerChanged();
     updateLayersList();
 
@@ -12218,20 +12027,39 @@ void CanvasItem::beginBrushEdit(const QString &brushName) {
 void CanvasItem::syncGpuToCpu() {
   if (!m_layerManager)
     return;
+  artflow::ScopedLatencyTimer readbackTimer(artflow::LatencyStage::Readback);
   Layer *layer = m_layerManager->getActiveLayer();
-  if (!layer || !m_pingFBO)
+  if (!layer || !layer->buffer || !m_pingFBO)
+    return;
+  if (m_pingFBO->width() != m_canvasWidth ||
+      m_pingFBO->height() != m_canvasHeight)
     return;
 
-  QImage img = m_pingFBO->toImage();
-  if (img.format() != QImage::Format_RGBA8888_Premultiplied) {
-    img = img.convertToFormat(QImage::Format_RGBA8888_Premultiplied);
-  }
+  // El spread de acuarela sigue escribiendo en el FBO fuera del último dab
+  if (m_watercolorEngine && m_watercolorEngine->hasActiveWetAreas())
+    m_strokeTiles.markRect(m_watercolorEngine->wetBounds());
+  if (m_strokeTiles.isEmpty())
+    return;
 
-  if (img.width() == m_canvasWidth && img.height() == m_canvasHeight) {
-    layer->buffer->loadRawData(img.constBits());
-    // Mark the entire layer dirty so the compositor refreshes it
-    layer->markDirty(QRect(0, 0, m_canvasWidth, m_canvasHeight));
+  QRect written;
+  if (artflow::GlTileReadback::isSupported(m_pingFBO)) {
+    // Lectura asíncrona por PBO, tile a tile, directa al ImageBuffer
+    if (!m_tileReadback)
+      m_tileReadback = new artflow::GlTileReadback();
+    m_tileReadback->setSource(m_pingFBO);
+    written = artflow::readbackDirtyTiles(m_strokeTiles, *m_tileReadback,
+                                          *layer->buffer);
+  } else {
+    // Sin PBOs (o GLES sin lectura a 8 bits): una descarga completa, pero
+    // solo se reescriben los tiles sucios
+    artflow::CpuTileReadback cpuSource(m_pingFBO->toImage(true));
+    written = artflow::readbackDirtyTiles(m_strokeTiles, cpuSource,
+                                          *layer->buffer);
   }
+  m_strokeTiles.reset(m_canvasWidth, m_canvasHeight);
+
+  if (!written.isEmpty())
+    layer->markDirty(written);
 }
 
 void CanvasItem::cancelBrushEdit() {
@@ -13546,6 +13374,87 @@ QString CanvasItem::getCanvasPreview() {
   return m_canvasPreviewBase64;
 }
 
+QVariantMap CanvasItem::latencyStats() const {
+  auto *profiler = artflow::LatencyProfiler::instance();
+  QVariantMap result;
+  for (int s = 0; s < artflow::LatencyProfiler::kStageCount; ++s) {
+    const auto stage = static_cast<artflow::LatencyStage>(s);
+    const auto p = profiler->percentiles(stage);
+    QVariantMap entry;
+    entry["p50"] = p.p50;
+    entry["p95"] = p.p95;
+    entry["p99"] = p.p99;
+    entry["max"] = p.max;
+    entry["count"] = p.count;
+    result[QString::fromLatin1(artflow::LatencyProfiler::stageName(stage))] =
+        entry;
+  }
+  return result;
+}
+
+QString CanvasItem::dumpLatencyTrace(const QString &path) {
+  QString target = path;
+  if (target.startsWith("file:"))
+    target = QUrl(target).toLocalFile();
+  if (target.isEmpty()) {
+    const QString dir =
+        QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) +
+        "/KromoStudioProjects";
+    QDir().mkpath(dir);
+    target = dir + "/latency_" +
+             QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss") +
+             ".json";
+  }
+  if (!artflow::LatencyProfiler::instance()->dumpToFile(target)) {
+    qWarning() << "[Latency] Could not write trace to" << target;
+    return QString();
+  }
+  qDebug() << "[Latency] Trace written to" << target;
+  return target;
+}
+
+void CanvasItem::resetLatencyStats() {
+  artflow::LatencyProfiler::instance()->reset();
+}
+
+void CanvasItem::syncFrameTracing() {
+  auto *tracer = artflow::FrameTracer::instance();
+  const bool wanted = PreferencesManager::instance()->frameTracingEnabled();
+  if (wanted == tracer->isEnabled())
+    return;
+
+  tracer->setEnabled(wanted);
+  if (wanted) {
+    tracer->clear();
+    qDebug() << "[FrameTrace] Recording enabled";
+  } else if (tracer->eventCount() > 0) {
+    // Al desactivar, volcar lo grabado para poder abrirlo en chrome://tracing
+    dumpFrameTrace();
+    tracer->clear();
+  }
+}
+
+QString CanvasItem::dumpFrameTrace(const QString &path) {
+  QString target = path;
+  if (target.startsWith("file:"))
+    target = QUrl(target).toLocalFile();
+  if (target.isEmpty()) {
+    const QString dir =
+        QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) +
+        "/KromoStudioProjects/.traces";
+    QDir().mkpath(dir);
+    target = dir + "/frame_trace_" +
+             QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss") +
+             ".json";
+  }
+  if (!artflow::FrameTracer::instance()->writeJson(target)) {
+    qWarning() << "[FrameTrace] Could not write trace to" << target;
+    return QString();
+  }
+  qDebug() << "[FrameTrace] Trace written to" << target;
+  return target;
+}
+
 QString CanvasItem::loadReference(const QString &path) {
   return path;
 }
@@ -13816,6 +13725,7 @@ void CanvasItem::capture_timelapse_frame() {
 
   // Ejecutar la composición de capas y la escritura a disco de forma totalmente asíncrona
   std::ignore = QtConcurrent::run([snapshot, cw, ch]() {
+    artflow::ScopedTrace trace("timelapseFrame", "concurrent");
     static int frameCount = 0;
 
     // Crear buffer compuesto intermedio en segundo plano
@@ -13829,8 +13739,7 @@ void CanvasItem::capture_timelapse_frame() {
         composite.composite(*snap.buffer, 0, 0, snap.opacity, snap.blendMode,
                             currentBaseBuffer);
       } else {
-        composite.composite(*snap.buffer, 0, 0, snap.opacity, snap.blendMode,
-                            nullptr);
+        composite.composite(*snap.buffer, 0, 0, snap.opacity, snap.blendMode);
         currentBaseBuffer = snap.buffer.get();
       }
     }
@@ -13951,104 +13860,13 @@ void CanvasItem::setCurvePoints(const QVariantList &points) {
       splinePts.push_back({uiX, uiY});
     }
 
-    // Calcular Spline Suave (Monotone Cubic)
-    prepareSpline(splinePts);
-
-    // Generar LUT desde Spline
-    m_lut.assign(1024, 0.0f);
-    for (int i = 0; i < 1024; ++i) {
-      m_lut[i] = evaluateSpline(i / 1023.0f);
-    }
+    // Spline Suave (Monotone Cubic) horneado en la LUT de 1024 entradas
+    m_pressureLut.bakeMonotoneSpline(std::move(splinePts));
 
     emit pressureCurvePointsChanged();
   }
 }
 
-// -----------------------------------------------------------------------
-// Spline Implementation (Algorithm: Monotone Cubic Hermite Spline)
-// -----------------------------------------------------------------------
-void CanvasItem::prepareSpline(
-    const std::vector<std::pair<float, float>> &rawPoints) {
-  if (rawPoints.empty())
-    return;
-
-  // 1. Sort by Input (X)
-  auto points = rawPoints;
-  std::sort(points.begin(), points.end(),
-            [](const auto &a, const auto &b) { return a.first < b.first; });
-
-  int n = points.size();
-  m_splineX.resize(n);
-  m_splineY.resize(n);
-  m_splineM.resize(n);
-
-  for (int i = 0; i < n; ++i) {
-    m_splineX[i] = points[i].first;
-    m_splineY[i] = points[i].second;
-  }
-
-  // 2. Deltas
-  std::vector<double> d(n - 1);
-  for (int i = 0; i < n - 1; ++i) {
-    double dx = m_splineX[i + 1] - m_splineX[i];
-    if (std::abs(dx) < 1e-6)
-      d[i] = 0;
-    else
-      d[i] = (m_splineY[i + 1] - m_splineY[i]) / dx;
-  }
-
-  // 3. Tangents
-  if (n > 1) {
-    m_splineM[0] = d[0];
-    m_splineM[n - 1] = d[n - 2];
-    for (int i = 1; i < n - 1; ++i) {
-      if (d[i - 1] * d[i] <= 0) {
-        m_splineM[i] = 0;
-      } else {
-        m_splineM[i] = (d[i - 1] + d[i]) * 0.5;
-      }
-    }
-  } else {
-    m_splineM[0] = 0;
-  }
-}
-
-float CanvasItem::evaluateSpline(float x) {
-  int n = m_splineX.size();
-  if (n == 0)
-    return x;
-
-  if (x <= m_splineX[0])
-    return (float)m_splineY[0];
-  if (x >= m_splineX[n - 1])
-    return (float)m_splineY[n - 1];
-
-  auto it = std::upper_bound(m_splineX.begin(), m_splineX.end(), x);
-  int i = std::distance(m_splineX.begin(), it) - 1;
-  if (i < 0)
-    i = 0;
-  if (i >= n - 1)
-    i = n - 2;
-
-  double h = m_splineX[i + 1] - m_splineX[i];
-  if (h < 1e-6)
-    return (float)m_splineY[i];
-
-  double t = (x - m_splineX[i]) / h;
-  double t2 = t * t;
-  double t3 = t2 * t;
-
-  double h00 = 2 * t3 - 3 * t2 + 1;
-  double h10 = t3 - 2 * t2 + t;
-  double h01 = -2 * t3 + 3 * t2;
-  double h11 = t3 - t2;
-
-  double y = h00 * m_splineY[i] + h10 * h * m_splineM[i] +
-             h01 * m_splineY[i + 1] + h11 * h * m_splineM[i + 1];
-
-  return std::clamp((float)y, 0.0f, 1.0f);
-}
-
 // Legacy signature kept for ABI compatibility
 void CanvasItem::updateLUT(float x1, float y1, float x2, float y2) {
   (void)x1;
@@ -14062,10 +13880,7 @@ float CanvasItem::applyPressureCurve(float input) {
     return 0.0f;
   if (input >= 1.0f)
     return 1.0f;
-  if (m_lut.empty())
-    return input; // Safety default linear
-  int idx = std::clamp((int)(input * 1023), 0, 1023);
-  return m_lut[idx];
+  return m_pressureLut.evaluate(input); // identity until a curve is set
 }
 
 void CanvasItem::hoverEnterEvent(QHoverEvent *event) {
@@ -14340,6 +14155,9 @@ void CanvasItem::blendWithShader(QPainter *painter, artflow::Layer *layer,
   if (overrideTextureId == 0) {
     auto getOrUpdateTexture = [&](artflow::Layer *L) -> QOpenGLTexture * {
       QOpenGLTexture *tex = m_layerTextures.value(L);
+      if (tex && !L->dirty)
+        return tex;
+      artflow::ScopedTrace uploadTrace("uploadLayerTexture", "gpu");
       if (!tex) {
         if (!L->buffer)
           return nullptr;
@@ -14398,6 +14216,9 @@ void CanvasItem::blendWithShader(QPainter *painter, artflow::Layer *layer,
     // We always need the mask from its persistent buffer (not override)
     auto getOrUpdateTexture = [&](artflow::Layer *L) -> QOpenGLTexture * {
       QOpenGLTexture *tex = m_layerTextures.value(L);
+      if (tex && !L->dirty)
+        return tex;
+      artflow::ScopedTrace uploadTrace("uploadLayerTexture", "gpu");
       if (!tex) {
         if (!L->buffer)
           return nullptr;
@@ -15267,6 +15088,7 @@ void CanvasItem::handleAutoSave() {
   if (!m_projectDirty || m_isDrawing) {
     return;
   }
+  artflow::ScopedTrace trace("autosave", "io");
 
   qDebug() << "[AutoSave] Executing background auto-save...";
   syncGpuToCpu();
@@ -15286,6 +15108,7 @@ void CanvasItem::handleAutoSave() {
   obj["timestamp"] = QDateTime::currentDateTime().toString(Qt::ISODate);
   obj["width"] = m_canvasWidth;
   obj["height"] = m_canvasHeight;
+  obj["dpi"] = m_projectDpi;
   obj["version"] = 2; // Embedded Data format
   obj["originalPath"] = m_currentProjectPath;
 
@@ -15483,6 +15306,7 @@ bool CanvasItem::recoverAutosave(const QString &autosavePath) {
   }
 
   resizeCanvas(w, h);
+  setProjectDpi(obj["dpi"].toInt(72));
 
   QJsonArray layersArray = obj["layers"].toArray();
   if (!layersArray.isEmpty()) {
@@ -16285,6 +16109,21 @@ void CanvasItem::setMagneticEdgeSensitivity(float value) {
   emit magneticEdgeSensitivityChanged();
 }
 
+void CanvasItem::syncEdgeDetectorSource() {
+  Layer *layer = m_layerManager ? m_layerManager->getActiveLayer() : nullptr;
+  if (layer && layer->buffer)
+    m_edgeDetector->setSource(layer->buffer.get(), layer->stableId);
+  else
+    m_edgeDetector->clearSource();
+}
+
+int CanvasItem::magneticSnapRadius() const {
+  // The radius is what the user sees: zoomed out it spans more canvas
+  // pixels (the detector scans those on a coarser pyramid level)
+  return static_cast<int>(std::ceil(m_magneticSearchRadius /
+                                    std::clamp(m_zoomLevel, 0.05f, 1.0f)));
+}
+
 void CanvasItem::setMagneticSearchRadius(int value) {
   if (m_magneticSearchRadius == value) return;
   m_magneticSearchRadius = value;
@@ -16298,57 +16137,22 @@ void CanvasItem::selectByColorRange(const QColor &color, float tolerance, int ch
   Layer *layer = m_layerManager->getActiveLayer();
   if (!layer || !layer->buffer) return;
 
-  QImage layerImg(layer->buffer->data(), m_canvasWidth, m_canvasHeight, QImage::Format_RGBA8888);
-  ColorRangeSelector selector;
-  QImage mask = selector.selectByColor(layerImg, color, tolerance, channelMode, fuzziness, invert);
-  QPainterPath selectionPath = selector.maskToPath(mask);
-
-  QPainterPath beforePath = m_selectionPath;
-  bool beforeHasSel = m_hasSelection;
-
-  if (m_selectionAddMode == 0) {
-    m_selectionPath = selectionPath;
-  } else if (m_selectionAddMode == 1) {
-    m_selectionPath = m_selectionPath.united(selectionPath);
-  } else if (m_selectionAddMode == 2) {
-    m_selectionPath = m_selectionPath.subtracted(selectionPath);
-  }
-
-  m_hasSelection = !m_selectionPath.isEmpty();
-  emit hasSelectionChanged();
-
-  if (m_hasSelection && m_marchingAntsTimer && !m_marchingAntsTimer->isActive())
-    m_marchingAntsTimer->start();
-  else if (!m_hasSelection && m_marchingAntsTimer)
-    m_marchingAntsTimer->stop();
-
-  update();
-
-  auto updateSelCb = [this](const QPainterPath &path, bool hasSel) {
-    m_selectionPath = path;
-    m_hasSelection = hasSel;
-    emit hasSelectionChanged();
-    if (m_hasSelection && m_marchingAntsTimer && !m_marchingAntsTimer->isActive())
-      m_marchingAntsTimer->start();
-    else if (!m_hasSelection && m_marchingAntsTimer)
-      m_marchingAntsTimer->stop();
-    update();
-  };
-
-  if (m_undoManager) {
-    m_undoManager->pushCommand(std::make_unique<artflow::SelectionUndoCommand>(
-        updateSelCb, beforePath, beforeHasSel, m_selectionPath, m_hasSelection));
-  }
+  // Full resolution only on commit; the cached conversion and tiles the
+  // preview already validated are reused
+  m_colorRangeSelector->setSource(layer->buffer.get(), layer->stableId);
+  QImage mask = m_colorRangeSelector->selectByColor(color, tolerance, channelMode, fuzziness, invert);
+  if (mask.isNull()) return;
+  combineSelectionMask(artflow::SelectionMask::fromImage(mask));
 }
 
 QString CanvasItem::getColorRangePreview(const QColor &color, float tolerance, int channelMode, float fuzziness, bool invert) {
   Layer *layer = m_layerManager->getActiveLayer();
   if (!layer || !layer->buffer) return QString();
 
-  QImage layerImg(layer->buffer->data(), m_canvasWidth, m_canvasHeight, QImage::Format_RGBA8888);
-  ColorRangeSelector selector;
-  QImage mask = selector.selectByColor(layerImg, color, tolerance, channelMode, fuzziness, invert);
-  QImage preview = selector.previewMask(layerImg, mask);
+  // Slider feedback runs on the downscaled proxy (<= 512 px)
+  m_colorRangeSelector->setSource(layer->buffer.get(), layer->stableId);
+  QImage preview = m_colorRangeSelector->previewByColor(color, tolerance, channelMode, fuzziness, invert);
+  if (preview.isNull()) return QString();
 
   // Convert QImage to Base64 PNG
   QByteArray ba;
@@ -7,15 +7,21 @@
 #include "core/cpp/include/liquify_engine.h"
 #include "core/cpp/include/stroke_renderer.h"
 #include "core/cpp/include/stroke_undo_command.h"
+#include "core/cpp/include/tile_readback.h"
 #include "core/cpp/include/undo_manager.h"
 #include "core/cpp/include/watercolor_engine.h"
 #include "core/cpp/include/animation_manager.h"
 #include "core/cpp/include/PerspectiveRuler.h"
 #include "core/cpp/include/edge_detector.h"
 #include "core/cpp/include/color_range_selector.h"
+#include "core/cpp/include/magic_wand.h"
+#include "core/cpp/include/mesh_warp.h"
+#include "core/cpp/include/transform_proxy.h"
+#include "core/cpp/include/selection_mask.h"
 #include "core/cpp/include/vector_types.h"
 #include "core/cpp/include/SpeechBalloon.h"
 #include "core/cpp/include/vector_math.h"
+#include "core/cpp/include/vector_simplify.h"
 #include <QColor>
 #include <QCursor>
 #include <QImage>
@@ -112,6 +118,13 @@ public:
       bool isTransforming READ isTransforming NOTIFY isTransformingChanged)
   Q_PROPERTY(int vectorPostCorrection READ vectorPostCorrection WRITE
                  setVectorPostCorrection NOTIFY vectorPostCorrectionChanged)
+  // Background "Simplificar": progress 0..1 while the preview is computed
+  // (-1 when idle), then the node count the layer would have once applied
+  // (-1 when there is no preview).
+  Q_PROPERTY(qreal vectorSimplifyProgress READ vectorSimplifyProgress NOTIFY
+                 vectorSimplifyChanged)
+  Q_PROPERTY(int vectorSimplifyPreviewNodes READ vectorSimplifyPreviewNodes
+                 NOTIFY vectorSimplifyChanged)
   Q_PROPERTY(bool isFreeTransformActive READ isFreeTransformActive WRITE setIsFreeTransformActive NOTIFY isFreeTransformActiveChanged)
   Q_PROPERTY(float brushAngle READ brushAngle WRITE setBrushAngle NOTIFY
                  brushAngleChanged)
@@ -166,6 +179,12 @@ public:
                  setSelectionAddMode NOTIFY selectionAddModeChanged)
   Q_PROPERTY(float selectionThreshold READ selectionThreshold WRITE
                  setSelectionThreshold NOTIFY selectionThresholdChanged)
+  Q_PROPERTY(bool wandContiguous READ wandContiguous WRITE setWandContiguous
+                 NOTIFY wandOptionsChanged)
+  Q_PROPERTY(bool wandSampleMerged READ wandSampleMerged WRITE
+                 setWandSampleMerged NOTIFY wandOptionsChanged)
+  Q_PROPERTY(bool wandAntiAlias READ wandAntiAlias WRITE setWandAntiAlias
+                 NOTIFY wandOptionsChanged)
   Q_PROPERTY(bool isSelectionModeActive READ isSelectionModeActive WRITE
                  setIsSelectionModeActive NOTIFY isSelectionModeActiveChanged)
   Q_PROPERTY(int lassoMode READ lassoMode WRITE setLassoMode NOTIFY lassoModeChanged)
@@ -180,6 +199,11 @@ public:
 
   Q_PROPERTY(int transformMode READ transformMode WRITE setTransformMode NOTIFY
                  transformModeChanged)
+  // Warp / mesh control grid, in cells (points = (columns + 1) x (rows + 1))
+  Q_PROPERTY(int transformMeshColumns READ transformMeshColumns WRITE
+                 setTransformMeshColumns NOTIFY transformMeshChanged)
+  Q_PROPERTY(int transformMeshRows READ transformMeshRows WRITE
+                 setTransformMeshRows NOTIFY transformMeshChanged)
   Q_PROPERTY(bool sizeByPressure READ sizeByPressure WRITE setSizeByPressure
                  NOTIFY sizeByPressureChanged)
   Q_PROPERTY(bool opacityByPressure READ opacityByPressure WRITE
@@ -202,6 +226,22 @@ public:
     emit transformModeChanged();
     update();
   }
+  int transformMeshColumns() const { return m_meshColumns; }
+  int transformMeshRows() const { return m_meshRows; }
+  void setTransformMeshColumns(int columns) {
+    columns = qBound(2, columns, 16);
+    if (m_meshColumns == columns)
+      return;
+    m_meshColumns = columns;
+    emit transformMeshChanged();
+  }
+  void setTransformMeshRows(int rows) {
+    rows = qBound(2, rows, 16);
+    if (m_meshRows == rows)
+      return;
+    m_meshRows = rows;
+    emit transformMeshChanged();
+  }
 
   Q_INVOKABLE void applyTransform();
   Q_INVOKABLE void cancelTransform();
@@ -265,6 +305,9 @@ public:
   bool hasSelection() const { return m_hasSelection; }
   int selectionAddMode() const { return m_selectionAddMode; }
   float selectionThreshold() const { return m_selectionThreshold; }
+  bool wandContiguous() const { return m_wandOptions.contiguous; }
+  bool wandSampleMerged() const { return m_wandSampleMerged; }
+  bool wandAntiAlias() const { return m_wandOptions.antiAlias; }
   bool isSelectionModeActive() const { return m_isSelectionModeActive; }
   bool isImporting() const { return m_isImporting; }
   float importProgress() const { return m_importProgress; }
@@ -346,6 +389,10 @@ public:
   Q_INVOKABLE bool saveProject(const QString &path);
   Q_INVOKABLE bool saveProjectAs(const QString &path);
   Q_INVOKABLE bool exportImage(const QString &path, const QString &format);
+  // Export re-rendered at `dpi` (scale = dpi / project DPI): vector layers are
+  // rasterized from their curves, raster layers resampled, band by band.
+  Q_INVOKABLE bool exportImageAtDpi(const QString &path, const QString &format,
+                                    int dpi);
   Q_INVOKABLE bool checkForAutosave();
   Q_INVOKABLE QVariantList getAutosaveList();
   Q_INVOKABLE bool recoverAutosave(const QString &autosavePath);
@@ -362,6 +409,7 @@ public:
   Q_INVOKABLE void resizeCanvas(int w, int h);
   Q_INVOKABLE void clearProjectPath();
   Q_INVOKABLE void setProjectDpi(int dpi);
+  Q_INVOKABLE int projectDpi() const { return m_projectDpi; }
   // Comic Panel Layout Drawing
   Q_INVOKABLE void drawPanelLayout(const QString &layoutType, int gutterPx,
                                    int borderPx, int marginPx);
@@ -416,6 +464,9 @@ public:
   // Selection Manipulation
   Q_INVOKABLE void invertSelection();
   Q_INVOKABLE void featherSelection(float radius);
+  Q_INVOKABLE void growSelection(float radius);
+  Q_INVOKABLE void shrinkSelection(float radius);
+  Q_INVOKABLE void smoothSelection(float radius);
   Q_INVOKABLE void duplicateSelection();
   Q_INVOKABLE void maskSelection();
   Q_INVOKABLE void colorSelection(const QColor &color);
@@ -426,6 +477,9 @@ public:
 
   void setSelectionAddMode(int mode);
   void setSelectionThreshold(float threshold);
+  void setWandContiguous(bool value);
+  void setWandSampleMerged(bool value);
+  void setWandAntiAlias(bool value);
   void setIsSelectionModeActive(bool active);
   int lassoMode() const { return m_lassoMode; }
   void setLassoMode(int mode);
@@ -537,6 +591,13 @@ public:
 
   // Canvas preview for navigator (base64 PNG)
   Q_INVOKABLE QString getCanvasPreview();
+
+  // Latency profiler: rolling p50/p95/p99 (ms) per pipeline stage
+  Q_INVOKABLE QVariantMap latencyStats() const;
+  Q_INVOKABLE QString dumpLatencyTrace(const QString &path = QString());
+  Q_INVOKABLE void resetLatencyStats();
+  // Chrome Trace Event JSON of the frame pipeline (preferences: frame tracing)
+  Q_INVOKABLE QString dumpFrameTrace(const QString &path = QString());
   Q_INVOKABLE QString sampleColorFromImage(const QString &imagePath, int x, int y, int viewWidth, int viewHeight);
   Q_INVOKABLE QString loadReference(const QString &path);
 
@@ -573,11 +634,18 @@ public:
   void setVectorPostCorrection(int value);
   Q_INVOKABLE int vectorStrokeCount(int index) const;
   Q_INVOKABLE int vectorNodeCount(int index) const;
+  // Starts (or restarts) the background preview; applyVectorSimplify()
+  // commits it as one undo step
   Q_INVOKABLE void simplifyVectorLayer(int index, int strength);
+  Q_INVOKABLE void applyVectorSimplify();
+  Q_INVOKABLE void cancelVectorSimplify();
+  qreal vectorSimplifyProgress() const { return m_vectorSimplifyProgress; }
+  int vectorSimplifyPreviewNodes() const;
 
 signals:
   void canvasPreviewChanged();
   void vectorPostCorrectionChanged();
+  void vectorSimplifyChanged();
   void animationManagerChanged();
   void perspectiveRulerChanged();
   void brushSizeChanged();
@@ -607,6 +675,7 @@ signals:
   void isTransformingChanged();
   void isFreeTransformActiveChanged();
   void transformModeChanged();
+  void transformMeshChanged();
   void brushAngleChanged();
   void cursorRotationChanged();
   void currentProjectPathChanged();
@@ -627,6 +696,7 @@ signals:
   void hasSelectionChanged();
   void selectionAddModeChanged();
   void selectionThresholdChanged();
+  void wandOptionsChanged();
   void isSelectionModeActiveChanged();
   void lassoModeChanged();
   void magneticEdgeSensitivityChanged();
@@ -687,17 +757,10 @@ private:
   float m_opacityBeforeDrag = 1.0f;
   bool m_isDraggingOpacity = false;
 
-  // Pressure Logic
-  std::vector<float> m_lut;
+  // Pressure Logic (monotone spline baked into a shared curve LUT)
+  artflow::CurveLUT m_pressureLut;
   QVariantList m_rawPoints;
 
-  // Spline Calculation Members
-  std::vector<double> m_splineX;
-  std::vector<double> m_splineY;
-  std::vector<double> m_splineM;
-  void prepareSpline(const std::vector<std::pair<float, float>> &points);
-  float evaluateSpline(float x);
-
   void updateLUT(float x1, float y1, float x2, float y2);
   float applyPressureCurve(float input);
 
@@ -720,6 +783,7 @@ private:
   ToolType m_tool = ToolType::Pen;
   int m_canvasWidth;
   int m_canvasHeight;
+  int m_projectDpi = 72; // Canvas pixels per inch (print size)
   QPointF m_viewOffset;
   int m_activeLayerIndex;
   float m_brushAngle;
@@ -825,12 +889,23 @@ private:
 
   // Lasso helpers
   void _commitLassoPath();                                // commit m_activeLassoPath
+  void syncEdgeDetectorSource();   // point the magnetic lasso at the active layer
+  int magneticSnapRadius() const;  // search radius in canvas px at the current zoom
   void _commitNewShapePath(const QPainterPath &newPath);  // commit rect/ellipse path
 
+  // Selection mask helpers
+  artflow::SelectionMask currentSelectionMask() const;   // m_selectionMask, canvas-sized
+  void setSelectionMask(const artflow::SelectionMask &mask);     // apply (no undo)
+  void commitSelectionMask(const artflow::SelectionMask &mask);  // apply + undo step
+  void combineSelectionMask(const artflow::SelectionMask &shape); // per selectionAddMode
+  void refineSelection(void (artflow::SelectionMask::*op)(float), float radius);
+
   QVariantList _scanSync();
   void updateLayersList();
   // Selection and Transform state
-  QPainterPath m_selectionPath;
+  artflow::SelectionMask m_selectionMask; // canonical selection
+  QPainterPath m_selectionPath;           // its binary clip path (coverage >= kInside), derived by setSelectionMask
+  QPainterPath m_selectionOutline;        // its contours (marching ants), likewise
   QPainterPath m_activeLassoPath;
   bool m_hasSelection = false;
   QImage m_selectionBuffer;
@@ -840,6 +915,16 @@ private:
   bool m_isFreeTransformActive = false;
   std::vector<QPointF> m_meshPoints;
   bool m_isMeshTransform = false;
+  int m_meshColumns = 3;
+  int m_meshRows = 3;
+  artflow::MeshWarp m_meshWarp; // m_meshPoints tessellated, for preview and commit
+  // Mip-mapped m_selectionBuffer the preview warps from: coarse frames while
+  // the handles move, refined one step per idle tick afterwards
+  artflow::TransformProxy m_transformProxy;
+  QTimer *m_transformRefineTimer = nullptr;
+  bool m_transformInteracting = false;
+  int m_transformPreviewCoarseness = 0;
+  QTransform m_transformPreviewViewport; // of the last preview frame
   QImage m_transformStaticCache;
   bool m_updateTransformTextures = false;
   QOpenGLShaderProgram *m_transformShader = nullptr;
@@ -847,6 +932,8 @@ private:
   QOpenGLTexture *m_selectionTex = nullptr;
   int m_selectionAddMode = 0; // 0=New, 1=Add, 2=Subtract
   float m_selectionThreshold = 0.15f;
+  artflow::MagicWand::Options m_wandOptions; // tolerance follows m_selectionThreshold
+  bool m_wandSampleMerged = false;           // sample the composite, not the active layer
   bool m_isSelectionModeActive = false;
   bool m_isImporting = false;
   float m_importProgress = 0.0f;
@@ -866,7 +953,7 @@ private:
   float m_magneticEdgeSensitivity = 0.85f;
   int m_magneticSearchRadius = 12;
   artflow::EdgeDetector *m_edgeDetector = nullptr;
-  bool m_gradientMapDirty = true;
+  artflow::ColorRangeSelector *m_colorRangeSelector = nullptr;
   QPainterPath m_magneticPreviewPath;
   QPointF m_lastTraceTarget;
 
@@ -955,7 +1042,10 @@ private:
   void updateBrushTipImage();
 
   void capture_timelapse_frame();
+  // Vuelca a la capa activa solo los tiles que tocó el trazo GPU en curso
   void syncGpuToCpu();
+  artflow::StrokeTileTracker m_strokeTiles; // Tiles written into m_pingFBO
+  artflow::GlTileReadback *m_tileReadback = nullptr; // PBO ring (GL thread)
   int m_lastActiveLayerIndex = -1;
 
   QCursor m_customOpenHandCursor;
@@ -966,6 +1056,7 @@ private:
   QTimer *m_updateThrottle = nullptr;
   void requestUpdate();
   void resetTransformState();
+  void noteTransformInteraction();
 
   // Timer persistente para animación de marching ants
   QTimer *m_marchingAntsTimer = nullptr;
@@ -1050,6 +1141,7 @@ private:
   
   // Vector stroke building state
   std::vector<artflow::VPoint2D> m_vectorPointBuffer;
+  artflow::IncrementalBezierFitter m_vectorFitter; // fits the buffer while drawing
   bool m_isVectorDrawing = false;
   std::unique_ptr<artflow::VectorLayerData> m_vectorBeforeData;
   bool m_isDraggingVectorPoint = false;
@@ -1058,12 +1150,16 @@ private:
   int m_draggedPointType = -1; // 0: p0, 1: cp1, 2: cp2, 3: p3
   QRectF m_vectorDragDirtyRect; // Bounds of the edited stroke before the last drag step
   int m_vectorPostCorrection = 50; // 0 = fiel al trazo, 100 = máxima suavización
+  std::shared_ptr<artflow::VectorSimplifyJob> m_vectorSimplifyJob; // preview en curso/listo
+  int m_vectorSimplifyLayer = -1;
+  qreal m_vectorSimplifyProgress = -1.0;
   QPointF m_transformBoxOrigin; // Box top-left captured at beginTransform (local-space origin)
   // Double-tap detection for touch node deletion
   qint64 m_lastNodeTapMs = 0;
   uint32_t m_lastNodeTapStroke = 0;
   size_t m_lastNodeTapSeg = 0;
   int m_lastNodeTapType = -1;
+  void beginVectorFit();
   void finalizeVectorStroke();
 
   // Vector node editing (shared by mouse and touch paths)
@@ -1080,6 +1176,7 @@ private:
 
   void handleAutoSave();
   void setupAutoSave();
+  void syncFrameTracing();
   bool exportPSD(const QString &path);
 };
 
@@ -30,6 +30,8 @@ class PreferencesManager : public QObject {
       int undoLevels READ undoLevels WRITE setUndoLevels NOTIFY settingsChanged)
   Q_PROPERTY(int memoryUsageLimit READ memoryUsageLimit WRITE
                  setMemoryUsageLimit NOTIFY settingsChanged)
+  Q_PROPERTY(bool frameTracingEnabled READ frameTracingEnabled WRITE
+                 setFrameTracingEnabled NOTIFY settingsChanged)
 
   // --- CURSOR ---
   Q_PROPERTY(bool cursorShowOutline READ cursorShowOutline WRITE
@@ -110,6 +112,9 @@ public:
   int memoryUsageLimit() const {
     return m_settings->value("memory_usage_limit", 70).toInt();
   }
+  bool frameTracingEnabled() const {
+    return m_settings->value("frame_tracing_enabled", false).toBool();
+  }
   bool cursorShowOutline() const {
     return m_settings->value("cursor_show_outline", true).toBool();
   }
@@ -289,6 +294,12 @@ public slots:
       emit settingsChanged();
     }
   }
+  void setFrameTracingEnabled(bool enabled) {
+    if (frameTracingEnabled() != enabled) {
+      m_settings->setValue("frame_tracing_enabled", enabled);
+      emit settingsChanged();
+    }
+  }
   void setCursorShowOutline(bool show) {
     if (cursorShowOutline() != show) {
       m_settings->setValue("cursor_show_outline", show);
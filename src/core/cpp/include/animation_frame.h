@@ -1,5 +1,6 @@
 #pragma once
 
+#include "curve_lut.h"
 #include "layer_manager.h"
 #include <QTransform>
 
@@ -38,22 +39,57 @@ public:
     bool isKeyframe() const { return m_layerRef != nullptr; }
 
     EasingType getEasing() const { return m_easing; }
-    void setEasing(EasingType easing) { m_easing = easing; }
+    void setEasing(EasingType easing) {
+        m_easing = easing;
+        bakeEasing();
+    }
 
     // Custom cubic-bezier control points (x1, y1, x2, y2), only
     // meaningful when m_easing == EasingType::Bezier.
     void setBezierHandles(float x1, float y1, float x2, float y2) {
         m_bezier[0] = x1; m_bezier[1] = y1; m_bezier[2] = x2; m_bezier[3] = y2;
+        bakeEasing();
     }
     const float* getBezierHandles() const { return m_bezier; }
 
+    // Eased progress (0..1) of the segment leaving this keyframe: a lookup
+    // in the table baked when the easing was set
+    float easeProgress(float t) const {
+        if (t <= 0.0f) return 0.0f;
+        if (t >= 1.0f) return 1.0f;
+        return m_easingLut.evaluate(t);
+    }
+
 private:
+    void bakeEasing() {
+        switch (m_easing) {
+            case EasingType::EaseIn:
+                m_easingLut = CurveLUT::cachedBezier(0.42f, 0.0f, 1.0f, 1.0f);
+                break;
+            case EasingType::EaseOut:
+                m_easingLut = CurveLUT::cachedBezier(0.0f, 0.0f, 0.58f, 1.0f);
+                break;
+            case EasingType::EaseInOut:
+                m_easingLut = CurveLUT::cachedBezier(0.42f, 0.0f, 0.58f, 1.0f);
+                break;
+            case EasingType::Bezier:
+                m_easingLut = CurveLUT::cachedBezier(m_bezier[0], m_bezier[1],
+                                                     m_bezier[2], m_bezier[3]);
+                break;
+            case EasingType::Linear:
+            default:
+                m_easingLut.setIdentity();
+                break;
+        }
+    }
+
     Layer* m_layerRef;
     int m_duration;
     float m_opacity;
     QTransform m_transform;
     EasingType m_easing = EasingType::Linear;
     float m_bezier[4] = { 0.42f, 0.0f, 0.58f, 1.0f };
+    CurveLUT m_easingLut; // identity = linear
 };
 
 } // namespace artflow
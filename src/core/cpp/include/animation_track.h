@@ -1,6 +1,7 @@
 #pragma once
 
 #include "animation_frame.h"
+#include "curve_lut.h"
 #include <string>
 #include <map>
 #include <cmath>
@@ -9,25 +10,12 @@ namespace artflow {
 
 // ── Easing evaluation ─────────────────────────────────────────
 // Evaluates a cubic bezier easing curve defined by control points
-// (x1,y1) and (x2,y2) at progress t (0..1). Solves x(u)=t with
-// Newton-Raphson and returns y(u).
+// (x1,y1) and (x2,y2) at progress t (0..1), exactly. For one-off queries
+// (the easing editor); playback reads the table each keyframe bakes.
 inline float evalCubicBezier(float t, float x1, float y1, float x2, float y2) {
     if (t <= 0.0f) return 0.0f;
     if (t >= 1.0f) return 1.0f;
-    float u = t;
-    for (int i = 0; i < 8; ++i) {
-        float omu = 1.0f - u;
-        float x = 3.0f * u * omu * omu * x1 + 3.0f * u * u * omu * x2 + u * u * u;
-        float dx = 3.0f * omu * omu * x1 + 6.0f * u * omu * (x2 - x1) + 3.0f * u * u * (1.0f - x2);
-        float err = x - t;
-        if (std::fabs(err) < 1e-5f) break;
-        if (std::fabs(dx) < 1e-6f) break;
-        u -= err / dx;
-        if (u < 0.0f) u = 0.0f;
-        if (u > 1.0f) u = 1.0f;
-    }
-    float omu = 1.0f - u;
-    return 3.0f * u * omu * omu * y1 + 3.0f * u * u * omu * y2 + u * u * u;
+    return CurveLUT::solveBezier(t, x1, y1, x2, y2);
 }
 
 inline float evalEasing(EasingType easing, float t, const float* bz = nullptr) {
@@ -121,7 +109,7 @@ public:
         const AnimationFrame& b = nextIt->second;
 
         // Apply the easing curve of the segment's leading keyframe
-        t = evalEasing(a.getEasing(), t, a.getBezierHandles());
+        t = a.easeProgress(t);
 
         float opacity = a.getOpacity() * (1.0f - t) + b.getOpacity() * t;
 
@@ -11,6 +11,7 @@
 #include <string>
 #include <vector>
 
+#include "curve_lut.h"
 #include <QString>
 
 class QOpenGLFramebufferObject;
@@ -44,6 +45,30 @@ struct StrokePoint {
       : x(x), y(y), pressure(pressure), tiltX(0), tiltY(0), timestamp(0) {}
 };
 
+// Dual tip / grain blend modes. Values are the shader uniform encoding.
+enum class DualTipBlend : int { Multiply = 0, Mask = 1, Add = 2, Height = 3 };
+enum class GrainBlend : int { Multiply = 0, Subtract = 1, Threshold = 2 };
+
+// Preset strings -> enum ("subtract" is the legacy name of the mask mode,
+// "reveal" of threshold). Unknown names fall back to multiply.
+inline DualTipBlend dualTipBlendFromString(const QString &mode) {
+  if (mode == "mask" || mode == "subtract")
+    return DualTipBlend::Mask;
+  if (mode == "add")
+    return DualTipBlend::Add;
+  if (mode == "height_linear" || mode == "height")
+    return DualTipBlend::Height;
+  return DualTipBlend::Multiply;
+}
+
+inline GrainBlend grainBlendFromString(const QString &mode) {
+  if (mode == "subtract")
+    return GrainBlend::Subtract;
+  if (mode == "threshold" || mode == "reveal")
+    return GrainBlend::Threshold;
+  return GrainBlend::Multiply;
+}
+
 struct BrushSettings {
   float size = 10.0f;
   float opacity = 1.0f;
@@ -89,7 +114,7 @@ struct BrushSettings {
   uint32_t dualTipTextureID = 0;
   float dualTipScale = 1.0f;
   float dualTipRotation = 0.0f;
-  QString dualTipBlendMode = "multiply";
+  DualTipBlend dualTipBlendMode = DualTipBlend::Multiply;
   float dualTipFlow = 1.0f;
 
   // Dual Grain Settings
@@ -141,7 +166,7 @@ struct BrushSettings {
   float grainMotionBlur = 0.0f;
   float grainMotionBlurAngle = 0.0f;
   bool grainRandomOffset = false;
-  QString grainBlendMode = "multiply";
+  GrainBlend grainBlendMode = GrainBlend::Multiply;
   float grainBright = 0.0f;
   float grainCon = 1.0f;
   float grainRotation = 0.0f;
@@ -287,6 +312,15 @@ struct BrushSettings {
   float sizeMinPressure = 0.0f;    // size factor floor at zero pressure
   float opacityMinPressure = 0.0f; // opacity factor floor at zero pressure
 
+  // Baked from pressureCurveX1..Y2 by bakePressureCurve()
+  CurveLUT pressureLut;
+
+  // Call after editing pressureCurveX1..Y2
+  void bakePressureCurve() {
+    pressureLut = CurveLUT::cachedBezier(pressureCurveX1, pressureCurveY1,
+                                         pressureCurveX2, pressureCurveY2);
+  }
+
   // Evaluate the per-brush pressure curve: y for a given input pressure x.
   float applyPressureCurve(float x) const {
     // Fast path: identity curve
@@ -294,36 +328,40 @@ struct BrushSettings {
         pressureCurveX2 == 1.0f && pressureCurveY2 == 1.0f) {
       return x;
     }
-    x = std::max(0.0f, std::min(1.0f, x));
-    // Newton's method: find t such that bezierX(t) == x
-    float t = x;
-    for (int i = 0; i < 8; ++i) {
-      float mt = 1.0f - t;
-      float bx = 3.0f * mt * mt * t * pressureCurveX1 +
-                 3.0f * mt * t * t * pressureCurveX2 + t * t * t;
-      float dx = bx - x;
-      if (std::abs(dx) < 1e-5f)
-        break;
-      float dbx = 3.0f * mt * mt * pressureCurveX1 +
-                  6.0f * mt * t * (pressureCurveX2 - pressureCurveX1) +
-                  3.0f * t * t * (1.0f - pressureCurveX2);
-      if (std::abs(dbx) < 1e-6f)
-        break;
-      t -= dx / dbx;
-      t = std::max(0.0f, std::min(1.0f, t));
-    }
-    float mt = 1.0f - t;
-    float y = 3.0f * mt * mt * t * pressureCurveY1 +
-              3.0f * mt * t * t * pressureCurveY2 + t * t * t;
+    // Fields edited without a re-bake fall back to the exact solver
+    float y = pressureLut.matchesBezier(pressureCurveX1, pressureCurveY1,
+                                        pressureCurveX2, pressureCurveY2)
+                  ? pressureLut.evaluate(x)
+                  : CurveLUT::solveBezier(x, pressureCurveX1, pressureCurveY1,
+                                          pressureCurveX2, pressureCurveY2);
     return std::max(0.0f, std::min(1.0f, y));
   }
 };
 
+// Dynamics a dab generator must honour, compiled from BrushSettings once per
+// segment. Bits that are off are removed from the dab loop at compile time.
+struct BrushFeatures {
+  static constexpr uint32_t PathJitter = 1u << 0;  // jitterLateral/Linear
+  static constexpr uint32_t DabJitter = 1u << 1;   // pos/size/rot/opacity
+  static constexpr uint32_t ColorJitter = 1u << 2; // hue/saturation
+  static constexpr uint32_t Taper = 1u << 3;       // taper + falloff
+  static constexpr uint32_t Stacking = 1u << 4;    // count > 1
+  static constexpr uint32_t MainSpray = 1u << 5;
+  static constexpr uint32_t DualSpray = 1u << 6;
+  static constexpr uint32_t PaintLoad = 1u << 7;   // oil depletion
+  static constexpr uint32_t All = 0xFFu;
+};
+
+uint32_t compileBrushFeatures(const BrushSettings &settings);
+
 class StrokeRenderer; // Forward declaration
 
 class BrushEngine {
 public:
   static uint32_t loadTexture(const QString &name, bool isTip = true);
+  // Jitter/scatter randomness is per thread. Seeding it makes a replayed
+  // stroke (vector layers) produce the same dabs on every thread.
+  static void seedJitter(uint32_t seed);
   BrushEngine();
   ~BrushEngine(); // Needed for unique_ptr cleanup if used, or raw pointer
                   // delete
@@ -341,6 +379,9 @@ public:
   // Compatibility methods for CanvasItem integration
   void setBrush(const BrushSettings &settings); // Implemented in cpp or inline
   BrushSettings getBrush() const { return m_currentSettings; }
+  // Immutable copy of the current settings, reused until setBrush/setColor
+  // changes them: every vector stroke drawn with one brush shares it.
+  std::shared_ptr<const BrushSettings> sharedBrush() const;
 
   void setColor(const Color &color); // Updated to update cache
   const Color &getColor() const;
@@ -366,6 +407,7 @@ public:
 
 private:
   BrushSettings m_currentSettings;
+  mutable std::shared_ptr<const BrushSettings> m_sharedSettings;
   StrokeRenderer *m_renderer = nullptr;
 
   // State for continueStroke
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "curve_lut.h"
 #include <QColor>
 #include <QJsonArray>
 #include <QJsonObject>
@@ -19,27 +20,12 @@ struct ResponseCurve {
   float cx1 = 0.0f, cy1 = 0.0f;
   float cx2 = 1.0f, cy2 = 1.0f;
 
-  // Pre-baked LUT for fast lookup (256 entries)
-  float lut[256];
+  // Pre-baked LUT, shared with every curve that has the same controls
+  CurveLUT lut;
 
-  void bake() {
-    for (int i = 0; i < 256; ++i) {
-      float t = i / 255.0f;
-      lut[i] = evalCubicBezier(t);
-    }
-  }
+  void bake() { lut = CurveLUT::cachedBezier(cx1, cy1, cx2, cy2); }
 
-  float evaluate(float input) const {
-    if (input <= 0.0f)
-      return lut[0];
-    if (input >= 1.0f)
-      return lut[255];
-    float idx = input * 255.0f;
-    int lo = (int)idx;
-    int hi = lo < 255 ? lo + 1 : 255;
-    float frac = idx - lo;
-    return lut[lo] * (1.0f - frac) + lut[hi] * frac;
-  }
+  float evaluate(float input) const { return lut.evaluate(input); }
 
   static ResponseCurve linear() {
     ResponseCurve c;
@@ -104,39 +90,6 @@ struct ResponseCurve {
     c.bake();
     return c;
   }
-
-private:
-  // Attempt to find y for a given x on the Bezier, by iterating t
-  float evalCubicBezier(float x) const {
-    // Newton's method: find t such that bezierX(t) == x
-    float t = x; // initial guess
-    for (int i = 0; i < 8; ++i) {
-      float bx = bezierComponent(t, 0.0f, cx1, cx2, 1.0f);
-      float dx = bx - x;
-      if (std::abs(dx) < 1e-6f)
-        break;
-      float dbx = bezierDerivative(t, 0.0f, cx1, cx2, 1.0f);
-      if (std::abs(dbx) < 1e-6f)
-        break;
-      t -= dx / dbx;
-      t = std::max(0.0f, std::min(1.0f, t));
-    }
-    return bezierComponent(t, 0.0f, cy1, cy2, 1.0f);
-  }
-
-  static float bezierComponent(float t, float p0, float p1, float p2,
-                               float p3) {
-    float mt = 1.0f - t;
-    return mt * mt * mt * p0 + 3.0f * mt * mt * t * p1 +
-           3.0f * mt * t * t * p2 + t * t * t * p3;
-  }
-
-  static float bezierDerivative(float t, float p0, float p1, float p2,
-                                float p3) {
-    float mt = 1.0f - t;
-    return 3.0f * mt * mt * (p1 - p0) + 6.0f * mt * t * (p2 - p1) +
-           3.0f * t * t * (p3 - p2);
-  }
 };
 
 // ============================================================
@@ -1,26 +1,73 @@
 #pragma once
 
+#include "image_buffer.h"
 #include <QImage>
 #include <QColor>
-#include <QPainterPath>
+#include <array>
+#include <cstdint>
+#include <vector>
 
 namespace artflow {
 
 class ColorRangeSelector {
 public:
+    // Longest side of the preview proxy
+    static constexpr int kProxySize = 512;
+
     ColorRangeSelector();
     ~ColorRangeSelector();
 
+    // Layer whose pixels are sampled. The hue / saturation the HSV channel
+    // modes compare are converted once per source tile and reused until that
+    // tile is edited; a different layer (id) or size drops them.
+    void setSource(const ImageBuffer *buffer, uint32_t sourceId);
+    void clearSource();
+
+    // Grayscale mask of the whole source, one task per source tile
+    QImage selectByColor(const QColor &targetColor, float tolerance, int channelMode,
+                         float fuzziness, bool invert);
+    // Mask overlay (see previewMask) of a box-filtered proxy of the source,
+    // longest side <= kProxySize, for slider feedback. The proxy is only
+    // rebuilt after the source changed.
+    QImage previewByColor(const QColor &targetColor, float tolerance, int channelMode,
+                          float fuzziness, bool invert);
+
     // Generates a grayscale mask (8-bit) representing the selected region
+    // of a standalone image (nothing cached)
     QImage selectByColor(const QImage &image, const QColor &targetColor,
                          float tolerance, int channelMode, float fuzziness,
                          bool invert) const;
 
-    // Converts the grayscale mask into a QPainterPath using a robust span-based approach
-    QPainterPath maskToPath(const QImage &mask) const;
-
     // Generates an RGBA preview of the mask overlay
     QImage previewMask(const QImage &image, const QImage &mask) const;
+
+private:
+    // Hue / saturation per pixel, row-major; empty = not converted yet
+    using Planes = std::array<std::vector<uint16_t>, 2>;
+    struct SourceTile {
+        const ImageBuffer::Tile *tile = nullptr; // as of the conversion
+        uint32_t revision = 0;
+        Planes planes;
+    };
+
+    // Drops the conversions of source tiles edited since they were made
+    void refresh();
+    void buildProxy();
+
+    const ImageBuffer *m_source = nullptr;
+    uint32_t m_sourceId = 0;
+    int m_width = 0;
+    int m_height = 0;
+    int m_tilesX = 0;
+    std::vector<SourceTile> m_tiles;
+
+    // Proxy pixel = RGBA average of m_proxyStep² source pixels
+    int m_proxyStep = 1;
+    int m_proxyWidth = 0;
+    int m_proxyHeight = 0;
+    bool m_proxyValid = false;
+    std::vector<uint8_t> m_proxyRgba;
+    Planes m_proxyPlanes;
 };
 
 } // namespace artflow
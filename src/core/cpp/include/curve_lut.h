@@ -0,0 +1,73 @@
+/**
+ * ArtFlow Studio - Curve LUT
+ * Shared response-curve engine: bake once, look up per sample
+ */
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace artflow {
+
+/**
+ * CurveLUT - A y = f(x) curve on [0,1] baked into a 1024-entry table.
+ *
+ * Pressure curves, easing curves and the global pressure spline all go
+ * through here, so the cubic solver runs only when a curve changes and the
+ * hot path (tablet samples, timeline playback) is a lerp between two
+ * entries. Tables are immutable and shared between copies; identical Bezier
+ * curves reuse the same table through a small process-wide cache.
+ */
+class CurveLUT {
+public:
+  static constexpr int kSize = 1024;
+  using Table = std::array<float, kSize>;
+
+  CurveLUT() = default; // identity
+
+  // Cubic Bezier with P0=(0,0), P3=(1,1) and control points P1, P2
+  void bakeBezier(float x1, float y1, float x2, float y2);
+
+  // Monotone cubic Hermite spline through (x,y) points (any order)
+  void bakeMonotoneSpline(std::vector<std::pair<float, float>> points);
+
+  void setIdentity();
+  bool isIdentity() const { return !m_table; }
+
+  // True when this LUT was baked from exactly these Bezier controls
+  bool matchesBezier(float x1, float y1, float x2, float y2) const {
+    return m_isBezier && m_bezier[0] == x1 && m_bezier[1] == y1 &&
+           m_bezier[2] == x2 && m_bezier[3] == y2;
+  }
+
+  float evaluate(float x) const {
+    if (!m_table)
+      return x < 0.0f ? 0.0f : (x > 1.0f ? 1.0f : x);
+    if (x <= 0.0f)
+      return (*m_table)[0];
+    if (x >= 1.0f)
+      return (*m_table)[kSize - 1];
+    const float pos = x * (kSize - 1);
+    const int lo = static_cast<int>(pos);
+    const float frac = pos - lo;
+    const float a = (*m_table)[lo];
+    return a + ((*m_table)[lo + 1] - a) * frac;
+  }
+
+  // Shared table for a Bezier curve (baked on first use)
+  static CurveLUT cachedBezier(float x1, float y1, float x2, float y2);
+
+  // Exact solver, used while baking and for one-off evaluations: y on the
+  // Bezier for input x
+  static float solveBezier(float x, float x1, float y1, float x2, float y2);
+
+private:
+  std::shared_ptr<const Table> m_table; // null = identity
+  bool m_isBezier = false;
+  float m_bezier[4] = {0.0f, 0.0f, 1.0f, 1.0f};
+};
+
+} // namespace artflow
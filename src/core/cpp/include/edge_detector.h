@@ -1,28 +1,58 @@
 #pragma once
 
-#include <QImage>
+#include "image_buffer.h"
 #include <QPointF>
+#include <QRect>
+#include <array>
+#include <cstdint>
+#include <memory>
 #include <vector>
 
 namespace artflow {
 
+class LiveWire;
+
 class EdgeDetector {
 public:
+    // Gradient tiles are kTileSize² pixels of their pyramid level; level L
+    // is the source box-filtered by 2^L before Sobel.
+    static constexpr int kTileSize = 64;
+    static constexpr int kLevels = 4;
+
     EdgeDetector();
     ~EdgeDetector();
 
-    // Precomputes gradient map from an image using 3x3 Sobel kernels
-    void computeGradientMap(const QImage &image);
+    // Layer whose pixels (premultiplied RGBA tiles) feed the detector. Nothing
+    // is computed here: gradient tiles are built on demand around the queries
+    // and cached until a source tile under them is dirtied. A different
+    // layer (id) or size drops the cache.
+    void setSource(const ImageBuffer *buffer, uint32_t sourceId);
+    void clearSource();
 
-    // Snaps the given coordinates to the nearby pixel with the strongest gradient
+    // Snaps the given coordinates to the nearby pixel with the strongest gradient.
+    // Wide radii (low zoom) scan a coarser level first and refine at full res.
     QPointF findEdgePoint(const QPointF &point, int searchRadius) const;
 
-    // Generates a path adhering to high gradient edges between points A and B
-    std::vector<QPointF> traceEdgePath(const QPointF &pA, const QPointF &pB) const;
+    // Generates a path adhering to high gradient edges between points A and B.
+    // Consecutive calls from the same A reuse one live-wire search tree.
+    // `budget` caps the pixels settled by this call (LiveWire::kFrameBudget
+    // for rubber-band previews): when it runs out the result is empty and
+    // the next call resumes the search. 0 is for clicks: a budget scaled to
+    // the padded box around A and B, then a straight segment A-B.
+    std::vector<QPointF> traceEdgePath(const QPointF &pA, const QPointF &pB,
+                                       size_t budget = 0) const;
+
+    // Gradient magnitudes [0-255] of `rect` (pixels of `level`), row-major,
+    // rect.width() per row; outside the canvas reads 0. Missing tiles are
+    // computed in parallel.
+    void gradientWindow(const QRect &rect, int level, std::vector<uint8_t> &out) const;
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
 
     // Setters / Getters
     float edgeSensitivity() const { return m_edgeSensitivity; }
-    void setEdgeSensitivity(float value) { m_edgeSensitivity = value; }
+    void setEdgeSensitivity(float value);
 
     int searchRadius() const { return m_searchRadius; }
     void setSearchRadius(int value) { m_searchRadius = value; }
@@ -31,16 +61,40 @@ public:
     void setPathResolution(int value) { m_pathResolution = value; }
 
 private:
+    // Source tile read by a gradient tile, as it was when it was read
+    struct SourceStamp {
+        int x = 0, y = 0; // any pixel of the source tile
+        const ImageBuffer::Tile *tile = nullptr;
+        uint32_t revision = 0;
+    };
+    struct GradientTile {
+        std::vector<uint8_t> magnitude; // kTileSize², empty = not computed
+        std::vector<SourceStamp> sources;
+    };
+    struct Level {
+        int width = 0, height = 0;
+        int tilesX = 0, tilesY = 0;
+        std::vector<GradientTile> tiles;
+    };
+
+    bool tileValid(const GradientTile &tile) const;
+    void computeTile(int level, int tx, int ty) const;
+    // Makes every tile of `level` under `rect` current
+    void ensureTiles(const QRect &rect, int level) const;
+    // Strongest pixel of `rect` at `level`, the one nearest `seed` among
+    // equals; `seed` itself (with its value) when nothing beats it
+    QPoint scanMax(const QRect &rect, int level, QPoint seed, int &value) const;
+
     float m_edgeSensitivity;
     int m_searchRadius;
     int m_pathResolution;
 
+    const ImageBuffer *m_source = nullptr;
+    uint32_t m_sourceId = 0;
     int m_width;
     int m_height;
-    std::vector<float> m_gradientMap; // Magnitude map [0.0 - 1.0]
-
-    // Helper to get gradient value safely
-    float getGradientAt(int x, int y) const;
+    mutable std::array<Level, kLevels> m_levels;
+    mutable std::unique_ptr<LiveWire> m_liveWire;
 };
 
 } // namespace artflow
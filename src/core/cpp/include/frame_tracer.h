@@ -0,0 +1,101 @@
+/**
+ * ArtFlow Studio - Frame Tracer
+ * Optional Chrome Trace Event recorder for the frame pipeline
+ */
+
+#pragma once
+
+#include <QString>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace artflow {
+
+/**
+ * FrameTracer - Collects "complete" (ph:X) events while enabled and writes
+ * them as Chrome Trace Event JSON (chrome://tracing, Perfetto).
+ *
+ * Disabled by default. A disabled ScopedTrace costs one relaxed atomic load;
+ * nothing is timed or allocated. Event names and categories must be string
+ * literals (only the pointer is stored).
+ */
+class FrameTracer {
+public:
+  static constexpr size_t kMaxEvents = 1 << 19; // ~16 MB, then events drop
+
+  static FrameTracer *instance();
+
+  bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+  void setEnabled(bool enabled);
+
+  // Microseconds since the tracer was created (trace timestamp base)
+  uint64_t nowUs() const;
+
+  void addComplete(const char *name, const char *category, uint64_t startUs,
+                   uint64_t durationUs);
+
+  size_t eventCount() const;
+  void clear();
+
+  // {"traceEvents": [...], "displayTimeUnit": "ms"}
+  bool writeJson(const QString &path) const;
+
+private:
+  FrameTracer();
+
+  struct Event {
+    const char *name;
+    const char *category;
+    uint64_t ts;
+    uint64_t dur;
+    uint32_t tid;
+  };
+
+  // Small sequential id per thread; the first call registers its name
+  uint32_t currentThreadId();
+
+  std::atomic<bool> m_enabled{false};
+  uint64_t m_epochNs = 0;
+
+  mutable std::mutex m_mutex;
+  std::vector<Event> m_events;
+  std::map<uint32_t, std::string> m_threadNames;
+  size_t m_dropped = 0;
+};
+
+/**
+ * ScopedTrace - Emits one complete event covering the scope, if tracing was
+ * enabled when the scope was entered.
+ */
+class ScopedTrace {
+public:
+  explicit ScopedTrace(const char *name, const char *category = "frame") {
+    FrameTracer *tracer = FrameTracer::instance();
+    if (tracer->isEnabled()) {
+      m_name = name;
+      m_category = category;
+      m_start = tracer->nowUs();
+    }
+  }
+  ~ScopedTrace() {
+    if (m_name) {
+      FrameTracer *tracer = FrameTracer::instance();
+      tracer->addComplete(m_name, m_category, m_start,
+                          tracer->nowUs() - m_start);
+    }
+  }
+
+  ScopedTrace(const ScopedTrace &) = delete;
+  ScopedTrace &operator=(const ScopedTrace &) = delete;
+
+private:
+  const char *m_name = nullptr;
+  const char *m_category = nullptr;
+  uint64_t m_start = 0;
+};
+
+} // namespace artflow
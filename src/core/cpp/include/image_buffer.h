@@ -13,6 +13,8 @@
 
 namespace artflow {
 
+class SelectionMask;
+
 /**
  * ImageBuffer - RGBA pixel buffer for layer/canvas data
  */
@@ -47,6 +49,10 @@ public:
   void floodFill(int x, int y, uint8_t r, uint8_t g, uint8_t b, uint8_t a,
                  float threshold = 0.1f, const ImageBuffer *mask = nullptr,
                  bool alphaLock = false);
+  // Same, confined to a selection mask read in place (no RGBA copy)
+  void floodFill(int x, int y, uint8_t r, uint8_t g, uint8_t b, uint8_t a,
+                 float threshold, const SelectionMask *mask,
+                 bool alphaLock = false);
 
   // Blend a color onto pixel with alpha blending. Optional alphaLock restricts
   // painting to areas that already have some alpha.
@@ -66,6 +72,8 @@ public:
   void composite(const ImageBuffer &other, int offsetX = 0, int offsetY = 0,
                  float opacity = 1.0f, BlendMode mode = BlendMode::Normal,
                  const ImageBuffer *mask = nullptr);
+  void composite(const ImageBuffer &other, int offsetX, int offsetY,
+                 float opacity, BlendMode mode, const SelectionMask *mask);
 
   // Get raw bytes for Python/QML interop
   std::vector<uint8_t> getBytes() const;
@@ -91,6 +99,21 @@ public:
   // Efficiently load from a contiguous buffer
   void loadRawData(const uint8_t *rawData);
 
+  // Copy a rect of RGBA rows straight into the tile grid (no data() cache
+  // round-trip). bottomUp reads rows in OpenGL order. Unallocated tiles stay
+  // sparse when the incoming pixels are fully transparent.
+  void writeRegion(int x, int y, int w, int h, const uint8_t *src,
+                   int srcStride, bool bottomUp = false);
+
+  // Inverse of writeRegion: copy a rect of the tile grid into `dst`.
+  // Unallocated tiles and out-of-bounds pixels read as transparent.
+  void readRegion(int x, int y, int w, int h, uint8_t *dst,
+                  int dstStride) const;
+
+  // Call after writing tile memory directly (getTile()->data) so the next
+  // data() rebuilds its contiguous cache.
+  void invalidateCache() { m_cacheDirty = true; }
+
   // Tile dimensions
   static constexpr int TILE_SIZE = 256;
   static constexpr int TILE_PIXELS = TILE_SIZE * TILE_SIZE;
@@ -100,6 +123,9 @@ public:
     int startX, startY;
     std::unique_ptr<uint8_t[]> data;
     bool dirty = false; // Flag to easily sync to GPU/Compositor
+    // Bumped each time clearDirtyFlags() consumes an edit, so caches derived
+    // from the pixels (edge gradients) can tell the tile changed since
+    uint32_t revision = 0;
 
     Tile(int sx, int sy)
         : startX(sx), startY(sy), data(new uint8_t[TILE_BYTES]()) {
@@ -124,8 +150,10 @@ public:
 
   void clearDirtyFlags() {
     for (auto &tile : m_tiles) {
-      if (tile)
+      if (tile && tile->dirty) {
         tile->dirty = false;
+        ++tile->revision;
+      }
     }
   }
 
@@ -144,6 +172,15 @@ private:
 
   void ensureCacheUpToDate() const;
 
+  // Shared bodies of the ImageBuffer / SelectionMask mask overloads
+  template <typename Mask>
+  void floodFillMasked(int x, int y, uint8_t r, uint8_t g, uint8_t b,
+                       uint8_t a, float threshold, const Mask *mask,
+                       bool alphaLock);
+  template <typename Mask>
+  void compositeMasked(const ImageBuffer &other, int offsetX, int offsetY,
+                       float opacity, BlendMode mode, const Mask *mask);
+
   // Converts global (x,y) into tile local memory index
   size_t pixelIndexLocal(int lx, int ly) const {
     return static_cast<size_t>((ly * TILE_SIZE + lx) * 4);
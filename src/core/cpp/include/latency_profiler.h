@@ -0,0 +1,117 @@
+/**
+ * ArtFlow Studio - Latency Profiler
+ * Input-to-pixel timing for the stroke pipeline
+ */
+
+#pragma once
+
+#include <QJsonObject>
+#include <QString>
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace artflow {
+
+enum class LatencyStage : int {
+  Input = 0,     // tabletEvent handling (includes everything below it)
+  Stabilize,     // handleDraw stabilizer
+  DabGeneration, // BrushEngine dab placement
+  GpuSubmit,     // BrushEngine GL draw calls
+  Readback,      // syncGpuToCpu at stroke end
+  Composite,     // CPU layer composite into the cached canvas image
+  Paint,         // whole CanvasItem::paint()
+  InputToPaint,  // oldest unpresented tablet sample -> end of paint()
+  Count
+};
+
+/**
+ * LatencyProfiler - Rolling window of timings per stage.
+ *
+ * Each stage is a fixed ring of the last kCapacity samples (microseconds).
+ * Writers claim a slot with one fetch_add and store relaxed, so timers can
+ * fire from the GUI and render threads without locks; readers take a
+ * best-effort snapshot.
+ */
+class LatencyProfiler {
+public:
+  static constexpr int kCapacity = 512;
+  static constexpr int kStageCount = static_cast<int>(LatencyStage::Count);
+
+  struct Percentiles {
+    double p50 = 0.0; // ms
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+    int count = 0;
+  };
+
+  static LatencyProfiler *instance();
+
+  static const char *stageName(LatencyStage stage);
+  static uint64_t nowNs();
+
+  void record(LatencyStage stage, uint64_t elapsedNs);
+
+  // A tablet sample arrived. Only the first one since the last presented
+  // frame is kept, so InputToPaint measures the worst case of the batch.
+  void markInput();
+  // A frame finished painting: closes the pending input, if any.
+  void markPresented();
+
+  Percentiles percentiles(LatencyStage stage) const;
+
+  // {"stages": {name: {p50_ms, p95_ms, p99_ms, max_ms, count, samples_us}}}
+  QJsonObject toJson() const;
+  bool dumpToFile(const QString &path) const;
+
+  void reset();
+
+private:
+  LatencyProfiler() = default;
+
+  struct Ring {
+    std::array<std::atomic<uint32_t>, kCapacity> samples{};
+    std::atomic<uint32_t> head{0};
+  };
+
+  std::array<Ring, kStageCount> m_rings;
+  std::atomic<uint64_t> m_pendingInputNs{0};
+};
+
+/**
+ * ScopedLatencyTimer - Records the lifetime of the scope into `stage`.
+ */
+class ScopedLatencyTimer {
+public:
+  explicit ScopedLatencyTimer(LatencyStage stage)
+      : m_stage(stage), m_start(LatencyProfiler::nowNs()) {}
+  ~ScopedLatencyTimer() {
+    LatencyProfiler::instance()->record(m_stage,
+                                        LatencyProfiler::nowNs() - m_start);
+  }
+
+  ScopedLatencyTimer(const ScopedLatencyTimer &) = delete;
+  ScopedLatencyTimer &operator=(const ScopedLatencyTimer &) = delete;
+
+private:
+  LatencyStage m_stage;
+  uint64_t m_start;
+};
+
+/**
+ * ScopedFrameTimer - Paint timer that also closes InputToPaint on exit.
+ */
+class ScopedFrameTimer {
+public:
+  ScopedFrameTimer() : m_timer(LatencyStage::Paint) {}
+  ~ScopedFrameTimer() { LatencyProfiler::instance()->markPresented(); }
+
+  ScopedFrameTimer(const ScopedFrameTimer &) = delete;
+  ScopedFrameTimer &operator=(const ScopedFrameTimer &) = delete;
+
+private:
+  ScopedLatencyTimer m_timer;
+};
+
+} // namespace artflow
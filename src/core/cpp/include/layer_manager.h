@@ -119,6 +119,13 @@ public:
   // Composite all visible layers
   void compositeAll(ImageBuffer &output, bool skipPrivate = false) const;
 
+  // Composite the `region` of the canvas rendered at `scale` (region is in
+  // scaled pixels, output is region-sized). Vector layers are re-rasterized
+  // at that scale, raster layers are resampled. Export at print DPI calls it
+  // band by band, so no layer ever exists at full export size.
+  void compositeRegionScaled(ImageBuffer &output, const QRect &region,
+                             float scale, bool skipPrivate = false) const;
+
   // Canvas dimensions
   int width() const { return m_width; }
   int height() const { return m_height; }
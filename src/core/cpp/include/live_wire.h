@@ -0,0 +1,79 @@
+#pragma once
+
+#include <QPointF>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace artflow {
+
+class EdgeDetector;
+
+// Live-wire (intelligent scissors) path search for the magnetic lasso.
+//
+// Keeps the shortest-path tree grown from the last anchor instead of running
+// a fresh search per cursor move: a target the tree already settled is a
+// parent-pointer walk, and a new one only expands the frontier until it is
+// settled. Edge costs are small integers, so the frontier is a circular
+// bucket queue (Dial's algorithm) rather than a heap. Per-pixel state lives
+// in 64x64 blocks allocated as the frontier reaches them and recycled on the
+// next anchor, so nothing is sized to the canvas.
+class LiveWire {
+public:
+    // Settle budget for one rubber-band update (~4 ms on a blank canvas,
+    // the worst case: every pixel costs the same)
+    static constexpr size_t kFrameBudget = 1 << 16;
+
+    explicit LiveWire(const EdgeDetector &detector);
+    ~LiveWire();
+
+    // Starts a new tree at `anchor` (canvas pixels). Gradients and edge
+    // sensitivity are read from the detector from here on.
+    void setAnchor(const QPointF &anchor);
+    bool isAnchoredAt(const QPointF &point) const;
+    // Drops the tree (layer or sensitivity changed)
+    void reset();
+
+    // Pixel path anchor -> target, both included. Settles at most `budget`
+    // more pixels (0 = no limit); empty when the target was not reached
+    // within it; later calls resume where this one stopped.
+    std::vector<QPointF> pathTo(const QPointF &target, size_t budget = 0);
+
+private:
+    static constexpr int kBlockShift = 6;
+    static constexpr int kBlock = 1 << kBlockShift;
+    static constexpr int kBuckets = 128; // > largest edge cost
+
+    struct Block {
+        std::vector<uint32_t> dist;    // kBlock², UINT32_MAX = unreached
+        std::vector<uint8_t> state;    // bits 0-2: step from parent, 3: has parent, 4: settled
+        std::vector<uint8_t> gradient; // detector magnitudes
+        bool inside = false;           // whole block on the canvas (no padding)
+    };
+
+    Block &block(int x, int y);
+    bool settled(int x, int y) const;
+    void push(uint32_t node, uint32_t dist);
+    // Settles nodes until `target` is settled or the budget runs out
+    bool expand(uint32_t target, size_t budget);
+
+    const EdgeDetector &m_detector;
+    int m_width = 0;
+    int m_height = 0;
+    int m_blocksX = 0;
+    bool m_anchored = false;
+    int m_anchorX = 0;
+    int m_anchorY = 0;
+
+    std::vector<std::unique_ptr<Block>> m_blocks; // block grid, null = untouched
+    std::vector<int> m_touched;                   // allocated grid slots
+    std::vector<std::unique_ptr<Block>> m_pool;   // recycled blocks
+
+    std::vector<std::vector<uint32_t>> m_buckets; // node = y << 16 | x
+    uint32_t m_current = 0;                       // distance being popped
+    size_t m_queued = 0;
+    uint16_t m_cost[2][256] = {};                 // [diagonal][gradient]
+};
+
+} // namespace artflow
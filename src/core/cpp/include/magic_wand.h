@@ -0,0 +1,31 @@
+#pragma once
+
+#include "image_buffer.h"
+#include "selection_mask.h"
+
+namespace artflow {
+
+// Magic wand: the region similar in color to a seed pixel, written straight
+// into selection mask tiles (only the tiles it reaches are allocated, so
+// combining it into a large selection stays cheap).
+class MagicWand {
+public:
+    struct Options {
+        // RGBA distance limit as a fraction of the largest one (510)
+        float tolerance = 0.15f;
+        // Grow from the seed through 4-connected neighbours (scanline fill
+        // shared with ImageBuffer::floodFill); off = every similar pixel
+        bool contiguous = true;
+        // Ramp coverage down over pixels just past the tolerance instead of
+        // cutting at it (the rim of a contiguous region, any pixel in
+        // global mode)
+        bool antiAlias = true;
+    };
+
+    // Region around (x, y) of `source` (premultiplied RGBA; unallocated
+    // tiles read transparent), as a mask the size of the source. Empty if
+    // the seed is outside.
+    static SelectionMask select(const ImageBuffer &source, int x, int y, const Options &options);
+};
+
+} // namespace artflow
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <QPointF>
+#include <QRectF>
+#include <vector>
+
+namespace artflow {
+
+// Warp surface of the mesh transform: a (columns + 1) x (rows + 1) grid of
+// canvas control points over the lifted source, interpolated per cell.
+//
+// The surface is tessellated once into a fine lattice of triangles (at most
+// kLatticeStep canvas px per side) carrying their source coordinates. The
+// GPU preview draws those triangles and TransformWarp::drawMesh rasterizes
+// the very same ones on the CPU, so the committed pixels match the preview.
+class MeshWarp {
+public:
+    enum class Interpolation {
+        Bilinear,  // each cell a bilinear patch between its four corners
+        CatmullRom // smooth surface through every control point
+    };
+
+    struct Vertex {
+        float x, y; // canvas px
+        float u, v; // source px
+    };
+
+    static constexpr float kLatticeStep = 16.0f;
+    static constexpr int kMaxSubdivision = 32;
+
+    MeshWarp() = default;
+    // `points` row-major, canvas coordinates; an invalid (empty) warp if
+    // their count does not match the grid
+    MeshWarp(int columns, int rows, const std::vector<QPointF> &points, int sourceWidth,
+             int sourceHeight, Interpolation interpolation = Interpolation::CatmullRom);
+
+    bool isValid() const { return !m_vertices.empty(); }
+    int columns() const { return m_columns; }
+    int rows() const { return m_rows; }
+    int sourceWidth() const { return m_sourceWidth; }
+    int sourceHeight() const { return m_sourceHeight; }
+    Interpolation interpolation() const { return m_interpolation; }
+    const std::vector<QPointF> &points() const { return m_points; }
+
+    // Canvas position of source point (sx, sy) on the exact surface
+    QPointF map(double sx, double sy) const;
+
+    // Tessellation: (latticeColumns + 1) x (latticeRows + 1) vertices,
+    // row-major; lattice cell (i, j) splits into (TL, TR, BL) and
+    // (BL, TR, BR)
+    int latticeColumns() const { return m_latticeColumns; }
+    int latticeRows() const { return m_latticeRows; }
+    const std::vector<Vertex> &vertices() const { return m_vertices; }
+    // Canvas bounds of the tessellation
+    QRectF bounds() const { return m_bounds; }
+    // The lattice triangles as GL_TRIANGLES of (x, y, u / width, v / height)
+    std::vector<float> triangleVertices() const;
+
+private:
+    // Control point; beyond the border, linearly extrapolated from it
+    QPointF control(int column, int row) const;
+    // Surface at grid parameter (s, t), s in [0, columns], t in [0, rows]
+    QPointF evaluate(double s, double t) const;
+
+    int m_columns = 0;
+    int m_rows = 0;
+    int m_sourceWidth = 0;
+    int m_sourceHeight = 0;
+    Interpolation m_interpolation = Interpolation::CatmullRom;
+    std::vector<QPointF> m_points;
+
+    int m_latticeColumns = 0;
+    int m_latticeRows = 0;
+    std::vector<Vertex> m_vertices;
+    QRectF m_bounds;
+};
+
+} // namespace artflow
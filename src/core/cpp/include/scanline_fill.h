@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace artflow {
+
+// Scanline flood fill over a width x height grid, 4-connected from (x, y).
+// `accept(x, y)` decides membership and is asked at most once per pixel, so
+// it may record something for the pixels it rejects; `span(y, x0, x1)` gets
+// every filled run [x0, x1] exactly once. The bucket fill and the magic wand
+// share it and differ only in what they test and write.
+template <typename Accept, typename Span>
+void scanlineFill(int width, int height, int x, int y, Accept &&accept, Span &&span) {
+    if (x < 0 || y < 0 || x >= width || y >= height) return;
+
+    // One bit per pixel: already tested, accepted or not
+    std::vector<uint64_t> seen((static_cast<size_t>(width) * height + 63) / 64, 0);
+    auto test = [&](int px, int py) {
+        const size_t i = static_cast<size_t>(py) * width + px;
+        const uint64_t bit = uint64_t(1) << (i & 63);
+        if (seen[i >> 6] & bit) return false;
+        seen[i >> 6] |= bit;
+        return static_cast<bool>(accept(px, py));
+    };
+
+    struct Run {
+        int y, x0, x1; // accepted pixels, not yet extended sideways
+    };
+    std::vector<Run> stack;
+    if (!test(x, y)) return;
+    stack.push_back({y, x, x});
+
+    while (!stack.empty()) {
+        const Run run = stack.back();
+        stack.pop_back();
+        int x0 = run.x0, x1 = run.x1;
+        while (x0 > 0 && test(x0 - 1, run.y)) --x0;
+        while (x1 < width - 1 && test(x1 + 1, run.y)) ++x1;
+        span(run.y, x0, x1);
+
+        // Accepted runs of the rows above and below become new seeds
+        for (const int ny : {run.y - 1, run.y + 1}) {
+            if (ny < 0 || ny >= height) continue;
+            for (int nx = x0; nx <= x1; ++nx) {
+                if (!test(nx, ny)) continue;
+                const int start = nx;
+                while (nx < x1 && test(nx + 1, ny)) ++nx;
+                stack.push_back({ny, start, nx});
+            }
+        }
+    }
+}
+
+} // namespace artflow
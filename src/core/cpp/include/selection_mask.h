@@ -0,0 +1,157 @@
+#pragma once
+
+#include <QImage>
+#include <QPainterPath>
+#include <QRect>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace artflow {
+
+// Canvas selection as a sparse grid of 8-bit coverage tiles.
+//
+// Tiles are immutable and shared: copying a mask (undo snapshots) copies
+// pointers, and every edit swaps in new tiles. An empty tile is null and a
+// fully selected one points at a single shared tile, so boolean operations
+// on large areas only touch the tiles along the shape's border. Texels of
+// edge tiles beyond the canvas are ignored.
+class SelectionMask {
+public:
+    static constexpr int kTileSize = 64;
+    static constexpr int kTilePixels = kTileSize * kTileSize;
+    // Coverage at or above this counts as selected for contours and clip path
+    static constexpr uint8_t kInside = 128;
+
+    enum class Op { Replace, Add, Subtract, Intersect };
+
+    struct Tile {
+        uint8_t data[kTilePixels];
+    };
+
+    // Writes coverage into a mask tile by tile (region growers). A tile is
+    // copied out when first touched and swapped back in, re-shared if it
+    // came out uniform, by finish(). Different tiles may be written from
+    // different threads.
+    class Writer {
+    public:
+        explicit Writer(SelectionMask &mask);
+        ~Writer();
+
+        // Coverage of [x0, x1) on row y (inside the canvas)
+        void fill(int y, int x0, int x1, uint8_t value);
+        void set(int x, int y, uint8_t value) {
+            tile(x / kTileSize, y / kTileSize).data[(y % kTileSize) * kTileSize + x % kTileSize] = value;
+        }
+        void finish();
+
+    private:
+        Tile &tile(int tx, int ty);
+
+        SelectionMask &m_mask;
+        std::vector<std::unique_ptr<Tile>> m_tiles;
+    };
+
+    SelectionMask(int width = 0, int height = 0);
+    SelectionMask(const SelectionMask &other);
+    SelectionMask &operator=(const SelectionMask &other);
+    ~SelectionMask();
+
+    // Antialiased coverage of `path` (canvas coordinates), rasterized in
+    // parallel tile rows
+    static SelectionMask fromPath(const QPainterPath &path, int width, int height);
+    // Coverage from an 8-bit image (Grayscale8 / Alpha8; others are
+    // converted to their alpha) the size of the canvas
+    static SelectionMask fromImage(const QImage &image);
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    int tilesX() const { return m_tilesX; }
+    int tilesY() const { return m_tilesY; }
+
+    bool isEmpty() const;
+    // Tight bounds of every pixel with non-zero coverage
+    QRect boundingRect() const;
+
+    // Coverage [0-255] at (x, y); 0 outside the canvas
+    uint8_t value(int x, int y) const {
+        if (static_cast<unsigned>(x) >= static_cast<unsigned>(m_width) ||
+            static_cast<unsigned>(y) >= static_cast<unsigned>(m_height))
+            return 0;
+        const Tile *tile = m_tiles[(y / kTileSize) * m_tilesX + x / kTileSize].get();
+        return tile ? tile->data[(y % kTileSize) * kTileSize + x % kTileSize] : 0;
+    }
+    // Row-major kTileSize² coverage of tile (tx, ty); null = nothing selected
+    const uint8_t *tileData(int tx, int ty) const {
+        const Tile *tile = m_tiles[ty * m_tilesX + tx].get();
+        return tile ? tile->data : nullptr;
+    }
+
+    void clear();
+    void selectAll();
+    void invert();
+    // Merges `other` (same size) into this mask: Add keeps the max coverage,
+    // Subtract removes `other`'s, Intersect keeps the min
+    void combine(const SelectionMask &other, Op op);
+
+    // Edge operations, radius in canvas px. Each works on the selection's
+    // bounds grown by its reach, in parallel tile rows / tile columns.
+    // Grow and shrink move the edge by an exact Euclidean distance
+    // (separable distance transform); the canvas border never shrinks.
+    void grow(float radius);
+    void shrink(float radius);
+    // Gaussian falloff (sigma = radius / 2) from three box blurs
+    void feather(float radius);
+    // Rounds off jaggies and corners smaller than `radius`
+    void smooth(float radius);
+
+    // Selected area (coverage >= kInside) as merged pixel rectangles, for
+    // QPainter clipping. Rebuilt only for tiles that changed since the last
+    // call.
+    const QPainterPath &clipPath() const;
+    // Selected area (coverage >= kInside) as closed polygons traced along
+    // the pixel edges and simplified to `tolerance` px
+    // (Ramer-Douglas-Peucker); specks and pinholes of at most tolerance²
+    // px are dropped. Outer contours run clockwise and holes
+    // counter-clockwise, so either fill rule keeps the holes. The canvas
+    // draws it as the marching ants. Edges are re-extracted only from tiles
+    // that changed since the last call, and only the rings through them
+    // are re-chained.
+    QPainterPath contourPath(float tolerance = 1.0f) const;
+
+private:
+    struct Cache;
+    using TilePtr = std::shared_ptr<const Tile>;
+
+    static const TilePtr &fullTile();
+    QRect tileRect(int index) const;
+    // Null / fullTile() when the canvas part of `tile` is uniform
+    TilePtr normalized(std::unique_ptr<Tile> tile, int index) const;
+    Cache &cache() const;
+    // Contour edges owned by tile `index`, into its cache entry
+    void extractContourEdges(int index) const;
+    // Chains the (tile, edge) cache references into new rings
+    void chainContours(const std::vector<std::pair<int, int>> &refs) const;
+    // Dense copy of `rect` (inside the canvas), rect.width() bytes per row
+    void readRegion(const QRect &rect, uint8_t *dst) const;
+    // Writes a dense `rect` back, re-sharing tiles that came out uniform
+    void writeRegion(const QRect &rect, const uint8_t *src);
+    // Selection bounds grown by `margin`, clipped to the canvas
+    QRect workRect(int margin) const;
+    // Distance to the nearest seed pixel (grow: selected, shrink:
+    // unselected) turned into coverage and merged into the mask
+    void distanceEdge(float radius, bool growing);
+
+    int m_width = 0;
+    int m_height = 0;
+    int m_tilesX = 0;
+    int m_tilesY = 0;
+    std::vector<TilePtr> m_tiles;
+    // Contour and clip path state; not copied with the tiles (a copy
+    // rebuilds its own), kept across assignment so restoring a snapshot
+    // only re-extracts the tiles that differ
+    mutable std::unique_ptr<Cache> m_cache;
+};
+
+} // namespace artflow
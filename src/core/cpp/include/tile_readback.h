@@ -0,0 +1,132 @@
+/**
+ * ArtFlow Studio - Tile Readback
+ * Partial GPU -> CPU transfer of the tiles touched by a stroke
+ */
+
+#pragma once
+
+#include "image_buffer.h"
+#include <QImage>
+#include <QOpenGLExtraFunctions>
+#include <QRect>
+#include <cstdint>
+#include <vector>
+
+class QOpenGLFramebufferObject;
+
+namespace artflow {
+
+/**
+ * StrokeTileTracker - Set of ImageBuffer tiles touched since the last reset.
+ * Pure CPU bookkeeping: canvas-space rects are snapped to the same TILE_SIZE
+ * grid ImageBuffer uses, so the result maps 1:1 onto layer tiles.
+ */
+class StrokeTileTracker {
+public:
+  void reset(int width, int height);
+
+  void markRect(const QRect &rect);
+  void markAll();
+
+  bool isEmpty() const { return m_count == 0; }
+  int tileCount() const { return m_count; }
+  bool isTileDirty(int tx, int ty) const;
+
+  // Canvas-space rect of every dirty tile (clipped to the canvas), row-major
+  std::vector<QRect> dirtyTileRects() const;
+
+  // Union of all dirty tiles, in canvas coordinates
+  QRect bounds() const { return m_bounds; }
+
+private:
+  int m_width = 0;
+  int m_height = 0;
+  int m_gridW = 0;
+  int m_gridH = 0;
+  int m_count = 0;
+  std::vector<uint8_t> m_flags;
+  QRect m_bounds;
+};
+
+/**
+ * TileReadbackSource - Provider of RGBA8888 premultiplied pixels for a
+ * canvas-space rect. Requests are queued before they are fetched so a GPU
+ * implementation can keep several transfers in flight.
+ */
+class TileReadbackSource {
+public:
+  virtual ~TileReadbackSource() = default;
+
+  // Number of requests that may be queued before the oldest is fetched
+  virtual int slotCount() const = 0;
+
+  virtual bool request(int slot, const QRect &rect) = 0;
+
+  // Rows of the rect queued in `slot`. bottomUp = rows arrive in GL order.
+  virtual const uint8_t *fetch(int slot, int &strideBytes, bool &bottomUp) = 0;
+  virtual void release(int slot) { (void)slot; }
+};
+
+/**
+ * CpuTileReadback - Reads from an already downloaded QImage. Used as the
+ * fallback when pixel-buffer objects are unavailable, and lets the tile
+ * bookkeeping run without any GL context.
+ */
+class CpuTileReadback : public TileReadbackSource {
+public:
+  explicit CpuTileReadback(const QImage &image);
+
+  int slotCount() const override { return 1; }
+  bool request(int slot, const QRect &rect) override;
+  const uint8_t *fetch(int slot, int &strideBytes, bool &bottomUp) override;
+
+private:
+  QImage m_image; // RGBA8888_Premultiplied, top-down
+  QRect m_rect;
+};
+
+/**
+ * GlTileReadback - Asynchronous readback from a framebuffer object through a
+ * ring of GL_PIXEL_PACK_BUFFERs. glReadPixels into a PBO returns immediately;
+ * the copy only blocks when a slot is mapped, by which time the following
+ * tiles are already queued on the GPU.
+ *
+ * Must be used (and destroyed) with the owning GL context current.
+ */
+class GlTileReadback : public TileReadbackSource,
+                       protected QOpenGLExtraFunctions {
+public:
+  static constexpr int kSlots = 8;
+
+  GlTileReadback();
+  ~GlTileReadback() override;
+
+  // PBO + glMapBufferRange need GL 3.0 / GLES 3.0. On GLES the FBO must
+  // also accept GL_RGBA/GL_UNSIGNED_BYTE reads (not guaranteed for RGBA16F).
+  static bool isSupported(QOpenGLFramebufferObject *fbo);
+
+  void setSource(QOpenGLFramebufferObject *fbo) { m_fbo = fbo; }
+
+  int slotCount() const override { return kSlots; }
+  bool request(int slot, const QRect &rect) override;
+  const uint8_t *fetch(int slot, int &strideBytes, bool &bottomUp) override;
+  void release(int slot) override;
+
+private:
+  void ensureBuffers();
+
+  QOpenGLFramebufferObject *m_fbo = nullptr;
+  bool m_initialized = false;
+  GLuint m_pbos[kSlots] = {};
+  size_t m_pboSizes[kSlots] = {};
+  QRect m_rects[kSlots];
+  bool m_mapped[kSlots] = {};
+};
+
+// Copies every dirty tile of `tracker` from `source` straight into the
+// matching tiles of `buffer`, keeping slotCount() requests in flight.
+// Returns the canvas-space union of the tiles written.
+QRect readbackDirtyTiles(const StrokeTileTracker &tracker,
+                         TileReadbackSource &source, ImageBuffer &buffer);
+
+} // namespace artflow
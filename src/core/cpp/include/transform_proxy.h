@@ -0,0 +1,77 @@
+#pragma once
+
+#include "mesh_warp.h"
+#include <QImage>
+#include <QRect>
+#include <QRectF>
+#include <QTransform>
+#include <vector>
+
+namespace artflow {
+
+// Mip-mapped stand-in for the pixels lifted by the transform tool, for the
+// interactive preview. Level n is the source box-filtered down by 2^n.
+// A frame covers only the visible part of the warped bounds, at screen
+// resolution or coarser, and samples the level closest to it, so dragging
+// the handles over a multi-megapixel selection costs about as much as a
+// screen-sized image. Committing still goes through TransformWarp at full
+// resolution.
+class TransformProxy {
+public:
+    // Levels stop once the longest side is at most this
+    static constexpr int kMinLevelSize = 64;
+    // Output pixels budget of a frame while the handles move
+    static constexpr int kInteractivePixels = 1024 * 1024;
+    // `coarseness` argument: the least one that fits kInteractivePixels
+    static constexpr int kInteractive = -1;
+
+    struct Frame {
+        QImage image;      // premultiplied RGBA; null if nothing is visible
+        QRectF canvasRect; // where `image` goes on the canvas
+        int coarseness = 0;
+    };
+
+    TransformProxy() = default;
+    // Any format; kept as premultiplied RGBA
+    explicit TransformProxy(const QImage &source);
+
+    bool isNull() const { return m_levels.empty(); }
+    int levelCount() const { return static_cast<int>(m_levels.size()); }
+    const QImage &level(int n) const { return m_levels[static_cast<size_t>(n)]; }
+
+    // The source (local coordinates) through `transform`, affine or
+    // perspective, clipped to `visible` (canvas px). `screenScale` is screen
+    // px per canvas px; each step of `coarseness` halves the output
+    // resolution from there. The same arguments return the cached frame.
+    const Frame &render(const QTransform &transform, const QRectF &visible, double screenScale,
+                        int coarseness);
+    // Same through a mesh warp of the source (built for its full size)
+    const Frame &renderMesh(const MeshWarp &mesh, const QRectF &visible, double screenScale,
+                            int coarseness);
+
+private:
+    struct Key {
+        bool mesh = false;
+        QTransform transform;
+        int columns = 0;
+        int rows = 0;
+        std::vector<QPointF> points;
+        MeshWarp::Interpolation interpolation = MeshWarp::Interpolation::CatmullRom;
+        QRectF visible;
+        double screenScale = 0.0;
+        int coarseness = 0;
+
+        bool operator==(const Key &other) const;
+    };
+
+    // Warps the level matching the output resolution over `bounds` (the
+    // warped canvas bounds); `area` is the warped area in canvas px²
+    const Frame &renderFrame(Key key, const QRectF &bounds, double area);
+
+    std::vector<QImage> m_levels;
+    bool m_hasFrame = false;
+    Key m_key;
+    Frame m_frame;
+};
+
+} // namespace artflow
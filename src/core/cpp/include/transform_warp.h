@@ -0,0 +1,46 @@
+#pragma once
+
+#include "image_buffer.h"
+#include "mesh_warp.h"
+#include <QImage>
+#include <QRectF>
+#include <QTransform>
+
+namespace artflow {
+
+// Resamples the pixels lifted by the transform tool back into a layer.
+// Only the destination tiles under the warped bounds are visited, one task
+// per tile: each pixel is inverse-mapped into the source, filtered and
+// composited over the tile (premultiplied source-over), so committing never
+// goes through the layer's contiguous data() copy.
+class TransformWarp {
+public:
+    enum class Filter {
+        Bilinear,
+        Bicubic // Catmull-Rom, clamped to the premultiplied range
+    };
+
+    // Any format; kept as premultiplied RGBA
+    explicit TransformWarp(const QImage &source);
+
+    // Source (local coordinates, origin at its top-left) through
+    // `transform` (affine or perspective) onto the canvas. Its border fades
+    // over one pixel, like a smooth QPainter::drawImage.
+    void draw(ImageBuffer &target, const QTransform &transform, Filter filter) const;
+    // Source through a mesh warp (built for the source's size): its lattice
+    // triangles, each mapped affinely. Hard-edged along the mesh border.
+    void drawMesh(ImageBuffer &target, const MeshWarp &mesh, Filter filter) const;
+
+private:
+    struct Patch;
+
+    // Patch mapping `clip` (source px) through `transform`; false if it is
+    // degenerate or misses the canvas
+    bool makePatch(const QTransform &transform, const QRectF &clip, int canvasWidth,
+                   int canvasHeight, Patch &patch) const;
+    void drawPatch(ImageBuffer &target, const Patch &patch, Filter filter) const;
+
+    QImage m_source;
+};
+
+} // namespace artflow
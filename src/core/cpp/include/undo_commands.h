@@ -2,7 +2,7 @@
 
 #include "undo_command.h"
 #include "layer_manager.h"
-#include <QPainterPath>
+#include "selection_mask.h"
 #include <QVariant>
 #include <memory>
 #include <string>
@@ -139,23 +139,22 @@ private:
 
 /**
  * SelectionUndoCommand - Handles undo/redo for selections
+ * Before/after are mask snapshots: they share tiles with the live mask, so
+ * each step only holds the tiles the change replaced.
  */
 class SelectionUndoCommand : public UndoCommand {
 public:
-  SelectionUndoCommand(std::function<void(const QPainterPath&, bool)> callback,
-                       const QPainterPath &beforePath, bool beforeHasSelection,
-                       const QPainterPath &afterPath, bool afterHasSelection);
+  SelectionUndoCommand(std::function<void(const SelectionMask&)> callback,
+                       const SelectionMask &before, const SelectionMask &after);
 
   void undo() override;
   void redo() override;
   std::string name() const override { return "Selection Change"; }
 
 private:
-  std::function<void(const QPainterPath&, bool)> m_callback;
-  QPainterPath m_beforePath;
-  bool m_beforeHasSelection;
-  QPainterPath m_afterPath;
-  bool m_afterHasSelection;
+  std::function<void(const SelectionMask&)> m_callback;
+  SelectionMask m_before;
+  SelectionMask m_after;
 };
 
 } // namespace artflow
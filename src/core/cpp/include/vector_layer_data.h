@@ -2,8 +2,11 @@
 
 #include "vector_types.h"
 #include "image_buffer.h"
+#include "vector_spatial_index.h"
 #include <vector>
 #include <memory>
+#include <unordered_map>
+#include <QRect>
 #include <QTransform>
 
 class QPainter;
@@ -17,14 +20,39 @@ public:
     enum class RasterQuality { Draft, Final };
 
     VectorLayerData(int canvasW, int canvasH);
+    // Snapshot copy (undo, duplicate layer): stroke geometry, brushes and
+    // texture names are shared with `other`; the spatial index is not copied
+    // and is rebuilt on the copy's first query.
+    VectorLayerData(const VectorLayerData& other);
+    VectorLayerData& operator=(const VectorLayerData&) = delete;
     ~VectorLayerData() = default;
 
     // Stroke management
     uint32_t addStroke(VectorStroke&& stroke);
     void removeStroke(uint32_t id);
+    // Mutable access: the stroke is re-indexed (from its cachedBounds) before
+    // the next spatial query, so call recalcBounds() after editing it.
+    // Geometry edits go through segments.unpack(); rasterizeDirty() packs
+    // the stroke again.
     VectorStroke* getStroke(uint32_t id);
+    const VectorStroke* getStroke(uint32_t id) const;
     const std::vector<VectorStroke>& getStrokes() const;
-    std::vector<VectorStroke>& getStrokes();
+    // Bulk mutable access: invalidates the whole spatial index
+    std::vector<VectorStroke>& editStrokes();
+
+    // Spatial queries (canvas coordinates, untransformed stroke space)
+    // Indices into getStrokes() of strokes whose bounds intersect `region`,
+    // in paint (z) order.
+    std::vector<size_t> queryRegion(const QRectF& region) const;
+
+    struct SegmentHit {
+        uint32_t strokeId = 0;
+        int segIdx = -1;
+        float t = 0.0f;
+        float distance = 1e9f;
+    };
+    // Closest stroke segment to `point` within `maxDistance` (segIdx -1 if none)
+    SegmentHit nearestSegment(const VPoint2D& point, float maxDistance) const;
 
     // Vector Eraser result
     struct EraseResult {
@@ -35,17 +63,58 @@ public:
     // Erase strokes intersecting or close to the eraserPath
     EraseResult vectorErase(const VectorStroke& eraserPath);
 
-    // Rasterization
+    // Rasterization. rasterize() bins strokes into output tiles and renders
+    // the tiles in parallel, so export-scale renders use every core.
     void rasterize(ImageBuffer& output, float scale = 1.0f,
                    RasterQuality quality = RasterQuality::Final) const;
+    // Renders the window of the `scale`d canvas whose top-left is `origin`
+    // into `output` (its size is the window size). Export at print DPI
+    // streams bands through this instead of holding a full-scale layer.
+    void rasterizeWindow(ImageBuffer& output, const QPoint& origin, float scale,
+                         RasterQuality quality = RasterQuality::Final) const;
     void rasterizeStroke(const VectorStroke& stroke, ImageBuffer& output, float scale = 1.0f) const;
 
     // Re-rasterize only `region` (canvas coordinates): clears the region and
-    // redraws the strokes that intersect it, clipped. Much cheaper than a full
-    // rasterize() when editing a single stroke on a crowded layer.
+    // redraws the strokes that intersect it, clipped, inside the tiles it
+    // covers. Much cheaper than a full rasterize() when editing a single
+    // stroke on a crowded layer.
     void rasterizeRegion(ImageBuffer& output, const QRectF& region, float scale = 1.0f,
                          RasterQuality quality = RasterQuality::Final) const;
 
+    // Incremental rasterization (canvas resolution, scale 1).
+    // Every edit through this class marks the canvas tiles (ImageBuffer::TILE_SIZE
+    // grid) under the old and new stroke footprint. rasterizeDirty() re-renders
+    // only those tiles straight into the tile memory of `output`, leaving the
+    // rest of the layer untouched, and returns the canvas rect it rewrote.
+    void markDirty(const QRectF& region);
+    void markAllDirty();
+    bool hasDirtyTiles() const { return m_allTilesDirty || m_dirtyTileCount > 0; }
+    QRect rasterizeDirty(ImageBuffer& output, RasterQuality quality = RasterQuality::Final);
+
+    // Undo record of one edit. Only the strokes the edit added, removed or
+    // changed are kept (their geometry is shared with the layer), so a
+    // typical entry is a few hundred bytes instead of a copy of the layer.
+    // A whole-layer transform keeps the original points of every stroke:
+    // undoing through the inverse matrix would drift.
+    struct Delta {
+        struct Placed {
+            size_t index = 0; // position in the stroke list it came from
+            VectorStroke stroke;
+        };
+        std::vector<Placed> removed; // before-edit positions, ascending
+        std::vector<Placed> added;   // after-edit positions, ascending
+        std::vector<std::pair<VectorStroke, VectorStroke>> changed; // (before, after)
+
+        bool empty() const {
+            return removed.empty() && added.empty() && changed.empty();
+        }
+    };
+    // Strokes are matched by id (ids are never reused)
+    static Delta diff(const VectorLayerData& before, const VectorLayerData& after);
+    // Redo (forward) or undo a delta. Marks the affected tiles dirty; the
+    // caller re-renders them with rasterizeDirty().
+    void applyDelta(const Delta& delta, bool forward);
+
     // Transformations
     void transformAll(const QTransform& matrix);
     void transformStroke(uint32_t id, const QTransform& matrix);
@@ -61,10 +130,45 @@ private:
     void paintStrokeInternal(QPainter& painter, const VectorStroke& stroke,
                              float scale, RasterQuality quality) const;
 
+    // Brings the index up to date with strokes handed out for editing
+    void syncIndex() const;
+    void rebuildIndex() const;
+    // Marks the tiles under `region`; const so syncIndex() can use it
+    void invalidateTiles(const QRectF& region) const;
+
+    struct TileJob {
+        int tx = 0;
+        int ty = 0;
+        std::vector<size_t> strokes; // indices into m_strokes, z-order
+    };
+    // Renders each job's strokes into its tile of `output`, tiles in parallel
+    // on the global thread pool. clearFirst rewrites the tiles from scratch
+    // (incremental path); otherwise strokes go over the existing pixels.
+    // `origin` is where output pixel (0,0) sits in the scaled canvas. A
+    // non-null `clip` (scaled canvas) limits clearing and drawing to it.
+    void rasterizeTiles(ImageBuffer& output, const std::vector<TileJob>& jobs,
+                        float scale, RasterQuality quality, bool clearFirst,
+                        const QPoint& origin = QPoint(), const QRect& clip = QRect()) const;
+
     int m_canvasW;
     int m_canvasH;
     std::vector<VectorStroke> m_strokes;
     uint32_t m_nextId = 1;
+
+    // id -> position in m_strokes
+    mutable std::unordered_map<uint32_t, size_t> m_idToIndex;
+    mutable VectorSpatialIndex m_index;
+    mutable std::vector<uint32_t> m_pendingIds; // edited through getStroke()
+    mutable bool m_indexStale = false;          // edited through editStrokes()
+    // Strokes handed out for editing since the last rasterizeDirty(), which
+    // packs their segments again (all of them after editStrokes())
+    std::vector<uint32_t> m_repackIds;
+    bool m_repackAll = false;
+
+    // Canvas tiles whose pixels no longer match the strokes
+    mutable std::vector<uint8_t> m_dirtyTiles;
+    mutable size_t m_dirtyTileCount = 0;
+    mutable bool m_allTilesDirty = true;
 };
 
 } // namespace artflow
@@ -43,9 +43,92 @@ struct StrokeDistanceResult {
 // Calculate the minimum distance from a point to a stroke
 StrokeDistanceResult distanceToStroke(const VPoint2D& point, const VectorStroke& stroke);
 
+// Flattened stroke with a bounding-volume hierarchy over its chords.
+// Build it once per stroke and reuse it for every query: the free functions
+// above re-flatten on each call and test all chord pairs. Leaves are runs of
+// consecutive chords (polylines are spatially coherent, so this groups well
+// without sorting) stored as flat arrays so the per-leaf distance loops
+// vectorize.
+class StrokeBVH {
+public:
+    explicit StrokeBVH(const VectorStroke& stroke, float tolerance = 1.5f);
+
+    bool empty() const { return m_nodes.empty(); }
+
+    // Same result as distanceToStroke(point, stroke). Chords farther than
+    // maxDistance are pruned; if none is closer, segIdx is -1.
+    StrokeDistanceResult distanceTo(const VPoint2D& point, float maxDistance = 1e9f) const;
+
+    // Same result as findIntersections(thisStroke, other)
+    std::vector<Intersection> intersect(const StrokeBVH& other) const;
+
+    // True if any chord of this stroke comes within `radius` of `other`
+    bool withinDistance(const StrokeBVH& other, float radius) const;
+
+private:
+    static constexpr int kLeafChords = 8;
+
+    struct Node {
+        float minX, minY, maxX, maxY;
+        int left = -1, right = -1; // children (leaf if left < 0)
+        int first = 0, count = 0;  // chord range for leaves
+    };
+
+    // Chord i goes from point i to point i + 1
+    std::vector<float> m_x, m_y, m_pressure;
+    std::vector<int> m_segIdx;
+    std::vector<float> m_t;
+    std::vector<Node> m_nodes;
+    int m_root = -1;
+
+    // Maps a position on a chord back to (segment index, Bezier t)
+    void chordParam(int chord, float tSeg, int& segIdx, float& t) const;
+};
+
 // Fit a series of input points into a chain of Bezier segments using Philip Schneider's algorithm
 std::vector<BezierSegment> fitBezierChain(const std::vector<VPoint2D>& points, float tolerance = 4.0f, float epsilon = 2.0f);
 
+// Streaming form of fitBezierChain for live freehand input.
+// update() runs after each appended point: once the uncommitted tail grows
+// past kWindow points it is fitted and every segment but the last few is
+// frozen, so pen-up (finish) only fits a bounded tail instead of the whole
+// stroke. The next window starts at the frozen end point with the frozen
+// end tangent, so joints stay G1. Points near the end of the buffer are
+// never frozen: appendStrokePointFiltered may still slide or merge them.
+class IncrementalBezierFitter {
+public:
+    void reset(float tolerance, float epsilon);
+    void update(const std::vector<VPoint2D>& points);
+
+    // Committed segments plus a fit of the remaining tail. Strokes too short
+    // to have committed anything get exactly fitBezierChain's result.
+    std::vector<BezierSegment> finish(const std::vector<VPoint2D>& points) const;
+
+    size_t committedCount() const { return m_committed.size(); }
+
+private:
+    static constexpr size_t kWindow = 128;       // tail length that triggers a fit
+    static constexpr size_t kRefitStep = 24;     // new points between fit attempts
+    static constexpr size_t kMaxWindow = 384;    // force a commit past this tail
+    static constexpr size_t kHeldSegments = 2;   // tail segments left open
+    static constexpr size_t kGuardPoints = 8;    // buffer end that may still move
+
+    // Fit points[first..last]; `ends` receives the input index of each
+    // segment's end point.
+    void fitRange(const std::vector<VPoint2D>& points, size_t first, size_t last,
+                  std::vector<BezierSegment>& segments, std::vector<size_t>* ends) const;
+    void commit(const std::vector<BezierSegment>& segments, size_t count, size_t endIndex);
+
+    float m_tolerance = 4.0f;
+    float m_epsilon = 2.0f;
+    size_t m_anchor = 0;      // input index of the first uncommitted point
+    size_t m_lastFitSize = 0;
+    bool m_hasJoint = false;
+    VPoint2D m_jointPoint;    // end of the last committed segment
+    VPoint2D m_jointTangent;  // its forward unit tangent
+    std::vector<BezierSegment> m_committed;
+};
+
 // In-place low-pass smoothing of raw input points (position and pressure).
 // Endpoints stay fixed. Removes stylus/touch sensor jitter so curve fitting
 // sees the intended shape instead of the noise.
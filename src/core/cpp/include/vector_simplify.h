@@ -0,0 +1,52 @@
+#pragma once
+
+#include "vector_types.h"
+#include <atomic>
+#include <functional>
+#include <vector>
+
+namespace artflow {
+
+class VectorLayerData;
+
+// Node reduction for a whole vector layer, computed off the UI thread.
+//
+// The job works on a snapshot of the layer's strokes (their geometry is
+// shared, not copied) and refits them in parallel chunks. Until applyTo()
+// writes it into the layer the result is only a preview: node counts before
+// and after. Strokes edited after the snapshot keep their edit.
+class VectorSimplifyJob {
+public:
+    // `tolerance`: max deviation of the refitted curve, canvas px
+    VectorSimplifyJob(std::vector<VectorStroke> strokes, float tolerance);
+
+    // Worker side: blocks until every chunk is done or cancel() is called.
+    // `progress` is invoked from pool threads with (strokes done, total).
+    void run(const std::function<void(int, int)>& progress = {});
+    void cancel() { m_cancelled.store(true, std::memory_order_relaxed); }
+    bool isCancelled() const { return m_cancelled.load(std::memory_order_relaxed); }
+    // True once run() completed without being cancelled
+    bool isFinished() const { return m_finished.load(std::memory_order_acquire); }
+
+    // Preview (valid once finished); nodes are counted like the layer panel
+    int strokeCount() const { return static_cast<int>(m_strokes.size()); }
+    int nodesBefore() const { return m_nodesBefore; }
+    int nodesAfter() const { return m_nodesAfter; }
+
+    // Swaps in the refitted geometry of every stroke `layer` still holds
+    // unchanged since the snapshot. Returns the number of nodes removed.
+    int applyTo(VectorLayerData& layer) const;
+
+private:
+    static constexpr size_t kChunkStrokes = 16;
+
+    std::vector<VectorStroke> m_strokes;  // snapshot
+    std::vector<SegmentArray> m_refitted; // per stroke; empty = keep as is
+    float m_tolerance;
+    std::atomic<bool> m_cancelled{false};
+    std::atomic<bool> m_finished{false};
+    int m_nodesBefore = 0;
+    int m_nodesAfter = 0;
+};
+
+} // namespace artflow
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <QRectF>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace artflow {
+
+// Uniform hashed grid over stroke bounding boxes (canvas coordinates).
+//
+// Strokes are registered by id with their cachedBounds and bucketed into
+// every kCellSize cell they overlap. Region queries only visit the cells
+// under the query rect, so hit-testing and erasing cost O(strokes nearby)
+// instead of O(strokes on the layer). The grid is hashed, so strokes moved
+// outside the canvas by a transform still index correctly.
+class VectorSpatialIndex {
+public:
+    static constexpr float kCellSize = 128.0f;
+    // Strokes spanning more cells than this (huge fills, long swooshes) go to
+    // a flat list that every query checks, instead of flooding the grid.
+    static constexpr int kMaxCellsPerStroke = 256;
+
+    void insert(uint32_t id, const QRectF& bounds);
+    void remove(uint32_t id);
+    void update(uint32_t id, const QRectF& bounds);
+    void clear();
+
+    bool contains(uint32_t id) const { return m_entries.count(id) != 0; }
+    size_t size() const { return m_entries.size(); }
+
+    // Ids whose bounds intersect `rect` (unordered, no duplicates)
+    void query(const QRectF& rect, std::vector<uint32_t>& out) const;
+
+private:
+    struct Entry {
+        QRectF bounds;
+        int x0 = 0, y0 = 0, x1 = -1, y1 = -1; // cell range (inclusive)
+        bool oversized = false;
+    };
+
+    static uint64_t cellKey(int cx, int cy) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) |
+               static_cast<uint32_t>(cy);
+    }
+    static void cellRange(const QRectF& r, int& x0, int& y0, int& x1, int& y1);
+
+    std::unordered_map<uint32_t, Entry> m_entries;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> m_cells;
+    std::vector<uint32_t> m_oversized;
+};
+
+} // namespace artflow
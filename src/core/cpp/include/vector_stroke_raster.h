@@ -0,0 +1,64 @@
+#pragma once
+
+#include "vector_types.h"
+#include <vector>
+#include <QColor>
+#include <QImage>
+#include <QPoint>
+
+namespace artflow {
+
+// Variable-width stroke outline as a triangle list (output pixels).
+//
+// Every triangle is stored counter-clockwise, so where pieces of the outline
+// overlap (inner side of a turn, joins, caps) their coverage adds up and is
+// clamped instead of cancelling out.
+struct StrokeMesh {
+    std::vector<float> xy; // 6 floats per triangle
+
+    void clear() { xy.clear(); }
+    bool empty() const { return xy.empty(); }
+    size_t triangleCount() const { return xy.size() / 6; }
+    void addTriangle(float ax, float ay, float bx, float by, float cx, float cy);
+    void addDisc(float cx, float cy, float radius);
+};
+
+// Tessellates a polyline with one diameter per point. Gentle turns share a
+// mitered vertex pair, so the body is one continuous triangle strip; sharp
+// turns break the strip and get a round join, and both ends get round caps.
+void tessellateStroke(const std::vector<VPoint2D>& points,
+                      const std::vector<float>& widths, StrokeMesh& mesh);
+
+// Anti-aliased scanline coverage for triangle meshes over a width x height
+// window. Edges deposit their exact signed area into an accumulation buffer
+// (the font-rasterizer approach), and a per-row prefix sum turns it into
+// coverage: exact per-pixel area, no supersampling. The prefix sum and
+// coverage clamp use SSE2/NEON when available.
+class CoverageRasterizer {
+public:
+    void reset(int width, int height);
+    // Mesh vertices are shifted by (dx, dy) into window pixels
+    void addMesh(const StrokeMesh& mesh, float dx, float dy);
+
+    // Composites `color` at `opacity` through the coverage onto `target`
+    // (Format_ARGB32_Premultiplied or Format_RGBA8888_Premultiplied), window
+    // pixel (0,0) landing on `origin`:
+    // source-over, or destination-out when `erase` is set.
+    void composite(QImage& target, const QPoint& origin, const QColor& color,
+                   float opacity, bool erase) const;
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+
+private:
+    void addLine(float x0, float y0, float x1, float y1);
+
+    int m_width = 0;
+    int m_height = 0;
+    int m_stride = 0; // width + 2: columns past the right edge absorb clamped x
+    int m_minRow = 0; // rows touched since reset()
+    int m_maxRow = -1;
+    std::vector<float> m_accum;
+};
+
+} // namespace artflow
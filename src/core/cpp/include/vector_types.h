@@ -1,7 +1,10 @@
 #pragma once
 
 #include <algorithm>
+#include <cstddef>
+#include <iterator>
 #include <memory>
+#include <utility>
 #include <vector>
 #include <QColor>
 #include <QRectF>
@@ -26,9 +29,91 @@ struct BezierSegment {
     float widthEnd = 1.0f;
 };
 
+// Geometry of one stroke, copy-on-write.
+//
+// At rest the segments live in a packed, immutable structure-of-arrays block
+// shared by every copy of the stroke (undo snapshots, duplicated layers):
+// neighbouring segments share their joint anchor, and all coordinates sit in
+// one allocation (~40 bytes per segment instead of 56). Const access decodes
+// segments by value. Mutable access unpacks once into a plain
+// std::vector<BezierSegment>; VectorLayerData packs the stroke again when the
+// edit is committed.
+class SegmentArray {
+public:
+    SegmentArray() = default;
+    SegmentArray(std::vector<BezierSegment> segments) : m_loose(std::move(segments)) {}
+    SegmentArray& operator=(std::vector<BezierSegment> segments) {
+        m_packed.reset();
+        m_loose = std::move(segments);
+        return *this;
+    }
+
+    size_t size() const { return m_packed ? m_packed->count : m_loose.size(); }
+    bool empty() const { return size() == 0; }
+
+    BezierSegment operator[](size_t i) const {
+        return m_packed ? m_packed->segment(i) : m_loose[i];
+    }
+    BezierSegment front() const { return (*this)[0]; }
+    BezierSegment back() const { return (*this)[size() - 1]; }
+
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = BezierSegment;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = BezierSegment;
+
+        const_iterator(const SegmentArray* array, size_t i) : m_array(array), m_i(i) {}
+        BezierSegment operator*() const { return (*m_array)[m_i]; }
+        const_iterator& operator++() { ++m_i; return *this; }
+        bool operator==(const const_iterator& o) const { return m_i == o.m_i; }
+        bool operator!=(const const_iterator& o) const { return m_i != o.m_i; }
+
+    private:
+        const SegmentArray* m_array;
+        size_t m_i;
+    };
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size()); }
+
+    // Editable segments. Unpacks (copies out of) the shared packed block, so
+    // later diffs see the stroke as changed; pack() again once done. Plain
+    // reads never unpack: there is no non-const indexing or iteration.
+    std::vector<BezierSegment>& unpack();
+
+    // Moves the segments into the shared packed block (no-op when packed)
+    void pack();
+    bool isPacked() const { return m_packed != nullptr; }
+    // True when both arrays use the same packed block, i.e. neither was
+    // edited since one was copied from the other
+    bool sharesStorageWith(const SegmentArray& other) const {
+        return m_packed && m_packed == other.m_packed;
+    }
+
+private:
+    struct Packed {
+        uint32_t count = 0;
+        // Anchors are shared by neighbouring segments (count + 1 of them).
+        // If any joint does not match exactly, every segment keeps its own
+        // two anchors instead (2 * count).
+        uint32_t anchors = 0;
+        bool sharedJoints = true;
+        // [x | y | pressure | width] x anchors, then [x | y | pressure] x
+        // 2 * count handles
+        std::unique_ptr<float[]> data;
+
+        BezierSegment segment(size_t i) const;
+    };
+
+    std::shared_ptr<const Packed> m_packed;
+    std::vector<BezierSegment> m_loose;
+};
+
 struct VectorStroke {
     uint32_t id = 0;
-    std::vector<BezierSegment> segments;
+    SegmentArray segments;
     QColor color = Qt::black;
     float opacity = 1.0f;
     float globalWidth = 1.0f;
@@ -62,7 +147,7 @@ struct VectorStroke {
             if (y + r > maxY) maxY = y + r;
         };
 
-        for (const auto& seg : segments) {
+        for (const BezierSegment& seg : std::as_const(segments)) {
             // Check endpoints and control points to get a conservative bounding box quickly
             float maxW = std::max(seg.widthStart, seg.widthEnd) * globalWidth;
             update(seg.p0.x, seg.p0.y, seg.widthStart * globalWidth);
@@ -107,6 +107,10 @@ public:
     // ¿Hay zonas húmedas activas?
     bool hasActiveWetAreas() const { return m_hasWetAreas; }
 
+    // Unión de zonas húmedas: el spread puede reescribir el canvas en todo
+    // este rectángulo, no solo bajo el último dab
+    QRect wetBounds() const { return m_wetBounds; }
+
     // Destruir los FBOs (llamar antes de cambiar de capa / canvas resize)
     void invalidate();
 
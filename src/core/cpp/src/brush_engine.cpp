@@ -1,4 +1,5 @@
 #include "../include/brush_engine.h"
+#include "../include/latency_profiler.h"
 #include "stroke_renderer.h"
 #include <QCoreApplication>
 #include <QDebug>
@@ -16,6 +17,7 @@
 #include <QString>
 #include <QStringList>
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstdlib>
 #include <vector>
@@ -26,6 +28,17 @@ namespace artflow {
 static QMap<QString, uint32_t> g_textureCache;
 static std::vector<QOpenGLTexture *> g_textures; // To manage lifetime
 
+// Jitter RNG: LCG with the same 15-bit range as std::rand, but thread_local,
+// so concurrent raster workers neither race nor interleave sequences.
+static thread_local uint32_t t_jitterState = 1;
+
+static inline int jitterRand() {
+  t_jitterState = t_jitterState * 1103515245u + 12345u;
+  return static_cast<int>((t_jitterState >> 16) & 0x7FFF);
+}
+
+void BrushEngine::seedJitter(uint32_t seed) { t_jitterState = seed ? seed : 1; }
+
 // ===========================================================================
 // SPRAY / SPLATTER THROTTLING (Android 60 FPS)
 // ===========================================================================
@@ -182,7 +195,8 @@ uint32_t BrushEngine::loadTexture(const QString &name, bool isTip) {
 
 // Helper to get/load texture image for Raster mode
 static QImage getTextureImage(const QString &name, bool isTip = true) {
-  static QMap<QString, QImage> s_imageTextureCache;
+  // Per thread: raster workers load their own copy instead of locking
+  thread_local QMap<QString, QImage> s_imageTextureCache;
   QString cacheKey = name + (isTip ? "_tip" : "_grain");
   if (s_imageTextureCache.contains(cacheKey))
     return s_imageTextureCache[cacheKey];
@@ -294,9 +308,9 @@ static void paintTipRaster(QPainter *painter, const QPointF &point, float size,
 
   // Cache key: we cache the tinted image for the current texture and color to avoid
   // expensive scaling, cropping, and QPainter setup on every single dab.
-  static QString cachedTexName;
-  static QColor cachedColor;
-  static QImage cachedTintedImg;
+  thread_local QString cachedTexName;
+  thread_local QColor cachedColor;
+  thread_local QImage cachedTintedImg;
 
   if (cachedTexName != texName || cachedColor != color || cachedTintedImg.isNull()) {
     cachedTexName = texName;
@@ -563,8 +577,8 @@ static void paintTexturedDabRaster(QPainter *painter, const QPointF &point, floa
 
       float threshold = (1.0f - opacity) * settings.textureIntensity;
       float textureIntensity = settings.textureIntensity;
-      bool isSubtract = (settings.grainBlendMode == "subtract");
-      bool isThreshold = (settings.grainBlendMode == "threshold" || settings.grainBlendMode == "reveal");
+      bool isSubtract = (settings.grainBlendMode == GrainBlend::Subtract);
+      bool isThreshold = (settings.grainBlendMode == GrainBlend::Threshold);
 
       for (int y = 0; y < finalSize; ++y) {
         float canvasY = startY + y;
@@ -695,9 +709,9 @@ static void paintTexturedDabRaster(QPainter *painter, const QPointF &point, floa
     const uint32_t *dualBits = reinterpret_cast<const uint32_t*>(scaledDualTip.constBits());
     int dualStride = scaledDualTip.bytesPerLine() / 4;
 
-    bool isMask = (settings.dualTipBlendMode == "mask" || settings.dualTipBlendMode == "subtract");
-    bool isAdd = (settings.dualTipBlendMode == "add");
-    bool isHeight = (settings.dualTipBlendMode == "height_linear" || settings.dualTipBlendMode == "height");
+    bool isMask = (settings.dualTipBlendMode == DualTipBlend::Mask);
+    bool isAdd = (settings.dualTipBlendMode == DualTipBlend::Add);
+    bool isHeight = (settings.dualTipBlendMode == DualTipBlend::Height);
 
     for (int y = 0; y < finalSize; ++y) {
       uint32_t *tipRow = tipBits + y * tipStride;
@@ -768,8 +782,8 @@ static void paintTexturedDabRaster(QPainter *painter, const QPointF &point, floa
 
     float threshold = (1.0f - opacity) * settings.textureIntensity;
     float textureIntensity = settings.textureIntensity;
-    bool isSubtract = (settings.grainBlendMode == "subtract");
-    bool isThreshold = (settings.grainBlendMode == "threshold" || settings.grainBlendMode == "reveal");
+    bool isSubtract = (settings.grainBlendMode == GrainBlend::Subtract);
+    bool isThreshold = (settings.grainBlendMode == GrainBlend::Threshold);
 
     for (int y = 0; y < finalSize; ++y) {
       float canvasY = startY + y;
@@ -824,6 +838,284 @@ static void paintTexturedDabRaster(QPainter *painter, const QPointF &point, floa
   painter->restore();
 }
 
+// ===========================================================================
+// DAB GENERATORS (compile-time specialised)
+// ===========================================================================
+// compileBrushFeatures() reduce los ~150 campos de BrushSettings a una
+// máscara de bits una vez por segmento; el bucle de dabs se instancia para
+// unas pocas máscaras y `if constexpr` elimina las dinámicas apagadas. Un
+// pincel redondo simple no evalúa jitter, spray, color ni carga de pintura.
+namespace {
+
+using DabList = std::vector<StrokeRenderer::DabInstance>;
+
+// Per-segment constants shared by every dab of the GPU path
+struct DabSegment {
+  const BrushSettings *settings = nullptr;
+  QPointF from;
+  QPointF to;
+  float dist = 0.0f;
+  float stepSize = 1.0f;
+  float currentSize = 1.0f;
+  float strokeAngle = 0.0f;
+  float calligraphyWidth = 1.0f;
+  float scaleFactor = 1.0f;
+  float effectivePressure = 1.0f;
+  float accumulatedDistance = 0.0f;
+  float tipRotation = 0.0f;
+  bool isBlendOnly = false;
+  QTransform xform;
+  QColor color;
+};
+
+struct DabJitter {
+  float x = 0.0f, y = 0.0f, size = 1.0f, rot = 0.0f, opac = 1.0f;
+};
+
+inline float randSigned() { return (jitterRand() % 2001 - 1000) / 1000.0f; }
+
+// Same draw order as the original inline code (x, y, size, rot, opacity)
+inline DabJitter sampleDabJitter(const BrushSettings &s, float base) {
+  DabJitter j;
+  if (s.posJitterX > 0)
+    j.x = randSigned() * s.posJitterX * base;
+  if (s.posJitterY > 0)
+    j.y = randSigned() * s.posJitterY * base;
+  if (s.sizeJitter > 0)
+    j.size = 1.0f + randSigned() * s.sizeJitter;
+  if (s.rotationJitter > 0)
+    j.rot = randSigned() * s.rotationJitter * 3.14159f;
+  if (s.opacityJitter > 0)
+    j.opac = 1.0f - (jitterRand() % 1001 / 1000.0f) * s.opacityJitter;
+  return j;
+}
+
+inline void applyColorJitter(const BrushSettings &s, QColor &color) {
+  if (s.hueJitter > 0 || s.satJitter > 0) {
+    float h, sat, l, a;
+    color.getHslF(&h, &sat, &l, &a);
+    h = std::fmod(h + randSigned() * s.hueJitter, 1.0f);
+    if (h < 0)
+      h += 1.0f;
+    sat = std::clamp(sat + randSigned() * s.satJitter, 0.0f, 1.0f);
+    color.setHslF(h, sat, l, a);
+  }
+}
+
+template <uint32_t kF>
+void emitSprayParticles(const DabSegment &seg, const QPointF &pt,
+                        int rawDensity, float particleSize, bool sizeByBrush,
+                        int deviation, float direction, float flow,
+                        float sizeMultiplier, float devSizeBase,
+                        float opacityBase, float paintLoad, DabList &out) {
+  const BrushSettings &s = *seg.settings;
+  int numParticles;
+  float spraySizeComp;
+  computeSprayThrottle(rawDensity, seg.dist, seg.stepSize, numParticles,
+                       spraySizeComp);
+
+  float pSize = particleSize;
+  if (sizeByBrush) {
+    pSize = seg.currentSize * (particleSize / 100.0f);
+  }
+
+  float maxScatter = (seg.currentSize - pSize) * 0.5f;
+  float scatterRadius = std::max(0.0f, maxScatter) * (deviation / 5.0f);
+
+  for (int pIdx = 0; pIdx < numParticles; ++pIdx) {
+    float theta = (jitterRand() % 360) * 3.14159265f / 180.0f;
+    float tRandom = (jitterRand() % 1001) / 1000.0f;
+    float r = std::pow(tRandom, 1.5f) * scatterRadius;
+    QPointF particlePt = pt + QPointF(r * std::cos(theta), r * std::sin(theta));
+    QPointF devParticlePt = seg.xform.map(particlePt);
+
+    DabJitter j;
+    if constexpr ((kF & BrushFeatures::DabJitter) != 0)
+      j = sampleDabJitter(s, devSizeBase);
+
+    float devParticleSize = pSize * seg.scaleFactor * sizeMultiplier *
+                            seg.calligraphyWidth * j.size * spraySizeComp;
+
+    QColor finalColor = seg.color;
+    finalColor.setAlphaF(std::clamp(opacityBase * j.opac * flow, 0.0f, 1.0f));
+    if constexpr ((kF & BrushFeatures::ColorJitter) != 0)
+      applyColorJitter(s, finalColor);
+
+    StrokeRenderer::DabInstance pDab;
+    pDab.x = devParticlePt.x() + j.x;
+    pDab.y = devParticlePt.y() + j.y;
+    pDab.size = devParticleSize;
+    pDab.rotation = (direction * 3.14159265f / 180.0f) + j.rot;
+    pDab.colorR = finalColor.redF();
+    pDab.colorG = finalColor.greenF();
+    pDab.colorB = finalColor.blueF();
+    pDab.colorA = finalColor.alphaF();
+    pDab.paintLoad = paintLoad;
+    out.push_back(pDab);
+  }
+}
+
+// Walks the segment at stepSize intervals starting at distanceToDab and
+// appends the resulting dabs. Returns the distance of the first dab that did
+// not fit (the caller derives the remainder from it).
+template <uint32_t kF>
+float generateGpuDabs(const DabSegment &seg, float distanceToDab,
+                      DabList &instancedDabs, DabList &particleDabs) {
+  const BrushSettings &s = *seg.settings;
+
+  while (distanceToDab <= seg.dist) {
+    float t = (seg.dist > 0.0001f) ? (distanceToDab / seg.dist) : 0.0f;
+    QPointF pt = seg.from + (seg.to - seg.from) * t;
+
+    // Stroke-path jitter: lateral = perpendicular, linear = along stroke
+    if constexpr ((kF & BrushFeatures::PathJitter) != 0) {
+      if (s.jitterLateral > 0.0f || s.jitterLinear > 0.0f) {
+        float latAmt = randSigned() * s.jitterLateral * seg.currentSize;
+        float linAmt = randSigned() * s.jitterLinear * seg.currentSize;
+        float ca = std::cos(seg.strokeAngle), sa = std::sin(seg.strokeAngle);
+        pt += QPointF(linAmt * ca - latAmt * sa, linAmt * sa + latAmt * ca);
+      }
+    }
+
+    // Progress within stroke
+    float totalDist = seg.accumulatedDistance + distanceToDab;
+
+    // Taper and Falloff
+    float sizeMultiplier = 1.0f;
+    float opacityMultiplier = 1.0f;
+
+    if constexpr ((kF & BrushFeatures::Taper) != 0) {
+      if (s.taperStart > 0.0f && totalDist < s.taperStart) {
+        // Parabolic Taper (smoother start)
+        float x = 1.0f - (totalDist / s.taperStart); // 1.0 to 0.0
+        float parabola = 1.0f - (x * x);
+        sizeMultiplier = 0.1f + 0.9f * parabola;
+      }
+      if (s.fallOff > 0.0f) {
+        // Opacity falloff
+        opacityMultiplier = std::max(0.0f, 1.0f - (totalDist / s.fallOff));
+
+        // Parabolic Taper (smoother end)
+        if (s.taperEnd > 0.0f && totalDist > (s.fallOff - s.taperEnd)) {
+          float x = (totalDist - (s.fallOff - s.taperEnd)) /
+                    s.taperEnd; // 0.0 to 1.0
+          float parabola = 1.0f - (x * x);
+          sizeMultiplier *= (0.1f + 0.9f * parabola);
+        }
+      }
+    }
+
+    QPointF devPt = seg.xform.map(pt);
+    float devSizeBase = seg.currentSize * seg.scaleFactor * sizeMultiplier *
+                        seg.calligraphyWidth;
+    float opacityBase = seg.color.alphaF() * opacityMultiplier;
+
+    float dabPaintLoad = 1.0f;
+    if constexpr ((kF & BrushFeatures::PaintLoad) != 0) {
+      dabPaintLoad = std::max(0.0f, 1.0f - totalDist * s.depletionRate);
+    }
+
+    bool sprayed = false;
+    if constexpr ((kF & BrushFeatures::MainSpray) != 0) {
+      if (s.mainSprayEnabled) {
+        emitSprayParticles<kF>(seg, pt, s.mainParticleDensity * 3,
+                               s.mainParticleSize, s.mainSpraySizeByBrush,
+                               s.mainSprayDeviation, s.mainParticleDirection,
+                               1.0f, sizeMultiplier, devSizeBase, opacityBase,
+                               dabPaintLoad, instancedDabs);
+        sprayed = true;
+      }
+    }
+
+    if (!sprayed) {
+      // Loop for Count (Stamp stacking)
+      int count = 1;
+      if constexpr ((kF & BrushFeatures::Stacking) != 0)
+        count = std::max(1, s.count);
+      for (int k = 0; k < count; ++k) {
+        DabJitter j;
+        if constexpr ((kF & BrushFeatures::DabJitter) != 0)
+          j = sampleDabJitter(s, devSizeBase);
+
+        QColor finalColor = seg.color;
+        finalColor.setAlphaF(std::clamp(opacityBase * j.opac, 0.0f, 1.0f));
+        if constexpr ((kF & BrushFeatures::ColorJitter) != 0)
+          applyColorJitter(s, finalColor);
+
+        if (devSizeBase < 1.0f || seg.effectivePressure < 0.001f ||
+            (!seg.isBlendOnly && opacityBase < 0.001f))
+          continue;
+
+        StrokeRenderer::DabInstance dab;
+        dab.x = devPt.x() + j.x;
+        dab.y = devPt.y() + j.y;
+        dab.size = devSizeBase * j.size;
+        dab.rotation = seg.tipRotation + j.rot;
+        dab.colorR = finalColor.redF();
+        dab.colorG = finalColor.greenF();
+        dab.colorB = finalColor.blueF();
+        dab.colorA = finalColor.alphaF();
+        dab.paintLoad = dabPaintLoad;
+        instancedDabs.push_back(dab);
+      }
+    }
+
+    // Generate Dual Brush Spray Particles
+    if constexpr ((kF & BrushFeatures::DualSpray) != 0) {
+      emitSprayParticles<kF>(seg, pt, s.particleDensity * 3, s.particleSize,
+                             s.spraySizeByBrush, s.sprayDeviation,
+                             s.particleDirection, s.dualTipFlow,
+                             sizeMultiplier, devSizeBase, opacityBase, 1.0f,
+                             particleDabs);
+    }
+
+    distanceToDab += seg.stepSize;
+  }
+  return distanceToDab;
+}
+
+using DabGenerator = float (*)(const DabSegment &, float, DabList &,
+                               DabList &);
+
+// Smallest instantiation whose mask covers every feature the brush uses
+DabGenerator selectDabGenerator(uint32_t features) {
+  constexpr uint32_t kSimple = BrushFeatures::Taper;
+  constexpr uint32_t kDynamic = BrushFeatures::Taper |
+                                BrushFeatures::PathJitter |
+                                BrushFeatures::DabJitter |
+                                BrushFeatures::ColorJitter |
+                                BrushFeatures::Stacking;
+  if ((features & ~kSimple) == 0)
+    return &generateGpuDabs<kSimple>;
+  if ((features & ~kDynamic) == 0)
+    return &generateGpuDabs<kDynamic>;
+  return &generateGpuDabs<BrushFeatures::All>;
+}
+
+} // namespace
+
+uint32_t compileBrushFeatures(const BrushSettings &s) {
+  uint32_t f = 0;
+  if (s.jitterLateral > 0.0f || s.jitterLinear > 0.0f)
+    f |= BrushFeatures::PathJitter;
+  if (s.posJitterX > 0 || s.posJitterY > 0 || s.sizeJitter > 0 ||
+      s.rotationJitter > 0 || s.opacityJitter > 0)
+    f |= BrushFeatures::DabJitter;
+  if (s.hueJitter > 0 || s.satJitter > 0)
+    f |= BrushFeatures::ColorJitter;
+  if (s.taperStart > 0.0f || s.fallOff > 0.0f)
+    f |= BrushFeatures::Taper;
+  if (s.count > 1)
+    f |= BrushFeatures::Stacking;
+  if (s.mainSprayEnabled)
+    f |= BrushFeatures::MainSpray;
+  if (s.dualTipEnabled && s.sprayEnabled)
+    f |= BrushFeatures::DualSpray;
+  if (s.type == BrushSettings::Type::Oil)
+    f |= BrushFeatures::PaintLoad;
+  return f;
+}
+
 BrushEngine::BrushEngine() {}
 BrushEngine::~BrushEngine() {
   if (m_renderer)
@@ -878,15 +1170,14 @@ void BrushEngine::paintStroke(QPainter *painter, const QPointF &lastPoint,
                      (painter->paintEngine()->type() == QPaintEngine::OpenGL2 ||
                       painter->paintEngine()->type() == QPaintEngine::OpenGL))));
 
-  static bool hasLoggedMode = false;
-  if (!hasLoggedMode) {
+  static std::atomic<bool> hasLoggedMode{false};
+  if (!hasLoggedMode.exchange(true)) {
     qDebug() << "BrushEngine: paintStroke mode:"
              << (isOpenGL ? "OpenGL" : "Raster")
              << "devType:" << painter->device()->devType()
              << "paintEngineType:" << (painter->paintEngine() ? painter->paintEngine()->type() : -1)
              << "glContext:" << (QOpenGLContext::currentContext() != nullptr)
              << "dynamicCast:" << (dynamic_cast<QOpenGLPaintDevice*>(painter->device()) != nullptr);
-    hasLoggedMode = true;
   }
 
   if (isOpenGL) {
@@ -924,21 +1215,9 @@ void BrushEngine::paintStroke(QPainter *painter, const QPointF &lastPoint,
     bool hasDualTip = (dualTipTexID != 0 && settings.dualTipEnabled);
     bool hasDualGrain = (dualGrainTexID != 0 && settings.useDualTexture);
 
-    int uDualTipBlendMode = 0; // multiply
-    if (settings.dualTipBlendMode == "mask" || settings.dualTipBlendMode == "subtract") {
-      uDualTipBlendMode = 1;
-    } else if (settings.dualTipBlendMode == "add") {
-      uDualTipBlendMode = 2;
-    } else if (settings.dualTipBlendMode == "height_linear" || settings.dualTipBlendMode == "height") {
-      uDualTipBlendMode = 3;
-    }
-
-    int uGrainBlendMode = 0; // multiply
-    if (settings.grainBlendMode == "subtract") {
-      uGrainBlendMode = 1;
-    } else if (settings.grainBlendMode == "threshold" || settings.grainBlendMode == "reveal") {
-      uGrainBlendMode = 2;
-    }
+    // Enum values match the shader uniforms
+    int uDualTipBlendMode = static_cast<int>(settings.dualTipBlendMode);
+    int uGrainBlendMode = static_cast<int>(settings.grainBlendMode);
 
     painter->save();
     painter->beginNativePainting();
@@ -992,269 +1271,41 @@ void BrushEngine::paintStroke(QPainter *painter, const QPointF &lastPoint,
     std::vector<StrokeRenderer::DabInstance> instancedDabs;
     std::vector<StrokeRenderer::DabInstance> particleDabs;
 
-    while (distanceToDab <= dist) {
-      float t = (dist > 0.0001f) ? (distanceToDab / dist) : 0.0f;
-      QPointF pt = lastPoint + (currentPoint - lastPoint) * t;
-
-      // Stroke-path jitter: lateral = perpendicular, linear = along stroke
-      if (settings.jitterLateral > 0.0f || settings.jitterLinear > 0.0f) {
-        float latAmt = ((std::rand() % 2001 - 1000) / 1000.0f) *
-                       settings.jitterLateral * currentSize;
-        float linAmt = ((std::rand() % 2001 - 1000) / 1000.0f) *
-                       settings.jitterLinear * currentSize;
-        float ca = std::cos(strokeAngle), sa = std::sin(strokeAngle);
-        pt += QPointF(linAmt * ca - latAmt * sa, linAmt * sa + latAmt * ca);
-      }
-
-      // Progress within stroke
-      float totalDist = m_accumulatedDistance + distanceToDab;
-
-      // Taper and Falloff
-      float sizeMultiplier = 1.0f;
-      float opacityMultiplier = 1.0f;
-
-      if (settings.taperStart > 0.0f && totalDist < settings.taperStart) {
-        // Parabolic Taper (smoother start)
-        float x = 1.0f - (totalDist / settings.taperStart); // 1.0 to 0.0
-        float parabola = 1.0f - (x * x);
-        sizeMultiplier = 0.1f + 0.9f * parabola;
-      }
-      if (settings.fallOff > 0.0f) {
-        // Opacity falloff
-        opacityMultiplier =
-            std::max(0.0f, 1.0f - (totalDist / settings.fallOff));
-
-        // Parabolic Taper (smoother end)
-        if (settings.taperEnd > 0.0f &&
-            totalDist > (settings.fallOff - settings.taperEnd)) {
-          float x = (totalDist - (settings.fallOff - settings.taperEnd)) /
-                    settings.taperEnd; // 0.0 to 1.0
-          float parabola = 1.0f - (x * x);
-          sizeMultiplier *= (0.1f + 0.9f * parabola);
-        }
-      }
-
-      QPointF devPt = xform.map(pt);
-      float devSizeBase =
-          currentSize * scaleFactor * sizeMultiplier * calligraphyWidth;
-      float opacityBase = c.alphaF() * opacityMultiplier;
-
-      if (settings.mainSprayEnabled) {
-        int numParticles;
-        float spraySizeComp;
-        computeSprayThrottle(settings.mainParticleDensity * 3, dist, stepSize,
-                             numParticles, spraySizeComp);
-
-        float pSize = settings.mainParticleSize;
-        if (settings.mainSpraySizeByBrush) {
-          pSize = currentSize * (settings.mainParticleSize / 100.0f);
-        }
-
-        float maxScatter = (currentSize - pSize) * 0.5f;
-        float scatterRadius = std::max(0.0f, maxScatter) * (settings.mainSprayDeviation / 5.0f);
-
-        for (int pIdx = 0; pIdx < numParticles; ++pIdx) {
-          float theta = (std::rand() % 360) * 3.14159265f / 180.0f;
-          float tRandom = (std::rand() % 1001) / 1000.0f;
-          float r = std::pow(tRandom, 1.5f) * scatterRadius;
-          float pOffsetX = r * std::cos(theta);
-          float pOffsetY = r * std::sin(theta);
-          QPointF particlePt = pt + QPointF(pOffsetX, pOffsetY);
-          QPointF devParticlePt = xform.map(particlePt);
-
-          // Jitters
-          float jX = 0, jY = 0, jSize = 1.0f, jRot = 0, jOpac = 1.0f;
-          if (settings.posJitterX > 0)
-            jX = ((std::rand() % 2001 - 1000) / 1000.0f) * settings.posJitterX * devSizeBase;
-          if (settings.posJitterY > 0)
-            jY = ((std::rand() % 2001 - 1000) / 1000.0f) * settings.posJitterY * devSizeBase;
-          if (settings.sizeJitter > 0)
-            jSize = 1.0f + ((std::rand() % 2001 - 1000) / 1000.0f) * settings.sizeJitter;
-          if (settings.rotationJitter > 0)
-            jRot = ((std::rand() % 2001 - 1000) / 1000.0f) * settings.rotationJitter * 3.14159f;
-          if (settings.opacityJitter > 0)
-            jOpac = 1.0f - (std::rand() % 1001 / 1000.0f) * settings.opacityJitter;
-
-          float devParticleSize = pSize * scaleFactor * sizeMultiplier * calligraphyWidth * jSize * spraySizeComp;
-
-          QColor finalColor = c;
-          finalColor.setAlphaF(std::clamp(opacityBase * jOpac, 0.0f, 1.0f));
-
-          // Basic Color Dynamics
-          if (settings.hueJitter > 0 || settings.satJitter > 0) {
-            float h, s, l, a;
-            finalColor.getHslF(&h, &s, &l, &a);
-            h = std::fmod(h + ((std::rand() % 2001 - 1000) / 1000.0f) * settings.hueJitter, 1.0f);
-            if (h < 0) h += 1.0f;
-            s = std::clamp(s + ((std::rand() % 2001 - 1000) / 1000.0f) * settings.satJitter, 0.0f, 1.0f);
-            finalColor.setHslF(h, s, l, a);
-          }
-
-          StrokeRenderer::DabInstance pDab;
-          pDab.x = devParticlePt.x() + jX;
-          pDab.y = devParticlePt.y() + jY;
-          pDab.size = devParticleSize;
-          pDab.rotation = (settings.mainParticleDirection * 3.14159265f / 180.0f) + jRot;
-          pDab.colorR = finalColor.redF();
-          pDab.colorG = finalColor.greenF();
-          pDab.colorB = finalColor.blueF();
-          pDab.colorA = finalColor.alphaF();
-          
-          float dabPaintLoad = 1.0f;
-          if (settings.type == BrushSettings::Type::Oil) {
-            dabPaintLoad = std::max(0.0f, 1.0f - totalDist * settings.depletionRate);
-          }
-          pDab.paintLoad = dabPaintLoad;
-
-          instancedDabs.push_back(pDab);
-        }
-      } else {
-        // Loop for Count (Stamp stacking)
-        int count = std::max(1, settings.count);
-        for (int k = 0; k < count; ++k) {
-          // Jitters
-          float jX = 0, jY = 0, jSize = 1.0f, jRot = 0, jOpac = 1.0f;
-          if (settings.posJitterX > 0)
-            jX = ((std::rand() % 2001 - 1000) / 1000.0f) * settings.posJitterX *
-                 devSizeBase;
-          if (settings.posJitterY > 0)
-            jY = ((std::rand() % 2001 - 1000) / 1000.0f) * settings.posJitterY *
-                 devSizeBase;
-          if (settings.sizeJitter > 0)
-            jSize = 1.0f +
-                    ((std::rand() % 2001 - 1000) / 1000.0f) * settings.sizeJitter;
-          if (settings.rotationJitter > 0)
-            jRot = ((std::rand() % 2001 - 1000) / 1000.0f) *
-                   settings.rotationJitter * 3.14159f;
-          if (settings.opacityJitter > 0)
-            jOpac =
-                1.0f - (std::rand() % 1001 / 1000.0f) * settings.opacityJitter;
-
-          QColor finalColor = c;
-          finalColor.setAlphaF(std::clamp(opacityBase * jOpac, 0.0f, 1.0f));
-
-          // Basic Color Dynamics
-          if (settings.hueJitter > 0 || settings.satJitter > 0) {
-            float h, s, l, a;
-            finalColor.getHslF(&h, &s, &l, &a);
-            h = std::fmod(h + ((std::rand() % 2001 - 1000) / 1000.0f) *
-                                  settings.hueJitter,
-                          1.0f);
-            if (h < 0)
-              h += 1.0f;
-            s = std::clamp(s + ((std::rand() % 2001 - 1000) / 1000.0f) *
-                                   settings.satJitter,
-                           0.0f, 1.0f);
-            finalColor.setHslF(h, s, l, a);
-          }
-
-          // Blend-only brushes (e.g. blenders or watercolor wet mixers) have 0 opacity pigment
-          // but need to draw dabs to trigger GPU neighbor blending and smudging.
-          bool isBlendOnly = (settings.blendOnly || 
-                              settings.dilution > 0.01f || 
-                              settings.smudge > 0.01f || 
-                              settings.type == BrushSettings::Type::Watercolor || 
-                              settings.type == BrushSettings::Type::Oil);
-
-          if (devSizeBase < 1.0f || effectivePressure < 0.001f ||
-              (!isBlendOnly && opacityBase < 0.001f))
-            continue;
-
-          // Calculate base rotation
-          float currentTipRot = settings.tipRotation;
-          if (settings.rotateWithStroke) {
-            currentTipRot += strokeAngle;
-          }
-
-          StrokeRenderer::DabInstance dab;
-          dab.x = devPt.x() + jX;
-          dab.y = devPt.y() + jY;
-          dab.size = devSizeBase * jSize;
-          dab.rotation = currentTipRot + jRot;
-          dab.colorR = finalColor.redF();
-          dab.colorG = finalColor.greenF();
-          dab.colorB = finalColor.blueF();
-          dab.colorA = finalColor.alphaF();
-          
-          float dabPaintLoad = 1.0f;
-          if (settings.type == BrushSettings::Type::Oil) {
-            dabPaintLoad = std::max(0.0f, 1.0f - totalDist * settings.depletionRate);
-          }
-          dab.paintLoad = dabPaintLoad;
-
-          instancedDabs.push_back(dab);
-        }
-      }
-
-      // Generate Dual Brush Spray Particles
-      if (settings.dualTipEnabled && settings.sprayEnabled) {
-        int numParticles;
-        float spraySizeComp;
-        computeSprayThrottle(settings.particleDensity * 3, dist, stepSize,
-                             numParticles, spraySizeComp);
-
-        float pSize = settings.particleSize;
-        if (settings.spraySizeByBrush) {
-          pSize = currentSize * (settings.particleSize / 100.0f);
-        }
-
-        float maxScatter = (currentSize - pSize) * 0.5f;
-        float scatterRadius = std::max(0.0f, maxScatter) * (settings.sprayDeviation / 5.0f);
-
-        for (int pIdx = 0; pIdx < numParticles; ++pIdx) {
-          float theta = (std::rand() % 360) * 3.14159265f / 180.0f;
-          float tRandom = (std::rand() % 1001) / 1000.0f;
-          float r = std::pow(tRandom, 1.5f) * scatterRadius;
-          float pOffsetX = r * std::cos(theta);
-          float pOffsetY = r * std::sin(theta);
-          QPointF particlePt = pt + QPointF(pOffsetX, pOffsetY);
-          QPointF devParticlePt = xform.map(particlePt);
-
-          float jX = 0, jY = 0, jSize = 1.0f, jRot = 0, jOpac = 1.0f;
-          if (settings.posJitterX > 0)
-            jX = ((std::rand() % 2001 - 1000) / 1000.0f) * settings.posJitterX * devSizeBase;
-          if (settings.posJitterY > 0)
-            jY = ((std::rand() % 2001 - 1000) / 1000.0f) * settings.posJitterY * devSizeBase;
-          if (settings.sizeJitter > 0)
-            jSize = 1.0f + ((std::rand() % 2001 - 1000) / 1000.0f) * settings.sizeJitter;
-          if (settings.rotationJitter > 0)
-            jRot = ((std::rand() % 2001 - 1000) / 1000.0f) * settings.rotationJitter * 3.14159f;
-          if (settings.opacityJitter > 0)
-            jOpac = 1.0f - (std::rand() % 1001 / 1000.0f) * settings.opacityJitter;
-
-          float devParticleSize = pSize * scaleFactor * sizeMultiplier * calligraphyWidth * jSize * spraySizeComp;
-
-          QColor finalColor = c;
-          finalColor.setAlphaF(std::clamp(opacityBase * jOpac * settings.dualTipFlow, 0.0f, 1.0f));
-
-          if (settings.hueJitter > 0 || settings.satJitter > 0) {
-            float h, s, l, a;
-            finalColor.getHslF(&h, &s, &l, &a);
-            h = std::fmod(h + ((std::rand() % 2001 - 1000) / 1000.0f) * settings.hueJitter, 1.0f);
-            if (h < 0) h += 1.0f;
-            s = std::clamp(s + ((std::rand() % 2001 - 1000) / 1000.0f) * settings.satJitter, 0.0f, 1.0f);
-            finalColor.setHslF(h, s, l, a);
-          }
-
-          StrokeRenderer::DabInstance pDab;
-          pDab.x = devParticlePt.x() + jX;
-          pDab.y = devParticlePt.y() + jY;
-          pDab.size = devParticleSize;
-          pDab.rotation = (settings.particleDirection * 3.14159265f / 180.0f) + jRot;
-          pDab.colorR = finalColor.redF();
-          pDab.colorG = finalColor.greenF();
-          pDab.colorB = finalColor.blueF();
-          pDab.colorA = finalColor.alphaF();
-          pDab.paintLoad = 1.0f;
-
-          particleDabs.push_back(pDab);
-        }
-      }
-
-      distanceToDab += stepSize;
+    DabSegment seg;
+    seg.settings = &settings;
+    seg.from = lastPoint;
+    seg.to = currentPoint;
+    seg.dist = dist;
+    seg.stepSize = stepSize;
+    seg.currentSize = currentSize;
+    seg.strokeAngle = strokeAngle;
+    seg.calligraphyWidth = calligraphyWidth;
+    seg.scaleFactor = scaleFactor;
+    seg.effectivePressure = effectivePressure;
+    seg.accumulatedDistance = m_accumulatedDistance;
+    seg.tipRotation = settings.tipRotation +
+                      (settings.rotateWithStroke ? strokeAngle : 0.0f);
+    // Blend-only brushes (e.g. blenders or watercolor wet mixers) have 0
+    // opacity pigment but need to draw dabs to trigger GPU neighbor blending
+    // and smudging.
+    seg.isBlendOnly = (settings.blendOnly || settings.dilution > 0.01f ||
+                       settings.smudge > 0.01f ||
+                       settings.type == BrushSettings::Type::Watercolor ||
+                       settings.type == BrushSettings::Type::Oil);
+    seg.xform = xform;
+    seg.color = c;
+
+    {
+      ScopedLatencyTimer dabTimer(LatencyStage::DabGeneration);
+      DabGenerator generateDabs =
+          selectDabGenerator(compileBrushFeatures(settings));
+      distanceToDab =
+          generateDabs(seg, distanceToDab, instancedDabs, particleDabs);
     }
 
     if (!instancedDabs.empty()) {
+      // Tiempo de CPU en emitir los draw calls (GL es asíncrono)
+      ScopedLatencyTimer gpuTimer(LatencyStage::GpuSubmit);
       bool useSequentialPingPong = (pingFBO && pongFBO &&
                                     (settings.type == BrushSettings::Type::Oil ||
                                      settings.smudge > 0.01f ||
@@ -1530,9 +1581,9 @@ void BrushEngine::paintStroke(QPainter *painter, const QPointF &lastPoint,
     // Stroke-path jitter: lateral = perpendicular, linear = along stroke
     if (settings.jitterLateral > 0.0f || settings.jitterLinear > 0.0f) {
       float strokeAngleQP = std::atan2(dy, dx);
-      float latAmt = ((std::rand() % 2001 - 1000) / 1000.0f) *
+      float latAmt = ((jitterRand() % 2001 - 1000) / 1000.0f) *
                      settings.jitterLateral * currentSize;
-      float linAmt = ((std::rand() % 2001 - 1000) / 1000.0f) *
+      float linAmt = ((jitterRand() % 2001 - 1000) / 1000.0f) *
                      settings.jitterLinear * currentSize;
       float ca = std::cos(strokeAngleQP), sa = std::sin(strokeAngleQP);
       pt += QPointF(linAmt * ca - latAmt * sa, linAmt * sa + latAmt * ca);
@@ -1563,16 +1614,16 @@ void BrushEngine::paintStroke(QPainter *painter, const QPointF &lastPoint,
       // Jitters
       float jX = 0, jY = 0, jSize = 1.0f, jRot = 0, jOpac = 1.0f;
       if (settings.posJitterX > 0)
-        jX = ((std::rand() % 2001 - 1000) / 1000.0f) * settings.posJitterX *
+        jX = ((jitterRand() % 2001 - 1000) / 1000.0f) * settings.posJitterX *
              dabSize;
       if (settings.posJitterY > 0)
-        jY = ((std::rand() % 2001 - 1000) / 1000.0f) * settings.posJitterY *
+        jY = ((jitterRand() % 2001 - 1000) / 1000.0f) * settings.posJitterY *
              dabSize;
       if (settings.sizeJitter > 0)
         jSize = 1.0f +
-                ((std::rand() % 2001 - 1000) / 1000.0f) * settings.sizeJitter;
+                ((jitterRand() % 2001 - 1000) / 1000.0f) * settings.sizeJitter;
       if (settings.opacityJitter > 0)
-        jOpac = 1.0f - (std::rand() % 1001 / 1000.0f) * settings.opacityJitter;
+        jOpac = 1.0f - (jitterRand() % 1001 / 1000.0f) * settings.opacityJitter;
 
       QPointF finalPt = pt + QPointF(jX, jY);
       float finalSize = std::max(0.1f, dabSize * jSize);
@@ -1584,12 +1635,12 @@ void BrushEngine::paintStroke(QPainter *painter, const QPointF &lastPoint,
       if (settings.hueJitter > 0 || settings.satJitter > 0) {
         float h, s, l, a;
         finalColor.getHslF(&h, &s, &l, &a);
-        h = std::fmod(h + ((std::rand() % 2001 - 1000) / 1000.0f) *
+        h = std::fmod(h + ((jitterRand() % 2001 - 1000) / 1000.0f) *
                               settings.hueJitter,
                       1.0f);
         if (h < 0)
           h += 1.0f;
-        s = std::clamp(s + ((std::rand() % 2001 - 1000) / 1000.0f) *
+        s = std::clamp(s + ((jitterRand() % 2001 - 1000) / 1000.0f) *
                                settings.satJitter,
                        0.0f, 1.0f);
         finalColor.setHslF(h, s, l, a);
@@ -1620,8 +1671,8 @@ void BrushEngine::paintStroke(QPainter *painter, const QPointF &lastPoint,
         float scatterRadius = std::max(0.0f, maxScatter) * (settings.mainSprayDeviation / 5.0f);
 
         for (int pIdx = 0; pIdx < numParticles; ++pIdx) {
-          float theta = (std::rand() % 360) * 3.14159265f / 180.0f;
-          float tRandom = (std::rand() % 1001) / 1000.0f;
+          float theta = (jitterRand() % 360) * 3.14159265f / 180.0f;
+          float tRandom = (jitterRand() % 1001) / 1000.0f;
           float r = std::pow(tRandom, 1.5f) * scatterRadius;
           float pOffsetX = r * std::cos(theta);
           float pOffsetY = r * std::sin(theta);
@@ -1629,15 +1680,15 @@ void BrushEngine::paintStroke(QPainter *painter, const QPointF &lastPoint,
 
           float pjX = 0, pjY = 0, pjSize = 1.0f, pjRot = 0, pjOpac = 1.0f;
           if (settings.posJitterX > 0)
-            pjX = ((std::rand() % 2001 - 1000) / 1000.0f) * settings.posJitterX * dabSize;
+            pjX = ((jitterRand() % 2001 - 1000) / 1000.0f) * settings.posJitterX * dabSize;
           if (settings.posJitterY > 0)
-            pjY = ((std::rand() % 2001 - 1000) / 1000.0f) * settings.posJitterY * dabSize;
+            pjY = ((jitterRand() % 2001 - 1000) / 1000.0f) * settings.posJitterY * dabSize;
           if (settings.sizeJitter > 0)
-            pjSize = 1.0f + ((std::rand() % 2001 - 1000) / 1000.0f) * settings.sizeJitter;
+            pjSize = 1.0f + ((jitterRand() % 2001 - 1000) / 1000.0f) * settings.sizeJitter;
           if (settings.rotationJitter > 0)
-            pjRot = ((std::rand() % 2001 - 1000) / 1000.0f) * settings.rotationJitter * 3.14159f;
+            pjRot = ((jitterRand() % 2001 - 1000) / 1000.0f) * settings.rotationJitter * 3.14159f;
           if (settings.opacityJitter > 0)
-            pjOpac = 1.0f - (std::rand() % 1001 / 1000.0f) * settings.opacityJitter;
+            pjOpac = 1.0f - (jitterRand() % 1001 / 1000.0f) * settings.opacityJitter;
 
           float finalParticleSize = std::max(0.1f, pSize * sizeMultiplier * calligraphyWidth * pjSize * spraySizeComp);
           float finalParticleOpacity = std::clamp(dabOpacity * pjOpac, 0.0f, 1.0f);
@@ -1685,8 +1736,8 @@ void BrushEngine::paintStroke(QPainter *painter, const QPointF &lastPoint,
           float scatterRadius = std::max(0.0f, maxScatter) * (settings.sprayDeviation / 5.0f);
 
           for (int pIdx = 0; pIdx < numParticles; ++pIdx) {
-            float theta = (std::rand() % 360) * 3.14159265f / 180.0f;
-            float tRandom = (std::rand() % 1001) / 1000.0f;
+            float theta = (jitterRand() % 360) * 3.14159265f / 180.0f;
+            float tRandom = (jitterRand() % 1001) / 1000.0f;
             float r = std::pow(tRandom, 1.5f) * scatterRadius;
             float pOffsetX = r * std::cos(theta);
             float pOffsetY = r * std::sin(theta);
@@ -1694,15 +1745,15 @@ void BrushEngine::paintStroke(QPainter *painter, const QPointF &lastPoint,
 
             float pjX = 0, pjY = 0, pjSize = 1.0f, pjRot = 0, pjOpac = 1.0f;
             if (settings.posJitterX > 0)
-              pjX = ((std::rand() % 2001 - 1000) / 1000.0f) * settings.posJitterX * dabSize;
+              pjX = ((jitterRand() % 2001 - 1000) / 1000.0f) * settings.posJitterX * dabSize;
             if (settings.posJitterY > 0)
-              pjY = ((std::rand() % 2001 - 1000) / 1000.0f) * settings.posJitterY * dabSize;
+              pjY = ((jitterRand() % 2001 - 1000) / 1000.0f) * settings.posJitterY * dabSize;
             if (settings.sizeJitter > 0)
-              pjSize = 1.0f + ((std::rand() % 2001 - 1000) / 1000.0f) * settings.sizeJitter;
+              pjSize = 1.0f + ((jitterRand() % 2001 - 1000) / 1000.0f) * settings.sizeJitter;
             if (settings.rotationJitter > 0)
-              pjRot = ((std::rand() % 2001 - 1000) / 1000.0f) * settings.rotationJitter * 3.14159f;
+              pjRot = ((jitterRand() % 2001 - 1000) / 1000.0f) * settings.rotationJitter * 3.14159f;
             if (settings.opacityJitter > 0)
-              pjOpac = 1.0f - (std::rand() % 1001 / 1000.0f) * settings.opacityJitter;
+              pjOpac = 1.0f - (jitterRand() % 1001 / 1000.0f) * settings.opacityJitter;
 
             float finalParticleSize = std::max(0.1f, pSize * sizeMultiplier * calligraphyWidth * pjSize * spraySizeComp);
             float finalParticleOpacity = std::clamp(dabOpacity * pjOpac * settings.dualTipFlow, 0.0f, 1.0f);
@@ -1730,6 +1781,7 @@ void BrushEngine::paintStroke(QPainter *painter, const QPointF &lastPoint,
 
 void BrushEngine::setBrush(const BrushSettings &settings) {
   m_currentSettings = settings;
+  m_sharedSettings.reset();
   // Sync cached color
   m_cachedColor = Color(settings.color.red(), settings.color.green(),
                         settings.color.blue(), settings.color.alpha());
@@ -1738,6 +1790,13 @@ void BrushEngine::setBrush(const BrushSettings &settings) {
 void BrushEngine::setColor(const Color &color) {
   m_cachedColor = color;
   m_currentSettings.color = QColor(color.r, color.g, color.b, color.a);
+  m_sharedSettings.reset();
+}
+
+std::shared_ptr<const BrushSettings> BrushEngine::sharedBrush() const {
+  if (!m_sharedSettings)
+    m_sharedSettings = std::make_shared<const BrushSettings>(m_currentSettings);
+  return m_sharedSettings;
 }
 
 const Color &BrushEngine::getColor() const { return m_cachedColor; }
@@ -1819,21 +1878,9 @@ void BrushEngine::continueStroke(const StrokePoint &point) {
   bool hasDualTip = (dualTipTexId != 0 && m_currentSettings.dualTipEnabled);
   bool hasDualGrain = (dualGrainTexId != 0 && m_currentSettings.useDualTexture);
 
-  int uDualTipBlendMode = 0; // multiply
-  if (m_currentSettings.dualTipBlendMode == "mask" || m_currentSettings.dualTipBlendMode == "subtract") {
-    uDualTipBlendMode = 1;
-  } else if (m_currentSettings.dualTipBlendMode == "add") {
-    uDualTipBlendMode = 2;
-  } else if (m_currentSettings.dualTipBlendMode == "height_linear" || m_currentSettings.dualTipBlendMode == "height") {
-    uDualTipBlendMode = 3;
-  }
-
-  int uGrainBlendMode = 0; // multiply
-  if (m_currentSettings.grainBlendMode == "subtract") {
-    uGrainBlendMode = 1;
-  } else if (m_currentSettings.grainBlendMode == "threshold" || m_currentSettings.grainBlendMode == "reveal") {
-    uGrainBlendMode = 2;
-  }
+  // Enum values match the shader uniforms
+  int uDualTipBlendMode = static_cast<int>(m_currentSettings.dualTipBlendMode);
+  int uGrainBlendMode = static_cast<int>(m_currentSettings.grainBlendMode);
 
   int w = m_renderer ? m_renderer->viewportWidth() : 2000;
   int h = m_renderer ? m_renderer->viewportHeight() : 2000;
@@ -1885,8 +1932,8 @@ void BrushEngine::continueStroke(const StrokePoint &point) {
       float scatterRadius = std::max(0.0f, maxScatter) * (m_currentSettings.mainSprayDeviation / 5.0f);
 
       for (int pIdx = 0; pIdx < numParticles; ++pIdx) {
-        float theta = (std::rand() % 360) * 3.14159265f / 180.0f;
-        float tRandom = (std::rand() % 1001) / 1000.0f;
+        float theta = (jitterRand() % 360) * 3.14159265f / 180.0f;
+        float tRandom = (jitterRand() % 1001) / 1000.0f;
         float r = std::pow(tRandom, 1.5f) * scatterRadius;
         float pOffsetX = r * std::cos(theta);
         float pOffsetY = r * std::sin(theta);
@@ -1895,15 +1942,15 @@ void BrushEngine::continueStroke(const StrokePoint &point) {
         // Jitters
         float jX = 0, jY = 0, jSize = 1.0f, jRot = 0, jOpac = 1.0f;
         if (m_currentSettings.posJitterX > 0)
-          jX = ((std::rand() % 2001 - 1000) / 1000.0f) * m_currentSettings.posJitterX * devSizeBase;
+          jX = ((jitterRand() % 2001 - 1000) / 1000.0f) * m_currentSettings.posJitterX * devSizeBase;
         if (m_currentSettings.posJitterY > 0)
-          jY = ((std::rand() % 2001 - 1000) / 1000.0f) * m_currentSettings.posJitterY * devSizeBase;
+          jY = ((jitterRand() % 2001 - 1000) / 1000.0f) * m_currentSettings.posJitterY * devSizeBase;
         if (m_currentSettings.sizeJitter > 0)
-          jSize = 1.0f + ((std::rand() % 2001 - 1000) / 1000.0f) * m_currentSettings.sizeJitter;
+          jSize = 1.0f + ((jitterRand() % 2001 - 1000) / 1000.0f) * m_currentSettings.sizeJitter;
         if (m_currentSettings.rotationJitter > 0)
-          jRot = ((std::rand() % 2001 - 1000) / 1000.0f) * m_currentSettings.rotationJitter * 3.14159f;
+          jRot = ((jitterRand() % 2001 - 1000) / 1000.0f) * m_currentSettings.rotationJitter * 3.14159f;
         if (m_currentSettings.opacityJitter > 0)
-          jOpac = 1.0f - (std::rand() % 1001 / 1000.0f) * m_currentSettings.opacityJitter;
+          jOpac = 1.0f - (jitterRand() % 1001 / 1000.0f) * m_currentSettings.opacityJitter;
 
         float devParticleSize = pSize * sizeMultiplier * jSize * spraySizeComp;
 
@@ -1913,9 +1960,9 @@ void BrushEngine::continueStroke(const StrokePoint &point) {
         if (m_currentSettings.hueJitter > 0 || m_currentSettings.satJitter > 0) {
           float h, s, l, a;
           finalColor.getHslF(&h, &s, &l, &a);
-          h = std::fmod(h + ((std::rand() % 2001 - 1000) / 1000.0f) * m_currentSettings.hueJitter, 1.0f);
+          h = std::fmod(h + ((jitterRand() % 2001 - 1000) / 1000.0f) * m_currentSettings.hueJitter, 1.0f);
           if (h < 0) h += 1.0f;
-          s = std::clamp(s + ((std::rand() % 2001 - 1000) / 1000.0f) * m_currentSettings.satJitter, 0.0f, 1.0f);
+          s = std::clamp(s + ((jitterRand() % 2001 - 1000) / 1000.0f) * m_currentSettings.satJitter, 0.0f, 1.0f);
           finalColor.setHslF(h, s, l, a);
         }
 
@@ -1944,19 +1991,19 @@ void BrushEngine::continueStroke(const StrokePoint &point) {
         // Jitters
         float jX = 0, jY = 0, jSize = 1.0f, jRot = 0, jOpac = 1.0f;
         if (m_currentSettings.posJitterX > 0)
-          jX = ((std::rand() % 2001 - 1000) / 1000.0f) *
+          jX = ((jitterRand() % 2001 - 1000) / 1000.0f) *
                m_currentSettings.posJitterX * devSizeBase;
         if (m_currentSettings.posJitterY > 0)
-          jY = ((std::rand() % 2001 - 1000) / 1000.0f) *
+          jY = ((jitterRand() % 2001 - 1000) / 1000.0f) *
                m_currentSettings.posJitterY * devSizeBase;
         if (m_currentSettings.sizeJitter > 0)
-          jSize = 1.0f + ((std::rand() % 2001 - 1000) / 1000.0f) *
+          jSize = 1.0f + ((jitterRand() % 2001 - 1000) / 1000.0f) *
                              m_currentSettings.sizeJitter;
         if (m_currentSettings.rotationJitter > 0)
-          jRot = ((std::rand() % 2001 - 1000) / 1000.0f) *
+          jRot = ((jitterRand() % 2001 - 1000) / 1000.0f) *
                  m_currentSettings.rotationJitter * 3.14159f;
         if (m_currentSettings.opacityJitter > 0)
-          jOpac = 1.0f - (std::rand() % 1001 / 1000.0f) *
+          jOpac = 1.0f - (jitterRand() % 1001 / 1000.0f) *
                              m_currentSettings.opacityJitter;
 
         QColor finalColor = m_currentSettings.color;
@@ -1966,12 +2013,12 @@ void BrushEngine::continueStroke(const StrokePoint &point) {
         if (m_currentSettings.hueJitter > 0 || m_currentSettings.satJitter > 0) {
           float h, s, l, a;
           finalColor.getHslF(&h, &s, &l, &a);
-          h = std::fmod(h + ((std::rand() % 2001 - 1000) / 1000.0f) *
+          h = std::fmod(h + ((jitterRand() % 2001 - 1000) / 1000.0f) *
                                 m_currentSettings.hueJitter,
                         1.0f);
           if (h < 0)
             h += 1.0f;
-          s = std::clamp(s + ((std::rand() % 2001 - 1000) / 1000.0f) *
+          s = std::clamp(s + ((jitterRand() % 2001 - 1000) / 1000.0f) *
                                  m_currentSettings.satJitter,
                          0.0f, 1.0f);
           finalColor.setHslF(h, s, l, a);
@@ -2020,8 +2067,8 @@ void BrushEngine::continueStroke(const StrokePoint &point) {
       float scatterRadius = std::max(0.0f, maxScatter) * (m_currentSettings.sprayDeviation / 5.0f);
 
       for (int pIdx = 0; pIdx < numParticles; ++pIdx) {
-        float theta = (std::rand() % 360) * 3.14159265f / 180.0f;
-        float tRandom = (std::rand() % 1001) / 1000.0f;
+        float theta = (jitterRand() % 360) * 3.14159265f / 180.0f;
+        float tRandom = (jitterRand() % 1001) / 1000.0f;
         float r = std::pow(tRandom, 1.5f) * scatterRadius;
         float pOffsetX = r * std::cos(theta);
         float pOffsetY = r * std::sin(theta);
@@ -2029,15 +2076,15 @@ void BrushEngine::continueStroke(const StrokePoint &point) {
 
         float jX = 0, jY = 0, jSize = 1.0f, jRot = 0, jOpac = 1.0f;
         if (m_currentSettings.posJitterX > 0)
-          jX = ((std::rand() % 2001 - 1000) / 1000.0f) * m_currentSettings.posJitterX * devSizeBase;
+          jX = ((jitterRand() % 2001 - 1000) / 1000.0f) * m_currentSettings.posJitterX * devSizeBase;
         if (m_currentSettings.posJitterY > 0)
-          jY = ((std::rand() % 2001 - 1000) / 1000.0f) * m_currentSettings.posJitterY * devSizeBase;
+          jY = ((jitterRand() % 2001 - 1000) / 1000.0f) * m_currentSettings.posJitterY * devSizeBase;
         if (m_currentSettings.sizeJitter > 0)
-          jSize = 1.0f + ((std::rand() % 2001 - 1000) / 1000.0f) * m_currentSettings.sizeJitter;
+          jSize = 1.0f + ((jitterRand() % 2001 - 1000) / 1000.0f) * m_currentSettings.sizeJitter;
         if (m_currentSettings.rotationJitter > 0)
-          jRot = ((std::rand() % 2001 - 1000) / 1000.0f) * m_currentSettings.rotationJitter * 3.14159f;
+          jRot = ((jitterRand() % 2001 - 1000) / 1000.0f) * m_currentSettings.rotationJitter * 3.14159f;
         if (m_currentSettings.opacityJitter > 0)
-          jOpac = 1.0f - (std::rand() % 1001 / 1000.0f) * m_currentSettings.opacityJitter;
+          jOpac = 1.0f - (jitterRand() % 1001 / 1000.0f) * m_currentSettings.opacityJitter;
 
         float devParticleSize = pSize * sizeMultiplier * jSize * spraySizeComp;
 
@@ -2047,9 +2094,9 @@ void BrushEngine::continueStroke(const StrokePoint &point) {
         if (m_currentSettings.hueJitter > 0 || m_currentSettings.satJitter > 0) {
           float h, s, l, a;
           finalColor.getHslF(&h, &s, &l, &a);
-          h = std::fmod(h + ((std::rand() % 2001 - 1000) / 1000.0f) * m_currentSettings.hueJitter, 1.0f);
+          h = std::fmod(h + ((jitterRand() % 2001 - 1000) / 1000.0f) * m_currentSettings.hueJitter, 1.0f);
           if (h < 0) h += 1.0f;
-          s = std::clamp(s + ((std::rand() % 2001 - 1000) / 1000.0f) * m_currentSettings.satJitter, 0.0f, 1.0f);
+          s = std::clamp(s + ((jitterRand() % 2001 - 1000) / 1000.0f) * m_currentSettings.satJitter, 0.0f, 1.0f);
           finalColor.setHslF(h, s, l, a);
         }
 
@@ -872,7 +872,7 @@ void BrushPreset::applyToLegacy(BrushSettings &s) const {
   s.dualTipTextureID = 0; // Loaded lazily by BrushEngine
   s.dualTipScale = dualBrush.scale;
   s.dualTipRotation = dualBrush.rotation * 3.14159265f / 180.0f; // deg to rad
-  s.dualTipBlendMode = dualBrush.blendMode;
+  s.dualTipBlendMode = dualTipBlendFromString(dualBrush.blendMode);
   s.dualTipFlow = dualBrush.flow;
 
   // Dual Brush Spray Settings
@@ -904,13 +904,8 @@ void BrushPreset::applyToLegacy(BrushSettings &s) const {
     s.dualGrainRotation = dualBrush.grain.rotation * 3.14159265f / 180.0f;
     s.dualGrainEmphasizeDensity = dualBrush.grain.emphasizeDensity;
     s.dualGrainApplyToTips = dualBrush.grain.applyToTips;
-    int dbm = 0;
-    if (dualBrush.grain.blendMode == "subtract") {
-      dbm = 1;
-    } else if (dualBrush.grain.blendMode == "threshold" || dualBrush.grain.blendMode == "reveal") {
-      dbm = 2;
-    }
-    s.dualGrainBlendMode = dbm;
+    s.dualGrainBlendMode =
+        static_cast<int>(grainBlendFromString(dualBrush.grain.blendMode));
   } else {
     s.useDualTexture = false;
     s.dualTextureName = "";
@@ -964,6 +959,7 @@ void BrushPreset::applyToLegacy(BrushSettings &s) const {
   s.pressureCurveY1 = sizeDynamics.pressureCurve.cy1;
   s.pressureCurveX2 = sizeDynamics.pressureCurve.cx2;
   s.pressureCurveY2 = sizeDynamics.pressureCurve.cy2;
+  s.bakePressureCurve();
   s.sizeMinPressure = std::max(0.0f, std::min(1.0f, sizeDynamics.minLimit));
   s.opacityMinPressure =
       std::max(0.0f, std::min(1.0f, opacityDynamics.minLimit));
@@ -1003,7 +999,7 @@ void BrushPreset::applyToLegacy(BrushSettings &s) const {
   s.grainMotionBlur = grain.motionBlur;
   s.grainMotionBlurAngle = grain.motionBlurAngle;
   s.grainRandomOffset = grain.randomOffset;
-  s.grainBlendMode = grain.blendMode;
+  s.grainBlendMode = grainBlendFromString(grain.blendMode);
   s.grainBright = grain.brightness;
   s.grainCon = grain.contrast;
 
@@ -1,326 +1,498 @@
 #include "color_range_selector.h"
 #include <cmath>
+#include <cstring>
 #include <algorithm>
 #include <vector>
-#include <functional>
-#include <unordered_map>
-#include <utility>
+#include <QtConcurrent/QtConcurrentMap>
 
-namespace artflow {
-
-ColorRangeSelector::ColorRangeSelector() {}
-
-ColorRangeSelector::~ColorRangeSelector() {}
-
-QImage ColorRangeSelector::selectByColor(const QImage &image, const QColor &targetColor,
-                                         float tolerance, int channelMode, float fuzziness,
-                                         bool invert) const {
-    int W = image.width();
-    int H = image.height();
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ARTFLOW_COLOR_RANGE_SSE2 1
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && defined(__aarch64__)
+#include <arm_neon.h>
+#define ARTFLOW_COLOR_RANGE_NEON 1
+#endif
 
-    QImage mask(W, H, QImage::Format_Grayscale8);
-    if (W <= 0 || H <= 0) return mask;
-
-    int tr = targetColor.red();
-    int tg = targetColor.green();
-    int tb = targetColor.blue();
-
-    int tH, tS, tV;
-    targetColor.getHsv(&tH, &tS, &tV);
-    if (tH < 0) tH = 0;
+namespace artflow {
 
-    float tL = 0.299f * tr + 0.587f * tg + 0.114f * tb;
-    float fuzzRange = fuzziness * 2.55f;
+namespace {
+
+// Channel-mode test, resolved once per call
+struct Criteria {
+    int mode = 0;
+    int plane = -1;   // ColorRangeSelector plane read (hue, saturation), -1 = RGBA
+    int channel = 0;  // RGBA byte read by the R / G / B modes
+    bool invert = false;
+    // All Channels / Luminosity, computed per pixel: coverage =
+    // clamp((limit - diff) * slope), or a hard threshold at `tolerance`
+    // without fuzziness
+    float tr = 0.0f, tg = 0.0f, tb = 0.0f, tl = 0.0f;
+    float tolerance = 0.0f;
+    float limit = 0.0f;
+    float slope = 0.0f;
+    bool hard = true;
+    // Other modes: coverage by channel value (hue needs 360 entries)
+    uint8_t lut[360] = {};
+
+    Criteria(const QColor &target, float tolerance, int channelMode, float fuzziness, bool invert);
+};
+
+// RGB distance normalized to 0-255
+constexpr float kDistanceScale = 255.0f / 441.673f;
+
+// Coverage [0-255] of a channel difference: full up to the tolerance,
+// fading out over the fuzziness range
+float rampCoverage(float diff, float tolerance, float fuzzRange) {
+    if (fuzzRange <= 0.0f) return diff <= tolerance ? 255.0f : 0.0f;
+    return std::clamp((tolerance + fuzzRange - diff) * (255.0f / fuzzRange), 0.0f, 255.0f);
+}
 
-    for (int y = 0; y < H; ++y) {
-        uint8_t *maskLine = mask.scanLine(y);
-        for (int x = 0; x < W; ++x) {
-            QRgb pixel = image.pixel(x, y);
-            int pr = qRed(pixel);
-            int pg = qGreen(pixel);
-            int pb = qBlue(pixel);
-            int pa = qAlpha(pixel);
-
-            float alphaFactor = pa / 255.0f;
-            float diff = 0.0f;
-
-            switch (channelMode) {
-                case 0: { // All Channels (RGB Euclidean)
-                    float dist = std::sqrt((pr - tr) * (pr - tr) + (pg - tg) * (pg - tg) + (pb - tb) * (pb - tb));
-                    diff = (dist / 441.673f) * 255.0f; // Normalized to 0-255
-                    break;
-                }
-                case 1: // Red Channel
-                    diff = std::abs(pr - tr);
-                    break;
-                case 2: // Green Channel
-                    diff = std::abs(pg - tg);
-                    break;
-                case 3: // Blue Channel
-                    diff = std::abs(pb - tb);
-                    break;
-                case 4: { // Hue Channel
-                    QColor col(pr, pg, pb);
-                    int h, s, v;
-                    col.getHsv(&h, &s, &v);
-                    if (h < 0) h = 0;
-                    int deltaH = std::abs(h - tH);
-                    if (deltaH > 180) deltaH = 360 - deltaH;
-                    diff = (deltaH / 180.0f) * 255.0f;
-                    break;
-                }
-                case 5: { // Saturation Channel
-                    QColor col(pr, pg, pb);
-                    int h, s, v;
-                    col.getHsv(&h, &s, &v);
-                    diff = std::abs(s - tS);
-                    break;
-                }
-                case 6: { // Luminosity Channel
-                    float pl = 0.299f * pr + 0.587f * pg + 0.114f * pb;
-                    diff = std::abs(pl - tL);
-                    break;
-                }
-                default:
-                    diff = 0.0f;
-                    break;
-            }
+// QColor::getHsv() hue and saturation of an 8-bit color, with Qt's 16-bit
+// intermediate steps; the hue of grays reads 0 (Qt's -1 was always clamped
+// to it)
+void hueSaturation(int r8, int g8, int b8, int &h, int &s) {
+    const float r = (r8 * 0x101) / 65535.0f;
+    const float g = (g8 * 0x101) / 65535.0f;
+    const float b = (b8 * 0x101) / 65535.0f;
+    const float mx = std::max({r, g, b});
+    const float delta = mx - std::min({r, g, b});
+    if (delta == 0.0f) {
+        h = 0;
+        s = 0;
+        return;
+    }
+    const unsigned s16 = static_cast<unsigned>(delta / mx * 65535.0f + 0.5f);
+    s = static_cast<int>((s16 - (s16 >> 8) + 0x80) >> 8);
+    float hue;
+    if (r == mx) hue = (g - b) / delta;
+    else if (g == mx) hue = 2.0f + (b - r) / delta;
+    else hue = 4.0f + (r - g) / delta;
+    hue *= 60.0f;
+    if (hue < 0.0f) hue += 360.0f;
+    h = (static_cast<int>(hue * 100.0f + 0.5f) / 100) % 360;
+}
 
-            float s = 0.0f;
-            if (diff <= tolerance) {
-                s = 255.0f;
-            } else if (fuzzRange > 0.0f && diff <= tolerance + fuzzRange) {
-                s = 255.0f * (1.0f - (diff - tolerance) / fuzzRange);
-            } else {
-                s = 0.0f;
+Criteria::Criteria(const QColor &target, float tolerance, int channelMode, float fuzziness,
+                   bool invert)
+    : mode(channelMode), invert(invert), tolerance(tolerance) {
+    const int r = target.red(), g = target.green(), b = target.blue();
+    const float fuzzRange = fuzziness * 2.55f;
+    tr = r;
+    tg = g;
+    tb = b;
+    tl = 0.299f * r + 0.587f * g + 0.114f * b;
+    hard = fuzzRange <= 0.0f;
+    limit = tolerance + fuzzRange;
+    slope = hard ? 0.0f : 255.0f / fuzzRange;
+
+    int tH, tS;
+    hueSaturation(r, g, b, tH, tS);
+    for (int v = 0; v < 360; ++v) {
+        float diff = 0.0f;
+        switch (channelMode) {
+            case 1: // Red Channel
+            case 2: // Green Channel
+            case 3: // Blue Channel
+                diff = std::abs(v - (channelMode == 1 ? r : channelMode == 2 ? g : b));
+                break;
+            case 4: { // Hue Channel
+                int deltaH = std::abs(v - tH);
+                if (deltaH > 180) deltaH = 360 - deltaH;
+                diff = (deltaH / 180.0f) * 255.0f;
+                break;
             }
+            case 5: // Saturation Channel
+                diff = std::abs(v - tS);
+                break;
+            default:
+                break;
+        }
+        lut[v] = static_cast<uint8_t>(std::lround(rampCoverage(diff, tolerance, fuzzRange)));
+    }
+    if (channelMode >= 1 && channelMode <= 3) channel = channelMode - 1;
+    if (channelMode == 4 || channelMode == 5) plane = channelMode - 4;
+}
 
-            int val = std::clamp(static_cast<int>(std::round(s * alphaFactor)), 0, 255);
-            if (invert) {
-                val = 255 - val;
-            }
+// Plane `plane` (hue, saturation) of `count` RGBA pixels
+void convertRow(const uint8_t *rgba, int count, int plane, uint16_t *out) {
+    for (int x = 0; x < count; ++x, rgba += 4) {
+        int h, s;
+        hueSaturation(rgba[0], rgba[1], rgba[2], h, s);
+        out[x] = static_cast<uint16_t>(plane == 0 ? h : s);
+    }
+}
 
-            maskLine[x] = static_cast<uint8_t>(val);
+// All Channels (RGB distance) and Luminosity modes: difference ramp
+// weighted by alpha
+void rampRow(const uint8_t *rgba, int count, const Criteria &c, uint8_t *out) {
+    int x = 0;
+#if defined(ARTFLOW_COLOR_RANGE_SSE2)
+    const __m128i byte = _mm_set1_epi32(0xFF);
+    const bool luma = c.mode == 6;
+    const __m128 tr = _mm_set1_ps(c.tr), tg = _mm_set1_ps(c.tg), tb = _mm_set1_ps(c.tb);
+    const __m128 tl = _mm_set1_ps(c.tl);
+    const __m128 wr = _mm_set1_ps(0.299f), wg = _mm_set1_ps(0.587f), wb = _mm_set1_ps(0.114f);
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 scale = _mm_set1_ps(kDistanceScale);
+    const __m128 tolerance = _mm_set1_ps(c.tolerance);
+    const __m128 limit = _mm_set1_ps(c.limit);
+    const __m128 slope = _mm_set1_ps(c.slope);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 full = _mm_set1_ps(255.0f);
+    const __m128 alphaScale = _mm_set1_ps(1.0f / 255.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128i flip = _mm_set1_epi32(c.invert ? 255 : 0);
+    for (; x + 4 <= count; x += 4) {
+        const __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rgba + x * 4));
+        const __m128 r = _mm_cvtepi32_ps(_mm_and_si128(px, byte));
+        const __m128 g = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(px, 8), byte));
+        const __m128 b = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(px, 16), byte));
+        const __m128 a = _mm_cvtepi32_ps(_mm_srli_epi32(px, 24));
+        __m128 diff;
+        if (luma) {
+            const __m128 l = _mm_add_ps(_mm_add_ps(_mm_mul_ps(wr, r), _mm_mul_ps(wg, g)), _mm_mul_ps(wb, b));
+            diff = _mm_andnot_ps(sign, _mm_sub_ps(l, tl));
+        } else {
+            const __m128 dr = _mm_sub_ps(r, tr), dg = _mm_sub_ps(g, tg), db = _mm_sub_ps(b, tb);
+            diff = _mm_mul_ps(
+                _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db))),
+                scale);
         }
+        const __m128 s = c.hard ? _mm_and_ps(_mm_cmple_ps(diff, tolerance), full)
+                                : _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(limit, diff), slope), zero), full);
+        __m128i v = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, a), alphaScale), half));
+        v = _mm_xor_si128(v, flip); // 255 - v for v in [0, 255]
+        v = _mm_packs_epi32(v, v);
+        v = _mm_packus_epi16(v, v);
+        const int packed = _mm_cvtsi128_si32(v);
+        std::memcpy(out + x, &packed, 4);
+    }
+#elif defined(ARTFLOW_COLOR_RANGE_NEON)
+    const uint32x4_t byte = vdupq_n_u32(0xFF);
+    const bool luma = c.mode == 6;
+    const float32x4_t tr = vdupq_n_f32(c.tr), tg = vdupq_n_f32(c.tg), tb = vdupq_n_f32(c.tb);
+    const float32x4_t tl = vdupq_n_f32(c.tl);
+    const float32x4_t tolerance = vdupq_n_f32(c.tolerance);
+    const float32x4_t limit = vdupq_n_f32(c.limit);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t full = vdupq_n_f32(255.0f);
+    const float32x4_t half = vdupq_n_f32(0.5f);
+    const uint32x4_t flip = vdupq_n_u32(c.invert ? 255 : 0);
+    for (; x + 4 <= count; x += 4) {
+        const uint32x4_t px = vreinterpretq_u32_u8(vld1q_u8(rgba + x * 4));
+        const float32x4_t r = vcvtq_f32_u32(vandq_u32(px, byte));
+        const float32x4_t g = vcvtq_f32_u32(vandq_u32(vshrq_n_u32(px, 8), byte));
+        const float32x4_t b = vcvtq_f32_u32(vandq_u32(vshrq_n_u32(px, 16), byte));
+        const float32x4_t a = vcvtq_f32_u32(vshrq_n_u32(px, 24));
+        float32x4_t diff;
+        if (luma) {
+            const float32x4_t l = vaddq_f32(vaddq_f32(vmulq_n_f32(r, 0.299f), vmulq_n_f32(g, 0.587f)),
+                                            vmulq_n_f32(b, 0.114f));
+            diff = vabdq_f32(l, tl);
+        } else {
+            const float32x4_t dr = vsubq_f32(r, tr), dg = vsubq_f32(g, tg), db = vsubq_f32(b, tb);
+            diff = vmulq_n_f32(vsqrtq_f32(vaddq_f32(vaddq_f32(vmulq_f32(dr, dr), vmulq_f32(dg, dg)),
+                                                    vmulq_f32(db, db))),
+                               kDistanceScale);
+        }
+        const float32x4_t s =
+            c.hard ? vreinterpretq_f32_u32(vandq_u32(vcleq_f32(diff, tolerance), vreinterpretq_u32_f32(full)))
+                   : vminq_f32(vmaxq_f32(vmulq_n_f32(vsubq_f32(limit, diff), c.slope), zero), full);
+        uint32x4_t v = vcvtq_u32_f32(vmlaq_f32(half, vmulq_f32(s, a), vdupq_n_f32(1.0f / 255.0f)));
+        v = veorq_u32(v, flip);
+        const uint16x4_t h = vmovn_u32(v);
+        const uint8x8_t bytes = vmovn_u16(vcombine_u16(h, h));
+        const uint32_t packed = vget_lane_u32(vreinterpret_u32_u8(bytes), 0);
+        std::memcpy(out + x, &packed, 4);
+    }
+#endif
+    for (; x < count; ++x) {
+        const uint8_t *px = rgba + x * 4;
+        float diff;
+        if (c.mode == 6) {
+            diff = std::abs(0.299f * px[0] + 0.587f * px[1] + 0.114f * px[2] - c.tl);
+        } else {
+            const float dr = px[0] - c.tr, dg = px[1] - c.tg, db = px[2] - c.tb;
+            diff = std::sqrt(dr * dr + dg * dg + db * db) * kDistanceScale;
+        }
+        const float s = c.hard ? (diff <= c.tolerance ? 255.0f : 0.0f)
+                               : std::min(std::max((c.limit - diff) * c.slope, 0.0f), 255.0f);
+        const int v = static_cast<int>(s * px[3] * (1.0f / 255.0f) + 0.5f);
+        out[x] = static_cast<uint8_t>(c.invert ? 255 - v : v);
     }
-
-    return mask;
 }
 
-QPainterPath ColorRangeSelector::maskToPath(const QImage &mask) const {
-    int W = mask.width();
-    int H = mask.height();
-    QPainterPath path;
-    if (W <= 0 || H <= 0) return path;
+// out = round(out * alpha / 255), inverted if asked
+void alphaRow(const uint8_t *rgba, int count, bool invert, uint8_t *out) {
+    const uint8_t flip = invert ? 255 : 0;
+    int x = 0;
+#if defined(ARTFLOW_COLOR_RANGE_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bias = _mm_set1_epi16(128);
+    const __m128i flipV = _mm_set1_epi8(static_cast<char>(flip));
+    for (; x + 8 <= count; x += 8) {
+        const __m128i lo = _mm_srli_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(rgba + x * 4)), 24);
+        const __m128i hi = _mm_srli_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(rgba + x * 4 + 16)), 24);
+        const __m128i a = _mm_packs_epi32(lo, hi);
+        const __m128i s = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(out + x)), zero);
+        __m128i t = _mm_add_epi16(_mm_mullo_epi16(s, a), bias);
+        t = _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+        const __m128i v = _mm_xor_si128(_mm_packus_epi16(t, t), flipV);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(out + x), v);
+    }
+#elif defined(ARTFLOW_COLOR_RANGE_NEON)
+    const uint8x8_t flipV = vdup_n_u8(flip);
+    for (; x + 8 <= count; x += 8) {
+        const uint8x8x4_t px = vld4_u8(rgba + x * 4);
+        const uint16x8_t t = vmull_u8(vld1_u8(out + x), px.val[3]);
+        vst1_u8(out + x, veor_u8(vraddhn_u16(t, vrshrq_n_u16(t, 8)), flipV));
+    }
+#endif
+    for (; x < count; ++x) {
+        const unsigned t = out[x] * rgba[x * 4 + 3] + 128u;
+        out[x] = static_cast<uint8_t>(((t + (t >> 8)) >> 8) ^ flip);
+    }
+}
 
-    // 1. Build a binary grid from the mask (threshold at 50%)
-    std::vector<uint8_t> grid(W * H, 0);
-    for (int y = 0; y < H; ++y) {
-        const uint8_t *line = mask.constScanLine(y);
-        for (int x = 0; x < W; ++x) {
-            if (line[x] > 127) grid[y * W + x] = 1;
-        }
+// Mask values of `count` pixels; `plane` is the converted channel for the
+// hue / saturation modes
+void evaluateRow(const uint8_t *rgba, const uint16_t *plane, int count, const Criteria &c,
+                 uint8_t *out) {
+    if (c.mode == 0 || c.mode == 6) {
+        rampRow(rgba, count, c, out);
+        return;
+    }
+    if (plane) {
+        for (int x = 0; x < count; ++x) out[x] = c.lut[plane[x]];
+    } else {
+        for (int x = 0; x < count; ++x) out[x] = c.lut[rgba[x * 4 + c.channel]];
     }
+    alphaRow(rgba, count, c.invert, out);
+}
+
+std::vector<int> chunkStarts(int total, int step) {
+    std::vector<int> starts;
+    for (int i = 0; i < total; i += step) starts.push_back(i);
+    return starts;
+}
 
-    // Helper: is pixel inside the selection?
-    auto inside = [&](int x, int y) -> bool {
-        if (x < 0 || x >= W || y < 0 || y >= H) return false;
-        return grid[y * W + x] != 0;
-    };
+// Rows per parallel task for row-major passes
+constexpr int kBandRows = 64;
 
-    // 2. Quick check: is there any selected pixel?
-    bool anySelected = false;
-    for (int i = 0; i < W * H && !anySelected; ++i) {
-        if (grid[i]) anySelected = true;
+} // namespace
+
+ColorRangeSelector::ColorRangeSelector() {}
+
+ColorRangeSelector::~ColorRangeSelector() {}
+
+void ColorRangeSelector::setSource(const ImageBuffer *buffer, uint32_t sourceId) {
+    if (!buffer) {
+        clearSource();
+        return;
     }
-    if (!anySelected) return path;
-
-    // 3. Marching Squares contour tracing
-    //    Pad the grid by 1 pixel on each side to handle border contours cleanly.
-    int PW = W + 2;
-    int PH = H + 2;
-    auto paddedInside = [&](int px, int py) -> bool {
-        int x = px - 1;
-        int y = py - 1;
-        return inside(x, y);
-    };
-
-    // Direction tables for marching squares
-    // Cell corners:  TL(x,y)  TR(x+1,y)
-    //                BL(x,y+1) BR(x+1,y+1)
-    // Case index = TL*8 + TR*4 + BR*2 + BL*1
-
-    struct Edge { float x1, y1, x2, y2; };
-
-    // Collect all boundary edges
-    std::vector<Edge> edges;
-    edges.reserve(W * 4); // rough estimate
-
-    for (int cy = 0; cy < PH - 1; ++cy) {
-        for (int cx = 0; cx < PW - 1; ++cx) {
-            bool tl = paddedInside(cx, cy);
-            bool tr = paddedInside(cx + 1, cy);
-            bool br = paddedInside(cx + 1, cy + 1);
-            bool bl = paddedInside(cx, cy + 1);
-
-            int caseIdx = (tl ? 8 : 0) | (tr ? 4 : 0) | (br ? 2 : 0) | (bl ? 1 : 0);
-            if (caseIdx == 0 || caseIdx == 15) continue; // No boundary
-
-            // Map back to original coordinates (subtract 1 for padding offset)
-            float ox = cx - 1.0f;
-            float oy = cy - 1.0f;
-
-
-            // Edge midpoints in (x,y):
-            float tmx = ox + 0.5f, tmy = oy;        // top edge midpoint
-            float bmx = ox + 0.5f, bmy = oy + 1.0f;  // bottom edge midpoint
-            float lmx = ox,        lmy = oy + 0.5f;  // left edge midpoint
-            float rmx = ox + 1.0f, rmy = oy + 0.5f;  // right edge midpoint
-
-            switch (caseIdx) {
-                case 1:  edges.push_back({lmx, lmy, bmx, bmy}); break;
-                case 2:  edges.push_back({bmx, bmy, rmx, rmy}); break;
-                case 3:  edges.push_back({lmx, lmy, rmx, rmy}); break;
-                case 4:  edges.push_back({tmx, tmy, rmx, rmy}); break;
-                case 5:  edges.push_back({lmx, lmy, tmx, tmy}); edges.push_back({bmx, bmy, rmx, rmy}); break;
-                case 6:  edges.push_back({tmx, tmy, bmx, bmy}); break;
-                case 7:  edges.push_back({lmx, lmy, tmx, tmy}); break;
-                case 8:  edges.push_back({tmx, tmy, lmx, lmy}); break;
-                case 9:  edges.push_back({tmx, tmy, bmx, bmy}); break;
-                case 10: edges.push_back({tmx, tmy, rmx, rmy}); edges.push_back({lmx, lmy, bmx, bmy}); break;
-                case 11: edges.push_back({tmx, tmy, rmx, rmy}); break;
-                case 12: edges.push_back({lmx, lmy, rmx, rmy}); break;
-                case 13: edges.push_back({bmx, bmy, rmx, rmy}); break;
-                case 14: edges.push_back({lmx, lmy, bmx, bmy}); break;
-                default: break;
-            }
-        }
+    if (buffer == m_source && sourceId == m_sourceId &&
+        buffer->width() == m_width && buffer->height() == m_height) {
+        return; // same layer: refresh() drops what was edited
     }
 
-    if (edges.empty()) return path;
+    const int T = ImageBuffer::TILE_SIZE;
+    m_source = buffer;
+    m_sourceId = sourceId;
+    m_width = buffer->width();
+    m_height = buffer->height();
+    m_tilesX = (m_width + T - 1) / T;
+    m_tiles.clear();
+    m_tiles.resize(static_cast<size_t>(m_tilesX) * ((m_height + T - 1) / T));
+
+    const int longest = std::max(m_width, m_height);
+    m_proxyStep = std::max(1, (longest + kProxySize - 1) / kProxySize);
+    m_proxyWidth = (m_width + m_proxyStep - 1) / m_proxyStep;
+    m_proxyHeight = (m_height + m_proxyStep - 1) / m_proxyStep;
+    m_proxyValid = false;
+    m_proxyRgba.clear();
+    for (auto &plane : m_proxyPlanes) plane.clear();
+}
 
-    // 4. Chain edges into contours by matching endpoints
-    //    Use a spatial hash to quickly find matching endpoints
-    struct PtHash {
-        size_t operator()(const std::pair<int,int> &p) const {
-            return std::hash<long long>()(((long long)p.first << 32) | (unsigned int)p.second);
-        }
-    };
-
-    // Quantize float coords to int keys (multiply by 2 to handle 0.5 increments)
-    auto toKey = [](float x, float y) -> std::pair<int,int> {
-        return {(int)std::round(x * 2.0f), (int)std::round(y * 2.0f)};
-    };
-
-    // Build adjacency: for each endpoint, list of (edge_index, which_end: 0=start, 1=end)
-    std::unordered_multimap<std::pair<int,int>, std::pair<int,int>, PtHash> endpointMap;
-    for (int i = 0; i < (int)edges.size(); ++i) {
-        auto k1 = toKey(edges[i].x1, edges[i].y1);
-        auto k2 = toKey(edges[i].x2, edges[i].y2);
-        endpointMap.insert({k1, {i, 0}});
-        endpointMap.insert({k2, {i, 1}});
+void ColorRangeSelector::clearSource() {
+    m_source = nullptr;
+    m_sourceId = 0;
+    m_width = 0;
+    m_height = 0;
+    m_tilesX = 0;
+    m_tiles.clear();
+    m_proxyWidth = 0;
+    m_proxyHeight = 0;
+    m_proxyValid = false;
+    m_proxyRgba.clear();
+    for (auto &plane : m_proxyPlanes) plane.clear();
+}
+
+void ColorRangeSelector::refresh() {
+    const int T = ImageBuffer::TILE_SIZE;
+    for (size_t i = 0; i < m_tiles.size(); ++i) {
+        SourceTile &st = m_tiles[i];
+        const ImageBuffer::Tile *now =
+            m_source->getTile(static_cast<int>(i % m_tilesX) * T, static_cast<int>(i / m_tilesX) * T);
+        const uint32_t revision = now ? now->revision : 0u;
+        // A dirty tile has edits nobody consumed yet: its revision will move
+        if (now == st.tile && revision == st.revision && !(now && now->dirty)) continue;
+        st.tile = now;
+        st.revision = revision;
+        for (auto &plane : st.planes) plane.clear();
+        m_proxyValid = false;
     }
+}
 
-    std::vector<bool> usedEdge(edges.size(), false);
-
-    // Trace contours
-    std::vector<std::vector<QPointF>> contours;
-    for (int startIdx = 0; startIdx < (int)edges.size(); ++startIdx) {
-        if (usedEdge[startIdx]) continue;
-
-        std::vector<QPointF> contour;
-        int curIdx = startIdx;
-        usedEdge[curIdx] = true;
-        contour.push_back(QPointF(edges[curIdx].x1, edges[curIdx].y1));
-        contour.push_back(QPointF(edges[curIdx].x2, edges[curIdx].y2));
-
-        // Follow the chain from the end
-        bool progress = true;
-        while (progress) {
-            progress = false;
-            QPointF lastPt = contour.back();
-            auto key = toKey(lastPt.x(), lastPt.y());
-            auto range = endpointMap.equal_range(key);
-            for (auto it = range.first; it != range.second; ++it) {
-                int eIdx = it->second.first;
-                int eEnd = it->second.second;
-                if (usedEdge[eIdx]) continue;
-
-                usedEdge[eIdx] = true;
-                // Add the other endpoint
-                if (eEnd == 0) {
-                    contour.push_back(QPointF(edges[eIdx].x2, edges[eIdx].y2));
-                } else {
-                    contour.push_back(QPointF(edges[eIdx].x1, edges[eIdx].y1));
+void ColorRangeSelector::buildProxy() {
+    const int s = m_proxyStep;
+    const int pw = m_proxyWidth;
+    m_proxyRgba.assign(static_cast<size_t>(pw) * m_proxyHeight * 4, 0);
+    for (auto &plane : m_proxyPlanes) plane.clear();
+
+    std::vector<int> rows = chunkStarts(m_proxyHeight, 1);
+    QtConcurrent::blockingMap(rows, [&](int py) {
+        const int sy = py * s;
+        const int rowCount = std::min(s, m_height - sy);
+        thread_local std::vector<uint8_t> band;
+        thread_local std::vector<uint32_t> sums;
+        band.resize(static_cast<size_t>(m_width) * rowCount * 4);
+        m_source->readRegion(0, sy, m_width, rowCount, band.data(), m_width * 4);
+        sums.assign(static_cast<size_t>(pw) * 4, 0);
+        for (int y = 0; y < rowCount; ++y) {
+            const uint8_t *src = band.data() + static_cast<size_t>(y) * m_width * 4;
+            for (int px = 0; px < pw; ++px) {
+                uint32_t *sum = &sums[px * 4];
+                const int end = std::min(m_width, (px + 1) * s);
+                for (int x = px * s; x < end; ++x) {
+                    sum[0] += src[x * 4];
+                    sum[1] += src[x * 4 + 1];
+                    sum[2] += src[x * 4 + 2];
+                    sum[3] += src[x * 4 + 3];
                 }
-                progress = true;
-                break;
             }
         }
+        uint8_t *dst = m_proxyRgba.data() + static_cast<size_t>(py) * pw * 4;
+        for (int px = 0; px < pw; ++px) {
+            const uint32_t n = static_cast<uint32_t>(std::min(s, m_width - px * s) * rowCount);
+            for (int c = 0; c < 4; ++c)
+                dst[px * 4 + c] = static_cast<uint8_t>((sums[px * 4 + c] + n / 2) / n);
+        }
+    });
+    m_proxyValid = true;
+}
 
-        if (contour.size() >= 3) {
-            contours.push_back(std::move(contour));
+QImage ColorRangeSelector::selectByColor(const QColor &targetColor, float tolerance,
+                                         int channelMode, float fuzziness, bool invert) {
+    if (!m_source || m_width <= 0 || m_height <= 0) return QImage();
+    refresh();
+
+    QImage mask(m_width, m_height, QImage::Format_Grayscale8);
+    uint8_t *bits = mask.bits();
+    const qsizetype stride = mask.bytesPerLine();
+    const Criteria c(targetColor, tolerance, channelMode, fuzziness, invert);
+    const int T = ImageBuffer::TILE_SIZE;
+
+    std::vector<int> tiles = chunkStarts(static_cast<int>(m_tiles.size()), 1);
+    QtConcurrent::blockingMap(tiles, [&](int i) {
+        SourceTile &st = m_tiles[i];
+        const int x0 = (i % m_tilesX) * T;
+        const int y0 = (i / m_tilesX) * T;
+        const int w = std::min(T, m_width - x0);
+        const int h = std::min(T, m_height - y0);
+        uint8_t *dst = bits + y0 * stride + x0;
+
+        if (!st.tile) {
+            // Unallocated: transparent everywhere, one value for the tile
+            static const uint8_t clear[4] = {};
+            static const uint16_t zero = 0;
+            uint8_t value;
+            evaluateRow(clear, c.plane >= 0 ? &zero : nullptr, 1, c, &value);
+            for (int y = 0; y < h; ++y) std::memset(dst + y * stride, value, w);
+            return;
         }
-    }
 
-    // 5. Simplify contours using Ramer-Douglas-Peucker and build the QPainterPath
-    std::function<void(const std::vector<QPointF>&, int, int, float, std::vector<bool>&)> rdp;
-    rdp = [&rdp](const std::vector<QPointF>& pts, int start, int end, float epsilon, std::vector<bool>& keep) {
-        if (end - start < 2) return;
-        float maxDist = 0;
-        int maxIdx = start;
-        QPointF a = pts[start], b = pts[end];
-        float dx = b.x() - a.x(), dy = b.y() - a.y();
-        float lenSq = dx * dx + dy * dy;
-
-        for (int i = start + 1; i < end; ++i) {
-            float dist;
-            if (lenSq < 1e-10f) {
-                float ex = pts[i].x() - a.x(), ey = pts[i].y() - a.y();
-                dist = std::sqrt(ex * ex + ey * ey);
-            } else {
-                float t = ((pts[i].x() - a.x()) * dx + (pts[i].y() - a.y()) * dy) / lenSq;
-                t = std::max(0.0f, std::min(1.0f, t));
-                float px = a.x() + t * dx - pts[i].x();
-                float py = a.y() + t * dy - pts[i].y();
-                dist = std::sqrt(px * px + py * py);
+        const uint8_t *src = st.tile->data.get();
+        const uint16_t *plane = nullptr;
+        if (c.plane >= 0) {
+            // Each task owns its tile, so converting here is race-free
+            std::vector<uint16_t> &p = st.planes[c.plane];
+            if (p.empty()) {
+                p.resize(static_cast<size_t>(T) * T);
+                convertRow(src, T * T, c.plane, p.data());
             }
-            if (dist > maxDist) { maxDist = dist; maxIdx = i; }
+            plane = p.data();
         }
-        if (maxDist > epsilon) {
-            keep[maxIdx] = true;
-            rdp(pts, start, maxIdx, epsilon, keep);
-            rdp(pts, maxIdx, end, epsilon, keep);
+        for (int y = 0; y < h; ++y) {
+            evaluateRow(src + static_cast<size_t>(y) * T * 4, plane ? plane + y * T : nullptr, w, c,
+                        dst + y * stride);
         }
-    };
+    });
+    return mask;
+}
 
-    float epsilon = 1.0f; // Simplification tolerance in pixels
+QImage ColorRangeSelector::previewByColor(const QColor &targetColor, float tolerance,
+                                          int channelMode, float fuzziness, bool invert) {
+    if (!m_source || m_width <= 0 || m_height <= 0) return QImage();
+    refresh();
+    if (!m_proxyValid) buildProxy();
+
+    const int pw = m_proxyWidth;
+    const int ph = m_proxyHeight;
+    const Criteria c(targetColor, tolerance, channelMode, fuzziness, invert);
+    std::vector<int> bands = chunkStarts(ph, kBandRows);
+    if (c.plane >= 0 && m_proxyPlanes[c.plane].empty()) {
+        std::vector<uint16_t> &p = m_proxyPlanes[c.plane];
+        p.resize(static_cast<size_t>(pw) * ph);
+        QtConcurrent::blockingMap(bands, [&](int y0) {
+            const int rows = std::min(kBandRows, ph - y0);
+            convertRow(m_proxyRgba.data() + static_cast<size_t>(y0) * pw * 4, rows * pw, c.plane,
+                       p.data() + static_cast<size_t>(y0) * pw);
+        });
+    }
 
-    for (auto &contour : contours) {
-        if (contour.size() < 3) continue;
+    QImage mask(pw, ph, QImage::Format_Grayscale8);
+    uint8_t *bits = mask.bits();
+    const qsizetype stride = mask.bytesPerLine();
+    const uint16_t *plane = c.plane >= 0 ? m_proxyPlanes[c.plane].data() : nullptr;
+    QtConcurrent::blockingMap(bands, [&](int y0) {
+        const int y1 = std::min(ph, y0 + kBandRows);
+        for (int y = y0; y < y1; ++y) {
+            evaluateRow(m_proxyRgba.data() + static_cast<size_t>(y) * pw * 4,
+                        plane ? plane + static_cast<size_t>(y) * pw : nullptr, pw, c,
+                        bits + y * stride);
+        }
+    });
 
-        // Simplify
-        std::vector<bool> keep(contour.size(), false);
-        keep[0] = true;
-        keep[contour.size() - 1] = true;
-        rdp(contour, 0, (int)contour.size() - 1, epsilon, keep);
+    const QImage proxy(m_proxyRgba.data(), pw, ph, pw * 4, QImage::Format_RGBA8888);
+    return previewMask(proxy, mask);
+}
 
-        std::vector<QPointF> simplified;
-        for (int i = 0; i < (int)contour.size(); ++i) {
-            if (keep[i]) simplified.push_back(contour[i]);
-        }
+QImage ColorRangeSelector::selectByColor(const QImage &image, const QColor &targetColor,
+                                         float tolerance, int channelMode, float fuzziness,
+                                         bool invert) const {
+    int W = image.width();
+    int H = image.height();
 
-        if (simplified.size() < 3) simplified = contour; // Keep original if too few points
+    QImage mask(W, H, QImage::Format_Grayscale8);
+    if (W <= 0 || H <= 0) return mask;
 
-        // Add to path
-        path.moveTo(simplified[0]);
-        for (size_t i = 1; i < simplified.size(); ++i) {
-            path.lineTo(simplified[i]);
+    const QImage rgba = image.convertToFormat(QImage::Format_RGBA8888);
+    uint8_t *bits = mask.bits();
+    const qsizetype stride = mask.bytesPerLine();
+    const Criteria c(targetColor, tolerance, channelMode, fuzziness, invert);
+    std::vector<int> bands = chunkStarts(H, kBandRows);
+    QtConcurrent::blockingMap(bands, [&](int y0) {
+        std::vector<uint16_t> plane(c.plane >= 0 ? W : 0);
+        const int y1 = std::min(H, y0 + kBandRows);
+        for (int y = y0; y < y1; ++y) {
+            const uint8_t *src = rgba.constScanLine(y);
+            if (c.plane >= 0) convertRow(src, W, c.plane, plane.data());
+            evaluateRow(src, plane.empty() ? nullptr : plane.data(), W, c, bits + y * stride);
         }
-        path.closeSubpath();
-    }
+    });
 
-    return path;
+    return mask;
 }
 
 QImage ColorRangeSelector::previewMask(const QImage &image, const QImage &mask) const {
@@ -0,0 +1,180 @@
+/**
+ * ArtFlow Studio - Curve LUT Implementation
+ */
+
+#include "../include/curve_lut.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+
+namespace artflow {
+
+namespace {
+
+inline float bezierComponent(float t, float p1, float p2) {
+  float mt = 1.0f - t;
+  return 3.0f * mt * mt * t * p1 + 3.0f * mt * t * t * p2 + t * t * t;
+}
+
+inline float bezierDerivative(float t, float p1, float p2) {
+  float mt = 1.0f - t;
+  return 3.0f * mt * mt * p1 + 6.0f * mt * t * (p2 - p1) +
+         3.0f * t * t * (1.0f - p2);
+}
+
+// Cache de tablas Bezier: la mayoría de presets comparten las mismas curvas
+// (linear, ease_in, soft...), así que se hornean una sola vez por proceso.
+constexpr size_t kMaxCachedCurves = 256;
+std::mutex g_curveCacheMutex;
+std::map<std::array<float, 4>, CurveLUT> g_curveCache;
+
+} // namespace
+
+float CurveLUT::solveBezier(float x, float x1, float y1, float x2,
+                            float y2) {
+  if (x <= 0.0f)
+    return 0.0f;
+  if (x >= 1.0f)
+    return 1.0f;
+
+  // Newton's method: find t such that bezierX(t) == x
+  float t = x;
+  bool converged = false;
+  for (int i = 0; i < 8; ++i) {
+    float dx = bezierComponent(t, x1, x2) - x;
+    if (std::abs(dx) < 1e-6f) {
+      converged = true;
+      break;
+    }
+    float dbx = bezierDerivative(t, x1, x2);
+    if (std::abs(dbx) < 1e-6f)
+      break;
+    t = std::clamp(t - dx / dbx, 0.0f, 1.0f);
+  }
+
+  // Flat tangents (x1 or x2 at the ends) stall Newton; bisection is slow but
+  // always converges since x(t) is monotone for controls in [0,1]. Hot paths
+  // read a baked table instead.
+  if (!converged) {
+    float lo = 0.0f, hi = 1.0f;
+    for (int i = 0; i < 30; ++i) {
+      t = 0.5f * (lo + hi);
+      if (bezierComponent(t, x1, x2) < x)
+        lo = t;
+      else
+        hi = t;
+    }
+  }
+  return bezierComponent(t, y1, y2);
+}
+
+void CurveLUT::setIdentity() {
+  m_table.reset();
+  m_isBezier = false;
+}
+
+void CurveLUT::bakeBezier(float x1, float y1, float x2, float y2) {
+  m_isBezier = true;
+  m_bezier[0] = x1;
+  m_bezier[1] = y1;
+  m_bezier[2] = x2;
+  m_bezier[3] = y2;
+
+  // P1 and P2 on the diagonal give y == x exactly
+  if (x1 == y1 && x2 == y2) {
+    m_table.reset();
+    return;
+  }
+
+  auto table = std::make_shared<Table>();
+  for (int i = 0; i < kSize; ++i) {
+    (*table)[i] =
+        solveBezier(static_cast<float>(i) / (kSize - 1), x1, y1, x2, y2);
+  }
+  m_table = std::move(table);
+}
+
+// Monotone Cubic Hermite Spline (Fritsch-Carlson tangents)
+void CurveLUT::bakeMonotoneSpline(
+    std::vector<std::pair<float, float>> points) {
+  m_isBezier = false;
+  if (points.empty()) {
+    m_table.reset();
+    return;
+  }
+
+  // 1. Sort by Input (X)
+  std::sort(points.begin(), points.end(),
+            [](const auto &a, const auto &b) { return a.first < b.first; });
+
+  const int n = static_cast<int>(points.size());
+  std::vector<double> xs(n), ys(n), ms(n, 0.0);
+  for (int i = 0; i < n; ++i) {
+    xs[i] = points[i].first;
+    ys[i] = points[i].second;
+  }
+
+  // 2. Deltas + 3. Tangents
+  if (n > 1) {
+    std::vector<double> d(n - 1);
+    for (int i = 0; i < n - 1; ++i) {
+      double dx = xs[i + 1] - xs[i];
+      d[i] = std::abs(dx) < 1e-6 ? 0.0 : (ys[i + 1] - ys[i]) / dx;
+    }
+    ms[0] = d[0];
+    ms[n - 1] = d[n - 2];
+    for (int i = 1; i < n - 1; ++i)
+      ms[i] = (d[i - 1] * d[i] <= 0) ? 0.0 : (d[i - 1] + d[i]) * 0.5;
+  }
+
+  auto table = std::make_shared<Table>();
+  int seg = 0;
+  for (int k = 0; k < kSize; ++k) {
+    const double x = static_cast<double>(k) / (kSize - 1);
+    double y;
+    if (x <= xs[0]) {
+      y = ys[0];
+    } else if (x >= xs[n - 1]) {
+      y = ys[n - 1];
+    } else {
+      // x crece con k: el segmento sólo avanza
+      while (seg < n - 2 && x >= xs[seg + 1])
+        ++seg;
+      const double h = xs[seg + 1] - xs[seg];
+      if (h < 1e-6) {
+        y = ys[seg];
+      } else {
+        const double t = (x - xs[seg]) / h;
+        const double t2 = t * t;
+        const double t3 = t2 * t;
+        const double h00 = 2 * t3 - 3 * t2 + 1;
+        const double h10 = t3 - 2 * t2 + t;
+        const double h01 = -2 * t3 + 3 * t2;
+        const double h11 = t3 - t2;
+        y = h00 * ys[seg] + h10 * h * ms[seg] + h01 * ys[seg + 1] +
+            h11 * h * ms[seg + 1];
+      }
+    }
+    (*table)[k] = std::clamp(static_cast<float>(y), 0.0f, 1.0f);
+  }
+  m_table = std::move(table);
+}
+
+CurveLUT CurveLUT::cachedBezier(float x1, float y1, float x2, float y2) {
+  const std::array<float, 4> key{x1, y1, x2, y2};
+  std::lock_guard<std::mutex> lock(g_curveCacheMutex);
+  auto it = g_curveCache.find(key);
+  if (it != g_curveCache.end())
+    return it->second;
+
+  if (g_curveCache.size() >= kMaxCachedCurves)
+    g_curveCache.clear(); // las copias vivas conservan su tabla
+
+  CurveLUT lut;
+  lut.bakeBezier(x1, y1, x2, y2);
+  g_curveCache.emplace(key, lut);
+  return lut;
+}
+
+} // namespace artflow
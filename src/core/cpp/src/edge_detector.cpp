@@ -1,12 +1,27 @@
 #include "edge_detector.h"
+#include "live_wire.h"
 #include <cmath>
-#include <queue>
+#include <cstring>
 #include <algorithm>
-#include <QColor>
 #include <QDebug>
+#include <QtConcurrent/QtConcurrentMap>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ARTFLOW_EDGE_SSE2 1
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && defined(__aarch64__)
+#include <arm_neon.h>
+#define ARTFLOW_EDGE_NEON 1
+#endif
 
 namespace artflow {
 
+// Above this radius (pixels of a level) findEdgePoint moves up a level
+static constexpr int kMaxScanRadius = 16;
+// Gradient below this (of 255) is not an edge worth snapping to
+static constexpr int kMinSnapGradient = 3;
+
 EdgeDetector::EdgeDetector()
     : m_edgeSensitivity(0.85f),
       m_searchRadius(12),
@@ -16,222 +31,297 @@ EdgeDetector::EdgeDetector()
 
 EdgeDetector::~EdgeDetector() {}
 
-void EdgeDetector::computeGradientMap(const QImage &image) {
-    m_width = image.width();
-    m_height = image.height();
-    m_gradientMap.assign(m_width * m_height, 0.0f);
+void EdgeDetector::setEdgeSensitivity(float value) {
+    if (m_edgeSensitivity == value) return;
+    m_edgeSensitivity = value;
+    if (m_liveWire) m_liveWire->reset(); // step costs changed
+}
 
-    if (m_width <= 2 || m_height <= 2) {
+void EdgeDetector::setSource(const ImageBuffer *buffer, uint32_t sourceId) {
+    if (!buffer) {
+        clearSource();
         return;
     }
+    if (buffer == m_source && sourceId == m_sourceId &&
+        buffer->width() == m_width && buffer->height() == m_height) {
+        return; // same layer: cached tiles validate themselves
+    }
 
-    std::vector<float> luminance(m_width * m_height, 0.0f);
-
-    // Compute luminance map with virtual white background blending
-    if (image.format() == QImage::Format_RGBA8888 || image.format() == QImage::Format_RGBA8888_Premultiplied) {
-        for (int y = 0; y < m_height; ++y) {
-            const uint8_t *line = image.constScanLine(y);
-            int idx = y * m_width;
-            for (int x = 0; x < m_width; ++x) {
-                float a = line[4 * x + 3] / 255.0f;
-                // Since internal layer buffers are premultiplied:
-                float r = (line[4 * x + 0] / 255.0f) + (1.0f - a);
-                float g = (line[4 * x + 1] / 255.0f) + (1.0f - a);
-                float b = (line[4 * x + 2] / 255.0f) + (1.0f - a);
-                luminance[idx + x] = 0.299f * r + 0.587f * g + 0.114f * b;
-            }
-        }
-    } else {
-        for (int y = 0; y < m_height; ++y) {
-            int idx = y * m_width;
-            for (int x = 0; x < m_width; ++x) {
-                QRgb rgb = image.pixel(x, y);
-                float a = qAlpha(rgb) / 255.0f;
-                float r = (qRed(rgb) / 255.0f) * a + (1.0f - a);
-                float g = (qGreen(rgb) / 255.0f) * a + (1.0f - a);
-                float b = (qBlue(rgb) / 255.0f) * a + (1.0f - a);
-                luminance[idx + x] = 0.299f * r + 0.587f * g + 0.114f * b;
-            }
+    if (m_liveWire) m_liveWire->reset();
+    m_source = buffer;
+    m_sourceId = sourceId;
+    m_width = buffer->width();
+    m_height = buffer->height();
+    for (int level = 0; level < kLevels; ++level) {
+        Level &L = m_levels[level];
+        L.width = (m_width + (1 << level) - 1) >> level;
+        L.height = (m_height + (1 << level) - 1) >> level;
+        L.tilesX = (L.width + kTileSize - 1) / kTileSize;
+        L.tilesY = (L.height + kTileSize - 1) / kTileSize;
+        L.tiles.clear();
+        L.tiles.resize(static_cast<size_t>(L.tilesX) * L.tilesY);
+    }
+}
+
+void EdgeDetector::clearSource() {
+    if (m_liveWire) m_liveWire->reset();
+    m_source = nullptr;
+    m_sourceId = 0;
+    m_width = 0;
+    m_height = 0;
+    for (Level &L : m_levels) L = Level();
+}
+
+bool EdgeDetector::tileValid(const GradientTile &tile) const {
+    if (tile.magnitude.empty()) return false;
+    for (const SourceStamp &stamp : tile.sources) {
+        const ImageBuffer::Tile *now = m_source->getTile(stamp.x, stamp.y);
+        if (now != stamp.tile) return false; // allocated or freed since
+        // A dirty tile has edits nobody consumed yet: its revision will move
+        if (now && (now->dirty || now->revision != stamp.revision)) return false;
+    }
+    return true;
+}
+
+// One output row of Sobel magnitude from three luminance rows (each with a
+// 1 px apron on both sides), scaled so a full black/white step reads 255.
+static void sobelRow(const float *p, const float *c, const float *n, uint8_t *out, int count) {
+    constexpr float kScale = 255.0f / 4.0f;
+    int x = 0;
+#if defined(ARTFLOW_EDGE_SSE2)
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 scale = _mm_set1_ps(kScale);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 top = _mm_set1_ps(255.0f);
+    for (; x + 4 <= count; x += 4) {
+        const __m128 p0 = _mm_loadu_ps(p + x), p1 = _mm_loadu_ps(p + x + 1), p2 = _mm_loadu_ps(p + x + 2);
+        const __m128 c0 = _mm_loadu_ps(c + x), c2 = _mm_loadu_ps(c + x + 2);
+        const __m128 n0 = _mm_loadu_ps(n + x), n1 = _mm_loadu_ps(n + x + 1), n2 = _mm_loadu_ps(n + x + 2);
+        const __m128 gx = _mm_add_ps(_mm_add_ps(_mm_sub_ps(p2, p0), _mm_sub_ps(n2, n0)),
+                                     _mm_mul_ps(two, _mm_sub_ps(c2, c0)));
+        const __m128 gy = _mm_sub_ps(_mm_add_ps(_mm_add_ps(n0, n2), _mm_mul_ps(two, n1)),
+                                     _mm_add_ps(_mm_add_ps(p0, p2), _mm_mul_ps(two, p1)));
+        __m128 mag = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(gx, gx), _mm_mul_ps(gy, gy)));
+        mag = _mm_min_ps(_mm_add_ps(_mm_mul_ps(mag, scale), half), top);
+        __m128i v = _mm_cvttps_epi32(mag);
+        v = _mm_packs_epi32(v, v);
+        v = _mm_packus_epi16(v, v);
+        const int packed = _mm_cvtsi128_si32(v);
+        std::memcpy(out + x, &packed, 4);
+    }
+#elif defined(ARTFLOW_EDGE_NEON)
+    const float32x4_t scale = vdupq_n_f32(kScale);
+    const float32x4_t half = vdupq_n_f32(0.5f);
+    const float32x4_t top = vdupq_n_f32(255.0f);
+    for (; x + 4 <= count; x += 4) {
+        const float32x4_t p0 = vld1q_f32(p + x), p1 = vld1q_f32(p + x + 1), p2 = vld1q_f32(p + x + 2);
+        const float32x4_t c0 = vld1q_f32(c + x), c2 = vld1q_f32(c + x + 2);
+        const float32x4_t n0 = vld1q_f32(n + x), n1 = vld1q_f32(n + x + 1), n2 = vld1q_f32(n + x + 2);
+        const float32x4_t gx = vmlaq_n_f32(vaddq_f32(vsubq_f32(p2, p0), vsubq_f32(n2, n0)),
+                                           vsubq_f32(c2, c0), 2.0f);
+        const float32x4_t gy = vsubq_f32(vmlaq_n_f32(vaddq_f32(n0, n2), n1, 2.0f),
+                                         vmlaq_n_f32(vaddq_f32(p0, p2), p1, 2.0f));
+        float32x4_t mag = vsqrtq_f32(vmlaq_f32(vmulq_f32(gx, gx), gy, gy));
+        mag = vminq_f32(vmlaq_f32(half, mag, scale), top);
+        const uint16x4_t h = vmovn_u32(vcvtq_u32_f32(mag));
+        const uint8x8_t b = vmovn_u16(vcombine_u16(h, h));
+        const uint32_t packed = vget_lane_u32(vreinterpret_u32_u8(b), 0);
+        std::memcpy(out + x, &packed, 4);
+    }
+#endif
+    for (; x < count; ++x) {
+        const float gx = (p[x + 2] - p[x]) + 2.0f * (c[x + 2] - c[x]) + (n[x + 2] - n[x]);
+        const float gy = (n[x] + 2.0f * n[x + 1] + n[x + 2]) - (p[x] + 2.0f * p[x + 1] + p[x + 2]);
+        const float mag = std::sqrt(gx * gx + gy * gy) * kScale + 0.5f;
+        out[x] = static_cast<uint8_t>(std::min(mag, 255.0f));
+    }
+}
+
+void EdgeDetector::computeTile(int level, int tx, int ty) const {
+    const int K = kTileSize;
+    const int A = K + 2; // luminance grid with a 1 px apron
+    const int s = 1 << level;
+    Level &L = m_levels[level];
+    GradientTile &tile = L.tiles[static_cast<size_t>(ty) * L.tilesX + tx];
+
+    // Source window (canvas pixels) and the source tiles it reads
+    const int cx = (tx * K - 1) * s;
+    const int cy = (ty * K - 1) * s;
+    const int span = A * s;
+    const int T = ImageBuffer::TILE_SIZE;
+    tile.sources.clear();
+    const int x0 = std::max(0, cx), y0 = std::max(0, cy);
+    const int x1 = std::min(m_width, cx + span), y1 = std::min(m_height, cy + span);
+    for (int sy = y0 / T * T; sy < y1; sy += T) {
+        for (int sx = x0 / T * T; sx < x1; sx += T) {
+            const ImageBuffer::Tile *src = m_source->getTile(sx, sy);
+            tile.sources.push_back({sx, sy, src, src ? src->revision : 0u});
         }
     }
 
-    float maxGrad = 0.0f;
-    std::vector<float> rawG(m_width * m_height, 0.0f);
-
-    // Apply Sobel kernels
-    for (int y = 1; y < m_height - 1; ++y) {
-        int idx = y * m_width;
-        int idxPrev = (y - 1) * m_width;
-        int idxNext = (y + 1) * m_width;
-
-        for (int x = 1; x < m_width - 1; ++x) {
-            // Sobel X Kernel:
-            // -1  0  1
-            // -2  0  2
-            // -1  0  1
-            float gx = 
-                -1.0f * luminance[idxPrev + (x - 1)] + 1.0f * luminance[idxPrev + (x + 1)] +
-                -2.0f * luminance[idx + (x - 1)]     + 2.0f * luminance[idx + (x + 1)] +
-                -1.0f * luminance[idxNext + (x - 1)] + 1.0f * luminance[idxNext + (x + 1)];
-
-            // Sobel Y Kernel:
-            // -1 -2 -1
-            //  0  0  0
-            //  1  2  1
-            float gy =
-                -1.0f * luminance[idxPrev + (x - 1)] - 2.0f * luminance[idxPrev + x] - 1.0f * luminance[idxPrev + (x + 1)] +
-                 1.0f * luminance[idxNext + (x - 1)] + 2.0f * luminance[idxNext + x] + 1.0f * luminance[idxNext + (x + 1)];
-
-            float val = std::sqrt(gx * gx + gy * gy);
-            rawG[idx + x] = val;
-            if (val > maxGrad) {
-                maxGrad = val;
+    thread_local std::vector<uint8_t> rgba;
+    thread_local std::vector<float> lum;
+    rgba.resize(static_cast<size_t>(span) * span * 4);
+    m_source->readRegion(cx, cy, span, span, rgba.data(), span * 4);
+
+    // Luminance over a virtual white background (layer pixels are
+    // premultiplied), box-filtered down to the level
+    lum.resize(static_cast<size_t>(A) * A);
+    const float norm = 1.0f / (255.0f * s * s);
+    for (int ly = 0; ly < A; ++ly) {
+        for (int lx = 0; lx < A; ++lx) {
+            uint32_t r = 0, g = 0, b = 0, a = 0;
+            for (int by = 0; by < s; ++by) {
+                const uint8_t *px = rgba.data() +
+                                    (static_cast<size_t>(ly * s + by) * span + lx * s) * 4;
+                for (int bx = 0; bx < s; ++bx, px += 4) {
+                    r += px[0];
+                    g += px[1];
+                    b += px[2];
+                    a += px[3];
+                }
             }
+            lum[ly * A + lx] = (0.299f * r + 0.587f * g + 0.114f * b - a) * norm + 1.0f;
         }
     }
 
-    // Normalize magnitude map to [0.0, 1.0]
-    if (maxGrad > 0.001f) {
-        for (int i = 0; i < m_width * m_height; ++i) {
-            m_gradientMap[i] = rawG[i] / maxGrad;
+    tile.magnitude.resize(static_cast<size_t>(K) * K);
+    for (int y = 0; y < K; ++y) {
+        sobelRow(&lum[y * A], &lum[(y + 1) * A], &lum[(y + 2) * A], &tile.magnitude[y * K], K);
+    }
+}
+
+void EdgeDetector::ensureTiles(const QRect &rect, int level) const {
+    const Level &L = m_levels[level];
+    std::vector<int> stale;
+    for (int ty = rect.top() / kTileSize; ty <= rect.bottom() / kTileSize; ++ty) {
+        for (int tx = rect.left() / kTileSize; tx <= rect.right() / kTileSize; ++tx) {
+            const int i = ty * L.tilesX + tx;
+            if (!tileValid(L.tiles[i])) stale.push_back(i);
         }
     }
+    if (stale.size() == 1) {
+        computeTile(level, stale[0] % L.tilesX, stale[0] / L.tilesX);
+    } else if (!stale.empty()) {
+        QtConcurrent::blockingMap(stale, [&](int i) { computeTile(level, i % L.tilesX, i / L.tilesX); });
+    }
 }
 
-float EdgeDetector::getGradientAt(int x, int y) const {
-    if (x < 0 || x >= m_width || y < 0 || y >= m_height) return 0.0f;
-    return m_gradientMap[y * m_width + x];
+void EdgeDetector::gradientWindow(const QRect &rect, int level, std::vector<uint8_t> &out) const {
+    out.assign(static_cast<size_t>(std::max(0, rect.width())) * std::max(0, rect.height()), 0);
+    if (!m_source || rect.isEmpty() || level < 0 || level >= kLevels) return;
+    const Level &L = m_levels[level];
+    const QRect r = rect.intersected(QRect(0, 0, L.width, L.height));
+    if (r.isEmpty()) return;
+    ensureTiles(r, level);
+
+    for (int ty = r.top() / kTileSize; ty <= r.bottom() / kTileSize; ++ty) {
+        for (int tx = r.left() / kTileSize; tx <= r.right() / kTileSize; ++tx) {
+            const GradientTile &tile = L.tiles[ty * L.tilesX + tx];
+            const QRect part = r.intersected(QRect(tx * kTileSize, ty * kTileSize, kTileSize, kTileSize));
+            for (int y = part.top(); y <= part.bottom(); ++y) {
+                std::memcpy(&out[static_cast<size_t>(y - rect.top()) * rect.width() + (part.left() - rect.left())],
+                            &tile.magnitude[(y - ty * kTileSize) * kTileSize + (part.left() - tx * kTileSize)],
+                            part.width());
+            }
+        }
+    }
 }
 
-QPointF EdgeDetector::findEdgePoint(const QPointF &point, int searchRadius) const {
-    if (m_gradientMap.empty() || m_width <= 0 || m_height <= 0) return point;
-
-    int px = std::clamp(static_cast<int>(std::round(point.x())), 0, m_width - 1);
-    int py = std::clamp(static_cast<int>(std::round(point.y())), 0, m_height - 1);
-
-    int bestX = px;
-    int bestY = py;
-    float maxGrad = m_gradientMap[py * m_width + px]; // Start with the gradient at the center/clicked point
-
-    for (int dy = -searchRadius; dy <= searchRadius; ++dy) {
-        int ny = py + dy;
-        if (ny < 0 || ny >= m_height) continue;
-        int idx = ny * m_width;
-        for (int dx = -searchRadius; dx <= searchRadius; ++dx) {
-            if (dx == 0 && dy == 0) continue; // Skip center pixel since it is the default
-            int nx = px + dx;
-            if (nx < 0 || nx >= m_width) continue;
-
-            float grad = m_gradientMap[idx + nx];
-            if (grad > maxGrad) {
-                maxGrad = grad;
-                bestX = nx;
-                bestY = ny;
+QPoint EdgeDetector::scanMax(const QRect &rect, int level, QPoint seed, int &value) const {
+    std::vector<uint8_t> window;
+    const QRect area = rect.united(QRect(seed.x(), seed.y(), 1, 1));
+    gradientWindow(area, level, window);
+    auto at = [&](int x, int y) { return window[static_cast<size_t>(y - area.top()) * area.width() + (x - area.left())]; };
+
+    // Equal maxima (saturated edges, coarse levels) resolve to the nearest
+    QPoint best = seed;
+    value = at(seed.x(), seed.y());
+    int bestDist = 0;
+    for (int y = rect.top(); y <= rect.bottom(); ++y) {
+        for (int x = rect.left(); x <= rect.right(); ++x) {
+            const int v = at(x, y);
+            if (v < value) continue;
+            const int dist = (x - seed.x()) * (x - seed.x()) + (y - seed.y()) * (y - seed.y());
+            if (v > value || dist < bestDist) {
+                value = v;
+                bestDist = dist;
+                best = QPoint(x, y);
             }
         }
     }
+    return best;
+}
+
+QPointF EdgeDetector::findEdgePoint(const QPointF &point, int searchRadius) const {
+    if (!m_source || m_width <= 0 || m_height <= 0) return point;
+
+    const int px = std::clamp(static_cast<int>(std::round(point.x())), 0, m_width - 1);
+    const int py = std::clamp(static_cast<int>(std::round(point.y())), 0, m_height - 1);
+    const QPoint center(px, py);
+
+    // Wide searches scan a coarse level, then refine inside the winning cell
+    int level = 0;
+    while (level + 1 < kLevels && (searchRadius >> level) > kMaxScanRadius) ++level;
+
+    int value = 0;
+    QPoint best;
+    if (level == 0) {
+        best = scanMax(QRect(px - searchRadius, py - searchRadius, 2 * searchRadius + 1, 2 * searchRadius + 1),
+                       0, center, value);
+    } else {
+        const int s = 1 << level;
+        const int r = (searchRadius + s - 1) >> level;
+        const QPoint coarseCenter(px >> level, py >> level);
+        const QPoint coarse = scanMax(QRect(coarseCenter.x() - r, coarseCenter.y() - r, 2 * r + 1, 2 * r + 1),
+                                      level, coarseCenter, value);
+        // The coarse cell plus half a cell around it: the Sobel footprint at
+        // the coarse level reaches that far
+        const QRect cell(coarse.x() * s - s / 2, coarse.y() * s - s / 2, 2 * s, 2 * s);
+        const QRect refine = cell.intersected(QRect(0, 0, m_width, m_height));
+        const QPoint seed = refine.contains(center) ? center : refine.center();
+        best = scanMax(refine, 0, seed, value);
+    }
 
     // Only snap if we found a significant edge gradient
-    if (maxGrad < 0.01f) {
+    if (value < kMinSnapGradient) {
         return point;
     }
 
-    return QPointF(bestX, bestY);
+    return QPointF(best.x(), best.y());
 }
 
-std::vector<QPointF> EdgeDetector::traceEdgePath(const QPointF &pA, const QPointF &pB) const {
+std::vector<QPointF> EdgeDetector::traceEdgePath(const QPointF &pA, const QPointF &pB,
+                                                 size_t budget) const {
     std::vector<QPointF> path;
-    if (m_gradientMap.empty() || m_width <= 2 || m_height <= 2) {
+    if (!m_source || m_width <= 2 || m_height <= 2) {
         path.push_back(pA);
         path.push_back(pB);
         return path;
     }
 
-    int ax = std::clamp(static_cast<int>(std::round(pA.x())), 0, m_width - 1);
-    int ay = std::clamp(static_cast<int>(std::round(pA.y())), 0, m_height - 1);
-    int bx = std::clamp(static_cast<int>(std::round(pB.x())), 0, m_width - 1);
-    int by = std::clamp(static_cast<int>(std::round(pB.y())), 0, m_height - 1);
-
-    // Bounding window with padding to allow the path to swing around, but stay fast
-    const int padding = 64;
-    int minX = std::max(0, std::min(ax, bx) - padding);
-    int maxX = std::min(m_width - 1, std::max(ax, bx) + padding);
-    int minY = std::max(0, std::min(ay, by) - padding);
-    int maxY = std::min(m_height - 1, std::max(ay, by) + padding);
-
-    int W = maxX - minX + 1;
-    int H = maxY - minY + 1;
-
-    if (W <= 0 || H <= 0) {
+    if (!m_liveWire) m_liveWire = std::make_unique<LiveWire>(*this);
+    if (!m_liveWire->isAnchoredAt(pA)) m_liveWire->setAnchor(pA);
+
+    // A click waits for its path, so it is bounded by the padded box around
+    // both points (twice its area, room for detours): on a flat canvas the
+    // tree would otherwise settle most of the image
+    const bool click = budget == 0;
+    if (click) {
+        constexpr double kPadding = 64.0;
+        const double w = std::abs(pB.x() - pA.x()) + 2.0 * kPadding;
+        const double h = std::abs(pB.y() - pA.y()) + 2.0 * kPadding;
+        budget = std::max(LiveWire::kFrameBudget, static_cast<size_t>(2.0 * w * h));
+    }
+    path = m_liveWire->pathTo(pB, budget);
+    if (path.empty() && click) {
+        // Out of budget (or canvas too large for the live-wire node ids):
+        // straight segment
         path.push_back(pA);
         path.push_back(pB);
         return path;
     }
 
-    std::vector<float> dists(W * H, 1e9f);
-    std::vector<int> parents(W * H, -1);
-    std::vector<bool> visited(W * H, false);
-
-    int startIdx = (ay - minY) * W + (ax - minX);
-    int targetIdx = (by - minY) * W + (bx - minX);
-
-    dists[startIdx] = 0.0f;
-
-    // Dijkstra's queue: {cost, local_index}
-    typedef std::pair<float, int> Element;
-    std::priority_queue<Element, std::vector<Element>, std::greater<Element>> pq;
-    pq.push({0.0f, startIdx});
-
-    while (!pq.empty()) {
-        auto top = pq.top();
-        pq.pop();
-        float d = top.first;
-        int u = top.second;
-
-        if (u == targetIdx) break;
-        if (visited[u]) continue;
-        visited[u] = true;
-
-        int ux = u % W + minX;
-        int uy = u / W + minY;
-
-        // Traverse 8 neighbors
-        for (int dy = -1; dy <= 1; ++dy) {
-            for (int dx = -1; dx <= 1; ++dx) {
-                if (dx == 0 && dy == 0) continue;
-                int nx = ux + dx;
-                int ny = uy + dy;
-                if (nx < minX || nx > maxX || ny < minY || ny > maxY) continue;
-
-                int v = (ny - minY) * W + (nx - minX);
-                if (visited[v]) continue;
-
-                float grad = m_gradientMap[ny * m_width + nx];
-                float moveDist = (dx != 0 && dy != 0) ? 1.4142f : 1.0f;
-                
-                // Strong edges (higher gradient) decrease the cost
-                float edgeFactor = 1.0f - grad * m_edgeSensitivity;
-                float cost = (edgeFactor * 1.5f + 0.08f) * moveDist;
-
-                if (dists[u] + cost < dists[v]) {
-                    dists[v] = dists[u] + cost;
-                    parents[v] = u;
-                    pq.push({dists[v], v});
-                }
-            }
-        }
-    }
-
-    // Reconstruct the path
-    int curr = targetIdx;
-    while (curr != -1) {
-        int cx = curr % W + minX;
-        int cy = curr / W + minY;
-        path.push_back(QPointF(cx, cy));
-        curr = parents[curr];
-    }
-    std::reverse(path.begin(), path.end());
-
     // Respect pathResolution
     if (m_pathResolution > 1 && path.size() > 2) {
         std::vector<QPointF> downsampled;
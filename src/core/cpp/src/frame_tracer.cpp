@@ -0,0 +1,148 @@
+/**
+ * ArtFlow Studio - Frame Tracer Implementation
+ */
+
+#include "../include/frame_tracer.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QThread>
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+
+namespace artflow {
+
+namespace {
+
+uint64_t steadyNs() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+std::string jsonEscape(const std::string &s) {
+  std::string out;
+  out.reserve(s.size());
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      out += ' ';
+    } else {
+      out += c;
+    }
+  }
+  return out;
+}
+
+} // namespace
+
+FrameTracer *FrameTracer::instance() {
+  static FrameTracer s_instance;
+  return &s_instance;
+}
+
+FrameTracer::FrameTracer() : m_epochNs(steadyNs()) {}
+
+void FrameTracer::setEnabled(bool enabled) {
+  m_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+uint64_t FrameTracer::nowUs() const { return (steadyNs() - m_epochNs) / 1000; }
+
+uint32_t FrameTracer::currentThreadId() {
+  static std::atomic<uint32_t> s_nextId{1};
+  thread_local uint32_t t_id = 0;
+  if (t_id != 0)
+    return t_id;
+
+  t_id = s_nextId.fetch_add(1, std::memory_order_relaxed);
+
+  QThread *thread = QThread::currentThread();
+  QString name = thread ? thread->objectName() : QString();
+  if (name.isEmpty()) {
+    if (QCoreApplication::instance() &&
+        thread == QCoreApplication::instance()->thread())
+      name = QStringLiteral("GUI");
+    else
+      name = QStringLiteral("Thread %1").arg(t_id);
+  }
+  // Caller holds m_mutex
+  m_threadNames[t_id] = name.toStdString();
+  return t_id;
+}
+
+void FrameTracer::addComplete(const char *name, const char *category,
+                              uint64_t startUs, uint64_t durationUs) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_events.size() >= kMaxEvents) {
+    ++m_dropped;
+    return;
+  }
+  m_events.push_back({name, category, startUs, durationUs, currentThreadId()});
+}
+
+size_t FrameTracer::eventCount() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_events.size();
+}
+
+void FrameTracer::clear() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_events.clear();
+  m_events.shrink_to_fit();
+  m_dropped = 0;
+  // Los nombres de hilo se conservan: los ids thread_local siguen vivos
+}
+
+bool FrameTracer::writeJson(const QString &path) const {
+  QFile file(path);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    return false;
+
+  const qint64 pid = QCoreApplication::applicationPid();
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::string out;
+  out.reserve(m_events.size() * 96 + 256);
+  out += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+  char line[512];
+  bool first = true;
+  auto append = [&](int len) {
+    if (len <= 0)
+      return;
+    if (!first)
+      out += ",\n";
+    out.append(line, std::min<size_t>(len, sizeof(line) - 1));
+    first = false;
+  };
+
+  for (const auto &[tid, name] : m_threadNames) {
+    append(std::snprintf(line, sizeof(line),
+                         "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%" PRId64
+                         ",\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                         static_cast<int64_t>(pid), tid,
+                         jsonEscape(name).c_str()));
+  }
+  for (const Event &e : m_events) {
+    append(std::snprintf(line, sizeof(line),
+                         "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\","
+                         "\"ts\":%" PRIu64 ",\"dur\":%" PRIu64
+                         ",\"pid\":%" PRId64 ",\"tid\":%u}",
+                         e.name, e.category, e.ts, e.dur,
+                         static_cast<int64_t>(pid), e.tid));
+  }
+  out += "\n],\"otherData\":{\"droppedEvents\":";
+  out += std::to_string(m_dropped);
+  out += "}}\n";
+
+  file.write(out.data(), static_cast<qint64>(out.size()));
+  file.close();
+  return true;
+}
+
+} // namespace artflow
@@ -1,4 +1,6 @@
 #include "../include/image_buffer.h"
+#include "../include/scanline_fill.h"
+#include "../include/selection_mask.h"
 #include <algorithm>
 #include <cmath>
 #include <cstring>
@@ -14,6 +16,17 @@ template <typename T> T clampVal(T val, T minVal, T maxVal) {
   return val;
 }
 
+// Coverage [0-255] of a clipping mask at canvas (x, y): the alpha of an
+// RGBA mask buffer (0 where unallocated) or a selection mask read in place
+static inline uint8_t maskCoverage(const ImageBuffer *mask, int x, int y) {
+  const uint8_t *p = mask->pixelAt(x, y);
+  return p ? p[3] : 0;
+}
+
+static inline uint8_t maskCoverage(const SelectionMask *mask, int x, int y) {
+  return mask->value(x, y);
+}
+
 ImageBuffer::ImageBuffer(int width, int height)
     : m_width(width), m_height(height) {
   m_gridW = tilesX();
@@ -185,15 +198,25 @@ bool ImageBuffer::getContentBounds(int &minX_out, int &minY_out, int &maxX_out,
 void ImageBuffer::floodFill(int x, int y, uint8_t r, uint8_t g, uint8_t b,
                             uint8_t a, float threshold,
                             const ImageBuffer *mask, bool alphaLock) {
+  floodFillMasked(x, y, r, g, b, a, threshold, mask, alphaLock);
+}
+
+void ImageBuffer::floodFill(int x, int y, uint8_t r, uint8_t g, uint8_t b,
+                            uint8_t a, float threshold,
+                            const SelectionMask *mask, bool alphaLock) {
+  floodFillMasked(x, y, r, g, b, a, threshold, mask, alphaLock);
+}
+
+template <typename Mask>
+void ImageBuffer::floodFillMasked(int x, int y, uint8_t r, uint8_t g,
+                                  uint8_t b, uint8_t a, float threshold,
+                                  const Mask *mask, bool alphaLock) {
   if (!isValidCoord(x, y))
     return;
 
   // If mask is provided, check if the start point is within the mask
-  if (mask) {
-    const uint8_t *mP = mask->pixelAt(x, y);
-    if (!mP || mP[3] == 0)
-      return; // Clicked outside the selection
-  }
+  if (mask && maskCoverage(mask, x, y) == 0)
+    return; // Clicked outside the selection
 
   uint8_t *startPixel = pixelAt(x, y);
   uint8_t startR = startPixel[0];
@@ -211,63 +234,44 @@ void ImageBuffer::floodFill(int x, int y, uint8_t r, uint8_t g, uint8_t b,
   uint32_t thresholdSq =
       static_cast<uint32_t>(threshold * 255 * threshold * 255 * 3);
 
-  std::vector<bool> visited(m_width * m_height, false);
-  std::vector<std::pair<int, int>> queue;
-  queue.reserve(m_width * m_height / 4);
-  queue.push_back({x, y});
-  visited[y * m_width + x] = true;
-
-  size_t head = 0;
-  while (head < queue.size()) {
-    std::pair<int, int> curr = queue[head++];
-    int cx = curr.first;
-    int cy = curr.second;
-
-    // Apply color (Premultiplied internally)
-    uint8_t targetA = a;
-    if (alphaLock) {
-      const uint8_t *currPixel = pixelAt(cx, cy);
-      targetA = currPixel ? currPixel[3] : 0;
-    }
-    uint8_t premulR = (r * targetA) / 255;
-    uint8_t premulG = (g * targetA) / 255;
-    uint8_t premulB = (b * targetA) / 255;
-    setPixel(cx, cy, premulR, premulG, premulB, targetA);
-
-    // Neighbors
-    int dx[] = {0, 0, 1, -1};
-    int dy[] = {1, -1, 0, 0};
-
-    for (int i = 0; i < 4; ++i) {
-      int nx = cx + dx[i];
-      int ny = cy + dy[i];
-
-      if (isValidCoord(nx, ny) && !visited[ny * m_width + nx]) {
-        // If mask is provided, verify against mask
-        if (mask) {
-          const uint8_t *mP = mask->pixelAt(nx, ny);
-          if (!mP || mP[3] == 0) {
-            visited[ny * m_width + nx] =
-                true; // Mark as visited to avoid re-checking
-            continue;
-          }
-        }
-
-        uint8_t *p = pixelAt(nx, ny);
-        uint32_t dr = static_cast<uint32_t>(p[0]) - startR;
-        uint32_t dg = static_cast<uint32_t>(p[1]) - startG;
-        uint32_t db = static_cast<uint32_t>(p[2]) - startB;
-        uint32_t da = static_cast<uint32_t>(p[3]) - startA;
-
-        uint32_t diffSq = dr * dr + dg * dg + db * db + da * da;
-
-        if (diffSq <= thresholdSq || threshold >= 0.99f) {
-          visited[ny * m_width + nx] = true;
-          queue.push_back({nx, ny});
-        }
+  // Tests read the untouched pixels: a painted pixel is never tested again
+  const ImageBuffer &self = *this;
+  auto accept = [&](int nx, int ny) {
+    // If mask is provided, verify against mask
+    if (mask && maskCoverage(mask, nx, ny) == 0)
+      return false;
+    if (threshold >= 0.99f)
+      return true;
+
+    static const uint8_t transparent[4] = {0, 0, 0, 0};
+    const uint8_t *p = self.pixelAt(nx, ny);
+    if (!p)
+      p = transparent;
+    uint32_t dr = static_cast<uint32_t>(p[0]) - startR;
+    uint32_t dg = static_cast<uint32_t>(p[1]) - startG;
+    uint32_t db = static_cast<uint32_t>(p[2]) - startB;
+    uint32_t da = static_cast<uint32_t>(p[3]) - startA;
+
+    uint32_t diffSq = dr * dr + dg * dg + db * db + da * da;
+    return diffSq <= thresholdSq;
+  };
+
+  auto paint = [&](int cy, int x0, int x1) {
+    for (int cx = x0; cx <= x1; ++cx) {
+      // Apply color (Premultiplied internally)
+      uint8_t targetA = a;
+      if (alphaLock) {
+        const uint8_t *currPixel = self.pixelAt(cx, cy);
+        targetA = currPixel ? currPixel[3] : 0;
       }
+      uint8_t premulR = (r * targetA) / 255;
+      uint8_t premulG = (g * targetA) / 255;
+      uint8_t premulB = (b * targetA) / 255;
+      setPixel(cx, cy, premulR, premulG, premulB, targetA);
     }
-  }
+  };
+
+  scanlineFill(m_width, m_height, x, y, accept, paint);
 }
 
 void ImageBuffer::blendPixel(int x, int y, uint8_t r, uint8_t g, uint8_t b,
@@ -453,6 +457,19 @@ void ImageBuffer::copyFrom(const ImageBuffer &other) {
 void ImageBuffer::composite(const ImageBuffer &other, int offsetX, int offsetY,
                             float opacity, BlendMode mode,
                             const ImageBuffer *mask) {
+  compositeMasked(other, offsetX, offsetY, opacity, mode, mask);
+}
+
+void ImageBuffer::composite(const ImageBuffer &other, int offsetX, int offsetY,
+                            float opacity, BlendMode mode,
+                            const SelectionMask *mask) {
+  compositeMasked(other, offsetX, offsetY, opacity, mode, mask);
+}
+
+template <typename Mask>
+void ImageBuffer::compositeMasked(const ImageBuffer &other, int offsetX,
+                                  int offsetY, float opacity, BlendMode mode,
+                                  const Mask *mask) {
   if (opacity <= 0.001f)
     return;
 
@@ -494,12 +511,7 @@ void ImageBuffer::composite(const ImageBuffer &other, int offsetX, int offsetY,
 
       // Apply Clipping Mask if present
       if (mask) {
-        const uint8_t *mP = mask->pixelAt(dx, dy);
-        if (mP) {
-          sA_f *= (mP[3] / 255.0f);
-        } else {
-          sA_f = 0;
-        }
+        sA_f *= (maskCoverage(mask, dx, dy) / 255.0f);
       }
 
       if (sA_f <= 0.001f)
@@ -980,4 +992,96 @@ void ImageBuffer::loadRawData(const uint8_t *rawData) {
   }
 }
 
+void ImageBuffer::writeRegion(int x, int y, int w, int h, const uint8_t *src,
+                              int srcStride, bool bottomUp) {
+  if (!src)
+    return;
+  const int x0 = std::max(0, x);
+  const int y0 = std::max(0, y);
+  const int x1 = std::min(m_width, x + w);
+  const int y1 = std::min(m_height, y + h);
+  if (x0 >= x1 || y0 >= y1)
+    return;
+
+  auto srcRow = [&](int gy) {
+    const int row = bottomUp ? (y + h - 1 - gy) : (gy - y);
+    return src + static_cast<size_t>(row) * srcStride;
+  };
+
+  for (int ty = y0 / TILE_SIZE; ty <= (y1 - 1) / TILE_SIZE; ++ty) {
+    for (int tx = x0 / TILE_SIZE; tx <= (x1 - 1) / TILE_SIZE; ++tx) {
+      const int tileX0 = tx * TILE_SIZE;
+      const int tileY0 = ty * TILE_SIZE;
+      const int cx0 = std::max(x0, tileX0);
+      const int cx1 = std::min(x1, tileX0 + TILE_SIZE);
+      const int cy0 = std::max(y0, tileY0);
+      const int cy1 = std::min(y1, tileY0 + TILE_SIZE);
+      const size_t rowBytes = static_cast<size_t>(cx1 - cx0) * 4;
+
+      auto &tile = m_tiles[static_cast<size_t>(ty * m_gridW + tx)];
+      if (!tile) {
+        // Un tile vacío que sigue vacío no merece reservar 256 KB
+        bool anyAlpha = false;
+        for (int gy = cy0; gy < cy1 && !anyAlpha; ++gy) {
+          const uint8_t *p = srcRow(gy) + static_cast<size_t>(cx0 - x) * 4;
+          for (int i = 0; i < cx1 - cx0; ++i) {
+            if (p[i * 4 + 3] != 0) {
+              anyAlpha = true;
+              break;
+            }
+          }
+        }
+        if (!anyAlpha)
+          continue;
+        tile = std::unique_ptr<Tile>(new Tile(tx, ty));
+      }
+
+      for (int gy = cy0; gy < cy1; ++gy) {
+        std::memcpy(&tile->data[pixelIndexLocal(cx0 - tileX0, gy - tileY0)],
+                    srcRow(gy) + static_cast<size_t>(cx0 - x) * 4, rowBytes);
+      }
+      tile->dirty = true;
+    }
+  }
+  m_cacheDirty = true;
+}
+
+void ImageBuffer::readRegion(int x, int y, int w, int h, uint8_t *dst,
+                             int dstStride) const {
+  if (!dst || w <= 0 || h <= 0)
+    return;
+  for (int row = 0; row < h; ++row)
+    std::memset(dst + static_cast<size_t>(row) * dstStride, 0,
+                static_cast<size_t>(w) * 4);
+
+  const int x0 = std::max(0, x);
+  const int y0 = std::max(0, y);
+  const int x1 = std::min(m_width, x + w);
+  const int y1 = std::min(m_height, y + h);
+  if (x0 >= x1 || y0 >= y1)
+    return;
+
+  for (int ty = y0 / TILE_SIZE; ty <= (y1 - 1) / TILE_SIZE; ++ty) {
+    for (int tx = x0 / TILE_SIZE; tx <= (x1 - 1) / TILE_SIZE; ++tx) {
+      const auto &tile = m_tiles[static_cast<size_t>(ty * m_gridW + tx)];
+      if (!tile)
+        continue;
+      const int tileX0 = tx * TILE_SIZE;
+      const int tileY0 = ty * TILE_SIZE;
+      const int cx0 = std::max(x0, tileX0);
+      const int cx1 = std::min(x1, tileX0 + TILE_SIZE);
+      const int cy0 = std::max(y0, tileY0);
+      const int cy1 = std::min(y1, tileY0 + TILE_SIZE);
+      const size_t rowBytes = static_cast<size_t>(cx1 - cx0) * 4;
+
+      for (int gy = cy0; gy < cy1; ++gy) {
+        std::memcpy(dst + static_cast<size_t>(gy - y) * dstStride +
+                        static_cast<size_t>(cx0 - x) * 4,
+                    &tile->data[pixelIndexLocal(cx0 - tileX0, gy - tileY0)],
+                    rowBytes);
+      }
+    }
+  }
+}
+
 } // namespace artflow
@@ -0,0 +1,172 @@
+/**
+ * ArtFlow Studio - Latency Profiler Implementation
+ */
+
+#include "../include/latency_profiler.h"
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace artflow {
+
+LatencyProfiler *LatencyProfiler::instance() {
+  static LatencyProfiler s_instance;
+  return &s_instance;
+}
+
+const char *LatencyProfiler::stageName(LatencyStage stage) {
+  switch (stage) {
+  case LatencyStage::Input:
+    return "input";
+  case LatencyStage::Stabilize:
+    return "stabilize";
+  case LatencyStage::DabGeneration:
+    return "dabGeneration";
+  case LatencyStage::GpuSubmit:
+    return "gpuSubmit";
+  case LatencyStage::Readback:
+    return "readback";
+  case LatencyStage::Composite:
+    return "composite";
+  case LatencyStage::Paint:
+    return "paint";
+  case LatencyStage::InputToPaint:
+    return "inputToPaint";
+  default:
+    return "unknown";
+  }
+}
+
+uint64_t LatencyProfiler::nowNs() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+void LatencyProfiler::record(LatencyStage stage, uint64_t elapsedNs) {
+  const int s = static_cast<int>(stage);
+  if (s < 0 || s >= kStageCount)
+    return;
+  Ring &ring = m_rings[s];
+  // +1 so that 0 means "empty slot" (sub-microsecond scopes still count)
+  const uint64_t us = elapsedNs / 1000 + 1;
+  const uint32_t value =
+      static_cast<uint32_t>(std::min<uint64_t>(us, UINT32_MAX));
+  const uint32_t slot = ring.head.fetch_add(1, std::memory_order_relaxed);
+  ring.samples[slot % kCapacity].store(value, std::memory_order_relaxed);
+}
+
+void LatencyProfiler::markInput() {
+  uint64_t expected = 0;
+  m_pendingInputNs.compare_exchange_strong(expected, nowNs(),
+                                           std::memory_order_relaxed);
+}
+
+void LatencyProfiler::markPresented() {
+  const uint64_t start =
+      m_pendingInputNs.exchange(0, std::memory_order_relaxed);
+  if (start != 0)
+    record(LatencyStage::InputToPaint, nowNs() - start);
+}
+
+namespace {
+
+std::vector<uint32_t> snapshot(const std::array<std::atomic<uint32_t>,
+                                                LatencyProfiler::kCapacity> &s) {
+  std::vector<uint32_t> out;
+  out.reserve(LatencyProfiler::kCapacity);
+  for (const auto &v : s) {
+    const uint32_t us = v.load(std::memory_order_relaxed);
+    if (us != 0)
+      out.push_back(us - 1);
+  }
+  return out;
+}
+
+double percentileMs(const std::vector<uint32_t> &sorted, double p) {
+  if (sorted.empty())
+    return 0.0;
+  // Nearest-rank
+  size_t rank = static_cast<size_t>(p * sorted.size() + 0.5);
+  rank = std::clamp<size_t>(rank, 1, sorted.size());
+  return sorted[rank - 1] / 1000.0;
+}
+
+} // namespace
+
+LatencyProfiler::Percentiles
+LatencyProfiler::percentiles(LatencyStage stage) const {
+  Percentiles result;
+  const int s = static_cast<int>(stage);
+  if (s < 0 || s >= kStageCount)
+    return result;
+
+  std::vector<uint32_t> samples = snapshot(m_rings[s].samples);
+  if (samples.empty())
+    return result;
+  std::sort(samples.begin(), samples.end());
+
+  result.count = static_cast<int>(samples.size());
+  result.p50 = percentileMs(samples, 0.50);
+  result.p95 = percentileMs(samples, 0.95);
+  result.p99 = percentileMs(samples, 0.99);
+  result.max = samples.back() / 1000.0;
+  return result;
+}
+
+QJsonObject LatencyProfiler::toJson() const {
+  QJsonObject stages;
+  for (int s = 0; s < kStageCount; ++s) {
+    const LatencyStage stage = static_cast<LatencyStage>(s);
+    const Percentiles p = percentiles(stage);
+
+    // Muestras en orden cronológico (la más antigua primero)
+    const uint32_t head = m_rings[s].head.load(std::memory_order_relaxed);
+    QJsonArray raw;
+    for (int i = 0; i < kCapacity; ++i) {
+      const uint32_t us =
+          m_rings[s].samples[(head + i) % kCapacity].load(
+              std::memory_order_relaxed);
+      if (us != 0)
+        raw.append(static_cast<double>(us - 1));
+    }
+
+    QJsonObject obj;
+    obj["p50_ms"] = p.p50;
+    obj["p95_ms"] = p.p95;
+    obj["p99_ms"] = p.p99;
+    obj["max_ms"] = p.max;
+    obj["count"] = p.count;
+    obj["samples_us"] = raw;
+    stages[QString::fromLatin1(stageName(stage))] = obj;
+  }
+
+  QJsonObject root;
+  root["window"] = kCapacity;
+  root["stages"] = stages;
+  return root;
+}
+
+bool LatencyProfiler::dumpToFile(const QString &path) const {
+  QFile file(path);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    return false;
+  file.write(QJsonDocument(toJson()).toJson(QJsonDocument::Indented));
+  file.close();
+  return true;
+}
+
+void LatencyProfiler::reset() {
+  for (Ring &ring : m_rings) {
+    for (auto &v : ring.samples)
+      v.store(0, std::memory_order_relaxed);
+    ring.head.store(0, std::memory_order_relaxed);
+  }
+  m_pendingInputNs.store(0, std::memory_order_relaxed);
+}
+
+} // namespace artflow
@@ -3,7 +3,11 @@
  */
 
 #include "../include/layer_manager.h"
+#include "../include/frame_tracer.h"
+#include <QImage>
+#include <QPainter>
 #include <algorithm>
+#include <cmath>
 
 namespace artflow {
 
@@ -181,6 +185,7 @@ void LayerManager::sampleColor(int x, int y, uint8_t *r, uint8_t *g, uint8_t *b,
 }
 
 void LayerManager::compositeAll(ImageBuffer &output, bool skipPrivate) const {
+  ScopedTrace trace("LayerManager::compositeAll", "cpu");
   output.clear();
 
   // Composite from bottom to top
@@ -192,10 +197,10 @@ void LayerManager::compositeAll(ImageBuffer &output, bool skipPrivate) const {
     if (skipPrivate && layer->isPrivate)
       continue;
 
-    if (layer->type == Layer::Type::Vector && layer->dirty && layer->vectorData) {
-      layer->buffer->clear();
-      layer->vectorData->rasterize(*layer->buffer);
-      layer->dirty = false;
+    // Vector layers only re-render the tiles their last edits touched
+    if (layer->type == Layer::Type::Vector && layer->vectorData &&
+        layer->vectorData->hasDirtyTiles()) {
+      layer->vectorData->rasterizeDirty(*layer->buffer);
     }
 
     if (layer->clipped && currentBaseBuffer) {
@@ -205,13 +210,80 @@ void LayerManager::compositeAll(ImageBuffer &output, bool skipPrivate) const {
     } else {
       // Normal Layer (or Clipping set but no base below)
       output.composite(*layer->buffer, layer->offsetX, layer->offsetY,
-                       layer->opacity, layer->blendMode, nullptr);
+                       layer->opacity, layer->blendMode);
       // This layer becomes the base for any subsequent clipped layers
       currentBaseBuffer = layer->buffer.get();
     }
   }
 }
 
+void LayerManager::compositeRegionScaled(ImageBuffer &output,
+                                         const QRect &region, float scale,
+                                         bool skipPrivate) const {
+  ScopedTrace trace("LayerManager::compositeRegionScaled", "cpu");
+  output.clear();
+  const int w = output.width();
+  const int h = output.height();
+  if (w <= 0 || h <= 0 || scale <= 0.0f)
+    return;
+
+  auto band = std::make_unique<ImageBuffer>(w, h);
+  std::unique_ptr<ImageBuffer> base; // clipping base of the current group
+  QImage resampled;
+
+  for (const auto &layer : m_layers) {
+    if (!layer->visible)
+      continue;
+    if (skipPrivate && layer->isPrivate)
+      continue;
+
+    band->clear();
+    if (layer->type == Layer::Type::Vector && layer->vectorData) {
+      // Re-render from the curves: crisp at any scale
+      const QPoint origin(region.x() - qRound(layer->offsetX * scale),
+                          region.y() - qRound(layer->offsetY * scale));
+      layer->vectorData->rasterizeWindow(*band, origin, scale);
+    } else {
+      // Canvas-space source rect of this band, plus a filter margin
+      const double sx = region.x() / scale - layer->offsetX;
+      const double sy = region.y() / scale - layer->offsetY;
+      const double sw = w / scale;
+      const double sh = h / scale;
+      const int x0 = static_cast<int>(std::floor(sx)) - 2;
+      const int y0 = static_cast<int>(std::floor(sy)) - 2;
+      const int x1 = static_cast<int>(std::ceil(sx + sw)) + 2;
+      const int y1 = static_cast<int>(std::ceil(sy + sh)) + 2;
+
+      QImage source(x1 - x0, y1 - y0, QImage::Format_RGBA8888_Premultiplied);
+      layer->buffer->readRegion(x0, y0, source.width(), source.height(),
+                                source.bits(), source.bytesPerLine());
+
+      if (resampled.isNull())
+        resampled = QImage(w, h, QImage::Format_RGBA8888_Premultiplied);
+      resampled.fill(Qt::transparent);
+      QPainter painter(&resampled);
+      painter.setCompositionMode(QPainter::CompositionMode_Source);
+      painter.setRenderHint(QPainter::SmoothPixmapTransform);
+      painter.drawImage(QRectF(0, 0, w, h), source,
+                        QRectF(sx - x0, sy - y0, sw, sh));
+      painter.end();
+      band->writeRegion(0, 0, w, h, resampled.constBits(),
+                        static_cast<int>(resampled.bytesPerLine()));
+    }
+
+    if (layer->clipped && base) {
+      output.composite(*band, 0, 0, layer->opacity, layer->blendMode,
+                       base.get());
+    } else {
+      output.composite(*band, 0, 0, layer->opacity, layer->blendMode);
+      // This band becomes the base for subsequent clipped layers
+      base.swap(band);
+      if (!band)
+        band = std::make_unique<ImageBuffer>(w, h);
+    }
+  }
+}
+
 std::unique_ptr<Layer> LayerManager::takeLayer(int index) {
   if (index < 0 || index >= static_cast<int>(m_layers.size()))
     return nullptr;
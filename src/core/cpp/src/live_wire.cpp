@@ -0,0 +1,182 @@
+#include "live_wire.h"
+#include "edge_detector.h"
+#include <QRect>
+#include <algorithm>
+#include <cmath>
+
+namespace artflow {
+
+static constexpr int kStepX[8] = {-1, 0, 1, -1, 1, -1, 0, 1};
+static constexpr int kStepY[8] = {-1, -1, -1, 0, 0, 1, 1, 1};
+static constexpr uint8_t kHasParent = 1 << 3;
+static constexpr uint8_t kSettled = 1 << 4;
+static constexpr uint32_t kUnreached = UINT32_MAX;
+// Integer cost units per pixel step at zero gradient sensitivity
+static constexpr float kCostScale = 48.0f;
+
+LiveWire::LiveWire(const EdgeDetector &detector)
+    : m_detector(detector), m_buckets(kBuckets) {}
+
+LiveWire::~LiveWire() = default;
+
+void LiveWire::reset() {
+    for (int slot : m_touched) m_pool.push_back(std::move(m_blocks[slot]));
+    m_touched.clear();
+    for (auto &bucket : m_buckets) bucket.clear();
+    m_queued = 0;
+    m_current = 0;
+    m_anchored = false;
+}
+
+void LiveWire::setAnchor(const QPointF &anchor) {
+    reset();
+    m_width = m_detector.width();
+    m_height = m_detector.height();
+    // Nodes pack x and y in 16 bits each
+    if (m_width <= 0 || m_height <= 0 || m_width > 0xFFFF || m_height > 0xFFFF) return;
+    m_blocksX = (m_width + kBlock - 1) >> kBlockShift;
+    const size_t grid = static_cast<size_t>(m_blocksX) * ((m_height + kBlock - 1) >> kBlockShift);
+    if (m_blocks.size() != grid) {
+        m_blocks.clear();
+        m_blocks.resize(grid);
+    }
+
+    // Same step cost as the old per-query Dijkstra, in integer units: strong
+    // edges (higher gradient) are cheap to walk along
+    const float sensitivity = m_detector.edgeSensitivity();
+    for (int g = 0; g < 256; ++g) {
+        const float edgeFactor = 1.0f - (g / 255.0f) * sensitivity;
+        const float step = (edgeFactor * 1.5f + 0.08f) * kCostScale;
+        m_cost[0][g] = static_cast<uint16_t>(std::clamp(std::lround(step), 1L, long(kBuckets - 1)));
+        m_cost[1][g] = static_cast<uint16_t>(std::clamp(std::lround(step * 1.4142f), 1L, long(kBuckets - 1)));
+    }
+
+    m_anchorX = std::clamp(static_cast<int>(std::round(anchor.x())), 0, m_width - 1);
+    m_anchorY = std::clamp(static_cast<int>(std::round(anchor.y())), 0, m_height - 1);
+    Block &b = block(m_anchorX, m_anchorY);
+    b.dist[(m_anchorY & (kBlock - 1)) * kBlock + (m_anchorX & (kBlock - 1))] = 0;
+    push(static_cast<uint32_t>(m_anchorY << 16 | m_anchorX), 0);
+    m_anchored = true;
+}
+
+bool LiveWire::isAnchoredAt(const QPointF &point) const {
+    return m_anchored && m_width == m_detector.width() && m_height == m_detector.height() &&
+           static_cast<int>(std::round(point.x())) == m_anchorX &&
+           static_cast<int>(std::round(point.y())) == m_anchorY;
+}
+
+LiveWire::Block &LiveWire::block(int x, int y) {
+    const int bx = x >> kBlockShift;
+    const int by = y >> kBlockShift;
+    const int slot = by * m_blocksX + bx;
+    std::unique_ptr<Block> &b = m_blocks[slot];
+    if (!b) {
+        if (!m_pool.empty()) {
+            b = std::move(m_pool.back());
+            m_pool.pop_back();
+        } else {
+            b = std::make_unique<Block>();
+        }
+        b->dist.assign(kBlock * kBlock, kUnreached);
+        b->state.assign(kBlock * kBlock, 0);
+        m_detector.gradientWindow(QRect(bx * kBlock, by * kBlock, kBlock, kBlock), 0, b->gradient);
+        b->inside = (bx + 1) * kBlock <= m_width && (by + 1) * kBlock <= m_height;
+        m_touched.push_back(slot);
+    }
+    return *b;
+}
+
+bool LiveWire::settled(int x, int y) const {
+    const auto &b = m_blocks[(y >> kBlockShift) * m_blocksX + (x >> kBlockShift)];
+    return b && (b->state[(y & (kBlock - 1)) * kBlock + (x & (kBlock - 1))] & kSettled);
+}
+
+void LiveWire::push(uint32_t node, uint32_t dist) {
+    m_buckets[dist % kBuckets].push_back(node);
+    ++m_queued;
+}
+
+bool LiveWire::expand(uint32_t target, size_t budget) {
+    const int tx = static_cast<int>(target & 0xFFFF);
+    const int ty = static_cast<int>(target >> 16);
+    size_t settledNow = 0;
+
+    while (m_queued > 0) {
+        if (settled(tx, ty)) return true;
+        if (budget && settledNow >= budget) return false;
+
+        // Every queued distance lies in [m_current, m_current + kBuckets)
+        std::vector<uint32_t> *bucket = &m_buckets[m_current % kBuckets];
+        while (bucket->empty()) {
+            ++m_current;
+            bucket = &m_buckets[m_current % kBuckets];
+        }
+        const uint32_t u = bucket->back();
+        bucket->pop_back();
+        --m_queued;
+
+        const int ux = static_cast<int>(u & 0xFFFF);
+        const int uy = static_cast<int>(u >> 16);
+        const int lx = ux & (kBlock - 1);
+        const int ly = uy & (kBlock - 1);
+        Block &ub = block(ux, uy);
+        const int ui = ly * kBlock + lx;
+        // Stale entry: settled already, or queued again at a shorter distance
+        if ((ub.state[ui] & kSettled) || ub.dist[ui] != m_current) continue;
+        ub.state[ui] |= kSettled;
+        ++settledNow;
+
+        auto relax = [&](Block &vb, int vi, int d, uint32_t node) {
+            if (vb.state[vi] & kSettled) return;
+            const bool diagonal = kStepX[d] != 0 && kStepY[d] != 0;
+            const uint32_t nd = m_current + m_cost[diagonal][vb.gradient[vi]];
+            if (nd < vb.dist[vi]) {
+                vb.dist[vi] = nd;
+                vb.state[vi] = static_cast<uint8_t>(kHasParent | d);
+                push(node, nd);
+            }
+        };
+
+        if (ub.inside && lx > 0 && lx < kBlock - 1 && ly > 0 && ly < kBlock - 1) {
+            // Interior of a block (most pixels): neighbours share its arrays.
+            // Partial blocks on the right / bottom edges hold zero-padded
+            // texels past the canvas, so they take the bounds-checked path.
+            for (int d = 0; d < 8; ++d) {
+                relax(ub, ui + kStepY[d] * kBlock + kStepX[d], d,
+                      static_cast<uint32_t>((uy + kStepY[d]) << 16 | (ux + kStepX[d])));
+            }
+            continue;
+        }
+        for (int d = 0; d < 8; ++d) {
+            const int vx = ux + kStepX[d];
+            const int vy = uy + kStepY[d];
+            if (vx < 0 || vx >= m_width || vy < 0 || vy >= m_height) continue;
+            relax(block(vx, vy), (vy & (kBlock - 1)) * kBlock + (vx & (kBlock - 1)), d,
+                  static_cast<uint32_t>(vy << 16 | vx));
+        }
+    }
+    return settled(tx, ty);
+}
+
+std::vector<QPointF> LiveWire::pathTo(const QPointF &target, size_t budget) {
+    std::vector<QPointF> path;
+    if (!m_anchored) return path;
+
+    const int tx = std::clamp(static_cast<int>(std::round(target.x())), 0, m_width - 1);
+    const int ty = std::clamp(static_cast<int>(std::round(target.y())), 0, m_height - 1);
+    if (!expand(static_cast<uint32_t>(ty << 16 | tx), budget)) return path;
+
+    // Walk the parent steps back to the anchor
+    int x = tx, y = ty;
+    for (;;) {
+        path.push_back(QPointF(x, y));
+        const uint8_t state = block(x, y).state[(y & (kBlock - 1)) * kBlock + (x & (kBlock - 1))];
+        if (!(state & kHasParent)) break;
+        x -= kStepX[state & 7];
+        y -= kStepY[state & 7];
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+} // namespace artflow
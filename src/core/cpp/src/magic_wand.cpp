@@ -0,0 +1,107 @@
+#include "magic_wand.h"
+#include "scanline_fill.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <QtConcurrent/QtConcurrentMap>
+
+namespace artflow {
+
+static_assert(ImageBuffer::TILE_SIZE % SelectionMask::kTileSize == 0,
+              "a source tile must cover whole mask tiles");
+
+// Largest RGBA distance (sqrt(4 * 255²))
+static constexpr float kMaxDistance = 510.0f;
+
+namespace {
+
+// Coverage by squared RGBA distance to the seed color
+struct Similarity {
+    int r, g, b, a;
+    float limitSq;   // full coverage up to here
+    float outerSq;   // anti-aliasing band ends here (== limitSq when off)
+    float limit, band;
+
+    Similarity(const uint8_t *seed, const MagicWand::Options &options) {
+        r = seed[0];
+        g = seed[1];
+        b = seed[2];
+        a = seed[3];
+        limit = kMaxDistance * std::clamp(options.tolerance, 0.0f, 1.0f);
+        // A few levels even at zero tolerance, a quarter of it above that
+        band = options.antiAlias ? 16.0f + 0.25f * limit : 0.0f;
+        limitSq = limit * limit;
+        outerSq = (limit + band) * (limit + band);
+    }
+
+    uint8_t coverage(const uint8_t *p) const {
+        const int dr = p[0] - r, dg = p[1] - g, db = p[2] - b, da = p[3] - a;
+        const float distSq = static_cast<float>(dr * dr + dg * dg + db * db + da * da);
+        if (distSq <= limitSq) return 255;
+        if (distSq >= outerSq) return 0;
+        return static_cast<uint8_t>(255.0f * (limit + band - std::sqrt(distSq)) / band + 0.5f);
+    }
+};
+
+} // namespace
+
+SelectionMask MagicWand::select(const ImageBuffer &source, int x, int y, const Options &options) {
+    const int W = source.width();
+    const int H = source.height();
+    SelectionMask mask(W, H);
+    if (x < 0 || y < 0 || x >= W || y >= H) return mask;
+
+    static const uint8_t transparent[4] = {0, 0, 0, 0};
+    auto pixel = [&](int px, int py) {
+        const uint8_t *p = source.pixelAt(px, py);
+        return p ? p : transparent;
+    };
+    const Similarity similar(pixel(x, y), options);
+    SelectionMask::Writer writer(mask);
+
+    if (options.contiguous) {
+        // The pixels the fill tests and rejects are exactly its rim: they
+        // take the anti-aliasing ramp
+        auto accept = [&](int px, int py) {
+            const uint8_t c = similar.coverage(pixel(px, py));
+            if (c == 255) return true;
+            if (c) writer.set(px, py, c);
+            return false;
+        };
+        auto span = [&](int py, int x0, int x1) { writer.fill(py, x0, x1 + 1, 255); };
+        scanlineFill(W, H, x, y, accept, span);
+        writer.finish();
+        return mask;
+    }
+
+    // Global: every pixel, one task per source tile (each owns its mask tiles)
+    const int T = ImageBuffer::TILE_SIZE;
+    const int tilesX = (W + T - 1) / T;
+    std::vector<int> tiles(static_cast<size_t>(tilesX) * ((H + T - 1) / T));
+    std::iota(tiles.begin(), tiles.end(), 0);
+    QtConcurrent::blockingMap(tiles, [&](int i) {
+        const int x0 = (i % tilesX) * T;
+        const int y0 = (i / tilesX) * T;
+        const int w = std::min(T, W - x0);
+        const int h = std::min(T, H - y0);
+        const ImageBuffer::Tile *tile = source.getTile(x0, y0);
+        if (!tile) {
+            // Unallocated: transparent throughout
+            const uint8_t c = similar.coverage(transparent);
+            if (c)
+                for (int py = y0; py < y0 + h; ++py) writer.fill(py, x0, x0 + w, c);
+            return;
+        }
+        for (int ly = 0; ly < h; ++ly) {
+            const uint8_t *p = tile->data.get() + static_cast<size_t>(ly) * T * 4;
+            for (int lx = 0; lx < w; ++lx, p += 4) {
+                const uint8_t c = similar.coverage(p);
+                if (c) writer.set(x0 + lx, y0 + ly, c);
+            }
+        }
+    });
+    writer.finish();
+    return mask;
+}
+
+} // namespace artflow
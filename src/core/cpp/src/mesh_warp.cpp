@@ -0,0 +1,144 @@
+#include "mesh_warp.h"
+#include <algorithm>
+#include <cmath>
+
+namespace artflow {
+
+namespace {
+
+// Catmull-Rom weights of the four control points around fraction t
+void catmullRomWeights(double t, double w[4]) {
+    const double t2 = t * t, t3 = t2 * t;
+    w[0] = -0.5 * t3 + t2 - 0.5 * t;
+    w[1] = 1.5 * t3 - 2.5 * t2 + 1.0;
+    w[2] = -1.5 * t3 + 2.0 * t2 + 0.5 * t;
+    w[3] = 0.5 * t3 - 0.5 * t2;
+}
+
+double length(const QPointF &a, const QPointF &b) { return std::hypot(b.x() - a.x(), b.y() - a.y()); }
+
+} // namespace
+
+MeshWarp::MeshWarp(int columns, int rows, const std::vector<QPointF> &points, int sourceWidth,
+                   int sourceHeight, Interpolation interpolation)
+    : m_columns(columns), m_rows(rows), m_sourceWidth(sourceWidth), m_sourceHeight(sourceHeight),
+      m_interpolation(interpolation), m_points(points) {
+    if (columns < 1 || rows < 1 || sourceWidth <= 0 || sourceHeight <= 0 ||
+        points.size() != static_cast<size_t>(columns + 1) * (rows + 1))
+        return;
+
+    // Lattice density from the longest canvas side per column / row of
+    // cells, measured on the surface itself (Catmull-Rom bulges past the
+    // control polygon)
+    auto subdivisions = [&](bool alongColumns) {
+        const int cells = alongColumns ? columns : rows;
+        const int lines = alongColumns ? rows : columns;
+        double longest = 0.0;
+        for (int line = 0; line <= lines; ++line) {
+            for (int cell = 0; cell < cells; ++cell) {
+                QPointF previous;
+                double run = 0.0;
+                for (int k = 0; k <= 4; ++k) {
+                    const double p = cell + k / 4.0;
+                    const QPointF point = alongColumns ? evaluate(p, line) : evaluate(line, p);
+                    if (k) run += length(previous, point);
+                    previous = point;
+                }
+                longest = std::max(longest, run);
+            }
+        }
+        return std::clamp(static_cast<int>(std::ceil(longest / kLatticeStep)), 1, kMaxSubdivision);
+    };
+    const int subX = subdivisions(true);
+    const int subY = subdivisions(false);
+    m_latticeColumns = columns * subX;
+    m_latticeRows = rows * subY;
+
+    m_vertices.resize(static_cast<size_t>(m_latticeColumns + 1) * (m_latticeRows + 1));
+    double minX = 0.0, minY = 0.0, maxX = 0.0, maxY = 0.0;
+    for (int j = 0; j <= m_latticeRows; ++j) {
+        for (int i = 0; i <= m_latticeColumns; ++i) {
+            const double s = static_cast<double>(i) / subX;
+            const double t = static_cast<double>(j) / subY;
+            const QPointF p = evaluate(s, t);
+            Vertex &vertex = m_vertices[static_cast<size_t>(j) * (m_latticeColumns + 1) + i];
+            vertex.x = static_cast<float>(p.x());
+            vertex.y = static_cast<float>(p.y());
+            vertex.u = static_cast<float>(s * sourceWidth / columns);
+            vertex.v = static_cast<float>(t * sourceHeight / rows);
+            if (i == 0 && j == 0) {
+                minX = maxX = p.x();
+                minY = maxY = p.y();
+            }
+            minX = std::min(minX, p.x());
+            minY = std::min(minY, p.y());
+            maxX = std::max(maxX, p.x());
+            maxY = std::max(maxY, p.y());
+        }
+    }
+    m_bounds = QRectF(minX, minY, maxX - minX, maxY - minY);
+}
+
+QPointF MeshWarp::control(int column, int row) const {
+    if (column < 0) return 2.0 * control(0, row) - control(1, row);
+    if (column > m_columns) return 2.0 * control(m_columns, row) - control(m_columns - 1, row);
+    if (row < 0) return 2.0 * control(column, 0) - control(column, 1);
+    if (row > m_rows) return 2.0 * control(column, m_rows) - control(column, m_rows - 1);
+    return m_points[static_cast<size_t>(row) * (m_columns + 1) + column];
+}
+
+QPointF MeshWarp::evaluate(double s, double t) const {
+    const int i = std::clamp(static_cast<int>(std::floor(s)), 0, m_columns - 1);
+    const int j = std::clamp(static_cast<int>(std::floor(t)), 0, m_rows - 1);
+    const double a = s - i, b = t - j;
+
+    if (m_interpolation == Interpolation::Bilinear) {
+        return (1.0 - a) * (1.0 - b) * control(i, j) + a * (1.0 - b) * control(i + 1, j) +
+               (1.0 - a) * b * control(i, j + 1) + a * b * control(i + 1, j + 1);
+    }
+    double wa[4], wb[4];
+    catmullRomWeights(a, wa);
+    catmullRomWeights(b, wb);
+    QPointF p(0.0, 0.0);
+    for (int n = 0; n < 4; ++n) {
+        QPointF row(0.0, 0.0);
+        for (int m = 0; m < 4; ++m) row += wa[m] * control(i - 1 + m, j - 1 + n);
+        p += wb[n] * row;
+    }
+    return p;
+}
+
+QPointF MeshWarp::map(double sx, double sy) const {
+    if (m_sourceWidth <= 0 || m_sourceHeight <= 0 || m_points.empty()) return QPointF(sx, sy);
+    return evaluate(sx * m_columns / m_sourceWidth, sy * m_rows / m_sourceHeight);
+}
+
+std::vector<float> MeshWarp::triangleVertices() const {
+    std::vector<float> out;
+    if (!isValid()) return out;
+    out.reserve(static_cast<size_t>(m_latticeColumns) * m_latticeRows * 6 * 4);
+    const int stride = m_latticeColumns + 1;
+    auto push = [&](const Vertex &vertex) {
+        out.push_back(vertex.x);
+        out.push_back(vertex.y);
+        out.push_back(vertex.u / m_sourceWidth);
+        out.push_back(vertex.v / m_sourceHeight);
+    };
+    for (int j = 0; j < m_latticeRows; ++j) {
+        for (int i = 0; i < m_latticeColumns; ++i) {
+            const Vertex &tl = m_vertices[static_cast<size_t>(j) * stride + i];
+            const Vertex &tr = (&tl)[1];
+            const Vertex &bl = (&tl)[stride];
+            const Vertex &br = (&tl)[stride + 1];
+            push(tl);
+            push(tr);
+            push(bl);
+            push(bl);
+            push(tr);
+            push(br);
+        }
+    }
+    return out;
+}
+
+} // namespace artflow
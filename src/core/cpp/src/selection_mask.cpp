@@ -0,0 +1,1046 @@
+#include "selection_mask.h"
+#include <QPainter>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <QtConcurrent/QtConcurrentMap>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ARTFLOW_SELECTION_SSE2 1
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && defined(__aarch64__)
+#include <arm_neon.h>
+#define ARTFLOW_SELECTION_NEON 1
+#endif
+
+namespace artflow {
+
+struct SelectionMask::Cache {
+    // Pixel-boundary edge on the lattice, directed so the selected side is
+    // on its right (y down)
+    struct Edge {
+        int x0, y0, x1, y1;
+    };
+    struct Entry {
+        // Tiles the contour edges were extracted from. A tile owns the
+        // edges on its top and left borders (and the canvas border), so
+        // they depend on the tiles above and to the left as well.
+        TilePtr self, top, left;
+        bool hasContour = false;
+        std::vector<Edge> edges;
+        std::vector<int> edgeRing; // ring of each edge, -1 = none
+        // Tile the clip rectangles were extracted from
+        TilePtr clipSelf;
+        bool hasClip = false;
+        std::vector<QRect> rects;
+    };
+    // Closed contour chained from edges of one or more tiles
+    struct Ring {
+        bool live = false;
+        std::vector<QPointF> corners;
+        std::vector<int> tiles; // tiles owning its edges
+        double area = 0.0;
+        // Corners simplified for `simplifiedFor` (< 0: not yet)
+        float simplifiedFor = -1.0f;
+        std::vector<QPointF> simplified;
+    };
+    int width = -1;
+    int height = -1;
+    std::vector<Entry> entries;
+    std::vector<Ring> rings;
+    std::vector<int> freeRings;
+    QPainterPath contour;
+    float contourFor = -1.0f; // tolerance `contour` was built for
+    QPainterPath clip;
+    bool clipBuilt = false;
+};
+
+SelectionMask::SelectionMask(int width, int height)
+    : m_width(std::max(0, width)), m_height(std::max(0, height)) {
+    m_tilesX = (m_width + kTileSize - 1) / kTileSize;
+    m_tilesY = (m_height + kTileSize - 1) / kTileSize;
+    m_tiles.resize(static_cast<size_t>(m_tilesX) * m_tilesY);
+}
+
+SelectionMask::SelectionMask(const SelectionMask &other)
+    : m_width(other.m_width), m_height(other.m_height), m_tilesX(other.m_tilesX),
+      m_tilesY(other.m_tilesY), m_tiles(other.m_tiles) {}
+
+SelectionMask &SelectionMask::operator=(const SelectionMask &other) {
+    if (this != &other) {
+        m_width = other.m_width;
+        m_height = other.m_height;
+        m_tilesX = other.m_tilesX;
+        m_tilesY = other.m_tilesY;
+        m_tiles = other.m_tiles;
+    }
+    return *this;
+}
+
+SelectionMask::~SelectionMask() = default;
+
+const SelectionMask::TilePtr &SelectionMask::fullTile() {
+    static const TilePtr full = [] {
+        auto tile = std::make_shared<Tile>();
+        std::memset(tile->data, 255, sizeof(tile->data));
+        return TilePtr(std::move(tile));
+    }();
+    return full;
+}
+
+QRect SelectionMask::tileRect(int index) const {
+    const int x = (index % m_tilesX) * kTileSize;
+    const int y = (index / m_tilesX) * kTileSize;
+    return QRect(x, y, std::min(kTileSize, m_width - x), std::min(kTileSize, m_height - y));
+}
+
+SelectionMask::TilePtr SelectionMask::normalized(std::unique_ptr<Tile> tile, int index) const {
+    const QRect r = tileRect(index);
+    bool allZero = true;
+    bool allFull = true;
+    for (int y = 0; y < r.height() && (allZero || allFull); ++y) {
+        const uint8_t *row = tile->data + y * kTileSize;
+        for (int x = 0; x < r.width(); ++x) {
+            allZero &= row[x] == 0;
+            allFull &= row[x] == 255;
+        }
+    }
+    if (allZero) return nullptr;
+    if (allFull) return fullTile();
+    return TilePtr(std::move(tile));
+}
+
+SelectionMask::Writer::Writer(SelectionMask &mask)
+    : m_mask(mask), m_tiles(mask.m_tiles.size()) {}
+
+SelectionMask::Writer::~Writer() = default;
+
+SelectionMask::Tile &SelectionMask::Writer::tile(int tx, int ty) {
+    const int index = ty * m_mask.m_tilesX + tx;
+    std::unique_ptr<Tile> &t = m_tiles[index];
+    if (!t) {
+        t = std::make_unique<Tile>();
+        if (m_mask.m_tiles[index])
+            std::memcpy(t->data, m_mask.m_tiles[index]->data, sizeof(t->data));
+        else
+            std::memset(t->data, 0, sizeof(t->data));
+    }
+    return *t;
+}
+
+void SelectionMask::Writer::fill(int y, int x0, int x1, uint8_t value) {
+    const int ly = y % kTileSize;
+    while (x0 < x1) {
+        const int tx = x0 / kTileSize;
+        const int end = std::min(x1, (tx + 1) * kTileSize);
+        std::memset(tile(tx, y / kTileSize).data + ly * kTileSize + x0 % kTileSize, value, end - x0);
+        x0 = end;
+    }
+}
+
+void SelectionMask::Writer::finish() {
+    for (size_t i = 0; i < m_tiles.size(); ++i) {
+        if (m_tiles[i])
+            m_mask.m_tiles[i] = m_mask.normalized(std::move(m_tiles[i]), static_cast<int>(i));
+    }
+}
+
+SelectionMask SelectionMask::fromPath(const QPainterPath &path, int width, int height) {
+    SelectionMask mask(width, height);
+    const QRect bounds =
+        path.boundingRect().toAlignedRect().intersected(QRect(0, 0, mask.m_width, mask.m_height));
+    if (bounds.isEmpty()) return mask;
+
+    const int tx0 = bounds.left() / kTileSize;
+    const int tx1 = bounds.right() / kTileSize;
+    std::vector<int> rows;
+    for (int ty = bounds.top() / kTileSize; ty <= bounds.bottom() / kTileSize; ++ty)
+        rows.push_back(ty);
+
+    // One QPainter pass per tile row: the path is walked once per band
+    // instead of once per tile
+    QtConcurrent::blockingMap(rows, [&](int ty) {
+        QImage band((tx1 - tx0 + 1) * kTileSize, kTileSize, QImage::Format_Alpha8);
+        band.fill(0);
+        QPainter p(&band);
+        p.setRenderHint(QPainter::Antialiasing);
+        p.translate(-tx0 * kTileSize, -ty * kTileSize);
+        p.fillPath(QPainterPath(path), Qt::black);
+        p.end();
+
+        for (int tx = tx0; tx <= tx1; ++tx) {
+            auto tile = std::make_unique<Tile>();
+            for (int y = 0; y < kTileSize; ++y) {
+                std::memcpy(tile->data + y * kTileSize,
+                            band.constScanLine(y) + (tx - tx0) * kTileSize, kTileSize);
+            }
+            const int index = ty * mask.m_tilesX + tx;
+            mask.m_tiles[index] = mask.normalized(std::move(tile), index);
+        }
+    });
+    return mask;
+}
+
+SelectionMask SelectionMask::fromImage(const QImage &image) {
+    QImage src = image;
+    if (src.format() != QImage::Format_Grayscale8 && src.format() != QImage::Format_Alpha8)
+        src = src.convertToFormat(QImage::Format_Alpha8);
+
+    SelectionMask mask(src.width(), src.height());
+    std::vector<int> indices(mask.m_tiles.size());
+    for (size_t i = 0; i < indices.size(); ++i) indices[i] = static_cast<int>(i);
+
+    QtConcurrent::blockingMap(indices, [&](int index) {
+        const QRect r = mask.tileRect(index);
+        auto tile = std::make_unique<Tile>();
+        std::memset(tile->data, 0, sizeof(tile->data));
+        for (int y = 0; y < r.height(); ++y) {
+            std::memcpy(tile->data + y * kTileSize, src.constScanLine(r.y() + y) + r.x(),
+                        r.width());
+        }
+        mask.m_tiles[index] = mask.normalized(std::move(tile), index);
+    });
+    return mask;
+}
+
+bool SelectionMask::isEmpty() const {
+    return std::all_of(m_tiles.begin(), m_tiles.end(), [](const TilePtr &t) { return !t; });
+}
+
+QRect SelectionMask::boundingRect() const {
+    QRect bounds;
+    for (int i = 0; i < static_cast<int>(m_tiles.size()); ++i) {
+        const Tile *tile = m_tiles[i].get();
+        if (!tile) continue;
+        const QRect r = tileRect(i);
+        if (tile == fullTile().get() || bounds.contains(r)) {
+            bounds |= r;
+            continue;
+        }
+        int minX = r.width(), minY = r.height(), maxX = -1, maxY = -1;
+        for (int y = 0; y < r.height(); ++y) {
+            const uint8_t *row = tile->data + y * kTileSize;
+            for (int x = 0; x < r.width(); ++x) {
+                if (!row[x]) continue;
+                minX = std::min(minX, x);
+                maxX = std::max(maxX, x);
+                minY = std::min(minY, y);
+                maxY = y;
+            }
+        }
+        if (maxX >= 0)
+            bounds |= QRect(r.x() + minX, r.y() + minY, maxX - minX + 1, maxY - minY + 1);
+    }
+    return bounds;
+}
+
+void SelectionMask::clear() {
+    std::fill(m_tiles.begin(), m_tiles.end(), nullptr);
+}
+
+void SelectionMask::selectAll() {
+    std::fill(m_tiles.begin(), m_tiles.end(), fullTile());
+}
+
+void SelectionMask::invert() {
+    std::vector<int> partial;
+    for (int i = 0; i < static_cast<int>(m_tiles.size()); ++i) {
+        if (!m_tiles[i])
+            m_tiles[i] = fullTile();
+        else if (m_tiles[i] == fullTile())
+            m_tiles[i] = nullptr;
+        else
+            partial.push_back(i);
+    }
+    QtConcurrent::blockingMap(partial, [this](int index) {
+        auto tile = std::make_unique<Tile>();
+        const uint8_t *src = m_tiles[index]->data;
+        for (int i = 0; i < kTilePixels; ++i) tile->data[i] = static_cast<uint8_t>(255 - src[i]);
+        m_tiles[index] = normalized(std::move(tile), index);
+    });
+}
+
+void SelectionMask::combine(const SelectionMask &other, Op op) {
+    if (op == Op::Replace) {
+        *this = other;
+        return;
+    }
+    if (other.m_width != m_width || other.m_height != m_height) return;
+
+    // Null / full tiles resolve by pointer; only tiles where both sides are
+    // partial need their pixels merged
+    const TilePtr &full = fullTile();
+    std::vector<int> partial;
+    for (int i = 0; i < static_cast<int>(m_tiles.size()); ++i) {
+        TilePtr &a = m_tiles[i];
+        const TilePtr &b = other.m_tiles[i];
+        switch (op) {
+        case Op::Add:
+            if (!b || a == full) continue;
+            if (!a || b == full) { a = b; continue; }
+            break;
+        case Op::Subtract:
+            if (!a || !b) continue;
+            if (b == full) { a = nullptr; continue; }
+            break;
+        case Op::Intersect:
+            if (!a || b == full) continue;
+            if (!b || a == full) { a = b; continue; }
+            break;
+        case Op::Replace:
+            break;
+        }
+        partial.push_back(i);
+    }
+
+    QtConcurrent::blockingMap(partial, [&](int index) {
+        const uint8_t *a = m_tiles[index]->data;
+        const uint8_t *b = other.m_tiles[index]->data;
+        auto tile = std::make_unique<Tile>();
+        uint8_t *out = tile->data;
+        if (op == Op::Add) {
+            for (int i = 0; i < kTilePixels; ++i) out[i] = std::max(a[i], b[i]);
+        } else if (op == Op::Subtract) {
+            for (int i = 0; i < kTilePixels; ++i)
+                out[i] = std::min(a[i], static_cast<uint8_t>(255 - b[i]));
+        } else {
+            for (int i = 0; i < kTilePixels; ++i) out[i] = std::min(a[i], b[i]);
+        }
+        m_tiles[index] = normalized(std::move(tile), index);
+    });
+}
+
+SelectionMask::Cache &SelectionMask::cache() const {
+    if (!m_cache) m_cache = std::make_unique<Cache>();
+    if (m_cache->width != m_width || m_cache->height != m_height) {
+        *m_cache = Cache();
+        m_cache->width = m_width;
+        m_cache->height = m_height;
+        m_cache->entries.resize(m_tiles.size());
+    }
+    return *m_cache;
+}
+
+const QPainterPath &SelectionMask::clipPath() const {
+    Cache &c = cache();
+    const TilePtr &full = fullTile();
+
+    std::vector<int> stale;
+    for (int i = 0; i < static_cast<int>(m_tiles.size()); ++i) {
+        const Cache::Entry &e = c.entries[i];
+        if (!e.hasClip || e.clipSelf != m_tiles[i]) stale.push_back(i);
+    }
+    if (stale.empty() && c.clipBuilt) return c.clip;
+
+    QtConcurrent::blockingMap(stale, [&](int index) {
+        Cache::Entry &e = c.entries[index];
+        e.clipSelf = m_tiles[index];
+        e.hasClip = true;
+        e.rects.clear();
+        // Full tiles are merged per tile row below
+        if (!e.clipSelf || e.clipSelf == full) return;
+
+        // Runs of selected pixels per row; a row with the same runs as the
+        // one above extends its rectangles down instead of adding new ones
+        const QRect r = tileRect(index);
+        std::vector<std::pair<int, int>> runs, openRuns;
+        size_t openFirst = 0;
+        for (int ly = 0; ly < r.height(); ++ly) {
+            runs.clear();
+            const uint8_t *row = e.clipSelf->data + ly * kTileSize;
+            for (int lx = 0; lx < r.width();) {
+                if (row[lx] < kInside) { ++lx; continue; }
+                const int start = lx;
+                while (lx < r.width() && row[lx] >= kInside) ++lx;
+                runs.emplace_back(start, lx);
+            }
+            if (runs == openRuns && !runs.empty()) {
+                for (size_t k = openFirst; k < e.rects.size(); ++k)
+                    e.rects[k].setBottom(e.rects[k].bottom() + 1);
+                continue;
+            }
+            openFirst = e.rects.size();
+            for (const auto &run : runs)
+                e.rects.emplace_back(r.x() + run.first, r.y() + ly, run.second - run.first, 1);
+            openRuns = runs;
+        }
+    });
+
+    c.clip = QPainterPath();
+    for (int ty = 0; ty < m_tilesY; ++ty) {
+        int fullStart = -1;
+        for (int tx = 0; tx <= m_tilesX; ++tx) {
+            const int index = ty * m_tilesX + tx;
+            const bool isFull = tx < m_tilesX && m_tiles[index] == full;
+            if (isFull && fullStart < 0) fullStart = tx;
+            if (!isFull && fullStart >= 0) {
+                const QRect first = tileRect(ty * m_tilesX + fullStart);
+                const QRect last = tileRect(index - 1);
+                c.clip.addRect(QRectF(first | last));
+                fullStart = -1;
+            }
+            if (tx < m_tilesX) {
+                for (const QRect &rect : c.entries[index].rects) c.clip.addRect(QRectF(rect));
+            }
+        }
+    }
+    c.clipBuilt = true;
+    return c.clip;
+}
+
+// ==================== Edge operations ====================
+
+// Ranges of `total` items in steps of `step`, one per parallel task
+static std::vector<int> chunkStarts(int total, int step) {
+    std::vector<int> starts;
+    for (int i = 0; i < total; i += step) starts.push_back(i);
+    return starts;
+}
+
+QRect SelectionMask::workRect(int margin) const {
+    const QRect bounds = boundingRect();
+    if (bounds.isEmpty()) return QRect();
+    return QRect(bounds.x() - margin, bounds.y() - margin, bounds.width() + 2 * margin,
+                 bounds.height() + 2 * margin)
+        .intersected(QRect(0, 0, m_width, m_height));
+}
+
+void SelectionMask::readRegion(const QRect &rect, uint8_t *dst) const {
+    std::vector<int> bands;
+    for (int ty = rect.top() / kTileSize; ty <= rect.bottom() / kTileSize; ++ty)
+        bands.push_back(ty);
+
+    QtConcurrent::blockingMap(bands, [&](int ty) {
+        const int y0 = std::max(rect.top(), ty * kTileSize);
+        const int y1 = std::min(rect.bottom(), ty * kTileSize + kTileSize - 1);
+        for (int tx = rect.left() / kTileSize; tx <= rect.right() / kTileSize; ++tx) {
+            const int x0 = std::max(rect.left(), tx * kTileSize);
+            const int x1 = std::min(rect.right(), tx * kTileSize + kTileSize - 1);
+            const Tile *tile = m_tiles[ty * m_tilesX + tx].get();
+            for (int y = y0; y <= y1; ++y) {
+                uint8_t *d = dst + static_cast<size_t>(y - rect.top()) * rect.width() +
+                             (x0 - rect.left());
+                if (tile)
+                    std::memcpy(d, tile->data + (y - ty * kTileSize) * kTileSize +
+                                       (x0 - tx * kTileSize),
+                                x1 - x0 + 1);
+                else
+                    std::memset(d, 0, x1 - x0 + 1);
+            }
+        }
+    });
+}
+
+void SelectionMask::writeRegion(const QRect &rect, const uint8_t *src) {
+    std::vector<int> indices;
+    for (int ty = rect.top() / kTileSize; ty <= rect.bottom() / kTileSize; ++ty)
+        for (int tx = rect.left() / kTileSize; tx <= rect.right() / kTileSize; ++tx)
+            indices.push_back(ty * m_tilesX + tx);
+
+    QtConcurrent::blockingMap(indices, [&](int index) {
+        const QRect tr = tileRect(index);
+        const QRect overlap = tr.intersected(rect);
+        auto tile = std::make_unique<Tile>();
+        if (m_tiles[index])
+            std::memcpy(tile->data, m_tiles[index]->data, sizeof(tile->data));
+        else
+            std::memset(tile->data, 0, sizeof(tile->data));
+        for (int y = overlap.top(); y <= overlap.bottom(); ++y) {
+            std::memcpy(tile->data + (y - tr.y()) * kTileSize + (overlap.x() - tr.x()),
+                        src + static_cast<size_t>(y - rect.top()) * rect.width() +
+                            (overlap.x() - rect.left()),
+                        overlap.width());
+        }
+        m_tiles[index] = normalized(std::move(tile), index);
+    });
+}
+
+// --- Box blur (edges clamped to the region) ---
+
+static void boxRow(const uint8_t *in, uint8_t *out, int n, int r) {
+    // Fixed-point 1 / (2r + 1): sum * mul stays below 255 << 16
+    const uint32_t mul = (1u << 16) / (2 * r + 1);
+    uint32_t sum = 0;
+    for (int k = -r; k <= r; ++k) sum += in[std::clamp(k, 0, n - 1)];
+    int x = 0;
+    auto emit = [&](int addIndex, int subIndex) {
+        out[x] = static_cast<uint8_t>((sum * mul + 0x8000) >> 16);
+        sum += in[addIndex] - in[subIndex];
+    };
+    // Clamped reads only near the ends; the middle has no bounds checks
+    const int leftEnd = std::min(r, n);
+    for (; x < leftEnd; ++x) emit(std::min(x + r + 1, n - 1), 0);
+    const int midEnd = std::max(x, n - r - 1);
+    for (; x < midEnd; ++x) emit(x + r + 1, x - r);
+    for (; x < n; ++x) emit(n - 1, std::max(x - r, 0));
+}
+
+// Columns [x0, x0 + n) of a `stride`-wide region, `h` rows. Runs down the
+// rows keeping one running sum per column, so the inner loop is contiguous.
+static void boxColumns(const uint8_t *in, uint8_t *out, int stride, int h, int x0, int n,
+                       int r, std::vector<int32_t> &sums) {
+    sums.assign(n, 0);
+    for (int k = -r; k <= r; ++k) {
+        const uint8_t *row = in + static_cast<size_t>(std::clamp(k, 0, h - 1)) * stride + x0;
+        for (int i = 0; i < n; ++i) sums[i] += row[i];
+    }
+    const float inv = 1.0f / (2 * r + 1);
+    int32_t *sum = sums.data();
+
+    for (int y = 0; y < h; ++y) {
+        uint8_t *dst = out + static_cast<size_t>(y) * stride + x0;
+        const uint8_t *add = in + static_cast<size_t>(std::min(y + r + 1, h - 1)) * stride + x0;
+        const uint8_t *sub = in + static_cast<size_t>(std::max(y - r, 0)) * stride + x0;
+        int i = 0;
+#if defined(ARTFLOW_SELECTION_SSE2)
+        const __m128 vinv = _mm_set1_ps(inv);
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + 16 <= n; i += 16) {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(add + i));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(sub + i));
+            const __m128i a16[2] = {_mm_unpacklo_epi8(a, zero), _mm_unpackhi_epi8(a, zero)};
+            const __m128i b16[2] = {_mm_unpacklo_epi8(b, zero), _mm_unpackhi_epi8(b, zero)};
+            __m128i v[4];
+            for (int q = 0; q < 4; ++q) {
+                __m128i *sp = reinterpret_cast<__m128i *>(sum + i + q * 4);
+                const __m128i s = _mm_loadu_si128(sp);
+                v[q] = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(s), vinv));
+                const __m128i a32 = (q & 1) ? _mm_unpackhi_epi16(a16[q >> 1], zero)
+                                            : _mm_unpacklo_epi16(a16[q >> 1], zero);
+                const __m128i b32 = (q & 1) ? _mm_unpackhi_epi16(b16[q >> 1], zero)
+                                            : _mm_unpacklo_epi16(b16[q >> 1], zero);
+                _mm_storeu_si128(sp, _mm_sub_epi32(_mm_add_epi32(s, a32), b32));
+            }
+            const __m128i packed =
+                _mm_packus_epi16(_mm_packs_epi32(v[0], v[1]), _mm_packs_epi32(v[2], v[3]));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), packed);
+        }
+#elif defined(ARTFLOW_SELECTION_NEON)
+        const float32x4_t vinv = vdupq_n_f32(inv);
+        for (; i + 16 <= n; i += 16) {
+            const uint8x16_t a = vld1q_u8(add + i);
+            const uint8x16_t b = vld1q_u8(sub + i);
+            const uint16x8_t a16[2] = {vmovl_u8(vget_low_u8(a)), vmovl_u8(vget_high_u8(a))};
+            const uint16x8_t b16[2] = {vmovl_u8(vget_low_u8(b)), vmovl_u8(vget_high_u8(b))};
+            uint16x4_t v[4];
+            for (int q = 0; q < 4; ++q) {
+                int32_t *sp = sum + i + q * 4;
+                const int32x4_t s = vld1q_s32(sp);
+                v[q] = vqmovun_s32(vcvtnq_s32_f32(vmulq_f32(vcvtq_f32_s32(s), vinv)));
+                const uint16x4_t a4 = (q & 1) ? vget_high_u16(a16[q >> 1]) : vget_low_u16(a16[q >> 1]);
+                const uint16x4_t b4 = (q & 1) ? vget_high_u16(b16[q >> 1]) : vget_low_u16(b16[q >> 1]);
+                vst1q_s32(sp, vsubq_s32(vaddq_s32(s, vreinterpretq_s32_u32(vmovl_u16(a4))),
+                                        vreinterpretq_s32_u32(vmovl_u16(b4))));
+            }
+            vst1q_u8(dst + i, vcombine_u8(vqmovn_u16(vcombine_u16(v[0], v[1])),
+                                          vqmovn_u16(vcombine_u16(v[2], v[3]))));
+        }
+#endif
+        for (; i < n; ++i) {
+            dst[i] = static_cast<uint8_t>(sum[i] * inv + 0.5f);
+            sum[i] += add[i] - sub[i];
+        }
+    }
+}
+
+// One box pass of radius `r` over a w x h region: rows into `tmp` in
+// parallel tile rows, then columns back into `buf` in parallel column strips
+static void boxBlur(uint8_t *buf, uint8_t *tmp, int w, int h, int r) {
+    std::vector<int> rows = chunkStarts(h, SelectionMask::kTileSize);
+    QtConcurrent::blockingMap(rows, [&](int y0) {
+        const int y1 = std::min(h, y0 + SelectionMask::kTileSize);
+        for (int y = y0; y < y1; ++y)
+            boxRow(buf + static_cast<size_t>(y) * w, tmp + static_cast<size_t>(y) * w, w, r);
+    });
+    // Strips of several tiles: narrower ones stream the rows poorly
+    const int strip = 4 * SelectionMask::kTileSize;
+    std::vector<int> columns = chunkStarts(w, strip);
+    QtConcurrent::blockingMap(columns, [&](int x0) {
+        std::vector<int32_t> sums;
+        boxColumns(tmp, buf, w, h, x0, std::min(strip, w - x0), r, sums);
+    });
+}
+
+// Radii of three box passes that approximate a Gaussian of `sigma`
+static std::array<int, 3> gaussianBoxRadii(float sigma) {
+    const float wIdeal = std::sqrt(12.0f * sigma * sigma / 3.0f + 1.0f);
+    int wl = static_cast<int>(std::floor(wIdeal));
+    if (wl % 2 == 0) --wl;
+    const int wu = wl + 2;
+    const float mIdeal =
+        (12.0f * sigma * sigma - 3.0f * wl * wl - 12.0f * wl - 9.0f) / (-4.0f * wl - 4.0f);
+    const int m = static_cast<int>(std::round(mIdeal));
+    std::array<int, 3> radii;
+    for (int i = 0; i < 3; ++i) radii[i] = ((i < m ? wl : wu) - 1) / 2;
+    return radii;
+}
+
+void SelectionMask::feather(float radius) {
+    const std::array<int, 3> radii = gaussianBoxRadii(radius * 0.5f);
+    const int reach = radii[0] + radii[1] + radii[2];
+    if (reach <= 0) return;
+    const QRect rect = workRect(reach);
+    if (rect.isEmpty()) return;
+
+    const size_t size = static_cast<size_t>(rect.width()) * rect.height();
+    std::vector<uint8_t> buf(size), tmp(size);
+    readRegion(rect, buf.data());
+    for (int r : radii) {
+        if (r > 0) boxBlur(buf.data(), tmp.data(), rect.width(), rect.height(), r);
+    }
+    writeRegion(rect, buf.data());
+}
+
+void SelectionMask::smooth(float radius) {
+    const int r = static_cast<int>(std::lround(radius));
+    if (r <= 0) return;
+    const QRect rect = workRect(r);
+    if (rect.isEmpty()) return;
+
+    const size_t size = static_cast<size_t>(rect.width()) * rect.height();
+    std::vector<uint8_t> buf(size), tmp(size);
+    readRegion(rect, buf.data());
+    boxBlur(buf.data(), tmp.data(), rect.width(), rect.height(), r);
+
+    // Majority vote over the window, re-sharpened to a ~1 px ramp: the
+    // box average changes by 255 / (2r + 1) per pixel across a straight edge
+    std::array<uint8_t, 256> ramp;
+    for (int v = 0; v < 256; ++v)
+        ramp[v] = static_cast<uint8_t>(std::clamp(128 + (v - 128) * (2 * r + 1) / 2, 0, 255));
+    std::vector<int> rows = chunkStarts(rect.height(), kTileSize);
+    QtConcurrent::blockingMap(rows, [&](int y0) {
+        const int y1 = std::min(rect.height(), y0 + kTileSize);
+        uint8_t *p = buf.data() + static_cast<size_t>(y0) * rect.width();
+        for (size_t i = 0, n = static_cast<size_t>(y1 - y0) * rect.width(); i < n; ++i)
+            p[i] = ramp[p[i]];
+    });
+    writeRegion(rect, buf.data());
+}
+
+void SelectionMask::grow(float radius) {
+    if (radius > 0.0f) distanceEdge(radius, true);
+}
+
+void SelectionMask::shrink(float radius) {
+    if (radius > 0.0f) distanceEdge(radius, false);
+}
+
+// Column pass of the distance transform: g = min(g, neighbour + 1) down
+// then up the rows (vertical distance to the nearest seed, capped)
+static void distanceColumns(uint16_t *g, int stride, int h, int x0, int n) {
+    auto pass = [&](int y, int from) {
+        uint16_t *cur = g + static_cast<size_t>(y) * stride + x0;
+        const uint16_t *prev = g + static_cast<size_t>(from) * stride + x0;
+        int i = 0;
+#if defined(ARTFLOW_SELECTION_SSE2)
+        // Values stay below 2^15, so the signed min is safe
+        const __m128i one = _mm_set1_epi16(1);
+        for (; i + 8 <= n; i += 8) {
+            __m128i *c = reinterpret_cast<__m128i *>(cur + i);
+            const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i *>(prev + i));
+            _mm_storeu_si128(c, _mm_min_epi16(_mm_loadu_si128(c), _mm_add_epi16(p, one)));
+        }
+#elif defined(ARTFLOW_SELECTION_NEON)
+        const uint16x8_t one = vdupq_n_u16(1);
+        for (; i + 8 <= n; i += 8)
+            vst1q_u16(cur + i, vminq_u16(vld1q_u16(cur + i), vaddq_u16(vld1q_u16(prev + i), one)));
+#endif
+        for (; i < n; ++i) cur[i] = std::min<uint16_t>(cur[i], prev[i] + 1);
+    };
+    for (int y = 1; y < h; ++y) pass(y, y - 1);
+    for (int y = h - 2; y >= 0; --y) pass(y, y + 1);
+}
+
+// Row pass (Felzenszwalb & Huttenlocher): squared Euclidean distance from
+// each x to the nearest site, as the lower envelope of the parabolas
+// (x - q)^2 + g[q]^2 over sites q with a finite column distance. Seeds
+// inside a run of seeds are skipped: only the seeds themselves are nearer
+// to them than to the run's ends, and callers do not read seed distances.
+static void distanceRow(const uint16_t *g, int n, uint16_t cap, std::vector<int> &v,
+                        std::vector<double> &z, double *d) {
+    int k = -1;
+    for (int q = 0; q < n; ++q) {
+        if (g[q] >= cap) continue;
+        if (g[q] == 0 && q > 0 && q < n - 1 && g[q - 1] == 0 && g[q + 1] == 0) continue;
+        const double fq = double(g[q]) * g[q] + double(q) * q;
+        if (k < 0) {
+            k = 0;
+            v[0] = q;
+            z[0] = -std::numeric_limits<double>::infinity();
+            z[1] = std::numeric_limits<double>::infinity();
+            continue;
+        }
+        double s;
+        for (;;) {
+            const int p = v[k];
+            s = (fq - (double(g[p]) * g[p] + double(p) * p)) / (2.0 * (q - p));
+            if (s > z[k]) break;
+            --k; // z[0] is -inf: stops at the first site
+        }
+        ++k;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = std::numeric_limits<double>::infinity();
+    }
+    if (k < 0) {
+        std::fill(d, d + n, std::numeric_limits<double>::infinity());
+        return;
+    }
+    for (int x = 0, j = 0; x < n; ++x) {
+        while (z[j + 1] < x) ++j;
+        const int p = v[j];
+        d[x] = double(x - p) * (x - p) + double(g[p]) * g[p];
+    }
+}
+
+void SelectionMask::distanceEdge(float radius, bool growing) {
+    // Distances are only needed up to radius + 1 (full coverage beyond)
+    const int reach = static_cast<int>(std::ceil(std::min(radius, 16000.0f))) + 1;
+    // Shrinking only removes selected pixels; the ring around the bounds
+    // supplies the unselected seeds outside them
+    const QRect rect = workRect(growing ? reach : 1);
+    if (rect.isEmpty()) return;
+    const int w = rect.width();
+    const int h = rect.height();
+    const uint16_t cap = static_cast<uint16_t>(reach + 1);
+
+    std::vector<uint8_t> buf(static_cast<size_t>(w) * h);
+    readRegion(rect, buf.data());
+    std::vector<uint16_t> g(buf.size());
+    for (size_t i = 0; i < buf.size(); ++i)
+        g[i] = ((buf[i] >= kInside) == growing) ? 0 : cap;
+
+    const int strip = 4 * kTileSize;
+    std::vector<int> columns = chunkStarts(w, strip);
+    QtConcurrent::blockingMap(columns, [&](int x0) {
+        distanceColumns(g.data(), w, h, x0, std::min(strip, w - x0));
+    });
+
+    const double limit = double(radius) + 1.0;
+    std::vector<int> rows = chunkStarts(h, kTileSize);
+    QtConcurrent::blockingMap(rows, [&](int y0) {
+        std::vector<int> v(w);
+        std::vector<double> z(w + 1), d(w);
+        const int y1 = std::min(h, y0 + kTileSize);
+        for (int y = y0; y < y1; ++y) {
+            const uint16_t *gRow = g.data() + static_cast<size_t>(y) * w;
+            distanceRow(gRow, w, cap, v, z, d.data());
+            uint8_t *row = buf.data() + static_cast<size_t>(y) * w;
+            for (int x = 0; x < w; ++x) {
+                if (gRow[x] == 0) {
+                    // Seed: selected pixels keep their antialiased coverage
+                    // when growing; unselected ones are cleared when shrinking
+                    if (!growing) row[x] = 0;
+                    continue;
+                }
+                if (growing) {
+                    // Unselected pixel at distance d from the nearest selected
+                    // centre: its centre lies d - 0.5 outside the old edge
+                    if (d[x] >= limit * limit) continue;
+                    const double cov = std::clamp(limit - std::sqrt(d[x]), 0.0, 1.0);
+                    row[x] = std::max(row[x], static_cast<uint8_t>(std::lround(cov * 255.0)));
+                } else {
+                    if (d[x] >= limit * limit) continue;
+                    const double cov = std::clamp(std::sqrt(d[x]) - double(radius), 0.0, 1.0);
+                    row[x] = std::min(row[x], static_cast<uint8_t>(std::lround(cov * 255.0)));
+                }
+            }
+        }
+    });
+    writeRegion(rect, buf.data());
+}
+
+// ==================== Contours ====================
+
+namespace {
+
+uint64_t vertexKey(int x, int y) {
+    return static_cast<uint64_t>(y) << 32 | static_cast<uint32_t>(x);
+}
+
+int sign(int v) { return (v > 0) - (v < 0); }
+
+} // namespace
+
+// Ramer-Douglas-Peucker on a closed ring, split at the first point and the
+// one farthest from it
+static void simplifyRing(std::vector<QPointF> &ring, float tolerance) {
+    const size_t n = ring.size();
+    if (n < 4 || tolerance <= 0.0f) return;
+    size_t far = 0;
+    double farthest = -1.0;
+    for (size_t i = 1; i < n; ++i) {
+        const double dx = ring[i].x() - ring[0].x(), dy = ring[i].y() - ring[0].y();
+        if (dx * dx + dy * dy > farthest) {
+            farthest = dx * dx + dy * dy;
+            far = i;
+        }
+    }
+
+    // Index n stands for ring[0] closing the ring
+    std::vector<uint8_t> keep(n + 1, 0);
+    keep[0] = keep[far] = keep[n] = 1;
+    std::vector<std::pair<size_t, size_t>> stack{{0, far}, {far, n}};
+    const double limit = static_cast<double>(tolerance) * tolerance;
+    while (!stack.empty()) {
+        const auto [a, b] = stack.back();
+        stack.pop_back();
+        if (b - a < 2) continue;
+        const QPointF &pa = ring[a];
+        const QPointF &pb = ring[b % n];
+        const double dx = pb.x() - pa.x(), dy = pb.y() - pa.y();
+        const double lenSq = dx * dx + dy * dy;
+        double maxDist = 0.0;
+        size_t maxIdx = a;
+        for (size_t i = a + 1; i < b; ++i) {
+            double ex = ring[i].x() - pa.x(), ey = ring[i].y() - pa.y();
+            if (lenSq > 1e-12) {
+                const double t = std::clamp((ex * dx + ey * dy) / lenSq, 0.0, 1.0);
+                ex -= t * dx;
+                ey -= t * dy;
+            }
+            const double d = ex * ex + ey * ey;
+            if (d > maxDist) {
+                maxDist = d;
+                maxIdx = i;
+            }
+        }
+        if (maxDist > limit) {
+            keep[maxIdx] = 1;
+            stack.emplace_back(a, maxIdx);
+            stack.emplace_back(maxIdx, b);
+        }
+    }
+
+    std::vector<QPointF> simplified;
+    for (size_t i = 0; i < n; ++i)
+        if (keep[i]) simplified.push_back(ring[i]);
+    if (simplified.size() >= 3) ring.swap(simplified);
+}
+
+void SelectionMask::extractContourEdges(int index) const {
+    Cache::Entry &e = m_cache->entries[index];
+    const int tx = index % m_tilesX;
+    const int ty = index / m_tilesX;
+    e.self = m_tiles[index];
+    e.top = ty > 0 ? m_tiles[index - m_tilesX] : nullptr;
+    e.left = tx > 0 ? m_tiles[index - 1] : nullptr;
+    e.hasContour = true;
+    e.edges.clear();
+
+    const QRect r = tileRect(index);
+    const bool atRight = r.right() == m_width - 1;
+    const bool atBottom = r.bottom() == m_height - 1;
+    // Same tile on all three sides (both empty or both full): no edges
+    // unless the canvas border runs along it
+    if (e.self == e.top && e.self == e.left && !((atRight || atBottom) && e.self)) {
+        e.edgeRing.clear();
+        return;
+    }
+
+    auto in = [](const TilePtr &tile, int lx, int ly) {
+        return tile && tile->data[ly * kTileSize + lx] >= kInside;
+    };
+
+    // Horizontal edges: boundary between row y - 1 and row y. Rightwards
+    // along the top of a region, leftwards along its bottom; a run is cut
+    // where the side flips.
+    const int rowsEnd = r.height() + (atBottom ? 1 : 0);
+    for (int ly = 0; ly < rowsEnd; ++ly) {
+        const int y = r.y() + ly;
+        int runStart = -1, runSide = 0;
+        for (int lx = 0; lx <= r.width(); ++lx) {
+            int side = 0; // 1: selected below, -1: above
+            if (lx < r.width()) {
+                const bool above = ly == 0 ? in(e.top, lx, kTileSize - 1) : in(e.self, lx, ly - 1);
+                const bool below = ly < r.height() && in(e.self, lx, ly);
+                side = below - above;
+            }
+            if (side == runSide) continue;
+            if (runSide > 0) e.edges.push_back({r.x() + runStart, y, r.x() + lx, y});
+            if (runSide < 0) e.edges.push_back({r.x() + lx, y, r.x() + runStart, y});
+            runStart = lx;
+            runSide = side;
+        }
+    }
+    // Vertical edges: boundary between column x - 1 and column x. Up along
+    // the left of a region, down along its right.
+    const int colsEnd = r.width() + (atRight ? 1 : 0);
+    for (int lx = 0; lx < colsEnd; ++lx) {
+        const int x = r.x() + lx;
+        int runStart = -1, runSide = 0;
+        for (int ly = 0; ly <= r.height(); ++ly) {
+            int side = 0; // 1: selected after, -1: before
+            if (ly < r.height()) {
+                const bool before = lx == 0 ? in(e.left, kTileSize - 1, ly) : in(e.self, lx - 1, ly);
+                const bool after = lx < r.width() && in(e.self, lx, ly);
+                side = after - before;
+            }
+            if (side == runSide) continue;
+            if (runSide > 0) e.edges.push_back({x, r.y() + ly, x, r.y() + runStart});
+            if (runSide < 0) e.edges.push_back({x, r.y() + runStart, x, r.y() + ly});
+            runStart = ly;
+            runSide = side;
+        }
+    }
+    e.edgeRing.assign(e.edges.size(), -1);
+}
+
+void SelectionMask::chainContours(const std::vector<std::pair<int, int>> &refs) const {
+    Cache &c = *m_cache;
+    // Edges sorted by start vertex, copied out of the tiles so the walk
+    // below stays in one array
+    std::vector<std::pair<uint64_t, uint32_t>> sorted(refs.size());
+    for (size_t i = 0; i < refs.size(); ++i) {
+        const Cache::Edge &edge = c.entries[refs[i].first].edges[refs[i].second];
+        sorted[i] = {vertexKey(edge.x0, edge.y0), static_cast<uint32_t>(i)};
+    }
+    std::sort(sorted.begin(), sorted.end());
+    std::vector<uint64_t> starts(sorted.size());
+    std::vector<Cache::Edge> edges(sorted.size());
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        starts[i] = sorted[i].first;
+        const auto &ref = refs[sorted[i].second];
+        edges[i] = c.entries[ref.first].edges[ref.second];
+    }
+
+    // Chain edges into rings, keeping only the corners. A vertex shared by
+    // two diagonal pixels has two exits: turning right keeps each pixel's
+    // contour separate (4-connected), the way the clip path sees them.
+    std::vector<uint8_t> used(edges.size(), 0);
+    std::vector<int> ringOf(edges.size(), -1);
+    std::vector<int> created;
+    for (size_t first = 0; first < edges.size(); ++first) {
+        if (used[first]) continue;
+        int id;
+        if (!c.freeRings.empty()) {
+            id = c.freeRings.back();
+            c.freeRings.pop_back();
+        } else {
+            id = static_cast<int>(c.rings.size());
+            c.rings.emplace_back();
+        }
+        created.push_back(id);
+        Cache::Ring &ring = c.rings[id];
+        ring = Cache::Ring();
+        ring.live = true;
+        ring.corners.reserve(4); // most rings on noisy masks are single pixels
+
+        size_t e = first;
+        int dx = sign(edges[e].x1 - edges[e].x0), dy = sign(edges[e].y1 - edges[e].y0);
+        for (;;) {
+            used[e] = 1;
+            ringOf[e] = id;
+            const Cache::Edge &edge = edges[e];
+            const uint64_t key = vertexKey(edge.x1, edge.y1);
+            const size_t lo = std::lower_bound(starts.begin(), starts.end(), key) - starts.begin();
+            size_t next = lo;
+            if (lo + 1 < starts.size() && starts[lo + 1] == key) {
+                const Cache::Edge &a = edges[lo];
+                const bool right = sign(a.x1 - a.x0) == -dy && sign(a.y1 - a.y0) == dx;
+                next = (right && !used[lo]) || used[lo + 1] ? lo : lo + 1;
+            }
+            if (next >= starts.size() || starts[next] != key) break; // open chain: never for a valid mask
+            const int ndx = sign(edges[next].x1 - edges[next].x0);
+            const int ndy = sign(edges[next].y1 - edges[next].y0);
+            if (ndx != dx || ndy != dy) ring.corners.push_back(QPointF(edge.x1, edge.y1));
+            if (used[next]) break; // back at the first edge
+            e = next;
+            dx = ndx;
+            dy = ndy;
+        }
+
+        double area = 0.0;
+        for (size_t i = 0, j = ring.corners.size() - 1; i < ring.corners.size(); j = i++)
+            area += ring.corners[j].x() * ring.corners[i].y() - ring.corners[i].x() * ring.corners[j].y();
+        ring.area = std::abs(area) * 0.5;
+    }
+
+    // Ring of every edge, and tiles of every ring, walking the edges in
+    // tile order
+    std::vector<uint32_t> position(sorted.size());
+    for (size_t i = 0; i < sorted.size(); ++i) position[sorted[i].second] = static_cast<uint32_t>(i);
+    for (size_t i = 0; i < refs.size(); ++i) {
+        const int id = ringOf[position[i]];
+        c.entries[refs[i].first].edgeRing[refs[i].second] = id;
+        std::vector<int> &tiles = c.rings[id].tiles;
+        if (tiles.empty() || tiles.back() != refs[i].first) tiles.push_back(refs[i].first);
+    }
+    for (int id : created) {
+        Cache::Ring &ring = c.rings[id];
+        if (ring.tiles.size() < 2 || std::is_sorted(ring.tiles.begin(), ring.tiles.end())) continue;
+        std::sort(ring.tiles.begin(), ring.tiles.end());
+        ring.tiles.erase(std::unique(ring.tiles.begin(), ring.tiles.end()), ring.tiles.end());
+    }
+}
+
+QPainterPath SelectionMask::contourPath(float tolerance) const {
+    QPainterPath path;
+    if (m_width <= 0 || m_height <= 0) return path;
+    Cache &c = cache();
+
+    std::vector<int> stale;
+    std::vector<uint8_t> isStale(m_tiles.size(), 0);
+    for (int i = 0; i < static_cast<int>(m_tiles.size()); ++i) {
+        const Cache::Entry &e = c.entries[i];
+        const int tx = i % m_tilesX;
+        const int ty = i / m_tilesX;
+        const TilePtr &top = ty > 0 ? m_tiles[i - m_tilesX] : nullptr;
+        const TilePtr &left = tx > 0 ? m_tiles[i - 1] : nullptr;
+        if (!e.hasContour || e.self != m_tiles[i] || e.top != top || e.left != left) {
+            stale.push_back(i);
+            isStale[i] = 1;
+        }
+    }
+
+    if (stale.empty() && c.contourFor == tolerance) return c.contour;
+    if (!stale.empty()) {
+        // Rings through a changed tile are re-chained; the others keep
+        // their corners. The first call traces everything.
+        std::vector<uint8_t> dropped(c.rings.size(), 0);
+        for (int i : stale)
+            for (int id : c.entries[i].edgeRing)
+                if (id >= 0) dropped[id] = 1;
+
+        QtConcurrent::blockingMap(stale, [this](int index) { extractContourEdges(index); });
+
+        std::vector<std::pair<int, int>> refs; // (tile, edge)
+        for (int i : stale)
+            for (size_t k = 0; k < c.entries[i].edges.size(); ++k) refs.emplace_back(i, static_cast<int>(k));
+        for (size_t id = 0; id < dropped.size(); ++id) {
+            if (!dropped[id]) continue;
+            for (int t : c.rings[id].tiles) {
+                if (isStale[t]) continue;
+                const Cache::Entry &e = c.entries[t];
+                for (size_t k = 0; k < e.edges.size(); ++k)
+                    if (e.edgeRing[k] == static_cast<int>(id)) refs.emplace_back(t, static_cast<int>(k));
+            }
+            c.rings[id] = Cache::Ring();
+            c.freeRings.push_back(static_cast<int>(id));
+        }
+        chainContours(refs);
+    }
+
+    const double speck = static_cast<double>(tolerance) * tolerance;
+    for (Cache::Ring &ring : c.rings) {
+        // Specks (and pinholes) no larger than the tolerance would only
+        // draw as dots: noisy masks have thousands of them
+        if (!ring.live || ring.corners.size() < 3 || ring.area <= speck) continue;
+        if (ring.simplifiedFor != tolerance) {
+            ring.simplified = ring.corners;
+            simplifyRing(ring.simplified, tolerance);
+            ring.simplifiedFor = tolerance;
+        }
+        path.moveTo(ring.simplified[0]);
+        for (size_t i = 1; i < ring.simplified.size(); ++i) path.lineTo(ring.simplified[i]);
+        path.closeSubpath();
+    }
+    c.contour = path;
+    c.contourFor = tolerance;
+    return path;
+}
+
+} // namespace artflow
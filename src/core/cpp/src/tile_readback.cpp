@@ -0,0 +1,251 @@
+/**
+ * ArtFlow Studio - Tile Readback Implementation
+ */
+
+#include "../include/tile_readback.h"
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <algorithm>
+
+namespace artflow {
+
+// ============================================================================
+// StrokeTileTracker
+// ============================================================================
+
+void StrokeTileTracker::reset(int width, int height) {
+  m_width = width;
+  m_height = height;
+  m_gridW = (width + ImageBuffer::TILE_SIZE - 1) / ImageBuffer::TILE_SIZE;
+  m_gridH = (height + ImageBuffer::TILE_SIZE - 1) / ImageBuffer::TILE_SIZE;
+  m_flags.assign(static_cast<size_t>(m_gridW * m_gridH), 0);
+  m_count = 0;
+  m_bounds = QRect();
+}
+
+void StrokeTileTracker::markRect(const QRect &rect) {
+  QRect r = rect.intersected(QRect(0, 0, m_width, m_height));
+  if (r.isEmpty())
+    return;
+
+  const int tx0 = r.left() / ImageBuffer::TILE_SIZE;
+  const int ty0 = r.top() / ImageBuffer::TILE_SIZE;
+  const int tx1 = r.right() / ImageBuffer::TILE_SIZE;
+  const int ty1 = r.bottom() / ImageBuffer::TILE_SIZE;
+
+  for (int ty = ty0; ty <= ty1; ++ty) {
+    for (int tx = tx0; tx <= tx1; ++tx) {
+      uint8_t &flag = m_flags[static_cast<size_t>(ty * m_gridW + tx)];
+      if (!flag) {
+        flag = 1;
+        ++m_count;
+      }
+    }
+  }
+
+  QRect snapped(tx0 * ImageBuffer::TILE_SIZE, ty0 * ImageBuffer::TILE_SIZE,
+                (tx1 - tx0 + 1) * ImageBuffer::TILE_SIZE,
+                (ty1 - ty0 + 1) * ImageBuffer::TILE_SIZE);
+  snapped = snapped.intersected(QRect(0, 0, m_width, m_height));
+  m_bounds = m_bounds.isEmpty() ? snapped : m_bounds.united(snapped);
+}
+
+void StrokeTileTracker::markAll() { markRect(QRect(0, 0, m_width, m_height)); }
+
+bool StrokeTileTracker::isTileDirty(int tx, int ty) const {
+  if (tx < 0 || ty < 0 || tx >= m_gridW || ty >= m_gridH)
+    return false;
+  return m_flags[static_cast<size_t>(ty * m_gridW + tx)] != 0;
+}
+
+std::vector<QRect> StrokeTileTracker::dirtyTileRects() const {
+  std::vector<QRect> rects;
+  rects.reserve(static_cast<size_t>(m_count));
+  for (int ty = 0; ty < m_gridH; ++ty) {
+    for (int tx = 0; tx < m_gridW; ++tx) {
+      if (!m_flags[static_cast<size_t>(ty * m_gridW + tx)])
+        continue;
+      const int x = tx * ImageBuffer::TILE_SIZE;
+      const int y = ty * ImageBuffer::TILE_SIZE;
+      rects.emplace_back(x, y, std::min(ImageBuffer::TILE_SIZE, m_width - x),
+                         std::min(ImageBuffer::TILE_SIZE, m_height - y));
+    }
+  }
+  return rects;
+}
+
+// ============================================================================
+// CpuTileReadback
+// ============================================================================
+
+CpuTileReadback::CpuTileReadback(const QImage &image)
+    : m_image(image.format() == QImage::Format_RGBA8888_Premultiplied
+                  ? image
+                  : image.convertToFormat(
+                        QImage::Format_RGBA8888_Premultiplied)) {}
+
+bool CpuTileReadback::request(int slot, const QRect &rect) {
+  (void)slot;
+  if (!m_image.rect().contains(rect))
+    return false;
+  m_rect = rect;
+  return true;
+}
+
+const uint8_t *CpuTileReadback::fetch(int slot, int &strideBytes,
+                                      bool &bottomUp) {
+  (void)slot;
+  if (m_rect.isEmpty())
+    return nullptr;
+  strideBytes = static_cast<int>(m_image.bytesPerLine());
+  bottomUp = false;
+  return m_image.constScanLine(m_rect.y()) + m_rect.x() * 4;
+}
+
+// ============================================================================
+// GlTileReadback
+// ============================================================================
+
+GlTileReadback::GlTileReadback() = default;
+
+GlTileReadback::~GlTileReadback() {
+  // Sin contexto no se puede tocar GL; el driver libera los PBOs junto con
+  // el contexto compartido.
+  if (m_initialized && QOpenGLContext::currentContext()) {
+    for (int i = 0; i < kSlots; ++i) {
+      if (m_mapped[i]) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbos[i]);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+      }
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glDeleteBuffers(kSlots, m_pbos);
+  }
+}
+
+bool GlTileReadback::isSupported(QOpenGLFramebufferObject *fbo) {
+  QOpenGLContext *ctx = QOpenGLContext::currentContext();
+  if (!ctx || !fbo || ctx->format().majorVersion() < 3)
+    return false;
+  if (!ctx->isOpenGLES())
+    return true;
+
+  // GLES 3 solo garantiza RGBA/FLOAT sobre buffers de coma flotante; la
+  // lectura a 8 bits depende del formato preferido por la implementación.
+  QOpenGLFunctions *f = ctx->functions();
+  GLint readFormat = 0;
+  GLint readType = 0;
+  fbo->bind();
+  f->glGetIntegerv(GL_IMPLEMENTATION_COLOR_READ_FORMAT, &readFormat);
+  f->glGetIntegerv(GL_IMPLEMENTATION_COLOR_READ_TYPE, &readType);
+  fbo->release();
+  return readFormat == GL_RGBA && readType == GL_UNSIGNED_BYTE;
+}
+
+void GlTileReadback::ensureBuffers() {
+  if (m_initialized)
+    return;
+  initializeOpenGLFunctions();
+  glGenBuffers(kSlots, m_pbos);
+  m_initialized = true;
+}
+
+bool GlTileReadback::request(int slot, const QRect &rect) {
+  if (!m_fbo || slot < 0 || slot >= kSlots || rect.isEmpty())
+    return false;
+  ensureBuffers();
+
+  const size_t bytes = static_cast<size_t>(rect.width()) * rect.height() * 4;
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbos[slot]);
+  if (m_pboSizes[slot] < bytes) {
+    glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(bytes), nullptr,
+                 GL_STREAM_READ);
+    m_pboSizes[slot] = bytes;
+  }
+
+  // El FBO tiene el origen abajo: la fila superior del tile en canvas es
+  // la última fila leída.
+  const int glY = m_fbo->height() - rect.y() - rect.height();
+  m_fbo->bind();
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glReadPixels(rect.x(), glY, rect.width(), rect.height(), GL_RGBA,
+               GL_UNSIGNED_BYTE, nullptr);
+  m_fbo->release();
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  m_rects[slot] = rect;
+  return true;
+}
+
+const uint8_t *GlTileReadback::fetch(int slot, int &strideBytes,
+                                     bool &bottomUp) {
+  if (!m_initialized || slot < 0 || slot >= kSlots || m_rects[slot].isEmpty())
+    return nullptr;
+
+  const QRect &rect = m_rects[slot];
+  const GLsizeiptr bytes =
+      static_cast<GLsizeiptr>(rect.width()) * rect.height() * 4;
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbos[slot]);
+  void *ptr = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+  if (!ptr) {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return nullptr;
+  }
+  m_mapped[slot] = true;
+  strideBytes = rect.width() * 4;
+  bottomUp = true;
+  return static_cast<const uint8_t *>(ptr);
+}
+
+void GlTileReadback::release(int slot) {
+  if (slot < 0 || slot >= kSlots || !m_mapped[slot])
+    return;
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbos[slot]);
+  glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  m_mapped[slot] = false;
+  m_rects[slot] = QRect();
+}
+
+// ============================================================================
+// Driver
+// ============================================================================
+
+QRect readbackDirtyTiles(const StrokeTileTracker &tracker,
+                         TileReadbackSource &source, ImageBuffer &buffer) {
+  const std::vector<QRect> rects = tracker.dirtyTileRects();
+  if (rects.empty())
+    return QRect();
+
+  const int slots = std::max(1, source.slotCount());
+  const int n = static_cast<int>(rects.size());
+  std::vector<bool> queued(static_cast<size_t>(n), false);
+
+  // Llenar la cola antes de mapear nada: mientras se copia el tile i, la GPU
+  // sigue transfiriendo los tiles i+1 .. i+slots-1.
+  for (int i = 0; i < std::min(n, slots); ++i)
+    queued[i] = source.request(i % slots, rects[i]);
+
+  QRect written;
+  for (int i = 0; i < n; ++i) {
+    const int slot = i % slots;
+    if (queued[i]) {
+      int stride = 0;
+      bool bottomUp = false;
+      const uint8_t *src = source.fetch(slot, stride, bottomUp);
+      if (src) {
+        const QRect &r = rects[i];
+        buffer.writeRegion(r.x(), r.y(), r.width(), r.height(), src, stride,
+                           bottomUp);
+        written = written.isEmpty() ? r : written.united(r);
+      }
+      source.release(slot);
+    }
+    const int next = i + slots;
+    if (next < n)
+      queued[next] = source.request(slot, rects[next]);
+  }
+  return written;
+}
+
+} // namespace artflow
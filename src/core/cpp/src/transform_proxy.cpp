@@ -0,0 +1,181 @@
+#include "transform_proxy.h"
+#include "image_buffer.h"
+#include "transform_warp.h"
+#include <QPolygonF>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <QtConcurrent/QtConcurrentMap>
+
+namespace artflow {
+
+namespace {
+
+// Next level: 2x2 box filter; an odd last row / column averages with
+// itself. One task per band of output rows.
+QImage halve(const QImage &src) {
+    constexpr int kBand = 64;
+    const int sw = src.width(), sh = src.height();
+    const int w = (sw + 1) / 2, h = (sh + 1) / 2;
+    QImage dst(w, h, QImage::Format_RGBA8888_Premultiplied);
+    uint8_t *bits = dst.bits(); // detach once, not from the tasks
+    const size_t stride = static_cast<size_t>(dst.bytesPerLine());
+    std::vector<int> bands;
+    for (int y = 0; y < h; y += kBand) bands.push_back(y);
+    QtConcurrent::blockingMap(bands, [&](int y0) {
+        for (int y = y0; y < std::min(h, y0 + kBand); ++y) {
+            const uint8_t *r0 = src.constScanLine(2 * y);
+            const uint8_t *r1 = src.constScanLine(std::min(2 * y + 1, sh - 1));
+            uint8_t *out = bits + y * stride;
+            for (int x = 0; x < w; ++x) {
+                const int a = 8 * x;
+                const int b = std::min(2 * x + 1, sw - 1) * 4;
+                for (int c = 0; c < 4; ++c)
+                    out[4 * x + c] = static_cast<uint8_t>(
+                        (r0[a + c] + r0[b + c] + r1[a + c] + r1[b + c] + 2) >> 2);
+            }
+        }
+    });
+    return dst;
+}
+
+double polygonArea(const QPolygonF &polygon) {
+    double twice = 0.0;
+    for (int i = 0, n = polygon.size(); i < n; ++i) {
+        const QPointF &a = polygon[i];
+        const QPointF &b = polygon[(i + 1) % n];
+        twice += a.x() * b.y() - b.x() * a.y();
+    }
+    return std::abs(twice) * 0.5;
+}
+
+} // namespace
+
+bool TransformProxy::Key::operator==(const Key &other) const {
+    return mesh == other.mesh && transform == other.transform && columns == other.columns &&
+           rows == other.rows && points == other.points && interpolation == other.interpolation &&
+           visible == other.visible && screenScale == other.screenScale &&
+           coarseness == other.coarseness;
+}
+
+TransformProxy::TransformProxy(const QImage &source) {
+    if (source.isNull()) return;
+    m_levels.push_back(source.convertToFormat(QImage::Format_RGBA8888_Premultiplied));
+    while (std::max(m_levels.back().width(), m_levels.back().height()) > kMinLevelSize)
+        m_levels.push_back(halve(m_levels.back()));
+}
+
+const TransformProxy::Frame &TransformProxy::render(const QTransform &transform,
+                                                    const QRectF &visible, double screenScale,
+                                                    int coarseness) {
+    Key key;
+    key.transform = transform;
+    key.visible = visible;
+    key.screenScale = screenScale;
+    key.coarseness = coarseness;
+    if (m_hasFrame && key == m_key) return m_frame;
+    if (isNull()) {
+        m_frame = Frame();
+        return m_frame;
+    }
+
+    const QImage &source = m_levels.front();
+    const QPolygonF quad = transform.map(QPolygonF(QRectF(0, 0, source.width(), source.height())));
+    return renderFrame(std::move(key), quad.boundingRect(), polygonArea(quad));
+}
+
+const TransformProxy::Frame &TransformProxy::renderMesh(const MeshWarp &mesh,
+                                                        const QRectF &visible, double screenScale,
+                                                        int coarseness) {
+    Key key;
+    key.mesh = true;
+    key.columns = mesh.columns();
+    key.rows = mesh.rows();
+    key.points = mesh.points();
+    key.interpolation = mesh.interpolation();
+    key.visible = visible;
+    key.screenScale = screenScale;
+    key.coarseness = coarseness;
+    if (m_hasFrame && key == m_key) return m_frame;
+    if (isNull() || !mesh.isValid()) {
+        m_frame = Frame();
+        return m_frame;
+    }
+
+    // Warped area from the lattice cells (folds count twice: finer level)
+    const std::vector<MeshWarp::Vertex> &v = mesh.vertices();
+    const int stride = mesh.latticeColumns() + 1;
+    double area = 0.0;
+    for (int j = 0; j < mesh.latticeRows(); ++j) {
+        for (int i = 0; i < mesh.latticeColumns(); ++i) {
+            const MeshWarp::Vertex &a = v[static_cast<size_t>(j) * stride + i];
+            const MeshWarp::Vertex &b = (&a)[1];
+            const MeshWarp::Vertex &c = (&a)[stride + 1];
+            const MeshWarp::Vertex &d = (&a)[stride];
+            // Shoelace over the diagonals
+            area += 0.5 * std::abs(double(c.x - a.x) * (d.y - b.y) - double(d.x - b.x) * (c.y - a.y));
+        }
+    }
+    return renderFrame(std::move(key), mesh.bounds(), area);
+}
+
+const TransformProxy::Frame &TransformProxy::renderFrame(Key key, const QRectF &bounds,
+                                                         double area) {
+    m_key = std::move(key);
+    m_hasFrame = true;
+    m_frame = Frame();
+
+    // Output px per canvas px: never finer than the screen nor the canvas
+    const double screen = std::min(1.0, m_key.screenScale);
+    const QRectF region = bounds.intersected(m_key.visible);
+    if (region.isEmpty() || screen <= 0.0 || area <= 0.0) return m_frame;
+
+    int coarseness = m_key.coarseness;
+    if (coarseness == kInteractive) {
+        const double pixels = region.width() * region.height() * screen * screen;
+        coarseness = 0;
+        while (coarseness < 8 && pixels / std::pow(4.0, coarseness) > kInteractivePixels)
+            ++coarseness;
+    }
+    m_frame.coarseness = coarseness;
+    const double scale = std::ldexp(screen, -coarseness);
+
+    // Level: source px per output px, rounded down to a power of two
+    const QImage &full = m_levels.front();
+    const double magnification = std::sqrt(area / (double(full.width()) * full.height())) * scale;
+    const int level = std::clamp(static_cast<int>(std::floor(std::log2(1.0 / magnification))), 0,
+                                 levelCount() - 1);
+    const QImage &source = m_levels[static_cast<size_t>(level)];
+
+    const QRect out(QPoint(static_cast<int>(std::floor(region.left() * scale)),
+                           static_cast<int>(std::floor(region.top() * scale))),
+                    QPoint(static_cast<int>(std::ceil(region.right() * scale)) - 1,
+                           static_cast<int>(std::ceil(region.bottom() * scale)) - 1));
+    if (out.isEmpty()) return m_frame;
+
+    ImageBuffer target(out.width(), out.height());
+    const TransformWarp warp(source);
+    if (m_key.mesh) {
+        std::vector<QPointF> points(m_key.points);
+        for (QPointF &p : points) p = p * scale - QPointF(out.topLeft());
+        const MeshWarp proxyMesh(m_key.columns, m_key.rows, points, source.width(),
+                                 source.height(), m_key.interpolation);
+        warp.drawMesh(target, proxyMesh, TransformWarp::Filter::Bilinear);
+    } else {
+        const QTransform toFrame =
+            QTransform::fromScale(double(full.width()) / source.width(),
+                                  double(full.height()) / source.height()) *
+            m_key.transform * QTransform::fromScale(scale, scale) *
+            QTransform::fromTranslate(-out.x(), -out.y());
+        warp.draw(target, toFrame, TransformWarp::Filter::Bilinear);
+    }
+
+    m_frame.image = QImage(out.width(), out.height(), QImage::Format_RGBA8888_Premultiplied);
+    target.readRegion(0, 0, out.width(), out.height(), m_frame.image.bits(),
+                      m_frame.image.bytesPerLine());
+    m_frame.canvasRect =
+        QRectF(out.x() / scale, out.y() / scale, out.width() / scale, out.height() / scale);
+    return m_frame;
+}
+
+} // namespace artflow
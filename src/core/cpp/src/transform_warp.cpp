@@ -0,0 +1,444 @@
+#include "transform_warp.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <QtConcurrent/QtConcurrentMap>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ARTFLOW_TRANSFORM_WARP_SSE2 1
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && defined(__aarch64__)
+#include <arm_neon.h>
+#define ARTFLOW_TRANSFORM_WARP_NEON 1
+#endif
+
+namespace artflow {
+
+struct TransformWarp::Patch {
+    // Canvas -> source, homogeneous (QTransform layout)
+    double m11, m12, m13, m21, m22, m23, m31, m32, m33;
+    // Sign of w over the patch; pixels with the other sign map from behind
+    // the horizon of a perspective
+    double sign;
+    // Source px: pixels whose center maps outside [left, right) x [top,
+    // bottom) are not part of the patch
+    double left, top, right, bottom;
+    // Canvas px that can map inside
+    QRect bounds;
+};
+
+namespace {
+
+// One RGBA pixel as four floats, premultiplied 0-255
+#if defined(ARTFLOW_TRANSFORM_WARP_SSE2)
+using Px = __m128;
+
+inline Px pxLoad(const uint8_t *p) {
+    int32_t word;
+    std::memcpy(&word, p, 4);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bytes = _mm_cvtsi32_si128(word);
+    return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, zero), zero));
+}
+inline Px pxZero() { return _mm_setzero_ps(); }
+inline Px pxMadd(Px acc, Px v, float w) { return _mm_add_ps(acc, _mm_mul_ps(v, _mm_set1_ps(w))); }
+inline float pxAlpha(Px v) { return _mm_cvtss_f32(_mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))); }
+// Alpha into [0, 255] and the colors into [0, alpha] (bicubic overshoot)
+inline Px pxClampPremultiplied(Px v) {
+    const __m128 zero = _mm_setzero_ps();
+    __m128 alpha = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+    alpha = _mm_min_ps(_mm_max_ps(alpha, zero), _mm_set1_ps(255.0f));
+    return _mm_min_ps(_mm_max_ps(v, zero), alpha);
+}
+// dst = v + dst * keep, rounded
+inline void pxStoreOver(uint8_t *dst, Px v, float keep) {
+    if (keep > 0.0f) v = _mm_add_ps(v, _mm_mul_ps(pxLoad(dst), _mm_set1_ps(keep)));
+    __m128i i = _mm_cvttps_epi32(_mm_add_ps(v, _mm_set1_ps(0.5f)));
+    i = _mm_packs_epi32(i, i);
+    const int32_t word = _mm_cvtsi128_si32(_mm_packus_epi16(i, i));
+    std::memcpy(dst, &word, 4);
+}
+#elif defined(ARTFLOW_TRANSFORM_WARP_NEON)
+using Px = float32x4_t;
+
+inline Px pxLoad(const uint8_t *p) {
+    uint32_t word;
+    std::memcpy(&word, p, 4);
+    const uint16x8_t wide = vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(word)));
+    return vcvtq_f32_u32(vmovl_u16(vget_low_u16(wide)));
+}
+inline Px pxZero() { return vdupq_n_f32(0.0f); }
+inline Px pxMadd(Px acc, Px v, float w) { return vmlaq_n_f32(acc, v, w); }
+inline float pxAlpha(Px v) { return vgetq_lane_f32(v, 3); }
+inline Px pxClampPremultiplied(Px v) {
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    float32x4_t alpha = vdupq_laneq_f32(v, 3);
+    alpha = vminq_f32(vmaxq_f32(alpha, zero), vdupq_n_f32(255.0f));
+    return vminq_f32(vmaxq_f32(v, zero), alpha);
+}
+inline void pxStoreOver(uint8_t *dst, Px v, float keep) {
+    if (keep > 0.0f) v = vmlaq_n_f32(v, pxLoad(dst), keep);
+    const uint16x4_t narrow = vqmovn_u32(vcvtq_u32_f32(vaddq_f32(v, vdupq_n_f32(0.5f))));
+    const uint8x8_t bytes = vqmovn_u16(vcombine_u16(narrow, narrow));
+    const uint32_t word = vget_lane_u32(vreinterpret_u32_u8(bytes), 0);
+    std::memcpy(dst, &word, 4);
+}
+#else
+struct Px {
+    float c[4];
+};
+
+inline Px pxLoad(const uint8_t *p) { return {{float(p[0]), float(p[1]), float(p[2]), float(p[3])}}; }
+inline Px pxZero() { return {{0.0f, 0.0f, 0.0f, 0.0f}}; }
+inline Px pxMadd(Px acc, const Px &v, float w) {
+    for (int i = 0; i < 4; ++i) acc.c[i] += v.c[i] * w;
+    return acc;
+}
+inline float pxAlpha(const Px &v) { return v.c[3]; }
+inline Px pxClampPremultiplied(Px v) {
+    const float alpha = std::clamp(v.c[3], 0.0f, 255.0f);
+    for (int i = 0; i < 4; ++i) v.c[i] = std::clamp(v.c[i], 0.0f, alpha);
+    return v;
+}
+inline void pxStoreOver(uint8_t *dst, Px v, float keep) {
+    for (int i = 0; i < 4; ++i) {
+        const float out = v.c[i] + dst[i] * keep + 0.5f;
+        dst[i] = static_cast<uint8_t>(std::min(out, 255.0f));
+    }
+}
+#endif
+
+// Catmull-Rom weights of the four taps around a sample at fraction t
+inline void catmullRom(float t, float w[4]) {
+    const float t2 = t * t, t3 = t2 * t;
+    w[0] = -0.5f * t3 + t2 - 0.5f * t;
+    w[1] = 1.5f * t3 - 2.5f * t2 + 1.0f;
+    w[2] = -1.5f * t3 + 2.0f * t2 + 0.5f * t;
+    w[3] = 0.5f * t3 - 0.5f * t2;
+}
+
+// Filtered reads of the source; texel (i, j) is centered at (i, j)
+class Sampler {
+public:
+    Sampler(const QImage &image, TransformWarp::Filter filter, bool clampEdges)
+        : m_bits(image.constBits()), m_stride(image.bytesPerLine()), m_width(image.width()),
+          m_height(image.height()), m_bicubic(filter == TransformWarp::Filter::Bicubic),
+          m_clamp(clampEdges) {}
+
+    Px sample(float u, float v) const {
+        // floor() without the libm call (u, v are never far below zero)
+        const int x0 = static_cast<int>(u + 4.0f) - 4, y0 = static_cast<int>(v + 4.0f) - 4;
+        const float tx = u - x0, ty = v - y0;
+        if (!m_bicubic) {
+            if (x0 >= 0 && y0 >= 0 && x0 + 1 < m_width && y0 + 1 < m_height) {
+                // Inside: both rows straight from the source
+                const uint8_t *top = m_bits + static_cast<size_t>(y0) * m_stride + static_cast<size_t>(x0) * 4;
+                const uint8_t *bottom = top + m_stride;
+                Px acc = pxMadd(pxZero(), pxLoad(top), (1.0f - tx) * (1.0f - ty));
+                acc = pxMadd(acc, pxLoad(top + 4), tx * (1.0f - ty));
+                acc = pxMadd(acc, pxLoad(bottom), (1.0f - tx) * ty);
+                return pxMadd(acc, pxLoad(bottom + 4), tx * ty);
+            }
+            Px acc = pxMadd(pxZero(), pxLoad(texel(x0, y0)), (1.0f - tx) * (1.0f - ty));
+            acc = pxMadd(acc, pxLoad(texel(x0 + 1, y0)), tx * (1.0f - ty));
+            acc = pxMadd(acc, pxLoad(texel(x0, y0 + 1)), (1.0f - tx) * ty);
+            return pxMadd(acc, pxLoad(texel(x0 + 1, y0 + 1)), tx * ty);
+        }
+        float wx[4], wy[4];
+        catmullRom(tx, wx);
+        catmullRom(ty, wy);
+        Px acc = pxZero();
+        if (x0 >= 1 && y0 >= 1 && x0 + 2 < m_width && y0 + 2 < m_height) {
+            const uint8_t *p = m_bits + static_cast<size_t>(y0 - 1) * m_stride + static_cast<size_t>(x0 - 1) * 4;
+            for (int j = 0; j < 4; ++j, p += m_stride) {
+                Px row = pxMadd(pxZero(), pxLoad(p), wx[0]);
+                row = pxMadd(row, pxLoad(p + 4), wx[1]);
+                row = pxMadd(row, pxLoad(p + 8), wx[2]);
+                acc = pxMadd(acc, pxMadd(row, pxLoad(p + 12), wx[3]), wy[j]);
+            }
+            return pxClampPremultiplied(acc);
+        }
+        for (int j = 0; j < 4; ++j) {
+            Px row = pxZero();
+            for (int i = 0; i < 4; ++i) row = pxMadd(row, pxLoad(texel(x0 - 1 + i, y0 - 1 + j)), wx[i]);
+            acc = pxMadd(acc, row, wy[j]);
+        }
+        return pxClampPremultiplied(acc);
+    }
+
+private:
+    // Outside the source: transparent, or the nearest edge texel
+    const uint8_t *texel(int x, int y) const {
+        static const uint8_t transparent[4] = {0, 0, 0, 0};
+        if (static_cast<unsigned>(x) >= static_cast<unsigned>(m_width) ||
+            static_cast<unsigned>(y) >= static_cast<unsigned>(m_height)) {
+            if (!m_clamp) return transparent;
+            x = std::clamp(x, 0, m_width - 1);
+            y = std::clamp(y, 0, m_height - 1);
+        }
+        return m_bits + static_cast<size_t>(y) * m_stride + static_cast<size_t>(x) * 4;
+    }
+
+    const uint8_t *m_bits;
+    qsizetype m_stride;
+    int m_width, m_height;
+    bool m_bicubic, m_clamp;
+};
+
+// Source-over into one destination tile, allocated on the first pixel that
+// is not fully transparent
+class TileWriter {
+public:
+    TileWriter(ImageBuffer &target, int tileX, int tileY)
+        : m_target(target), m_tileX(tileX), m_tileY(tileY),
+          m_tile(target.getTile(tileX, tileY, false)) {}
+    ~TileWriter() {
+        if (m_written) m_tile->dirty = true;
+    }
+
+    void over(int x, int y, Px src) {
+        const float alpha = pxAlpha(src);
+        if (alpha < 0.5f) return;
+        if (!m_tile) m_tile = m_target.getTile(m_tileX, m_tileY, true);
+        const int T = ImageBuffer::TILE_SIZE;
+        uint8_t *dst = m_tile->data.get() + (static_cast<size_t>(y - m_tileY) * T + (x - m_tileX)) * 4;
+        pxStoreOver(dst, src, alpha >= 254.5f ? 0.0f : 1.0f - alpha / 255.0f);
+        m_written = true;
+    }
+
+private:
+    ImageBuffer &m_target;
+    int m_tileX, m_tileY;
+    ImageBuffer::Tile *m_tile;
+    bool m_written = false;
+};
+
+// Pixels whose center lies in triangle (a, b, c), inside `area`, mapped to
+// the source affinely across the triangle (what the GPU does with the same
+// triangles). Vertices snap to 1/256 px and the edge tests are exact
+// integers, so a pixel on an edge shared by two triangles goes to exactly
+// one of them.
+void rasterTriangle(const MeshWarp::Vertex &a, const MeshWarp::Vertex &b, const MeshWarp::Vertex &c,
+                    const QRect &area, const Sampler &sampler, TileWriter &writer) {
+    constexpr int64_t kSub = 256;
+    constexpr double kLimit = 1 << 22; // px; keeps the edge products in range
+    auto snap = [&](float v) {
+        return static_cast<int64_t>(std::llround(std::clamp<double>(v, -kLimit, kLimit) * kSub));
+    };
+    int64_t x[3] = {snap(a.x), snap(b.x), snap(c.x)};
+    int64_t y[3] = {snap(a.y), snap(b.y), snap(c.y)};
+    const MeshWarp::Vertex *v[3] = {&a, &b, &c};
+    int64_t area2 = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+    if (area2 == 0) return;
+    if (area2 < 0) {
+        // Folded part of the mesh: same pixels, other winding
+        std::swap(x[1], x[2]);
+        std::swap(y[1], y[2]);
+        std::swap(v[1], v[2]);
+        area2 = -area2;
+    }
+
+    const int left = std::max(area.left(), static_cast<int>(std::min({x[0], x[1], x[2]}) / kSub) - 1);
+    const int right = std::min(area.right(), static_cast<int>(std::max({x[0], x[1], x[2]}) / kSub) + 1);
+    const int top = std::max(area.top(), static_cast<int>(std::min({y[0], y[1], y[2]}) / kSub) - 1);
+    const int bottom = std::min(area.bottom(), static_cast<int>(std::max({y[0], y[1], y[2]}) / kSub) + 1);
+    if (left > right || top > bottom) return;
+
+    // Edge k runs from vertex k to k + 1; inside when cross >= 0, on the
+    // edge itself only if the edge is owned (opposite directions disagree)
+    int64_t dx[3], dy[3], bias[3];
+    for (int k = 0; k < 3; ++k) {
+        const int n = (k + 1) % 3;
+        dx[k] = x[n] - x[k];
+        dy[k] = y[n] - y[k];
+        const bool owned = dy[k] > 0 || (dy[k] == 0 && dx[k] < 0);
+        bias[k] = owned ? 0 : -1;
+    }
+
+    // Source coordinates are affine in the canvas position
+    const double det = static_cast<double>(area2) / (kSub * kSub);
+    const double ex1 = double(x[1] - x[0]) / kSub, ey1 = double(y[1] - y[0]) / kSub;
+    const double ex2 = double(x[2] - x[0]) / kSub, ey2 = double(y[2] - y[0]) / kSub;
+    const double du1 = v[1]->u - v[0]->u, du2 = v[2]->u - v[0]->u;
+    const double dv1 = v[1]->v - v[0]->v, dv2 = v[2]->v - v[0]->v;
+    const double dudx = (du1 * ey2 - du2 * ey1) / det, dudy = (du2 * ex1 - du1 * ex2) / det;
+    const double dvdx = (dv1 * ey2 - dv2 * ey1) / det, dvdy = (dv2 * ex1 - dv1 * ex2) / det;
+    const double ox = double(x[0]) / kSub, oy = double(y[0]) / kSub;
+
+    for (int py = top; py <= bottom; ++py) {
+        const int64_t cy = py * kSub + kSub / 2;
+        const int64_t cx0 = left * kSub + kSub / 2;
+        int64_t e[3];
+        for (int k = 0; k < 3; ++k) e[k] = dx[k] * (cy - y[k]) - dy[k] * (cx0 - x[k]) + bias[k];
+        const double rowU = v[0]->u + dudy * (py + 0.5 - oy);
+        const double rowV = v[0]->v + dvdy * (py + 0.5 - oy);
+        for (int px = left; px <= right; ++px) {
+            if ((e[0] | e[1] | e[2]) >= 0) {
+                const double fx = px + 0.5 - ox;
+                writer.over(px, py, sampler.sample(static_cast<float>(rowU + dudx * fx - 0.5),
+                                                   static_cast<float>(rowV + dvdx * fx - 0.5)));
+            }
+            for (int k = 0; k < 3; ++k) e[k] -= dy[k] * kSub;
+        }
+    }
+}
+
+} // namespace
+
+TransformWarp::TransformWarp(const QImage &source)
+    : m_source(source.convertToFormat(QImage::Format_RGBA8888_Premultiplied)) {}
+
+void TransformWarp::draw(ImageBuffer &target, const QTransform &transform, Filter filter) const {
+    if (m_source.isNull()) return;
+    // Half a pixel of transparent margin: the edge pixels blend out over
+    // the filter instead of being cut at their centers
+    Patch patch;
+    const QRectF clip(-0.5, -0.5, m_source.width() + 1.0, m_source.height() + 1.0);
+    if (makePatch(transform, clip, target.width(), target.height(), patch))
+        drawPatch(target, patch, filter);
+}
+
+void TransformWarp::drawMesh(ImageBuffer &target, const MeshWarp &mesh, Filter filter) const {
+    if (m_source.isNull() || !mesh.isValid()) return;
+
+    // Inverse lookup grid: the lattice cells over each destination tile,
+    // in lattice order (later cells land on top where the mesh folds)
+    const int W = target.width(), H = target.height();
+    const int T = ImageBuffer::TILE_SIZE;
+    const int tilesX = target.tilesX();
+    std::vector<std::vector<int>> bins(static_cast<size_t>(tilesX) * target.tilesY());
+    const std::vector<MeshWarp::Vertex> &vertices = mesh.vertices();
+    const int columns = mesh.latticeColumns();
+    const int stride = columns + 1;
+    for (int j = 0; j < mesh.latticeRows(); ++j) {
+        for (int i = 0; i < columns; ++i) {
+            const MeshWarp::Vertex *tl = &vertices[static_cast<size_t>(j) * stride + i];
+            const float minX = std::min({tl[0].x, tl[1].x, tl[stride].x, tl[stride + 1].x});
+            const float maxX = std::max({tl[0].x, tl[1].x, tl[stride].x, tl[stride + 1].x});
+            const float minY = std::min({tl[0].y, tl[1].y, tl[stride].y, tl[stride + 1].y});
+            const float maxY = std::max({tl[0].y, tl[1].y, tl[stride].y, tl[stride + 1].y});
+            if (!(maxX >= 0.0f && maxY >= 0.0f && minX < W && minY < H)) continue; // also NaN
+            const int tx0 = static_cast<int>(std::max(minX, 0.0f)) / T;
+            const int ty0 = static_cast<int>(std::max(minY, 0.0f)) / T;
+            const int tx1 = static_cast<int>(std::min(maxX, W - 1.0f)) / T;
+            const int ty1 = static_cast<int>(std::min(maxY, H - 1.0f)) / T;
+            for (int ty = ty0; ty <= ty1; ++ty)
+                for (int tx = tx0; tx <= tx1; ++tx) bins[static_cast<size_t>(ty) * tilesX + tx].push_back(j * columns + i);
+        }
+    }
+    std::vector<int> tiles;
+    for (size_t b = 0; b < bins.size(); ++b)
+        if (!bins[b].empty()) tiles.push_back(static_cast<int>(b));
+
+    // The mesh border is cut at pixel centers, so the edge texels repeat
+    // instead of fading
+    const Sampler sampler(m_source, filter, true);
+    const QRect canvas(0, 0, W, H);
+    QtConcurrent::blockingMap(tiles, [&](int b) {
+        const int tileX = (b % tilesX) * T, tileY = (b / tilesX) * T;
+        const QRect tileRect = QRect(tileX, tileY, T, T).intersected(canvas);
+        TileWriter writer(target, tileX, tileY);
+        for (const int cell : bins[b]) {
+            const MeshWarp::Vertex *tl = &vertices[static_cast<size_t>(cell / columns) * stride + cell % columns];
+            rasterTriangle(tl[0], tl[1], tl[stride], tileRect, sampler, writer);
+            rasterTriangle(tl[stride], tl[1], tl[stride + 1], tileRect, sampler, writer);
+        }
+    });
+    target.invalidateCache();
+}
+
+bool TransformWarp::makePatch(const QTransform &transform, const QRectF &clip, int canvasWidth,
+                              int canvasHeight, Patch &patch) const {
+    if (!transform.isInvertible()) return false;
+
+    // Forward w; with one sign at every corner the patch maps to a bounded
+    // quad, otherwise it reaches the horizon and may cover the whole canvas
+    auto forwardW = [&](double x, double y) {
+        return transform.m13() * x + transform.m23() * y + transform.m33();
+    };
+    const double centerW = forwardW(clip.center().x(), clip.center().y());
+    if (std::abs(centerW) < 1e-12) return false;
+
+    patch.sign = centerW > 0.0 ? 1.0 : -1.0;
+    double minX = canvasWidth, minY = canvasHeight, maxX = 0.0, maxY = 0.0;
+    bool bounded = true;
+    for (const QPointF &corner : {clip.topLeft(), clip.topRight(), clip.bottomLeft(), clip.bottomRight()}) {
+        const double w = forwardW(corner.x(), corner.y());
+        if (w * patch.sign <= 1e-9) {
+            bounded = false;
+            break;
+        }
+        const double x = (transform.m11() * corner.x() + transform.m21() * corner.y() + transform.m31()) / w;
+        const double y = (transform.m12() * corner.x() + transform.m22() * corner.y() + transform.m32()) / w;
+        minX = std::min(minX, x);
+        minY = std::min(minY, y);
+        maxX = std::max(maxX, x);
+        maxY = std::max(maxY, y);
+    }
+    if (!bounded) {
+        minX = minY = 0.0;
+        maxX = canvasWidth;
+        maxY = canvasHeight;
+    }
+    const int x0 = static_cast<int>(std::floor(std::clamp(minX, 0.0, double(canvasWidth))));
+    const int y0 = static_cast<int>(std::floor(std::clamp(minY, 0.0, double(canvasHeight))));
+    const int x1 = static_cast<int>(std::ceil(std::clamp(maxX, 0.0, double(canvasWidth))));
+    const int y1 = static_cast<int>(std::ceil(std::clamp(maxY, 0.0, double(canvasHeight))));
+    if (x0 >= x1 || y0 >= y1) return false;
+    patch.bounds = QRect(x0, y0, x1 - x0, y1 - y0);
+
+    const QTransform inverse = transform.inverted();
+    patch.m11 = inverse.m11();
+    patch.m12 = inverse.m12();
+    patch.m13 = inverse.m13();
+    patch.m21 = inverse.m21();
+    patch.m22 = inverse.m22();
+    patch.m23 = inverse.m23();
+    patch.m31 = inverse.m31();
+    patch.m32 = inverse.m32();
+    patch.m33 = inverse.m33();
+    patch.left = clip.left();
+    patch.top = clip.top();
+    patch.right = clip.right();
+    patch.bottom = clip.bottom();
+    return true;
+}
+
+void TransformWarp::drawPatch(ImageBuffer &target, const Patch &patch, Filter filter) const {
+    // Destination tiles under the warped bounds, one task each (a task
+    // only allocates its own tile, and only once something lands on it)
+    const QRect &bounds = patch.bounds;
+    const int T = ImageBuffer::TILE_SIZE;
+    std::vector<QPoint> tiles;
+    for (int ty = bounds.top() / T; ty <= bounds.bottom() / T; ++ty)
+        for (int tx = bounds.left() / T; tx <= bounds.right() / T; ++tx) tiles.emplace_back(tx, ty);
+
+    const Sampler sampler(m_source, filter, false);
+    QtConcurrent::blockingMap(tiles, [&](const QPoint &t) {
+        const int tileX = t.x() * T, tileY = t.y() * T;
+        const QRect area = bounds.intersected(QRect(tileX, tileY, T, T));
+        TileWriter writer(target, tileX, tileY);
+        for (int y = area.top(); y <= area.bottom(); ++y) {
+            // Numerators and w are linear along the row
+            const double cy = y + 0.5;
+            const double rowU = patch.m21 * cy + patch.m31;
+            const double rowV = patch.m22 * cy + patch.m32;
+            const double rowW = patch.m23 * cy + patch.m33;
+            for (int x = area.left(); x <= area.right(); ++x) {
+                const double cx = x + 0.5;
+                const double w = patch.m13 * cx + rowW;
+                if (w * patch.sign <= 0.0) continue;
+                const double invW = 1.0 / w;
+                const double su = (patch.m11 * cx + rowU) * invW;
+                const double sv = (patch.m12 * cx + rowV) * invW;
+                if (su < patch.left || su >= patch.right || sv < patch.top || sv >= patch.bottom)
+                    continue;
+                writer.over(x, y, sampler.sample(static_cast<float>(su - 0.5), static_cast<float>(sv - 0.5)));
+            }
+        }
+    });
+    target.invalidateCache();
+}
+
+} // namespace artflow
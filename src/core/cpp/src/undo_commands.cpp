@@ -206,21 +206,19 @@ void LayerMergeUndoCommand::redo() {
 
 // ==================== SelectionUndoCommand ====================
 
-SelectionUndoCommand::SelectionUndoCommand(std::function<void(const QPainterPath&, bool)> callback,
-                                           const QPainterPath &beforePath, bool beforeHasSelection,
-                                           const QPainterPath &afterPath, bool afterHasSelection)
-    : m_callback(callback), m_beforePath(beforePath), m_beforeHasSelection(beforeHasSelection),
-      m_afterPath(afterPath), m_afterHasSelection(afterHasSelection) {}
+SelectionUndoCommand::SelectionUndoCommand(std::function<void(const SelectionMask&)> callback,
+                                           const SelectionMask &before, const SelectionMask &after)
+    : m_callback(callback), m_before(before), m_after(after) {}
 
 void SelectionUndoCommand::undo() {
   if (m_callback) {
-    m_callback(m_beforePath, m_beforeHasSelection);
+    m_callback(m_before);
   }
 }
 
 void SelectionUndoCommand::redo() {
   if (m_callback) {
-    m_callback(m_afterPath, m_afterHasSelection);
+    m_callback(m_after);
   }
 }
 
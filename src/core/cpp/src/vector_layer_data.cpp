@@ -1,5 +1,6 @@
 #include "vector_layer_data.h"
 #include "vector_math.h"
+#include "vector_stroke_raster.h"
 #include "brush_engine.h"
 #include <algorithm>
 #include <cmath>
@@ -12,6 +13,12 @@
 #include <QFileInfo>
 #include <QStringList>
 #include <QMap>
+#include <QSet>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstring>
+#include <mutex>
+#include <QtConcurrent/QtConcurrentMap>
 
 namespace artflow {
 
@@ -134,9 +141,10 @@ static QImage loadBrushTipImage(const QString &name) {
 
 // Cache of brush tips already tinted with a stroke color. Tinting per dab
 // (convertToFormat + fillRect) was the main CPU cost when re-rendering vector
-// layers on Android; per stroke it is constant, so cache it.
+// layers on Android; per stroke it is constant, so cache it. Per thread, so
+// tile workers of the parallel rasterizer never share it.
 static QImage tintedTipFor(const QImage &tipImg, const QString &tipName, const QColor &color) {
-    static QMap<QString, QImage> s_tintedCache;
+    thread_local QMap<QString, QImage> s_tintedCache;
     const QString key = tipName + QLatin1Char('|') + color.name(QColor::HexArgb);
     auto it = s_tintedCache.constFind(key);
     if (it != s_tintedCache.constEnd()) return it.value();
@@ -179,7 +187,7 @@ static void paintVectorTipRaster(QPainter *painter, const QPointF &point, float
 // Building a QRadialGradient with ~10 stops per dab does not scale to the
 // thousands of dabs a vector layer re-render produces.
 static QImage softStampFor(const QColor &color, float hardness) {
-    static QMap<QString, QImage> s_stampCache;
+    thread_local QMap<QString, QImage> s_stampCache;
     const int hardnessKey = static_cast<int>(std::clamp(hardness, 0.0f, 1.0f) * 20.0f + 0.5f);
     const QString key = color.name(QColor::HexArgb) + QLatin1Char('|') + QString::number(hardnessKey);
     auto it = s_stampCache.constFind(key);
@@ -280,74 +288,351 @@ static std::vector<VectorStroke> splitStrokeAtMultiple(const VectorStroke& strok
     return validFrags;
 }
 
+// Area a stroke can actually paint: cachedBounds only covers the nominal
+// width, the brush path adds tip softness, jitter and antialiasing on top.
+static QRectF strokePaintBounds(const VectorStroke& stroke) {
+    if (stroke.cachedBounds.isNull()) return QRectF();
+    const qreal pad = std::max(2.0f, stroke.globalWidth);
+    return stroke.cachedBounds.adjusted(-pad, -pad, pad, pad);
+}
+
+// Texture names repeat across thousands of strokes. QString is implicitly
+// shared, but names that arrive through different presets or copies are
+// separate buffers; interning makes every equal name share one.
+static QString internTextureName(const QString& name) {
+    if (name.isEmpty()) return QString();
+    static std::mutex s_mutex;
+    static QSet<QString> s_names;
+    std::lock_guard<std::mutex> lock(s_mutex);
+    auto it = s_names.constFind(name);
+    if (it == s_names.constEnd()) it = s_names.insert(name);
+    return *it;
+}
+
+// Writes straight into the painter's image when it is only translated (the
+// tile rasterizer); any other painter gets the stroke through a patch image.
+static void paintStrokeTessellated(QPainter& painter, const VectorStroke& stroke, float scale) {
+    const float tolerance = std::max(0.25f, 0.5f / std::max(scale, 0.01f));
+    std::vector<VPoint2D> pts = flattenStrokePolyline(stroke, tolerance);
+    if (pts.empty()) return;
+    std::vector<float> widths(pts.size());
+    for (size_t i = 0; i < pts.size(); ++i) {
+        widths[i] = std::max(0.75f, stroke.globalWidth * scale * pts[i].pressure);
+        pts[i].x *= scale;
+        pts[i].y *= scale;
+    }
+
+    thread_local StrokeMesh s_mesh;
+    thread_local CoverageRasterizer s_coverage;
+    tessellateStroke(pts, widths, s_mesh);
+    if (s_mesh.empty()) return;
+
+    float minX = s_mesh.xy[0], maxX = minX, minY = s_mesh.xy[1], maxY = minY;
+    for (size_t i = 0; i < s_mesh.xy.size(); i += 2) {
+        minX = std::min(minX, s_mesh.xy[i]);
+        maxX = std::max(maxX, s_mesh.xy[i]);
+        minY = std::min(minY, s_mesh.xy[i + 1]);
+        maxY = std::max(maxY, s_mesh.xy[i + 1]);
+    }
+    QRectF area(minX, minY, maxX - minX, maxY - minY);
+    if (painter.hasClipping()) area &= painter.clipBoundingRect();
+    if (area.isEmpty()) return;
+
+    const float opacity = stroke.opacity * static_cast<float>(painter.opacity());
+    const QTransform device = painter.deviceTransform();
+    QImage* target = dynamic_cast<QImage*>(painter.device());
+    if (target &&
+        (target->format() == QImage::Format_ARGB32_Premultiplied ||
+         target->format() == QImage::Format_RGBA8888_Premultiplied) &&
+        device.type() <= QTransform::TxTranslate) {
+        const QRect window = area.translated(device.dx(), device.dy()).toAlignedRect()
+                                 .intersected(target->rect());
+        if (window.isEmpty()) return;
+        s_coverage.reset(window.width(), window.height());
+        s_coverage.addMesh(s_mesh, static_cast<float>(device.dx() - window.x()),
+                           static_cast<float>(device.dy() - window.y()));
+        s_coverage.composite(*target, window.topLeft(), stroke.color, opacity, stroke.isEraser);
+        return;
+    }
+
+    const QRect window = area.toAlignedRect();
+    QImage patch(window.size(), QImage::Format_ARGB32_Premultiplied);
+    patch.fill(Qt::transparent);
+    s_coverage.reset(window.width(), window.height());
+    s_coverage.addMesh(s_mesh, static_cast<float>(-window.x()), static_cast<float>(-window.y()));
+    s_coverage.composite(patch, QPoint(0, 0), stroke.color, stroke.opacity, false);
+    painter.setCompositionMode(stroke.isEraser ? QPainter::CompositionMode_DestinationOut
+                                               : QPainter::CompositionMode_SourceOver);
+    painter.drawImage(window.topLeft(), patch);
+}
+
 VectorLayerData::VectorLayerData(int canvasW, int canvasH)
     : m_canvasW(canvasW), m_canvasH(canvasH) {}
 
+VectorLayerData::VectorLayerData(const VectorLayerData& other)
+    : m_canvasW(other.m_canvasW), m_canvasH(other.m_canvasH),
+      m_strokes(other.m_strokes), m_nextId(other.m_nextId),
+      m_indexStale(true), m_repackIds(other.m_repackIds), m_repackAll(other.m_repackAll),
+      m_dirtyTiles(other.m_dirtyTiles), m_dirtyTileCount(other.m_dirtyTileCount),
+      m_allTilesDirty(other.m_allTilesDirty) {}
+
+void VectorLayerData::rebuildIndex() const {
+    m_index.clear();
+    m_idToIndex.clear();
+    m_idToIndex.reserve(m_strokes.size());
+    for (size_t i = 0; i < m_strokes.size(); ++i) {
+        m_idToIndex[m_strokes[i].id] = i;
+        m_index.insert(m_strokes[i].id, strokePaintBounds(m_strokes[i]));
+    }
+    m_pendingIds.clear();
+    m_indexStale = false;
+}
+
+void VectorLayerData::syncIndex() const {
+    if (m_indexStale) {
+        rebuildIndex();
+        return;
+    }
+    for (uint32_t id : m_pendingIds) {
+        auto it = m_idToIndex.find(id);
+        if (it == m_idToIndex.end()) {
+            m_index.remove(id);
+        } else {
+            const QRectF bounds = strokePaintBounds(m_strokes[it->second]);
+            invalidateTiles(bounds);
+            m_index.update(id, bounds);
+        }
+    }
+    m_pendingIds.clear();
+}
+
 uint32_t VectorLayerData::addStroke(VectorStroke&& stroke) {
     stroke.id = m_nextId++;
     stroke.recalcBounds();
+    stroke.segments.pack();
+    stroke.tipTextureName = internTextureName(stroke.tipTextureName);
+    stroke.textureName = internTextureName(stroke.textureName);
     m_strokes.push_back(std::move(stroke));
-    return m_strokes.back().id;
+    const VectorStroke& added = m_strokes.back();
+    const QRectF bounds = strokePaintBounds(added);
+    invalidateTiles(bounds);
+    if (!m_indexStale) {
+        m_idToIndex[added.id] = m_strokes.size() - 1;
+        m_index.insert(added.id, bounds);
+    }
+    return added.id;
 }
 
 void VectorLayerData::removeStroke(uint32_t id) {
-    m_strokes.erase(
-        std::remove_if(m_strokes.begin(), m_strokes.end(), [id](const auto& s) { return s.id == id; }),
-        m_strokes.end()
-    );
+    syncIndex();
+    auto it = m_idToIndex.find(id);
+    if (it == m_idToIndex.end()) return;
+
+    const size_t pos = it->second;
+    invalidateTiles(strokePaintBounds(m_strokes[pos]));
+    m_strokes.erase(m_strokes.begin() + pos);
+    m_idToIndex.erase(it);
+    m_index.remove(id);
+    for (size_t i = pos; i < m_strokes.size(); ++i) {
+        m_idToIndex[m_strokes[i].id] = i;
+    }
 }
 
 VectorStroke* VectorLayerData::getStroke(uint32_t id) {
-    for (auto& stroke : m_strokes) {
-        if (stroke.id == id) return &stroke;
-    }
-    return nullptr;
+    syncIndex();
+    auto it = m_idToIndex.find(id);
+    if (it == m_idToIndex.end()) return nullptr;
+    // Old footprint now; the new one is marked when the edit is picked up
+    invalidateTiles(strokePaintBounds(m_strokes[it->second]));
+    m_pendingIds.push_back(id);
+    m_repackIds.push_back(id);
+    return &m_strokes[it->second];
+}
+
+const VectorStroke* VectorLayerData::getStroke(uint32_t id) const {
+    syncIndex();
+    auto it = m_idToIndex.find(id);
+    return it == m_idToIndex.end() ? nullptr : &m_strokes[it->second];
 }
 
 const std::vector<VectorStroke>& VectorLayerData::getStrokes() const {
     return m_strokes;
 }
 
-std::vector<VectorStroke>& VectorLayerData::getStrokes() {
+std::vector<VectorStroke>& VectorLayerData::editStrokes() {
+    m_indexStale = true;
+    m_repackAll = true;
+    markAllDirty();
     return m_strokes;
 }
 
+std::vector<size_t> VectorLayerData::queryRegion(const QRectF& region) const {
+    syncIndex();
+    std::vector<uint32_t> ids;
+    m_index.query(region, ids);
+
+    std::vector<size_t> result;
+    result.reserve(ids.size());
+    for (uint32_t id : ids) {
+        auto it = m_idToIndex.find(id);
+        if (it != m_idToIndex.end()) result.push_back(it->second);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+static bool strokeChanged(const VectorStroke& a, const VectorStroke& b) {
+    return !a.segments.sharesStorageWith(b.segments) || a.cachedBounds != b.cachedBounds ||
+           a.color != b.color || a.opacity != b.opacity || a.globalWidth != b.globalWidth ||
+           a.tipTextureName != b.tipTextureName || a.spacing != b.spacing ||
+           a.hardness != b.hardness || a.useTexture != b.useTexture ||
+           a.textureName != b.textureName || a.isEraser != b.isEraser || a.brush != b.brush;
+}
+
+VectorLayerData::Delta VectorLayerData::diff(const VectorLayerData& before,
+                                             const VectorLayerData& after) {
+    Delta delta;
+    std::unordered_map<uint32_t, size_t> beforePos;
+    beforePos.reserve(before.m_strokes.size());
+    for (size_t i = 0; i < before.m_strokes.size(); ++i) beforePos[before.m_strokes[i].id] = i;
+
+    std::unordered_map<uint32_t, size_t> afterPos;
+    afterPos.reserve(after.m_strokes.size());
+    bool reordered = false;
+    size_t lastCommon = 0;
+    bool anyCommon = false;
+    for (size_t j = 0; j < after.m_strokes.size(); ++j) {
+        const VectorStroke& stroke = after.m_strokes[j];
+        afterPos[stroke.id] = j;
+        auto it = beforePos.find(stroke.id);
+        if (it == beforePos.end()) {
+            delta.added.push_back({j, stroke});
+            continue;
+        }
+        if (anyCommon && it->second < lastCommon) reordered = true;
+        lastCommon = it->second;
+        anyCommon = true;
+        if (strokeChanged(before.m_strokes[it->second], stroke))
+            delta.changed.emplace_back(before.m_strokes[it->second], stroke);
+    }
+    for (size_t i = 0; i < before.m_strokes.size(); ++i) {
+        if (!afterPos.count(before.m_strokes[i].id)) delta.removed.push_back({i, before.m_strokes[i]});
+    }
+
+    if (reordered) {
+        // applyDelta keeps surviving strokes in their relative order; no edit
+        // reorders strokes today, but record a full swap if one ever does
+        delta = Delta();
+        for (size_t i = 0; i < before.m_strokes.size(); ++i) delta.removed.push_back({i, before.m_strokes[i]});
+        for (size_t j = 0; j < after.m_strokes.size(); ++j) delta.added.push_back({j, after.m_strokes[j]});
+    }
+    return delta;
+}
+
+void VectorLayerData::applyDelta(const Delta& delta, bool forward) {
+    syncIndex(); // the index is patched in place below
+
+    const std::vector<Delta::Placed>& drop = forward ? delta.removed : delta.added;
+    const std::vector<Delta::Placed>& put = forward ? delta.added : delta.removed;
+    std::unordered_map<uint32_t, const VectorStroke*> replace;
+    for (const auto& [before, after] : delta.changed) {
+        const VectorStroke& target = forward ? after : before;
+        replace[target.id] = &target;
+    }
+    std::unordered_set<uint32_t> dropIds;
+    for (const Delta::Placed& p : drop) dropIds.insert(p.stroke.id);
+
+    std::vector<VectorStroke> next;
+    next.reserve(m_strokes.size() + put.size());
+    size_t k = 0;
+    auto insertPending = [&](bool all) {
+        while (k < put.size() && (all || put[k].index <= next.size())) {
+            const VectorStroke& stroke = put[k++].stroke;
+            invalidateTiles(strokePaintBounds(stroke));
+            m_index.insert(stroke.id, strokePaintBounds(stroke));
+            m_nextId = std::max(m_nextId, stroke.id + 1);
+            next.push_back(stroke);
+        }
+    };
+
+    for (VectorStroke& stroke : m_strokes) {
+        if (dropIds.count(stroke.id)) {
+            invalidateTiles(strokePaintBounds(stroke));
+            m_index.remove(stroke.id);
+            continue;
+        }
+        insertPending(false);
+        auto it = replace.find(stroke.id);
+        if (it == replace.end()) {
+            next.push_back(std::move(stroke));
+            continue;
+        }
+        invalidateTiles(strokePaintBounds(stroke));
+        const QRectF bounds = strokePaintBounds(*it->second);
+        invalidateTiles(bounds);
+        m_index.update(stroke.id, bounds);
+        next.push_back(*it->second);
+    }
+    insertPending(true);
+
+    m_strokes = std::move(next);
+    m_idToIndex.clear();
+    for (size_t i = 0; i < m_strokes.size(); ++i) m_idToIndex[m_strokes[i].id] = i;
+}
+
+VectorLayerData::SegmentHit VectorLayerData::nearestSegment(const VPoint2D& point,
+                                                            float maxDistance) const {
+    SegmentHit best;
+    best.distance = maxDistance;
+    QRectF probe(point.x - maxDistance, point.y - maxDistance,
+                 maxDistance * 2.0f, maxDistance * 2.0f);
+    for (size_t idx : queryRegion(probe)) {
+        const VectorStroke& stroke = m_strokes[idx];
+        auto res = StrokeBVH(stroke).distanceTo(point, best.distance);
+        if (res.segIdx >= 0 && res.distance < best.distance) {
+            best.strokeId = stroke.id;
+            best.segIdx = res.segIdx;
+            best.t = res.t;
+            best.distance = res.distance;
+        }
+    }
+    return best;
+}
+
 VectorLayerData::EraseResult VectorLayerData::vectorErase(const VectorStroke& eraserPath) {
     EraseResult result;
-    std::vector<VectorStroke> updatedStrokes;
-    
+
     // Eraser threshold: let's use the eraser's width plus a small buffer
     float eraserRadius = eraserPath.globalWidth * 4.0f; 
     if (eraserRadius < 6.0f) eraserRadius = 6.0f; // minimum eraser size
 
-    for (const auto& stroke : m_strokes) {
-        // Quick bounding box check
-        QRectF expandedEraserBounds = eraserPath.cachedBounds.adjusted(-eraserRadius, -eraserRadius, eraserRadius, eraserRadius);
-        if (!stroke.cachedBounds.intersects(expandedEraserBounds)) {
-            updatedStrokes.push_back(stroke);
-            continue;
-        }
+    // Only strokes near the eraser are touched; the rest stay in place
+    // (no per-stroke copies on a crowded layer).
+    QRectF expandedEraserBounds = eraserPath.cachedBounds.adjusted(-eraserRadius, -eraserRadius, eraserRadius, eraserRadius);
+    const std::vector<size_t> candidates = queryRegion(expandedEraserBounds);
+    if (candidates.empty()) return result;
+
+    // Replacement for each modified stroke position (empty = fully erased)
+    std::unordered_map<size_t, std::vector<VectorStroke>> replacements;
+
+    // The eraser is flattened and indexed once for the whole pass
+    const StrokeBVH eraserBVH(eraserPath);
+    auto distanceToEraser = [&](const VPoint2D& pt) {
+        return eraserBVH.distanceTo(pt, eraserRadius).distance;
+    };
+
+    for (size_t strokeIdx : candidates) {
+        const auto& stroke = m_strokes[strokeIdx];
+        const StrokeBVH strokeBVH(stroke);
 
         // Find intersections
-        auto intersections = findIntersections(stroke, eraserPath);
+        auto intersections = strokeBVH.intersect(eraserBVH);
 
         if (intersections.empty()) {
             // No direct intersections, check if eraser is extremely close to the whole stroke
-            float minDist = 1e9f;
-            for (const auto& seg : stroke.segments) {
-                for (float t = 0.0f; t <= 1.0f; t += 0.25f) {
-                    VPoint2D pt = evalBezier(seg, t);
-                    auto distRes = distanceToStroke(pt, eraserPath);
-                    if (distRes.distance < minDist) {
-                        minDist = distRes.distance;
-                    }
-                }
-            }
-
-            if (minDist < eraserRadius) {
+            if (strokeBVH.withinDistance(eraserBVH, eraserRadius)) {
                 result.removedIds.push_back(stroke.id);
-            } else {
-                updatedStrokes.push_back(stroke);
+                replacements[strokeIdx];
             }
             continue;
         }
@@ -360,24 +645,21 @@ VectorLayerData::EraseResult VectorLayerData::vectorErase(const VectorStroke& er
 
         auto fragments = splitStrokeAtMultiple(stroke, splits);
         bool strokeWasModified = false;
+        std::vector<VectorStroke> kept;
 
         for (auto& frag : fragments) {
             float minDist = 1e9f;
             
             // Check segment midpoints
             for (const auto& seg : frag.segments) {
-                VPoint2D mid = evalBezier(seg, 0.5f);
-                auto distRes = distanceToStroke(mid, eraserPath);
-                if (distRes.distance < minDist) minDist = distRes.distance;
+                minDist = std::min(minDist, distanceToEraser(evalBezier(seg, 0.5f)));
+                if (minDist < eraserRadius) break;
             }
 
             // Check endpoints
-            if (!frag.segments.empty()) {
-                auto dStart = distanceToStroke(frag.segments.front().p0, eraserPath);
-                if (dStart.distance < minDist) minDist = dStart.distance;
-                
-                auto dEnd = distanceToStroke(frag.segments.back().p3, eraserPath);
-                if (dEnd.distance < minDist) minDist = dEnd.distance;
+            if (!frag.segments.empty() && minDist >= eraserRadius) {
+                minDist = std::min(minDist, distanceToEraser(frag.segments.front().p0));
+                minDist = std::min(minDist, distanceToEraser(frag.segments.back().p3));
             }
 
             if (minDist < eraserRadius) {
@@ -387,37 +669,84 @@ VectorLayerData::EraseResult VectorLayerData::vectorErase(const VectorStroke& er
                 if (strokeWasModified || fragments.size() > 1) {
                     frag.id = m_nextId++;
                     frag.recalcBounds();
+                    frag.segments.pack(); // the two copies below share it
                     result.newFragments.push_back(frag);
-                    updatedStrokes.push_back(frag);
-                } else {
-                    updatedStrokes.push_back(frag);
                 }
+                kept.push_back(std::move(frag));
             }
         }
 
+        // A single untouched fragment is the original stroke: leave it as is
+        if (kept.size() == 1 && kept.front().id == stroke.id) continue;
+
         // Since it was split/erased, we mark the original stroke ID as removed
         result.removedIds.push_back(stroke.id);
+        replacements[strokeIdx] = std::move(kept);
     }
 
+    if (replacements.empty()) return result;
+
+    std::vector<VectorStroke> updatedStrokes;
+    updatedStrokes.reserve(m_strokes.size() + result.newFragments.size());
+    for (const auto& entry : replacements) {
+        invalidateTiles(strokePaintBounds(m_strokes[entry.first]));
+    }
+    for (size_t i = 0; i < m_strokes.size(); ++i) {
+        auto it = replacements.find(i);
+        if (it == replacements.end()) {
+            updatedStrokes.push_back(std::move(m_strokes[i]));
+        } else {
+            for (auto& frag : it->second) updatedStrokes.push_back(std::move(frag));
+        }
+    }
     m_strokes = std::move(updatedStrokes);
+
+    // Positions shifted; the grid itself only needs the removed/added ids
+    for (uint32_t id : result.removedIds) m_index.remove(id);
+    for (const auto& frag : result.newFragments) m_index.insert(frag.id, strokePaintBounds(frag));
+    m_idToIndex.clear();
+    for (size_t i = 0; i < m_strokes.size(); ++i) m_idToIndex[m_strokes[i].id] = i;
     return result;
 }
 
 void VectorLayerData::rasterize(ImageBuffer& output, float scale, RasterQuality quality) const {
-    // One QImage wrap + one QPainter + one tile sync for the whole layer.
-    // The previous per-stroke version rebuilt the contiguous cache and synced
-    // it back into the tiled buffer once per stroke (O(strokes * canvas)).
-    QImage canvasImg(output.data(), output.width(), output.height(), QImage::Format_RGBA8888_Premultiplied);
-    QPainter painter(&canvasImg);
-    painter.setRenderHint(QPainter::Antialiasing);
-    painter.setRenderHint(QPainter::SmoothPixmapTransform, quality == RasterQuality::Final);
+    rasterizeWindow(output, QPoint(0, 0), scale, quality);
+}
 
-    for (const auto& stroke : m_strokes) {
-        paintStrokeInternal(painter, stroke, scale, quality);
+void VectorLayerData::rasterizeWindow(ImageBuffer& output, const QPoint& origin, float scale,
+                                      RasterQuality quality) const {
+    // Tile-parallel: every stroke is binned into the output tiles its paint
+    // bounds overlap (in z-order), then the tiles render independently on the
+    // thread pool. Strokes are composited over what the buffer already holds.
+    syncIndex();
+    const int T = ImageBuffer::TILE_SIZE;
+    const int tilesX = output.tilesX();
+    const int tilesY = output.tilesY();
+    const QRectF outputRect(0, 0, output.width(), output.height());
+
+    std::vector<std::vector<size_t>> bins(static_cast<size_t>(tilesX) * tilesY);
+    for (size_t i = 0; i < m_strokes.size(); ++i) {
+        const QRectF b = strokePaintBounds(m_strokes[i]);
+        const QRectF r = QRectF(b.x() * scale - origin.x(), b.y() * scale - origin.y(),
+                                b.width() * scale, b.height() * scale).intersected(outputRect);
+        if (r.isEmpty()) continue;
+        const int tx0 = std::max(0, static_cast<int>(r.left()) / T);
+        const int ty0 = std::max(0, static_cast<int>(r.top()) / T);
+        const int tx1 = std::min(tilesX - 1, static_cast<int>(r.right()) / T);
+        const int ty1 = std::min(tilesY - 1, static_cast<int>(r.bottom()) / T);
+        for (int ty = ty0; ty <= ty1; ++ty)
+            for (int tx = tx0; tx <= tx1; ++tx)
+                bins[static_cast<size_t>(ty) * tilesX + tx].push_back(i);
     }
 
-    painter.end();
-    output.loadRawData(output.data());
+    std::vector<TileJob> jobs;
+    for (int ty = 0; ty < tilesY; ++ty) {
+        for (int tx = 0; tx < tilesX; ++tx) {
+            auto& bin = bins[static_cast<size_t>(ty) * tilesX + tx];
+            if (!bin.empty()) jobs.push_back({tx, ty, std::move(bin)});
+        }
+    }
+    rasterizeTiles(output, jobs, scale, quality, false, origin);
 }
 
 void VectorLayerData::rasterizeRegion(ImageBuffer& output, const QRectF& region, float scale,
@@ -426,27 +755,190 @@ void VectorLayerData::rasterizeRegion(ImageBuffer& output, const QRectF& region,
 
     QRectF scaledRegion(region.x() * scale, region.y() * scale,
                         region.width() * scale, region.height() * scale);
-    scaledRegion = scaledRegion.intersected(QRectF(0, 0, output.width(), output.height()));
-    if (scaledRegion.isEmpty()) return;
+    const QRect area =
+        scaledRegion.toAlignedRect().intersected(QRect(0, 0, output.width(), output.height()));
+    if (area.isEmpty()) return;
+
+    // Same tile path as rasterizeDirty(), limited to `area`: each tile it
+    // overlaps clears and redraws just that part, in its own memory
+    const int T = ImageBuffer::TILE_SIZE;
+    std::vector<TileJob> jobs;
+    for (int ty = area.top() / T; ty <= area.bottom() / T; ++ty) {
+        for (int tx = area.left() / T; tx <= area.right() / T; ++tx) {
+            const QRect part = QRect(tx * T, ty * T, T, T).intersected(area);
+            jobs.push_back({tx, ty,
+                            queryRegion(QRectF(part.x() / scale, part.y() / scale,
+                                               part.width() / scale, part.height() / scale))});
+        }
+    }
+    rasterizeTiles(output, jobs, scale, quality, true, QPoint(), area);
+}
 
-    QImage canvasImg(output.data(), output.width(), output.height(), QImage::Format_RGBA8888_Premultiplied);
-    QPainter painter(&canvasImg);
-    painter.setRenderHint(QPainter::Antialiasing);
-    painter.setRenderHint(QPainter::SmoothPixmapTransform, quality == RasterQuality::Final);
-    painter.setClipRect(scaledRegion);
+void VectorLayerData::invalidateTiles(const QRectF& region) const {
+    if (m_allTilesDirty || region.isEmpty()) return;
 
-    // Clear only the affected region, then re-compose the strokes that touch it.
-    painter.setCompositionMode(QPainter::CompositionMode_Clear);
-    painter.fillRect(scaledRegion, Qt::transparent);
-    painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+    const int T = ImageBuffer::TILE_SIZE;
+    const int tilesX = (m_canvasW + T - 1) / T;
+    const int tilesY = (m_canvasH + T - 1) / T;
+    if (m_dirtyTiles.size() != static_cast<size_t>(tilesX) * tilesY) {
+        m_dirtyTiles.assign(static_cast<size_t>(tilesX) * tilesY, 0);
+        m_dirtyTileCount = 0;
+    }
 
-    for (const auto& stroke : m_strokes) {
-        if (!stroke.cachedBounds.intersects(region)) continue;
-        paintStrokeInternal(painter, stroke, scale, quality);
+    const QRectF canvas(0, 0, m_canvasW, m_canvasH);
+    const QRectF r = region.intersected(canvas);
+    if (r.isEmpty()) return;
+    const int tx0 = std::max(0, static_cast<int>(std::floor(r.left() / T)));
+    const int ty0 = std::max(0, static_cast<int>(std::floor(r.top() / T)));
+    const int tx1 = std::min(tilesX - 1, static_cast<int>(std::floor(r.right() / T)));
+    const int ty1 = std::min(tilesY - 1, static_cast<int>(std::floor(r.bottom() / T)));
+    for (int ty = ty0; ty <= ty1; ++ty) {
+        for (int tx = tx0; tx <= tx1; ++tx) {
+            uint8_t& flag = m_dirtyTiles[static_cast<size_t>(ty) * tilesX + tx];
+            if (!flag) {
+                flag = 1;
+                ++m_dirtyTileCount;
+            }
+        }
     }
+}
 
-    painter.end();
-    output.loadRawData(output.data());
+void VectorLayerData::markDirty(const QRectF& region) {
+    invalidateTiles(region);
+}
+
+void VectorLayerData::markAllDirty() {
+    m_allTilesDirty = true;
+}
+
+void VectorLayerData::rasterizeTiles(ImageBuffer& output, const std::vector<TileJob>& jobs,
+                                     float scale, RasterQuality quality, bool clearFirst,
+                                     const QPoint& origin, const QRect& clip) const {
+    if (jobs.empty()) return;
+    const int T = ImageBuffer::TILE_SIZE;
+
+    // Tiles are only looked up here, never allocated, so each worker touches
+    // nothing but its own tile memory. Missing tiles render into a fresh
+    // image that is adopted below (only if something visible landed in it,
+    // so the buffer stays sparse).
+    std::vector<ImageBuffer::Tile*> tiles(jobs.size());
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        tiles[i] = output.getTile(jobs[i].tx * T, jobs[i].ty * T, false);
+    }
+    std::vector<QImage> fresh(jobs.size());
+
+    auto renderJob = [&](size_t i) {
+        const TileJob& job = jobs[i];
+        ImageBuffer::Tile* tile = tiles[i];
+        if (!tile && job.strokes.empty()) return;
+
+        // Tile rect in scaled-canvas space, and the part of it to redraw
+        const QRect tileRect = QRect(job.tx * T, job.ty * T, T, T).translated(origin);
+        const QRect area = clip.isNull() ? tileRect : tileRect.intersected(clip);
+
+        QImage target;
+        if (tile) {
+            if (clearFirst && area == tileRect) {
+                std::memset(tile->data.get(), 0, ImageBuffer::TILE_BYTES);
+            } else if (clearFirst) {
+                const QRect local = area.translated(-tileRect.topLeft());
+                for (int y = local.top(); y <= local.bottom(); ++y)
+                    std::memset(tile->data.get() + (static_cast<size_t>(y) * T + local.left()) * 4, 0,
+                                static_cast<size_t>(local.width()) * 4);
+            }
+            target = QImage(tile->data.get(), T, T, T * 4, QImage::Format_RGBA8888_Premultiplied);
+        } else {
+            target = QImage(T, T, QImage::Format_RGBA8888_Premultiplied);
+            target.fill(Qt::transparent);
+        }
+
+        if (!job.strokes.empty()) {
+            QPainter painter(&target);
+            painter.setRenderHint(QPainter::Antialiasing);
+            painter.setRenderHint(QPainter::SmoothPixmapTransform, quality == RasterQuality::Final);
+            painter.translate(-tileRect.x(), -tileRect.y());
+            painter.setClipRect(area);
+            // Stroke order inside the tile is the layer's z-order, so
+            // over-compositing matches the single-pass render
+            for (size_t idx : job.strokes) {
+                paintStrokeInternal(painter, m_strokes[idx], scale, quality);
+            }
+            painter.end();
+        }
+
+        if (!tile) {
+            const uint8_t* px = target.constBits();
+            for (int a = 3; a < ImageBuffer::TILE_BYTES; a += 4) {
+                if (px[a]) {
+                    fresh[i] = target;
+                    break;
+                }
+            }
+        }
+    };
+
+    if (jobs.size() == 1) {
+        renderJob(0);
+    } else {
+        std::vector<size_t> order(jobs.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+        QtConcurrent::blockingMap(order, [&](size_t i) { renderJob(i); });
+    }
+
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        ImageBuffer::Tile* tile = tiles[i];
+        if (tile) {
+            if (clearFirst || !jobs[i].strokes.empty()) tile->dirty = true;
+            continue;
+        }
+        if (fresh[i].isNull()) continue;
+        tile = output.getTile(jobs[i].tx * T, jobs[i].ty * T, true);
+        if (!tile) continue;
+        std::memcpy(tile->data.get(), fresh[i].constBits(), ImageBuffer::TILE_BYTES);
+        tile->dirty = true;
+    }
+    output.invalidateCache();
+}
+
+QRect VectorLayerData::rasterizeDirty(ImageBuffer& output, RasterQuality quality) {
+    if (!hasDirtyTiles()) return QRect();
+    syncIndex(); // may mark more tiles (strokes edited through getStroke)
+    // Edits are committed by now: repack strokes handed out for editing so
+    // undo snapshots taken from here on share their geometry
+    if (m_repackAll) {
+        for (VectorStroke& stroke : m_strokes) stroke.segments.pack();
+    } else {
+        for (uint32_t id : m_repackIds) {
+            auto it = m_idToIndex.find(id);
+            if (it != m_idToIndex.end()) m_strokes[it->second].segments.pack();
+        }
+    }
+    m_repackIds.clear();
+    m_repackAll = false;
+
+    const int T = ImageBuffer::TILE_SIZE;
+    const int tilesX = std::min(output.tilesX(), (m_canvasW + T - 1) / T);
+    const int tilesY = std::min(output.tilesY(), (m_canvasH + T - 1) / T);
+    const int gridW = (m_canvasW + T - 1) / T;
+    const bool all = m_allTilesDirty ||
+                     m_dirtyTiles.size() != static_cast<size_t>(gridW) * ((m_canvasH + T - 1) / T);
+
+    std::vector<TileJob> jobs;
+    QRect changed;
+    for (int ty = 0; ty < tilesY; ++ty) {
+        for (int tx = 0; tx < tilesX; ++tx) {
+            if (!all && !m_dirtyTiles[static_cast<size_t>(ty) * gridW + tx]) continue;
+            const QRect tileRect(tx * T, ty * T, T, T);
+            jobs.push_back({tx, ty, queryRegion(QRectF(tileRect))});
+            changed |= tileRect;
+        }
+    }
+    rasterizeTiles(output, jobs, 1.0f, quality, true);
+
+    std::fill(m_dirtyTiles.begin(), m_dirtyTiles.end(), 0);
+    m_dirtyTileCount = 0;
+    m_allTilesDirty = false;
+    return changed.intersected(QRect(0, 0, output.width(), output.height()));
 }
 
 void VectorLayerData::rasterizeStroke(const VectorStroke& stroke, ImageBuffer& output, float scale) const {
@@ -465,29 +957,12 @@ void VectorLayerData::paintStrokeInternal(QPainter& painter, const VectorStroke&
 
     painter.save();
 
-    // ── Draft preview: flat stroked path, no dabs. Used while dragging nodes
+    // ── Draft preview: the outline at its true variable width, tessellated
+    // and coverage-rasterized on the CPU; no dabs. Used while dragging nodes
     // so curvature feedback is instant; the full-precision render happens on
     // release. ──
     if (quality == RasterQuality::Draft) {
-        painter.setCompositionMode(stroke.isEraser
-                                       ? QPainter::CompositionMode_DestinationOut
-                                       : QPainter::CompositionMode_SourceOver);
-        painter.setOpacity(stroke.opacity);
-        painter.setBrush(Qt::NoBrush);
-
-        for (const auto& seg : stroke.segments) {
-            float w = stroke.globalWidth * scale * 0.5f *
-                      (seg.p0.pressure * seg.widthStart + seg.p3.pressure * seg.widthEnd);
-            QPen pen(stroke.color, std::max(0.75f, w), Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin);
-            painter.setPen(pen);
-
-            QPainterPath path;
-            path.moveTo(seg.p0.x * scale, seg.p0.y * scale);
-            path.cubicTo(seg.cp1.x * scale, seg.cp1.y * scale,
-                         seg.cp2.x * scale, seg.cp2.y * scale,
-                         seg.p3.x * scale, seg.p3.y * scale);
-            painter.drawPath(path);
-        }
+        paintStrokeTessellated(painter, stroke, scale);
         painter.restore();
         return;
     }
@@ -496,7 +971,8 @@ void VectorLayerData::paintStrokeInternal(QPainter& painter, const VectorStroke&
     // raster brush pipeline so it keeps grain, tip shape, taper, jitter and
     // pressure dynamics instead of looking like a flat line. ──
     if (stroke.brush) {
-        static BrushEngine s_vectorEngine;
+        // One engine per thread: it carries dab spacing state across calls
+        thread_local BrushEngine s_vectorEngine;
 
         BrushSettings settings = *stroke.brush;
         settings.size = std::max(0.5f, stroke.globalWidth * scale);
@@ -513,6 +989,9 @@ void VectorLayerData::paintStrokeInternal(QPainter& painter, const VectorStroke&
         const float tolerance = std::max(0.2f, 0.4f / std::max(scale, 0.01f));
         auto pts = flattenStrokePolyline(stroke, tolerance);
         if (pts.size() >= 2) {
+            // Seed jitter per stroke so every tile that redraws this stroke
+            // (on any thread) gets the same dabs and the seams line up.
+            BrushEngine::seedJitter(stroke.id * 2654435761u);
             s_vectorEngine.resetRemainder();
             for (size_t i = 1; i < pts.size(); ++i) {
                 QPointF a(pts[i - 1].x * scale, pts[i - 1].y * scale);
@@ -530,7 +1009,7 @@ void VectorLayerData::paintStrokeInternal(QPainter& painter, const VectorStroke&
     QImage tipImg;
     bool hasTexture = false;
     if (!stroke.tipTextureName.isEmpty()) {
-        static QMap<QString, QImage> s_vectorTipCache;
+        thread_local QMap<QString, QImage> s_vectorTipCache;
         if (s_vectorTipCache.contains(stroke.tipTextureName)) {
             tipImg = s_vectorTipCache[stroke.tipTextureName];
         } else {
@@ -616,7 +1095,7 @@ void VectorLayerData::paintStrokeInternal(QPainter& painter, const VectorStroke&
 
 void VectorLayerData::transformAll(const QTransform& matrix) {
     for (auto& stroke : m_strokes) {
-        for (auto& seg : stroke.segments) {
+        for (BezierSegment& seg : stroke.segments.unpack()) {
             QPointF p0 = matrix.map(QPointF(seg.p0.x, seg.p0.y));
             seg.p0.x = p0.x(); seg.p0.y = p0.y();
             
@@ -630,29 +1109,37 @@ void VectorLayerData::transformAll(const QTransform& matrix) {
             seg.p3.x = p3.x(); seg.p3.y = p3.y();
         }
         stroke.recalcBounds();
+        stroke.segments.pack();
     }
+    rebuildIndex();
+    markAllDirty();
 }
 
 void VectorLayerData::transformStroke(uint32_t id, const QTransform& matrix) {
-    for (auto& stroke : m_strokes) {
-        if (stroke.id == id) {
-            for (auto& seg : stroke.segments) {
-                QPointF p0 = matrix.map(QPointF(seg.p0.x, seg.p0.y));
-                seg.p0.x = p0.x(); seg.p0.y = p0.y();
-                
-                QPointF cp1 = matrix.map(QPointF(seg.cp1.x, seg.cp1.y));
-                seg.cp1.x = cp1.x(); seg.cp1.y = cp1.y();
-                
-                QPointF cp2 = matrix.map(QPointF(seg.cp2.x, seg.cp2.y));
-                seg.cp2.x = cp2.x(); seg.cp2.y = cp2.y();
-                
-                QPointF p3 = matrix.map(QPointF(seg.p3.x, seg.p3.y));
-                seg.p3.x = p3.x(); seg.p3.y = p3.y();
-            }
-            stroke.recalcBounds();
-            break;
-        }
+    syncIndex();
+    auto it = m_idToIndex.find(id);
+    if (it == m_idToIndex.end()) return;
+
+    auto& stroke = m_strokes[it->second];
+    invalidateTiles(strokePaintBounds(stroke));
+    for (BezierSegment& seg : stroke.segments.unpack()) {
+        QPointF p0 = matrix.map(QPointF(seg.p0.x, seg.p0.y));
+        seg.p0.x = p0.x(); seg.p0.y = p0.y();
+        
+        QPointF cp1 = matrix.map(QPointF(seg.cp1.x, seg.cp1.y));
+        seg.cp1.x = cp1.x(); seg.cp1.y = cp1.y();
+        
+        QPointF cp2 = matrix.map(QPointF(seg.cp2.x, seg.cp2.y));
+        seg.cp2.x = cp2.x(); seg.cp2.y = cp2.y();
+        
+        QPointF p3 = matrix.map(QPointF(seg.p3.x, seg.p3.y));
+        seg.p3.x = p3.x(); seg.p3.y = p3.y();
     }
+    stroke.recalcBounds();
+    stroke.segments.pack();
+    const QRectF bounds = strokePaintBounds(stroke);
+    invalidateTiles(bounds);
+    m_index.update(id, bounds);
 }
 
 QRectF VectorLayerData::boundingBox() const {
@@ -214,78 +214,11 @@ static bool intersectSegments(const QPointF& a1, const QPointF& a2, const QPoint
 }
 
 std::vector<Intersection> findIntersections(const VectorStroke& strokeA, const VectorStroke& strokeB) {
-    std::vector<Intersection> results;
-    
     if (!strokeA.cachedBounds.intersects(strokeB.cachedBounds)) {
-        return results;
+        return {};
     }
-
-    auto ptsA = flattenStroke(strokeA, 1.5f);
-    auto ptsB = flattenStroke(strokeB, 1.5f);
-
-    if (ptsA.size() < 2 || ptsB.size() < 2) return results;
-
-    for (size_t i = 0; i < ptsA.size() - 1; ++i) {
-        QPointF a1(ptsA[i].pt.x, ptsA[i].pt.y);
-        QPointF a2(ptsA[i+1].pt.x, ptsA[i+1].pt.y);
-        
-        QRectF rectA = QRectF(a1, a2).normalized();
-        rectA.adjust(-1, -1, 1, 1);
-
-        for (size_t j = 0; j < ptsB.size() - 1; ++j) {
-            QPointF b1(ptsB[j].pt.x, ptsB[j].pt.y);
-            QPointF b2(ptsB[j+1].pt.x, ptsB[j+1].pt.y);
-            
-            QRectF rectB = QRectF(b1, b2).normalized();
-            if (!rectA.intersects(rectB)) continue;
-
-            float tSegA, tSegB;
-            QPointF pt;
-            if (intersectSegments(a1, a2, b1, b2, tSegA, tSegB, pt)) {
-                Intersection inter;
-                inter.pt = pt;
-                
-                if (ptsA[i].segIdx == ptsA[i+1].segIdx) {
-                    inter.segIdxA = ptsA[i].segIdx;
-                    inter.tA = ptsA[i].t + tSegA * (ptsA[i+1].t - ptsA[i].t);
-                } else {
-                    if (tSegA < 0.5f) {
-                        inter.segIdxA = ptsA[i].segIdx;
-                        inter.tA = ptsA[i].t;
-                    } else {
-                        inter.segIdxA = ptsA[i+1].segIdx;
-                        inter.tA = ptsA[i+1].t;
-                    }
-                }
-
-                if (ptsB[j].segIdx == ptsB[j+1].segIdx) {
-                    inter.segIdxB = ptsB[j].segIdx;
-                    inter.tB = ptsB[j].t + tSegB * (ptsB[j+1].t - ptsB[j].t);
-                } else {
-                    if (tSegB < 0.5f) {
-                        inter.segIdxB = ptsB[j].segIdx;
-                        inter.tB = ptsB[j].t;
-                    } else {
-                        inter.segIdxB = ptsB[j+1].segIdx;
-                        inter.tB = ptsB[j+1].t;
-                    }
-                }
-                
-                bool duplicate = false;
-                for (const auto& existing : results) {
-                    if (existing.segIdxA == inter.segIdxA && std::abs(existing.tA - inter.tA) < 0.05f &&
-                        existing.segIdxB == inter.segIdxB && std::abs(existing.tB - inter.tB) < 0.05f) {
-                        duplicate = true;
-                        break;
-                    }
-                }
-                if (!duplicate) {
-                    results.push_back(inter);
-                }
-            }
-        }
-    }
-    return results;
+    // One-off query; callers testing many pairs should keep the StrokeBVHs
+    return StrokeBVH(strokeA).intersect(StrokeBVH(strokeB));
 }
 
 std::pair<VectorStroke, VectorStroke> splitStrokeAt(const VectorStroke& stroke, int segIdx, float t) {
@@ -313,18 +246,20 @@ std::pair<VectorStroke, VectorStroke> splitStrokeAt(const VectorStroke& stroke,
     VectorStroke firstPart;
     copyStyle(firstPart);
 
+    std::vector<BezierSegment>& first = firstPart.segments.unpack();
     for (int i = 0; i < segIdx; ++i) {
-        firstPart.segments.push_back(stroke.segments[i]);
+        first.push_back(stroke.segments[i]);
     }
-    firstPart.segments.push_back(halves.first);
+    first.push_back(halves.first);
     firstPart.recalcBounds();
 
     VectorStroke secondPart;
     copyStyle(secondPart);
 
-    secondPart.segments.push_back(halves.second);
+    std::vector<BezierSegment>& second = secondPart.segments.unpack();
+    second.push_back(halves.second);
     for (size_t i = segIdx + 1; i < stroke.segments.size(); ++i) {
-        secondPart.segments.push_back(stroke.segments[i]);
+        second.push_back(stroke.segments[i]);
     }
     secondPart.recalcBounds();
 
@@ -332,53 +267,303 @@ std::pair<VectorStroke, VectorStroke> splitStrokeAt(const VectorStroke& stroke,
 }
 
 StrokeDistanceResult distanceToStroke(const VPoint2D& point, const VectorStroke& stroke) {
-    StrokeDistanceResult bestResult;
-    bestResult.distance = 1e9f;
+    return StrokeBVH(stroke).distanceTo(point);
+}
 
-    auto pts = flattenStroke(stroke, 1.5f);
-    if (pts.size() < 2) return bestResult;
+// ---------------------------------------------------------
+// StrokeBVH
+// ---------------------------------------------------------
+
+template <typename Box>
+static float boxPointDistanceSq(const Box& b, float px, float py) {
+    float dx = std::max(std::max(b.minX - px, px - b.maxX), 0.0f);
+    float dy = std::max(std::max(b.minY - py, py - b.maxY), 0.0f);
+    return dx * dx + dy * dy;
+}
 
-    for (size_t i = 0; i < pts.size() - 1; ++i) {
-        VPoint2D p1 = pts[i].pt;
-        VPoint2D p2 = pts[i+1].pt;
+template <typename Box>
+static float boxBoxDistanceSq(const Box& a, const Box& b) {
+    float dx = std::max(std::max(a.minX - b.maxX, b.minX - a.maxX), 0.0f);
+    float dy = std::max(std::max(a.minY - b.maxY, b.minY - a.maxY), 0.0f);
+    return dx * dx + dy * dy;
+}
 
-        float dx = p2.x - p1.x;
-        float dy = p2.y - p1.y;
-        float lenSq = dx * dx + dy * dy;
-        
-        float tSeg = 0.0f;
-        if (lenSq > 1e-6f) {
-            tSeg = ((point.x - p1.x) * dx + (point.y - p1.y) * dy) / lenSq;
-            if (tSeg < 0.0f) tSeg = 0.0f;
-            else if (tSeg > 1.0f) tSeg = 1.0f;
+static inline float pointSegmentDistanceSq(float px, float py, float x1, float y1,
+                                           float x2, float y2, float& tSeg) {
+    float dx = x2 - x1;
+    float dy = y2 - y1;
+    float lenSq = dx * dx + dy * dy;
+    float t = lenSq > 1e-6f ? ((px - x1) * dx + (py - y1) * dy) / lenSq : 0.0f;
+    t = std::clamp(t, 0.0f, 1.0f);
+    float ex = px - (x1 + t * dx);
+    float ey = py - (y1 + t * dy);
+    tSeg = t;
+    return ex * ex + ey * ey;
+}
+
+StrokeBVH::StrokeBVH(const VectorStroke& stroke, float tolerance) {
+    auto pts = flattenStroke(stroke, tolerance);
+    if (pts.size() < 2) return;
+
+    const size_t n = pts.size();
+    m_x.resize(n);
+    m_y.resize(n);
+    m_pressure.resize(n);
+    m_segIdx.resize(n);
+    m_t.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        m_x[i] = pts[i].pt.x;
+        m_y[i] = pts[i].pt.y;
+        m_pressure[i] = pts[i].pt.pressure;
+        m_segIdx[i] = pts[i].segIdx;
+        m_t[i] = pts[i].t;
+    }
+
+    // Leaves: runs of consecutive chords
+    const int chords = static_cast<int>(n) - 1;
+    std::vector<int> level;
+    m_nodes.reserve(2 * (chords / kLeafChords + 1));
+    for (int first = 0; first < chords; first += kLeafChords) {
+        Node leaf;
+        leaf.first = first;
+        leaf.count = std::min(kLeafChords, chords - first);
+        leaf.minX = leaf.maxX = m_x[first];
+        leaf.minY = leaf.maxY = m_y[first];
+        for (int k = first + 1; k <= first + leaf.count; ++k) {
+            leaf.minX = std::min(leaf.minX, m_x[k]);
+            leaf.maxX = std::max(leaf.maxX, m_x[k]);
+            leaf.minY = std::min(leaf.minY, m_y[k]);
+            leaf.maxY = std::max(leaf.maxY, m_y[k]);
         }
-        
-        VPoint2D closest;
-        closest.x = p1.x + tSeg * dx;
-        closest.y = p1.y + tSeg * dy;
-        closest.pressure = p1.pressure + tSeg * (p2.pressure - p1.pressure);
-
-        float distSq = (point.x - closest.x) * (point.x - closest.x) + (point.y - closest.y) * (point.y - closest.y);
-        float dist = std::sqrt(distSq);
-
-        if (dist < bestResult.distance) {
-            bestResult.distance = dist;
-            bestResult.closestPoint = closest;
-            if (pts[i].segIdx == pts[i+1].segIdx) {
-                bestResult.segIdx = pts[i].segIdx;
-                bestResult.t = pts[i].t + tSeg * (pts[i+1].t - pts[i].t);
-            } else {
-                if (tSeg < 0.5f) {
-                    bestResult.segIdx = pts[i].segIdx;
-                    bestResult.t = pts[i].t;
-                } else {
-                    bestResult.segIdx = pts[i+1].segIdx;
-                    bestResult.t = pts[i+1].t;
+        level.push_back(static_cast<int>(m_nodes.size()));
+        m_nodes.push_back(leaf);
+    }
+
+    // Pair neighbours bottom-up until one root remains
+    while (level.size() > 1) {
+        std::vector<int> next;
+        next.reserve(level.size() / 2 + 1);
+        for (size_t i = 0; i + 1 < level.size(); i += 2) {
+            const Node a = m_nodes[level[i]];
+            const Node b = m_nodes[level[i + 1]];
+            Node parent;
+            parent.minX = std::min(a.minX, b.minX);
+            parent.minY = std::min(a.minY, b.minY);
+            parent.maxX = std::max(a.maxX, b.maxX);
+            parent.maxY = std::max(a.maxY, b.maxY);
+            parent.left = level[i];
+            parent.right = level[i + 1];
+            next.push_back(static_cast<int>(m_nodes.size()));
+            m_nodes.push_back(parent);
+        }
+        if (level.size() % 2) next.push_back(level.back());
+        level.swap(next);
+    }
+    m_root = level.front();
+}
+
+void StrokeBVH::chordParam(int chord, float tSeg, int& segIdx, float& t) const {
+    if (m_segIdx[chord] == m_segIdx[chord + 1]) {
+        segIdx = m_segIdx[chord];
+        t = m_t[chord] + tSeg * (m_t[chord + 1] - m_t[chord]);
+    } else if (tSeg < 0.5f) {
+        segIdx = m_segIdx[chord];
+        t = m_t[chord];
+    } else {
+        segIdx = m_segIdx[chord + 1];
+        t = m_t[chord + 1];
+    }
+}
+
+StrokeDistanceResult StrokeBVH::distanceTo(const VPoint2D& point, float maxDistance) const {
+    StrokeDistanceResult result;
+    if (m_root < 0) return result;
+
+    const float px = point.x;
+    const float py = point.y;
+    float bestSq = maxDistance * maxDistance;
+    int bestChord = -1;
+    float bestT = 0.0f;
+
+    int stack[64];
+    int sp = 0;
+    stack[sp++] = m_root;
+    while (sp > 0) {
+        const Node& node = m_nodes[stack[--sp]];
+        if (boxPointDistanceSq(node, px, py) >= bestSq) continue;
+
+        if (node.left < 0) {
+            // Branch-free over the leaf's chords so the loop vectorizes
+            float dist[kLeafChords];
+            float ts[kLeafChords];
+            const float* x = m_x.data() + node.first;
+            const float* y = m_y.data() + node.first;
+            for (int k = 0; k < node.count; ++k) {
+                dist[k] = pointSegmentDistanceSq(px, py, x[k], y[k], x[k + 1], y[k + 1], ts[k]);
+            }
+            for (int k = 0; k < node.count; ++k) {
+                if (dist[k] < bestSq) {
+                    bestSq = dist[k];
+                    bestChord = node.first + k;
+                    bestT = ts[k];
+                }
+            }
+            continue;
+        }
+
+        // Visit the nearer child first (pushed last)
+        const float dl = boxPointDistanceSq(m_nodes[node.left], px, py);
+        const float dr = boxPointDistanceSq(m_nodes[node.right], px, py);
+        if (dl < dr) {
+            stack[sp++] = node.right;
+            stack[sp++] = node.left;
+        } else {
+            stack[sp++] = node.left;
+            stack[sp++] = node.right;
+        }
+    }
+
+    if (bestChord < 0) return result;
+
+    const int c = bestChord;
+    result.distance = std::sqrt(bestSq);
+    result.closestPoint.x = m_x[c] + bestT * (m_x[c + 1] - m_x[c]);
+    result.closestPoint.y = m_y[c] + bestT * (m_y[c + 1] - m_y[c]);
+    result.closestPoint.pressure = m_pressure[c] + bestT * (m_pressure[c + 1] - m_pressure[c]);
+    chordParam(c, bestT, result.segIdx, result.t);
+    return result;
+}
+
+std::vector<Intersection> StrokeBVH::intersect(const StrokeBVH& other) const {
+    std::vector<Intersection> results;
+    if (m_root < 0 || other.m_root < 0) return results;
+
+    struct Hit {
+        int i, j;
+        float tA, tB;
+        QPointF pt;
+    };
+    std::vector<Hit> hits;
+
+    // Chords of this stroke are padded by 1 px, as the brute-force test was
+    std::vector<std::pair<int, int>> stack;
+    stack.emplace_back(m_root, other.m_root);
+    while (!stack.empty()) {
+        auto [ia, ib] = stack.back();
+        stack.pop_back();
+        const Node& a = m_nodes[ia];
+        const Node& b = other.m_nodes[ib];
+        if (a.minX - 1.0f > b.maxX || a.maxX + 1.0f < b.minX ||
+            a.minY - 1.0f > b.maxY || a.maxY + 1.0f < b.minY)
+            continue;
+
+        const bool aLeaf = a.left < 0;
+        const bool bLeaf = b.left < 0;
+        if (aLeaf && bLeaf) {
+            for (int i = a.first; i < a.first + a.count; ++i) {
+                QPointF a1(m_x[i], m_y[i]);
+                QPointF a2(m_x[i + 1], m_y[i + 1]);
+                const float aMinX = std::min(m_x[i], m_x[i + 1]) - 1.0f;
+                const float aMaxX = std::max(m_x[i], m_x[i + 1]) + 1.0f;
+                const float aMinY = std::min(m_y[i], m_y[i + 1]) - 1.0f;
+                const float aMaxY = std::max(m_y[i], m_y[i + 1]) + 1.0f;
+                for (int j = b.first; j < b.first + b.count; ++j) {
+                    const float* bx = other.m_x.data() + j;
+                    const float* by = other.m_y.data() + j;
+                    if (std::max(bx[0], bx[1]) < aMinX || std::min(bx[0], bx[1]) > aMaxX ||
+                        std::max(by[0], by[1]) < aMinY || std::min(by[0], by[1]) > aMaxY)
+                        continue;
+
+                    float tSegA, tSegB;
+                    QPointF pt;
+                    if (intersectSegments(a1, a2, QPointF(bx[0], by[0]), QPointF(bx[1], by[1]),
+                                          tSegA, tSegB, pt)) {
+                        hits.push_back({i, j, tSegA, tSegB, pt});
+                    }
                 }
             }
+        } else if (bLeaf || (!aLeaf && (a.maxX - a.minX) + (a.maxY - a.minY) >=
+                                           (b.maxX - b.minX) + (b.maxY - b.minY))) {
+            stack.emplace_back(a.left, ib);
+            stack.emplace_back(a.right, ib);
+        } else {
+            stack.emplace_back(ia, b.left);
+            stack.emplace_back(ia, b.right);
         }
     }
-    return bestResult;
+
+    // Chord order along this stroke, so results match the sequential scan
+    std::sort(hits.begin(), hits.end(), [](const Hit& l, const Hit& r) {
+        return l.i != r.i ? l.i < r.i : l.j < r.j;
+    });
+
+    for (const Hit& hit : hits) {
+        Intersection inter;
+        inter.pt = hit.pt;
+        chordParam(hit.i, hit.tA, inter.segIdxA, inter.tA);
+        other.chordParam(hit.j, hit.tB, inter.segIdxB, inter.tB);
+
+        bool duplicate = false;
+        for (const auto& existing : results) {
+            if (existing.segIdxA == inter.segIdxA && std::abs(existing.tA - inter.tA) < 0.05f &&
+                existing.segIdxB == inter.segIdxB && std::abs(existing.tB - inter.tB) < 0.05f) {
+                duplicate = true;
+                break;
+            }
+        }
+        if (!duplicate) results.push_back(inter);
+    }
+    return results;
+}
+
+bool StrokeBVH::withinDistance(const StrokeBVH& other, float radius) const {
+    if (m_root < 0 || other.m_root < 0) return false;
+    const float r2 = radius * radius;
+
+    std::vector<std::pair<int, int>> stack;
+    stack.emplace_back(m_root, other.m_root);
+    while (!stack.empty()) {
+        auto [ia, ib] = stack.back();
+        stack.pop_back();
+        const Node& a = m_nodes[ia];
+        const Node& b = other.m_nodes[ib];
+        if (boxBoxDistanceSq(a, b) >= r2) continue;
+
+        const bool aLeaf = a.left < 0;
+        const bool bLeaf = b.left < 0;
+        if (aLeaf && bLeaf) {
+            for (int i = a.first; i < a.first + a.count; ++i) {
+                for (int j = b.first; j < b.first + b.count; ++j) {
+                    float t, tA, tB;
+                    QPointF pt;
+                    // Chord-to-chord distance: 0 if they cross, otherwise the
+                    // closest endpoint-to-chord distance
+                    if (intersectSegments(QPointF(m_x[i], m_y[i]), QPointF(m_x[i + 1], m_y[i + 1]),
+                                          QPointF(other.m_x[j], other.m_y[j]),
+                                          QPointF(other.m_x[j + 1], other.m_y[j + 1]), tA, tB, pt))
+                        return true;
+                    const float d = std::min(
+                        std::min(pointSegmentDistanceSq(m_x[i], m_y[i], other.m_x[j], other.m_y[j],
+                                                        other.m_x[j + 1], other.m_y[j + 1], t),
+                                 pointSegmentDistanceSq(m_x[i + 1], m_y[i + 1], other.m_x[j], other.m_y[j],
+                                                        other.m_x[j + 1], other.m_y[j + 1], t)),
+                        std::min(pointSegmentDistanceSq(other.m_x[j], other.m_y[j], m_x[i], m_y[i],
+                                                        m_x[i + 1], m_y[i + 1], t),
+                                 pointSegmentDistanceSq(other.m_x[j + 1], other.m_y[j + 1], m_x[i], m_y[i],
+                                                        m_x[i + 1], m_y[i + 1], t)));
+                    if (d < r2) return true;
+                }
+            }
+        } else if (bLeaf || (!aLeaf && (a.maxX - a.minX) + (a.maxY - a.minY) >=
+                                           (b.maxX - b.minX) + (b.maxY - b.minY))) {
+            stack.emplace_back(a.left, ib);
+            stack.emplace_back(a.right, ib);
+        } else {
+            stack.emplace_back(ia, b.left);
+            stack.emplace_back(ia, b.right);
+        }
+    }
+    return false;
 }
 
 // ---------------------------------------------------------
@@ -807,4 +992,98 @@ std::vector<BezierSegment> fitBezierChain(const std::vector<VPoint2D>& points, f
     return result;
 }
 
+
+void IncrementalBezierFitter::reset(float tolerance, float epsilon) {
+    m_tolerance = tolerance;
+    m_epsilon = epsilon;
+    m_anchor = 0;
+    m_lastFitSize = 0;
+    m_hasJoint = false;
+    m_committed.clear();
+}
+
+void IncrementalBezierFitter::fitRange(const std::vector<VPoint2D>& points, size_t first, size_t last,
+                                       std::vector<BezierSegment>& segments, std::vector<size_t>* ends) const {
+    segments.clear();
+    if (last <= first) return;
+
+    // Same pipeline as fitBezierChain, on the window only. The window starts
+    // at the committed joint so smoothing (endpoints fixed) cannot move it.
+    std::vector<VPoint2D> window(points.begin() + first, points.begin() + last + 1);
+    if (m_hasJoint) window[0] = m_jointPoint;
+    smoothStrokePoints(window, 2);
+
+    std::vector<VPoint2D> simplified = rdpSimplify(window, m_epsilon, m_epsilon * 1.5f);
+    if (simplified.size() < 2) simplified = window;
+
+    const int n = static_cast<int>(simplified.size());
+    VPoint2D tHat1 = m_hasJoint ? m_jointTangent : computeLeftTangent(simplified, 0);
+    VPoint2D tHat2 = computeRightTangent(simplified, n - 1);
+    fitRecursive(simplified, 0, n - 1, tHat1, tHat2, m_tolerance, segments);
+
+    if (!ends) return;
+    // Segment ends are exact copies of window points (RDP and the fitter both
+    // copy), in order, so a forward scan recovers their input indices.
+    ends->clear();
+    size_t cursor = 1;
+    for (const BezierSegment& seg : segments) {
+        while (cursor + 1 < window.size() &&
+               (window[cursor].x != seg.p3.x || window[cursor].y != seg.p3.y ||
+                window[cursor].pressure != seg.p3.pressure)) {
+            ++cursor;
+        }
+        ends->push_back(first + cursor);
+    }
+}
+
+void IncrementalBezierFitter::commit(const std::vector<BezierSegment>& segments, size_t count,
+                                     size_t endIndex) {
+    m_committed.insert(m_committed.end(), segments.begin(), segments.begin() + count);
+    const BezierSegment& last = segments[count - 1];
+    VPoint2D tangent = {last.p3.x - last.cp2.x, last.p3.y - last.cp2.y, 0};
+    if (len(tangent) < 1e-6f) tangent = {last.p3.x - last.p0.x, last.p3.y - last.p0.y, 0};
+    // Zero-length segment: keep the previous joint direction
+    if (len(tangent) >= 1e-6f) m_jointTangent = normalize(tangent);
+    else if (!m_hasJoint) m_jointTangent = {1.0f, 0.0f, 0.0f};
+    m_jointPoint = last.p3;
+    m_hasJoint = true;
+    m_anchor = endIndex;
+}
+
+void IncrementalBezierFitter::update(const std::vector<VPoint2D>& points) {
+    const size_t size = points.size();
+    if (size < m_anchor + kWindow || size < m_lastFitSize + kRefitStep) return;
+    m_lastFitSize = size;
+
+    std::vector<BezierSegment> segments;
+    std::vector<size_t> ends;
+
+    if (size - m_anchor > kMaxWindow) {
+        // Long run the fitter keeps as one or two segments (a near-straight
+        // swoosh): close off the first kWindow points so the tail stays bounded.
+        const size_t last = m_anchor + kWindow;
+        fitRange(points, m_anchor, last, segments, &ends);
+        if (!segments.empty()) commit(segments, segments.size(), last);
+        return;
+    }
+
+    fitRange(points, m_anchor, size - 1, segments, &ends);
+    size_t count = segments.size() > kHeldSegments ? segments.size() - kHeldSegments : 0;
+    const size_t stable = size - kGuardPoints;
+    while (count > 0 && ends[count - 1] >= stable) --count;
+    if (count > 0) commit(segments, count, ends[count - 1]);
+}
+
+std::vector<BezierSegment> IncrementalBezierFitter::finish(const std::vector<VPoint2D>& points) const {
+    if (m_committed.empty() || points.size() <= m_anchor) {
+        return fitBezierChain(points, m_tolerance, m_epsilon);
+    }
+
+    std::vector<BezierSegment> result = m_committed;
+    std::vector<BezierSegment> tail;
+    fitRange(points, m_anchor, points.size() - 1, tail, nullptr);
+    result.insert(result.end(), tail.begin(), tail.end());
+    return result;
+}
+
 } // namespace artflow
@@ -0,0 +1,88 @@
+#include "vector_simplify.h"
+#include "vector_layer_data.h"
+#include "vector_math.h"
+#include <algorithm>
+#include <utility>
+#include <QtConcurrent/QtConcurrentMap>
+
+namespace artflow {
+
+static int nodeCount(const SegmentArray& segments) {
+    return segments.empty() ? 0 : static_cast<int>(segments.size()) + 1;
+}
+
+// Refit of one stroke, or an empty array when it would not lose a node
+static SegmentArray refitStroke(const VectorStroke& stroke, float tolerance) {
+    if (stroke.segments.size() < 2) return {};
+
+    // Flatten with raw per-point pressure (NOT flattenStrokePolyline, which
+    // folds width factors into pressure and would shrink widths on refit).
+    std::vector<VPoint2D> pts;
+    for (const BezierSegment& seg : stroke.segments) {
+        auto segPts = flattenToPolyline(seg, 0.35f);
+        if (pts.empty()) {
+            pts = std::move(segPts);
+        } else if (segPts.size() > 1) {
+            pts.insert(pts.end(), segPts.begin() + 1, segPts.end());
+        }
+    }
+    if (pts.size() < 2) return {};
+
+    auto refitted = fitBezierChain(pts, tolerance, tolerance * 0.4f);
+    if (refitted.empty() || refitted.size() >= stroke.segments.size()) return {};
+    SegmentArray result(std::move(refitted));
+    result.pack();
+    return result;
+}
+
+VectorSimplifyJob::VectorSimplifyJob(std::vector<VectorStroke> strokes, float tolerance)
+    : m_strokes(std::move(strokes)), m_refitted(m_strokes.size()), m_tolerance(tolerance) {}
+
+void VectorSimplifyJob::run(const std::function<void(int, int)>& progress) {
+    const int total = static_cast<int>(m_strokes.size());
+    std::vector<size_t> chunks;
+    for (size_t i = 0; i < m_strokes.size(); i += kChunkStrokes) chunks.push_back(i);
+
+    std::atomic<int> done{0};
+    QtConcurrent::blockingMap(chunks, [&](size_t first) {
+        const size_t last = std::min(first + kChunkStrokes, m_strokes.size());
+        for (size_t i = first; i < last; ++i) {
+            if (isCancelled()) return;
+            m_refitted[i] = refitStroke(m_strokes[i], m_tolerance);
+        }
+        const int now = done.fetch_add(static_cast<int>(last - first)) +
+                        static_cast<int>(last - first);
+        if (progress) progress(now, total);
+    });
+    if (isCancelled()) return;
+
+    m_nodesBefore = 0;
+    m_nodesAfter = 0;
+    for (size_t i = 0; i < m_strokes.size(); ++i) {
+        const int before = nodeCount(m_strokes[i].segments);
+        m_nodesBefore += before;
+        m_nodesAfter += m_refitted[i].empty() ? before : nodeCount(m_refitted[i]);
+    }
+    m_finished.store(true, std::memory_order_release);
+}
+
+int VectorSimplifyJob::applyTo(VectorLayerData& layer) const {
+    if (!isFinished() || isCancelled()) return 0;
+
+    int removed = 0;
+    for (size_t i = 0; i < m_strokes.size(); ++i) {
+        if (m_refitted[i].empty()) continue;
+        const VectorStroke& snapshot = m_strokes[i];
+        const VectorStroke* current = std::as_const(layer).getStroke(snapshot.id);
+        // Edited, erased or never packed since the snapshot: leave it alone
+        if (!current || !current->segments.sharesStorageWith(snapshot.segments)) continue;
+
+        VectorStroke* stroke = layer.getStroke(snapshot.id);
+        removed += nodeCount(stroke->segments) - nodeCount(m_refitted[i]);
+        stroke->segments = m_refitted[i];
+        stroke->recalcBounds();
+    }
+    return removed;
+}
+
+} // namespace artflow
@@ -0,0 +1,121 @@
+#include "vector_spatial_index.h"
+#include <algorithm>
+#include <cmath>
+
+namespace artflow {
+
+static void eraseId(std::vector<uint32_t>& ids, uint32_t id) {
+    auto it = std::find(ids.begin(), ids.end(), id);
+    if (it != ids.end()) {
+        *it = ids.back();
+        ids.pop_back();
+    }
+}
+
+void VectorSpatialIndex::cellRange(const QRectF& r, int& x0, int& y0, int& x1, int& y1) {
+    // Clamp so absurd coordinates cannot overflow the int cell range
+    auto cell = [](double v) {
+        return static_cast<int>(std::floor(std::clamp(v / kCellSize, -1.0e9, 1.0e9)));
+    };
+    x0 = cell(r.left());
+    y0 = cell(r.top());
+    x1 = cell(r.right());
+    y1 = cell(r.bottom());
+}
+
+void VectorSpatialIndex::insert(uint32_t id, const QRectF& bounds) {
+    if (m_entries.count(id)) remove(id);
+
+    Entry e;
+    e.bounds = bounds;
+    if (bounds.isNull()) {
+        // Empty stroke: tracked but never returned by a query
+        m_entries.emplace(id, e);
+        return;
+    }
+
+    cellRange(bounds, e.x0, e.y0, e.x1, e.y1);
+    const int64_t cells = static_cast<int64_t>(e.x1 - e.x0 + 1) * (e.y1 - e.y0 + 1);
+    if (cells > kMaxCellsPerStroke) {
+        e.oversized = true;
+        m_oversized.push_back(id);
+    } else {
+        for (int cy = e.y0; cy <= e.y1; ++cy)
+            for (int cx = e.x0; cx <= e.x1; ++cx)
+                m_cells[cellKey(cx, cy)].push_back(id);
+    }
+    m_entries.emplace(id, e);
+}
+
+void VectorSpatialIndex::remove(uint32_t id) {
+    auto it = m_entries.find(id);
+    if (it == m_entries.end()) return;
+    const Entry& e = it->second;
+
+    if (e.oversized) {
+        eraseId(m_oversized, id);
+    } else {
+        for (int cy = e.y0; cy <= e.y1; ++cy) {
+            for (int cx = e.x0; cx <= e.x1; ++cx) {
+                auto cellIt = m_cells.find(cellKey(cx, cy));
+                if (cellIt == m_cells.end()) continue;
+                eraseId(cellIt->second, id);
+                if (cellIt->second.empty()) m_cells.erase(cellIt);
+            }
+        }
+    }
+    m_entries.erase(it);
+}
+
+void VectorSpatialIndex::update(uint32_t id, const QRectF& bounds) {
+    auto it = m_entries.find(id);
+    if (it != m_entries.end() && it->second.bounds == bounds) return;
+    insert(id, bounds);
+}
+
+void VectorSpatialIndex::clear() {
+    m_entries.clear();
+    m_cells.clear();
+    m_oversized.clear();
+}
+
+void VectorSpatialIndex::query(const QRectF& rect, std::vector<uint32_t>& out) const {
+    out.clear();
+    if (rect.isNull() || m_entries.empty()) return;
+
+    auto hit = [&](uint32_t id) {
+        auto it = m_entries.find(id);
+        return it != m_entries.end() && it->second.bounds.intersects(rect);
+    };
+
+    int x0, y0, x1, y1;
+    cellRange(rect, x0, y0, x1, y1);
+    const int64_t cells = static_cast<int64_t>(x1 - x0 + 1) * (y1 - y0 + 1);
+
+    if (cells > static_cast<int64_t>(m_cells.size())) {
+        // Query covers more cells than exist: walking the entries is cheaper
+        for (const auto& [id, e] : m_entries) {
+            if (!e.bounds.isNull() && e.bounds.intersects(rect)) out.push_back(id);
+        }
+        return;
+    }
+
+    for (int cy = y0; cy <= y1; ++cy) {
+        for (int cx = x0; cx <= x1; ++cx) {
+            auto cellIt = m_cells.find(cellKey(cx, cy));
+            if (cellIt == m_cells.end()) continue;
+            for (uint32_t id : cellIt->second) {
+                if (hit(id)) out.push_back(id);
+            }
+        }
+    }
+    for (uint32_t id : m_oversized) {
+        if (hit(id)) out.push_back(id);
+    }
+
+    // A stroke spanning several query cells was collected once per cell
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+} // namespace artflow
@@ -0,0 +1,320 @@
+#include "vector_stroke_raster.h"
+#include <algorithm>
+#include <utility>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ARTFLOW_COVERAGE_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define ARTFLOW_COVERAGE_NEON 1
+#endif
+
+namespace artflow {
+
+// ── Tessellation ───────────────────────────────────────────────────────────
+
+void StrokeMesh::addTriangle(float ax, float ay, float bx, float by, float cx, float cy) {
+    const float cross = (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+    if (cross == 0.0f) return; // zero area: no coverage
+    if (cross < 0.0f) {
+        std::swap(bx, cx);
+        std::swap(by, cy);
+    }
+    xy.insert(xy.end(), {ax, ay, bx, by, cx, cy});
+}
+
+void StrokeMesh::addDisc(float cx, float cy, float radius) {
+    if (radius <= 0.0f) return;
+    // Enough sides to keep the polygon within ~0.2 px of the circle
+    const float maxAngle = 2.0f * std::acos(std::max(0.0f, 1.0f - std::min(0.2f / radius, 1.0f)));
+    const int sides = std::clamp(static_cast<int>(std::ceil(6.2831853f / std::max(maxAngle, 1e-3f))), 8, 64);
+    float px = cx + radius, py = cy;
+    for (int i = 1; i <= sides; ++i) {
+        const float a = 6.2831853f * i / sides;
+        const float nx = cx + radius * std::cos(a);
+        const float ny = cy + radius * std::sin(a);
+        addTriangle(cx, cy, px, py, nx, ny);
+        px = nx;
+        py = ny;
+    }
+}
+
+void tessellateStroke(const std::vector<VPoint2D>& points,
+                      const std::vector<float>& widths, StrokeMesh& mesh) {
+    mesh.clear();
+    if (points.empty() || widths.size() != points.size()) return;
+
+    // Coincident points have no direction; keep the wider one
+    std::vector<VPoint2D> p;
+    std::vector<float> r;
+    p.reserve(points.size());
+    r.reserve(points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+        const float radius = 0.5f * widths[i];
+        if (!p.empty() && std::abs(points[i].x - p.back().x) < 1e-3f &&
+            std::abs(points[i].y - p.back().y) < 1e-3f) {
+            r.back() = std::max(r.back(), radius);
+            continue;
+        }
+        p.push_back(points[i]);
+        r.push_back(radius);
+    }
+
+    const size_t n = p.size();
+    mesh.addDisc(p[0].x, p[0].y, r[0]);
+    if (n == 1) return;
+    mesh.addDisc(p[n - 1].x, p[n - 1].y, r[n - 1]);
+
+    // Unit direction and left normal of every segment
+    std::vector<float> dx(n - 1), dy(n - 1);
+    for (size_t s = 0; s + 1 < n; ++s) {
+        const float ex = p[s + 1].x - p[s].x;
+        const float ey = p[s + 1].y - p[s].y;
+        const float len = std::sqrt(ex * ex + ey * ey);
+        dx[s] = ex / len;
+        dy[s] = ey / len;
+    }
+
+    // Turns sharper than 30 degrees get a round join; gentler ones a miter
+    constexpr float kMiterCos = 0.866f;
+    auto sharp = [&](size_t v) {
+        return dx[v - 1] * dx[v] + dy[v - 1] * dy[v] < kMiterCos;
+    };
+    // Offset of vertex v on segment s's side: its own normal at the ends and
+    // at sharp turns, the shared miter otherwise
+    auto offset = [&](size_t v, size_t s, float& ox, float& oy) {
+        float nx = -dy[s], ny = dx[s];
+        float len = r[v];
+        if (v > 0 && v + 1 < n && !sharp(v)) {
+            float mx = -dy[v - 1] - dy[v];
+            float my = dx[v - 1] + dx[v];
+            const float ml = std::sqrt(mx * mx + my * my);
+            mx /= ml;
+            my /= ml;
+            len = r[v] / std::max(mx * nx + my * ny, 0.5f);
+            nx = mx;
+            ny = my;
+        }
+        ox = nx * len;
+        oy = ny * len;
+    };
+
+    for (size_t s = 0; s + 1 < n; ++s) {
+        float ax, ay, bx, by;
+        offset(s, s, ax, ay);
+        offset(s + 1, s, bx, by);
+        const VPoint2D& a = p[s];
+        const VPoint2D& b = p[s + 1];
+        // Quad (a+, a-, b-, b+) as two triangles of the strip
+        mesh.addTriangle(a.x + ax, a.y + ay, a.x - ax, a.y - ay, b.x - bx, b.y - by);
+        mesh.addTriangle(a.x + ax, a.y + ay, b.x - bx, b.y - by, b.x + bx, b.y + by);
+
+        if (s + 2 < n && sharp(s + 1)) mesh.addDisc(b.x, b.y, r[s + 1]);
+    }
+}
+
+// ── Coverage ───────────────────────────────────────────────────────────────
+
+void CoverageRasterizer::reset(int width, int height) {
+    m_width = std::max(0, width);
+    m_height = std::max(0, height);
+    m_stride = m_width + 2;
+    m_accum.assign(static_cast<size_t>(m_stride) * m_height, 0.0f);
+    m_minRow = m_height;
+    m_maxRow = -1;
+}
+
+void CoverageRasterizer::addMesh(const StrokeMesh& mesh, float dx, float dy) {
+    const float* v = mesh.xy.data();
+    for (size_t t = 0; t < mesh.triangleCount(); ++t, v += 6) {
+        const float ax = v[0] + dx, ay = v[1] + dy;
+        const float bx = v[2] + dx, by = v[3] + dy;
+        const float cx = v[4] + dx, cy = v[5] + dy;
+        addLine(ax, ay, bx, by);
+        addLine(bx, by, cx, cy);
+        addLine(cx, cy, ax, ay);
+    }
+}
+
+void CoverageRasterizer::addLine(float x0, float y0, float x1, float y1) {
+    if (y0 == y1 || m_height == 0) return;
+
+    // Split where the line crosses the window's left/right edges: the parts
+    // outside become vertical lines on the edge, which is exact for the
+    // prefix sum (everything left of column 0 is fully "left").
+    float xs[4] = {x0}, ys[4] = {y0};
+    int count = 1;
+    const float edges[2] = {0.0f, static_cast<float>(m_width)};
+    float cuts[2];
+    int cutCount = 0;
+    for (float e : edges) {
+        if ((x0 - e) * (x1 - e) < 0.0f) cuts[cutCount++] = (e - x0) / (x1 - x0);
+    }
+    if (cutCount == 2 && cuts[0] > cuts[1]) std::swap(cuts[0], cuts[1]);
+    for (int i = 0; i < cutCount; ++i) {
+        xs[count] = x0 + (x1 - x0) * cuts[i];
+        ys[count] = y0 + (y1 - y0) * cuts[i];
+        ++count;
+    }
+    xs[count] = x1;
+    ys[count] = y1;
+
+    const float maxX = static_cast<float>(m_width);
+    for (int piece = 0; piece < count; ++piece) {
+        float ax = std::clamp(xs[piece], 0.0f, maxX);
+        float bx = std::clamp(xs[piece + 1], 0.0f, maxX);
+        float ay = ys[piece], by = ys[piece + 1];
+        if (ay == by) continue;
+
+        float dir = 1.0f;
+        if (ay > by) {
+            std::swap(ax, bx);
+            std::swap(ay, by);
+            dir = -1.0f;
+        }
+        if (by <= 0.0f || ay >= m_height) continue;
+
+        const float dxdy = (bx - ax) / (by - ay);
+        float x = ax;
+        if (ay < 0.0f) {
+            x -= ay * dxdy;
+            ay = 0.0f;
+        }
+        const int rowStart = static_cast<int>(ay);
+        const int rowEnd = std::min(m_height, static_cast<int>(std::ceil(by)));
+        m_minRow = std::min(m_minRow, rowStart);
+        m_maxRow = std::max(m_maxRow, rowEnd - 1);
+
+        for (int y = rowStart; y < rowEnd; ++y) {
+            float* row = m_accum.data() + static_cast<size_t>(y) * m_stride;
+            const float dy = std::min(static_cast<float>(y + 1), by) - std::max(static_cast<float>(y), ay);
+            const float xnext = std::clamp(x + dxdy * dy, 0.0f, maxX);
+            const float d = dy * dir;
+            const float lo = std::min(x, xnext);
+            const float hi = std::max(x, xnext);
+            const float loFloor = std::floor(lo);
+            const int loI = static_cast<int>(loFloor);
+            const float hiCeil = std::ceil(hi);
+            const int hiI = static_cast<int>(hiCeil);
+
+            if (hiI <= loI + 1) {
+                // Within one pixel column: split by the mean x
+                const float xmf = 0.5f * (x + xnext) - loFloor;
+                row[loI] += d - d * xmf;
+                row[loI + 1] += d * xmf;
+            } else {
+                // Spans columns: trapezoid areas per column
+                const float s = 1.0f / (hi - lo);
+                const float loF = lo - loFloor;
+                const float a0 = 0.5f * s * (1.0f - loF) * (1.0f - loF);
+                const float hiF = hi - hiCeil + 1.0f;
+                const float am = 0.5f * s * hiF * hiF;
+                row[loI] += d * a0;
+                if (hiI == loI + 2) {
+                    row[loI + 1] += d * (1.0f - a0 - am);
+                } else {
+                    const float a1 = s * (1.5f - loF);
+                    row[loI + 1] += d * (a1 - a0);
+                    for (int xi = loI + 2; xi < hiI - 1; ++xi) row[xi] += d * s;
+                    const float a2 = a1 + (hiI - loI - 3) * s;
+                    row[hiI - 1] += d * (1.0f - a2 - am);
+                }
+                row[hiI] += d * am;
+            }
+            x = xnext;
+        }
+    }
+}
+
+// Running sum of one accumulation row -> coverage in [0, 1]
+static void resolveRow(const float* acc, float* cov, int width) {
+    int x = 0;
+#if defined(ARTFLOW_COVERAGE_SSE2)
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    __m128 carry = _mm_setzero_ps();
+    for (; x + 4 <= width; x += 4) {
+        __m128 v = _mm_loadu_ps(acc + x);
+        // In-register inclusive scan of 4 lanes
+        v = _mm_add_ps(v, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 4)));
+        v = _mm_add_ps(v, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 8)));
+        v = _mm_add_ps(v, carry);
+        carry = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+        _mm_storeu_ps(cov + x, _mm_min_ps(_mm_andnot_ps(signMask, v), one));
+    }
+    float sum = _mm_cvtss_f32(carry);
+#elif defined(ARTFLOW_COVERAGE_NEON)
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    float32x4_t carry = zero;
+    for (; x + 4 <= width; x += 4) {
+        float32x4_t v = vld1q_f32(acc + x);
+        v = vaddq_f32(v, vextq_f32(zero, v, 3));
+        v = vaddq_f32(v, vextq_f32(zero, v, 2));
+        v = vaddq_f32(v, carry);
+        carry = vdupq_n_f32(vgetq_lane_f32(v, 3));
+        vst1q_f32(cov + x, vminq_f32(vabsq_f32(v), one));
+    }
+    float sum = vgetq_lane_f32(carry, 0);
+#else
+    float sum = 0.0f;
+#endif
+    for (; x < width; ++x) {
+        sum += acc[x];
+        cov[x] = std::min(std::abs(sum), 1.0f);
+    }
+}
+
+void CoverageRasterizer::composite(QImage& target, const QPoint& origin, const QColor& color,
+                                   float opacity, bool erase) const {
+    const bool rgba = target.format() == QImage::Format_RGBA8888_Premultiplied;
+    if (m_maxRow < m_minRow || (!rgba && target.format() != QImage::Format_ARGB32_Premultiplied))
+        return;
+
+    const float a = std::clamp(static_cast<float>(color.alphaF()) * opacity, 0.0f, 1.0f);
+    if (a <= 0.0f) return;
+    // Packed as 0xAARRGGBB; RGBA8888 bytes read as 0xAABBGGRR on the
+    // little-endian hosts we ship, so red and blue trade places
+    float sr = color.red() * a, sg = color.green() * a, sb = color.blue() * a;
+    if (rgba) std::swap(sr, sb);
+    const float sa = 255.0f * a;
+
+    // Window columns/rows that land inside the target
+    const int x0 = std::max(0, -origin.x());
+    const int x1 = std::min(m_width, target.width() - origin.x());
+    const int y0 = std::max(m_minRow, -origin.y());
+    const int y1 = std::min(m_maxRow + 1, target.height() - origin.y());
+    if (x0 >= x1) return;
+    std::vector<float> cov(static_cast<size_t>(m_width) + 4);
+
+    for (int y = y0; y < y1; ++y) {
+        resolveRow(m_accum.data() + static_cast<size_t>(y) * m_stride, cov.data(), m_width);
+        uint32_t* dst = reinterpret_cast<uint32_t*>(target.scanLine(origin.y() + y)) + origin.x();
+        for (int x = x0; x < x1; ++x) {
+            const float c = cov[x];
+            if (c < 1.0f / 512.0f) continue;
+            const uint32_t px = dst[x];
+            const float keep = 1.0f - a * c;
+            float oa = ((px >> 24) & 0xFF) * keep;
+            float orr = ((px >> 16) & 0xFF) * keep;
+            float og = ((px >> 8) & 0xFF) * keep;
+            float ob = (px & 0xFF) * keep;
+            if (!erase) {
+                oa += sa * c;
+                orr += sr * c;
+                og += sg * c;
+                ob += sb * c;
+            }
+            dst[x] = (static_cast<uint32_t>(std::min(255.0f, oa + 0.5f)) << 24) |
+                     (static_cast<uint32_t>(std::min(255.0f, orr + 0.5f)) << 16) |
+                     (static_cast<uint32_t>(std::min(255.0f, og + 0.5f)) << 8) |
+                     static_cast<uint32_t>(std::min(255.0f, ob + 0.5f));
+        }
+    }
+}
+
+} // namespace artflow
@@ -0,0 +1,86 @@
+#include "vector_types.h"
+
+namespace artflow {
+
+static bool sameAnchor(const BezierSegment& a, const BezierSegment& b) {
+    return a.p3.x == b.p0.x && a.p3.y == b.p0.y && a.p3.pressure == b.p0.pressure &&
+           a.widthEnd == b.widthStart;
+}
+
+BezierSegment SegmentArray::Packed::segment(size_t i) const {
+    const size_t A = anchors;
+    const size_t H = static_cast<size_t>(count) * 2;
+    const float* ax = data.get();
+    const float* ay = ax + A;
+    const float* ap = ay + A;
+    const float* aw = ap + A;
+    const float* hx = aw + A;
+    const float* hy = hx + H;
+    const float* hp = hy + H;
+
+    const size_t s = sharedJoints ? i : 2 * i;
+    const size_t e = s + 1;
+    const size_t h = 2 * i;
+
+    BezierSegment seg;
+    seg.p0 = {ax[s], ay[s], ap[s]};
+    seg.cp1 = {hx[h], hy[h], hp[h]};
+    seg.cp2 = {hx[h + 1], hy[h + 1], hp[h + 1]};
+    seg.p3 = {ax[e], ay[e], ap[e]};
+    seg.widthStart = aw[s];
+    seg.widthEnd = aw[e];
+    return seg;
+}
+
+void SegmentArray::pack() {
+    if (m_packed) return;
+    if (m_loose.empty()) {
+        std::vector<BezierSegment>().swap(m_loose);
+        return;
+    }
+
+    const size_t n = m_loose.size();
+    auto packed = std::make_shared<Packed>();
+    packed->count = static_cast<uint32_t>(n);
+    for (size_t i = 0; i + 1 < n && packed->sharedJoints; ++i)
+        packed->sharedJoints = sameAnchor(m_loose[i], m_loose[i + 1]);
+    packed->anchors = static_cast<uint32_t>(packed->sharedJoints ? n + 1 : 2 * n);
+
+    const size_t A = packed->anchors;
+    const size_t H = 2 * n;
+    packed->data.reset(new float[4 * A + 3 * H]);
+    float* ax = packed->data.get();
+    float* ay = ax + A;
+    float* ap = ay + A;
+    float* aw = ap + A;
+    float* hx = aw + A;
+    float* hy = hx + H;
+    float* hp = hy + H;
+
+    auto putAnchor = [&](size_t k, const VPoint2D& p, float w) {
+        ax[k] = p.x; ay[k] = p.y; ap[k] = p.pressure; aw[k] = w;
+    };
+    for (size_t i = 0; i < n; ++i) {
+        const BezierSegment& seg = m_loose[i];
+        const size_t s = packed->sharedJoints ? i : 2 * i;
+        putAnchor(s, seg.p0, seg.widthStart);
+        putAnchor(s + 1, seg.p3, seg.widthEnd);
+        hx[2 * i] = seg.cp1.x; hy[2 * i] = seg.cp1.y; hp[2 * i] = seg.cp1.pressure;
+        hx[2 * i + 1] = seg.cp2.x; hy[2 * i + 1] = seg.cp2.y; hp[2 * i + 1] = seg.cp2.pressure;
+    }
+
+    m_packed = std::move(packed);
+    std::vector<BezierSegment>().swap(m_loose);
+}
+
+std::vector<BezierSegment>& SegmentArray::unpack() {
+    if (m_packed) {
+        // Other copies keep the shared block; this one gets its own segments
+        m_loose.resize(m_packed->count);
+        for (size_t i = 0; i < m_loose.size(); ++i) m_loose[i] = m_packed->segment(i);
+        m_packed.reset();
+    }
+    return m_loose;
+}
+
+} // namespace artflow
@@ -968,6 +968,42 @@ Item {
                     onMoved: (val) => { if (mainCanvas) mainCanvas.selectionThreshold = val }
                 }
 
+                // Magic Wand Specifics
+                ColumnLayout {
+                    Layout.fillWidth: true
+                    spacing: 8
+                    visible: currentTool.toLowerCase() === "select_wand"
+
+                    Rectangle { Layout.fillWidth: true; height: 1; color: _colorBorder }
+
+                    RowLayout {
+                        Layout.fillWidth: true
+                        Text { text: "Contiguo"; color: _colorText; font.pixelSize: 11; Layout.fillWidth: true }
+                        Switch {
+                            checked: mainCanvas ? mainCanvas.wandContiguous : true
+                            onCheckedChanged: if(mainCanvas) mainCanvas.wandContiguous = checked
+                        }
+                    }
+
+                    RowLayout {
+                        Layout.fillWidth: true
+                        Text { text: "Muestrear todas las capas"; color: _colorText; font.pixelSize: 11; Layout.fillWidth: true }
+                        Switch {
+                            checked: mainCanvas ? mainCanvas.wandSampleMerged : false
+                            onCheckedChanged: if(mainCanvas) mainCanvas.wandSampleMerged = checked
+                        }
+                    }
+
+                    RowLayout {
+                        Layout.fillWidth: true
+                        Text { text: "Suavizar bordes"; color: _colorText; font.pixelSize: 11; Layout.fillWidth: true }
+                        Switch {
+                            checked: mainCanvas ? mainCanvas.wandAntiAlias : true
+                            onCheckedChanged: if(mainCanvas) mainCanvas.wandAntiAlias = checked
+                        }
+                    }
+                }
+
                 // Magnetic Lasso Specifics
                 ColumnLayout {
                     Layout.fillWidth: true
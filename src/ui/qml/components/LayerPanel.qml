@@ -283,8 +283,13 @@ Item {
                             text: {
                                 var m = root.layerModel; // refresca al cambiar las capas
                                 if (!targetCanvas) return "";
-                                return targetCanvas.vectorStrokeCount(targetCanvas.activeLayerIndex) + qsTr(" trazos · ")
-                                     + targetCanvas.vectorNodeCount(targetCanvas.activeLayerIndex) + qsTr(" nodos");
+                                var progress = targetCanvas.vectorSimplifyProgress;
+                                var preview = targetCanvas.vectorSimplifyPreviewNodes;
+                                var nodes = targetCanvas.vectorNodeCount(targetCanvas.activeLayerIndex);
+                                var label = targetCanvas.vectorStrokeCount(targetCanvas.activeLayerIndex) + qsTr(" trazos · ") + nodes;
+                                if (preview >= 0) return label + " → " + preview + qsTr(" nodos");
+                                if (progress >= 0) return label + qsTr(" nodos · ") + Math.round(progress * 100) + "%";
+                                return label + qsTr(" nodos");
                             }
                             color: "#8a8a93"
                             font.pixelSize: 9; font.family: "Monospace"
@@ -325,7 +330,13 @@ Item {
                                 color: "#fff"; border.color: "#555"; border.width: 1
                                 layer.enabled: true; layer.effect: MultiEffect { shadowEnabled: true; shadowBlur: 6; shadowColor: "#40000000" }
                             }
-                            onMoved: if (targetCanvas) targetCanvas.vectorPostCorrection = Math.round(value)
+                            onMoved: {
+                                if (!targetCanvas) return;
+                                targetCanvas.vectorPostCorrection = Math.round(value);
+                                // A pending preview follows the slider
+                                if (targetCanvas.vectorSimplifyProgress >= 0)
+                                    targetCanvas.simplifyVectorLayer(targetCanvas.activeLayerIndex, targetCanvas.vectorPostCorrection);
+                            }
                         }
 
                         Text {
@@ -370,25 +381,45 @@ Item {
                         }
 
                         Rectangle {
+                            id: simplifyBtn
+                            // Idle -> computing preview (click cancels) -> ready (click applies)
+                            property bool busy: targetCanvas && targetCanvas.vectorSimplifyProgress >= 0
+                                                && targetCanvas.vectorSimplifyPreviewNodes < 0
+                            property bool ready: targetCanvas && targetCanvas.vectorSimplifyPreviewNodes >= 0
                             Layout.fillWidth: true; Layout.preferredHeight: 26; radius: 13
-                            color: simplifyMa.containsMouse ? "#1a2238" : (mainWindow ? mainWindow.colorBg : "#101014")
-                            border.color: mainWindow ? mainWindow.colorBorder : "#303036"
+                            color: ready ? "#007aff" : (simplifyMa.containsMouse ? "#1a2238" : (mainWindow ? mainWindow.colorBg : "#101014"))
+                            border.color: ready ? "#007aff" : (mainWindow ? mainWindow.colorBorder : "#303036")
                             border.width: 1
                             Behavior on color { ColorAnimation { duration: 150 } }
 
                             Text {
                                 anchors.centerIn: parent
-                                text: qsTr("Simplificar")
-                                color: "#a0a0a5"; font.pixelSize: 10; font.weight: Font.DemiBold
+                                text: {
+                                    if (simplifyBtn.ready) {
+                                        var nodes = targetCanvas.vectorNodeCount(targetCanvas.activeLayerIndex);
+                                        var saved = nodes > 0 ? Math.round((1 - targetCanvas.vectorSimplifyPreviewNodes / nodes) * 100) : 0;
+                                        return qsTr("Aplicar −") + saved + "%";
+                                    }
+                                    if (simplifyBtn.busy) return qsTr("Cancelar ") + Math.round(targetCanvas.vectorSimplifyProgress * 100) + "%";
+                                    return qsTr("Simplificar");
+                                }
+                                color: simplifyBtn.ready ? "white" : "#a0a0a5"; font.pixelSize: 10; font.weight: Font.DemiBold
                             }
                             MouseArea {
                                 id: simplifyMa
                                 anchors.fill: parent; hoverEnabled: true; cursorShape: Qt.PointingHandCursor
-                                onClicked: if (targetCanvas) targetCanvas.simplifyVectorLayer(targetCanvas.activeLayerIndex, targetCanvas.vectorPostCorrection)
+                                onClicked: {
+                                    if (!targetCanvas) return;
+                                    if (simplifyBtn.ready) targetCanvas.applyVectorSimplify();
+                                    else if (simplifyBtn.busy) targetCanvas.cancelVectorSimplify();
+                                    else targetCanvas.simplifyVectorLayer(targetCanvas.activeLayerIndex, targetCanvas.vectorPostCorrection);
+                                }
                             }
                             ToolTip.visible: simplifyMa.containsMouse
                             ToolTip.delay: 400
-                            ToolTip.text: qsTr("Reduce los nodos de los trazos existentes\nusando la intensidad del slider (con deshacer)")
+                            ToolTip.text: simplifyBtn.ready
+                                          ? qsTr("Aplica la reducción de nodos mostrada (con deshacer)")
+                                          : qsTr("Calcula en segundo plano cuántos nodos se pueden quitar\nusando la intensidad del slider")
                         }
 
                         Rectangle {
@@ -43,6 +43,7 @@ Popup {
     property bool tempGpuEnabled: true
     property int tempUndoLevels: 50
     property int tempMemLimit: 70
+    property bool tempFrameTracing: false
     property bool tempSwitchTool: true
     property int tempSwitchDelay: 500
     property string tempLanguage: "en"
@@ -206,6 +207,7 @@ Popup {
             tempUndoLevels = preferencesManager.undoLevels
             tempLanguage = preferencesManager.language
             tempMemLimit = preferencesManager.memoryUsageLimit
+            tempFrameTracing = preferencesManager.frameTracingEnabled
             tempShowOutline = preferencesManager.cursorShowOutline
             tempShowCrosshair = preferencesManager.cursorShowCrosshair
             tempTabletMode = preferencesManager.tabletInputMode
@@ -234,6 +236,7 @@ Popup {
             preferencesManager.undoLevels = tempUndoLevels
             preferencesManager.language = tempLanguage
             preferencesManager.memoryUsageLimit = tempMemLimit
+            preferencesManager.frameTracingEnabled = tempFrameTracing
             preferencesManager.cursorShowOutline = tempShowOutline
             preferencesManager.cursorShowCrosshair = tempShowCrosshair
             preferencesManager.tabletInputMode = tempTabletMode
@@ -647,6 +650,21 @@ Popup {
                                     onMoved: root.tempMemLimit = value
                                 }
                             }
+
+                            SettingsGroup {
+                                title: "Diagnostics"
+
+                                CheckBoxOption {
+                                    text: "Record frame trace (Chrome Trace JSON)"
+                                    checked: root.tempFrameTracing
+                                    onCheckedChanged: root.tempFrameTracing = checked
+                                }
+                                Text {
+                                    text: "Records paint, composition, texture uploads, autosave and background jobs. The trace is saved to Documents/KromoStudioProjects/.traces when recording is turned off."
+                                    color: colorTextMuted; font.pixelSize: 11; wrapMode: Text.WordWrap
+                                    Layout.fillWidth: true
+                                }
+                            }
                         }
                     }
                     
@@ -97,8 +97,8 @@ Item {
     Rectangle {
         id: featherPopover
         visible: featherPopoverActive
-        width: 190 * uiScale
-        height: 52 * uiScale
+        width: 210 * uiScale
+        height: 80 * uiScale
         radius: 12 * uiScale
         color: "#f0101014"
         border.color: "#25ffffff"
@@ -124,7 +124,7 @@ Item {
             RowLayout {
                 Layout.fillWidth: true
                 Text {
-                    text: "Feather Selection"
+                    text: "Refine Edge"
                     color: "#f0f0f5"
                     font.pixelSize: 10 * uiScale
                     font.weight: Font.DemiBold
@@ -142,8 +142,8 @@ Item {
                 id: featherSlider
                 Layout.fillWidth: true
                 height: 18 * uiScale
-                from: 0
-                to: 100
+                from: 1
+                to: 200
                 stepSize: 1
                 value: 8
                 
@@ -170,9 +170,51 @@ Item {
                     border.color: root.accentColor
                     border.width: 2 * uiScale
                 }
+            }
 
-                onMoved: {
-                    if (canvas) canvas.featherSelection(value)
+            // Each click applies once (and is one undo step) with the radius above
+            RowLayout {
+                Layout.fillWidth: true
+                spacing: 4 * uiScale
+
+                Repeater {
+                    model: [
+                        { label: "Feather", op: "feather" },
+                        { label: "Grow", op: "grow" },
+                        { label: "Shrink", op: "shrink" },
+                        { label: "Smooth", op: "smooth" }
+                    ]
+                    delegate: Rectangle {
+                        Layout.fillWidth: true
+                        Layout.preferredHeight: 20 * uiScale
+                        radius: 6 * uiScale
+                        color: refineMa.pressed ? "#30ffffff" : (refineMa.containsMouse ? "#20ffffff" : "#12ffffff")
+
+                        Text {
+                            anchors.centerIn: parent
+                            text: modelData.label
+                            color: "#f0f0f5"
+                            font.pixelSize: 9 * uiScale
+                            font.weight: Font.Medium
+                        }
+
+                        MouseArea {
+                            id: refineMa
+                            anchors.fill: parent
+                            hoverEnabled: true
+                            cursorShape: Qt.PointingHandCursor
+                            onClicked: {
+                                if (!canvas) return
+                                var r = featherSlider.value
+                                switch (modelData.op) {
+                                    case "feather": canvas.featherSelection(r); break
+                                    case "grow": canvas.growSelection(r); break
+                                    case "shrink": canvas.shrinkSelection(r); break
+                                    case "smooth": canvas.smoothSelection(r); break
+                                }
+                            }
+                        }
+                    }
                 }
             }
         }
@@ -269,7 +311,7 @@ Item {
         ActionBtn {
             id: slidersBtn
             icon: "sliders.svg"
-            tip: "Feather Edge Settings"
+            tip: "Refine Edge (Feather / Grow / Shrink / Smooth)"
             onClicked: {
                 featherPopoverActive = !featherPopoverActive
             }
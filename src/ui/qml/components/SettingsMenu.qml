@@ -284,7 +284,8 @@ Popup {
                     ContentHeader { text: "Exportar y guardar" }
                     ContentSeparator {}
                     ActionButton { text: "Guardar proyecto (.stxf)"; onClicked: { if(windowRef) windowRef.saveProjectAndRefresh(); root.close() } }
-                    ActionButton { text: "Exportar imagen..."; onClicked: { exportImageDialog.open(); root.close() } }
+                    ActionButton { text: "Exportar imagen..."; onClicked: { exportImageDialog.exportDpi = 0; exportImageDialog.open(); root.close() } }
+                    ActionButton { text: "Exportar para impresión (300 DPI)..."; onClicked: { exportImageDialog.exportDpi = 300; exportImageDialog.open(); root.close() } }
                     ActionButton { text: "Grabar/Exportar Timelapse"; onClicked: { videoConfigDialog.open(); root.close() } }
                     Item { Layout.fillHeight: true }
                 }
@@ -330,6 +330,13 @@ Window {
     property string currentStoryPath: ""
     property bool transformBilinear: true
     property bool transformAdvancedMesh: false
+    // Advanced mesh: denser warp grid
+    onTransformAdvancedMeshChanged: {
+        if (typeof mainCanvas !== "undefined" && mainCanvas) {
+            mainCanvas.transformMeshColumns = transformAdvancedMesh ? 6 : 3
+            mainCanvas.transformMeshRows = transformAdvancedMesh ? 6 : 3
+        }
+    }
     
     // Sidebar visibility (hidden by default when on canvas for minimalist experience)
     property bool showSidebar: currentPage !== 1
@@ -1615,6 +1622,17 @@ Window {
                             // Perspective/Mesh points state
                             property var perspPoints: null
                             
+                            // One handle per warp/mesh control point, row-major like perspPoints
+                            function meshHandles(cols, rows) {
+                                var handles = [];
+                                for (var r = 0; r <= rows; ++r) {
+                                    for (var c = 0; c <= cols; ++c) {
+                                        handles.push({hx: c / cols, hy: r / rows, cursor: Qt.PointingHandCursor, idx: r * (cols + 1) + c});
+                                    }
+                                }
+                                return handles;
+                            }
+                            
                             // Helper function to initialize points for the current transform mode
                             function initializePointsForMode(mode) {
                                 var w = manipulator.width > 0 ? manipulator.width : (mainCanvas.transformBox.width > 0 ? mainCanvas.transformBox.width : parent.width);
@@ -1627,11 +1645,13 @@ Window {
                                         {x: 0, y: h}
                                     ];
                                 } else if (mode === 2 || mode === 3) { // Warp/Mesh
+                                    var cols = mainCanvas.transformMeshColumns;
+                                    var rows = mainCanvas.transformMeshRows;
                                     var pts = [];
-                                    for (var r = 0; r < 4; ++r) {
-                                        var y = (r / 3.0) * h;
-                                        for (var c = 0; c < 4; ++c) {
-                                            var x = (c / 3.0) * w;
+                                    for (var r = 0; r <= rows; ++r) {
+                                        var y = (r / rows) * h;
+                                        for (var c = 0; c <= cols; ++c) {
+                                            var x = (c / cols) * w;
                                             pts.push({ x: x, y: y });
                                         }
                                     }
@@ -1650,6 +1670,12 @@ Window {
                                         manipulator.updateTransform();
                                     }
                                 }
+                                function onTransformMeshChanged() {
+                                    if (mainCanvas.isTransforming && (mainCanvas.transformMode === 2 || mainCanvas.transformMode === 3)) {
+                                        manipulator.initializePointsForMode(mainCanvas.transformMode);
+                                        manipulator.updateTransform();
+                                    }
+                                }
                                 function onTransformBoxChanged() {
                                     if (mainCanvas.isTransforming) {
                                         manipulator.x = mainCanvas.transformBox.x
@@ -1705,19 +1731,22 @@ Window {
                                             ctx.lineTo(manipulator.perspPoints[2].x + offset, manipulator.perspPoints[2].y + offset)
                                             ctx.lineTo(manipulator.perspPoints[3].x + offset, manipulator.perspPoints[3].y + offset)
                                             ctx.closePath()
-                                        } else if ((mainCanvas.transformMode === 2 || mainCanvas.transformMode === 3) && manipulator.perspPoints.length === 16) {
+                                        } else if ((mainCanvas.transformMode === 2 || mainCanvas.transformMode === 3) && manipulator.perspPoints.length === (mainCanvas.transformMeshColumns + 1) * (mainCanvas.transformMeshRows + 1)) {
+                                            var cols = mainCanvas.transformMeshColumns
+                                            var rows = mainCanvas.transformMeshRows
+                                            var stride = cols + 1
                                             // Horizontal grid lines
-                                            for (var r = 0; r < 4; ++r) {
-                                                ctx.moveTo(manipulator.perspPoints[r*4].x + offset, manipulator.perspPoints[r*4].y + offset)
-                                                for (var c = 1; c < 4; ++c) {
-                                                    ctx.lineTo(manipulator.perspPoints[r*4 + c].x + offset, manipulator.perspPoints[r*4 + c].y + offset)
+                                            for (var r = 0; r <= rows; ++r) {
+                                                ctx.moveTo(manipulator.perspPoints[r*stride].x + offset, manipulator.perspPoints[r*stride].y + offset)
+                                                for (var c = 1; c <= cols; ++c) {
+                                                    ctx.lineTo(manipulator.perspPoints[r*stride + c].x + offset, manipulator.perspPoints[r*stride + c].y + offset)
                                                 }
                                             }
                                             // Vertical grid lines
-                                            for (var c = 0; c < 4; ++c) {
+                                            for (var c = 0; c <= cols; ++c) {
                                                 ctx.moveTo(manipulator.perspPoints[c].x + offset, manipulator.perspPoints[c].y + offset)
-                                                for (var r = 1; r < 4; ++r) {
-                                                    ctx.lineTo(manipulator.perspPoints[r*4 + c].x + offset, manipulator.perspPoints[r*4 + c].y + offset)
+                                                for (var r = 1; r <= rows; ++r) {
+                                                    ctx.lineTo(manipulator.perspPoints[r*stride + c].x + offset, manipulator.perspPoints[r*stride + c].y + offset)
                                                 }
                                             }
                                         }
@@ -1805,24 +1834,7 @@ Window {
                             // ── RESIZE HANDLES (Corners & Grid) ──
                             Repeater {
                                 model: (mainCanvas.transformMode === 2 || mainCanvas.transformMode === 3) 
-                                       ? [
-                                           {hx: 0, hy: 0, cursor: Qt.PointingHandCursor, idx: 0},
-                                           {hx: 0.33, hy: 0, cursor: Qt.PointingHandCursor, idx: 1},
-                                           {hx: 0.67, hy: 0, cursor: Qt.PointingHandCursor, idx: 2},
-                                           {hx: 1, hy: 0, cursor: Qt.PointingHandCursor, idx: 3},
-                                           {hx: 0, hy: 0.33, cursor: Qt.PointingHandCursor, idx: 4},
-                                           {hx: 0.33, hy: 0.33, cursor: Qt.PointingHandCursor, idx: 5},
-                                           {hx: 0.67, hy: 0.33, cursor: Qt.PointingHandCursor, idx: 6},
-                                           {hx: 1, hy: 0.33, cursor: Qt.PointingHandCursor, idx: 7},
-                                           {hx: 0, hy: 0.67, cursor: Qt.PointingHandCursor, idx: 8},
-                                           {hx: 0.33, hy: 0.67, cursor: Qt.PointingHandCursor, idx: 9},
-                                           {hx: 0.67, hy: 0.67, cursor: Qt.PointingHandCursor, idx: 10},
-                                           {hx: 1, hy: 0.67, cursor: Qt.PointingHandCursor, idx: 11},
-                                           {hx: 0, hy: 1, cursor: Qt.PointingHandCursor, idx: 12},
-                                           {hx: 0.33, hy: 1, cursor: Qt.PointingHandCursor, idx: 13},
-                                           {hx: 0.67, hy: 1, cursor: Qt.PointingHandCursor, idx: 14},
-                                           {hx: 1, hy: 1, cursor: Qt.PointingHandCursor, idx: 15}
-                                         ]
+                                       ? manipulator.meshHandles(mainCanvas.transformMeshColumns, mainCanvas.transformMeshRows)
                                        : [
                                            {hx: 0, hy: 0, cursor: Qt.SizeFDiagCursor, idx: 0},
                                            {hx: 1, hy: 0, cursor: Qt.SizeBDiagCursor, idx: 1},
@@ -9477,10 +9489,13 @@ Window {
 
     FileDialog {
         id: exportImageDialog
-        title: "Export Image"
+        // Output resolution; 0 = the document DPI (canvas pixels 1:1)
+        property int exportDpi: 0
+        title: exportDpi > 0 ? "Export Image (" + exportDpi + " DPI)" : "Export Image"
         fileMode: FileDialog.SaveFile
         nameFilters: ["PNG Image (*.png)", "JPEG Image (*.jpg)", "Photoshop (*.psd)"]
         defaultSuffix: "png"
+        onRejected: exportDpi = 0
         onAccepted: {
             // Determine format from extension
             var pathStr = file.toString()
@@ -9490,8 +9505,10 @@ Window {
             } else if (pathStr.toLowerCase().endsWith(".psd")) {
                 format = "PSD"
             }
-            if (mainCanvas.exportImage(file, format)) {
-                toastManager.show("Image exported: " + format, "success")
+            var dpi = exportDpi > 0 ? exportDpi : mainCanvas.projectDpi()
+            exportDpi = 0
+            if (mainCanvas.exportImageAtDpi(file, format, dpi)) {
+                toastManager.show("Image exported: " + format + " @ " + dpi + " DPI", "success")
             } else {
                 toastManager.show("Export failed", "error")
             }